@@ -0,0 +1 @@
+/system/bin/SRecApiTest -parfile baseline11k.par >out_SHIP_apitest.txt 2>&1
@@ -11,6 +11,7 @@ common_SRC_FILES:= \
 	src/ArrayListImpl.c \
 	src/ESR_ReturnCode.c \
 	src/LCHAR.c  \
+	src/parena.c \
 	src/pcputimer.c \
 	src/pcrc.c \
 	src/pendian.c \
@@ -20,6 +21,7 @@ common_SRC_FILES:= \
 	src/pLastError.c \
 	src/plog.c \
 	src/pmalloc.c \
+	src/pmemacct.c \
 	src/pmemory.c \
 	src/pmemory_ext.c \
 	src/PStackSize.c \
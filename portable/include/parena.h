@@ -0,0 +1,118 @@
+/*---------------------------------------------------------------------------*
+ *  parena.h  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#ifndef PARENA_H
+#define PARENA_H
+
+
+
+#include "PortPrefix.h"
+#include "ptypes.h"
+#include "ESR_ReturnCode.h"
+
+/**
+ * The default size of the blocks carved up by an arena.
+ */
+#define PARENA_DEFAULT_BLOCK_SIZE 4096
+
+/**
+ * @addtogroup PArenaModule PArena API functions
+ * Bump allocator for objects that all die at the same time.  Allocation
+ * takes the next free bytes of the current block, individual objects are
+ * never freed, and PArenaReset() makes the whole arena available again
+ * while keeping its blocks, so an arena that is reset between utterances
+ * stops calling the system allocator once it has grown to the size of a
+ * typical utterance.
+ *
+ * An arena is not thread-safe; it is meant to be owned by a single object
+ * such as a recognizer.
+ *
+ * @{
+ */
+
+/** Typedef */
+typedef struct PArena_t PArena;
+
+/**
+ * Creates an arena.
+ *
+ * @param blockSize Size of the blocks requested from the system allocator.
+ * Requests larger than a block get a block of their own.  0 selects
+ * PARENA_DEFAULT_BLOCK_SIZE.
+ * @param memTag Memory tag used for the blocks.  It is not copied and must
+ * remain valid for the lifetime of the arena.
+ * @param self [out] The arena
+ * @return ESR_INVALID_ARGUMENT if self is null; ESR_OUT_OF_MEMORY if system
+ * is out of memory
+ */
+PORTABLE_API ESR_ReturnCode PArenaCreate(size_t blockSize, const LCHAR* memTag,
+    PArena** self);
+
+/**
+ * Destroys an arena and everything allocated from it.
+ *
+ * @param self The arena
+ * @return ESR_INVALID_ARGUMENT if self is null
+ */
+PORTABLE_API ESR_ReturnCode PArenaDestroy(PArena* self);
+
+/**
+ * Allocates memory from an arena.  The memory is suitably aligned for any
+ * type and is not initialized.
+ *
+ * @param self The arena
+ * @param size Number of bytes to allocate
+ * @return the memory, or NULL if the system is out of memory
+ */
+PORTABLE_API void* PArenaAlloc(PArena* self, size_t size);
+
+/**
+ * Copies a string into an arena.
+ *
+ * @param self The arena
+ * @param str The string to copy
+ * @return the copy, or NULL if the system is out of memory
+ */
+PORTABLE_API LCHAR* PArenaStrdup(PArena* self, const LCHAR* str);
+
+/**
+ * Indicates if memory was allocated from an arena since it was last reset.
+ *
+ * @param self The arena
+ * @param ptr The memory
+ * @return ESR_TRUE if ptr lies in one of the arena's blocks
+ */
+PORTABLE_API ESR_BOOL PArenaOwns(PArena* self, const void* ptr);
+
+/**
+ * Makes all the memory of an arena available again.  Everything allocated
+ * from the arena becomes invalid.  Blocks of the regular size are kept for
+ * reuse, oversized blocks are returned to the system.
+ *
+ * @param self The arena
+ * @return ESR_INVALID_ARGUMENT if self is null
+ */
+PORTABLE_API ESR_ReturnCode PArenaReset(PArena* self);
+
+/**
+ * @}
+ */
+
+
+#endif
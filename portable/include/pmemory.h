@@ -61,11 +61,36 @@
 
 #ifdef USE_STDLIB_MALLOC
 
+/*
+ * PMEM_ACCOUNTING is not defined by default (see ASR_MEM_ACCOUNTING in
+ * make/asr/Makefile.common).  When it is, every allocation is charged to
+ * its tag, and PMemGetTagStats()/PMemDumpTagStats() report the live bytes,
+ * peak bytes and allocation counts of each tag.
+ */
+#ifdef PMEM_ACCOUNTING
+
+#define MALLOC(n, tag) pmalloc_acct(n, tag)
+#define CALLOC(m, n, tag) pcalloc_acct(m, n, tag)
+#define CALLOC_CLR(m, n, tag) pcalloc_acct(m, n, tag)
+#define REALLOC(p, n) prealloc_acct(p, n)
+#define FREE(p) pfree_acct(p)
+#define PMemLogFree(p) (pfree_acct(p), ESR_SUCCESS)
+#define PMemReport(f) PMemDumpTagStats(f)
+
+#else
+
 #define MALLOC(n, tag) malloc(n)
 #define CALLOC(m, n, tag) calloc(m, n)
 #define CALLOC_CLR(m, n, tag) calloc(m, n)
 #define REALLOC(p, n) realloc(p, n)
 #define FREE(p) free(p)
+#define PMemLogFree(p) (free(p), ESR_SUCCESS)
+#define PMemReport(f) ESR_NOT_SUPPORTED
+#define PMemGetTagStats(stats, count) ESR_NOT_SUPPORTED
+#define PMemDumpTagStats(f) ESR_NOT_SUPPORTED
+
+#endif
+
 #define NEW(type, tag) ((type*)MALLOC(sizeof(type), tag))
 #define NEW_ARRAY(type, n, tag) ((type*)CALLOC(n, sizeof(type), tag))
 
@@ -74,11 +99,90 @@
 #define PMemSetLogFile(f) ESR_NOT_SUPPORTED
 #define PMemDumpLogFile() ESR_NOT_SUPPORTED
 #define PMemSetLogEnabled(b) ESR_NOT_SUPPORTED
-#define PMemLogFree(p) (free(p), ESR_SUCCESS)
-#define PMemReport(f) ESR_NOT_SUPPORTED
 #define PMemorySetPoolSize(n) ESR_NOT_SUPPORTED
 #define PMemoryGetPoolSize(p) ESR_NOT_SUPPORTED
 
+#ifdef PMEM_ACCOUNTING
+
+/**
+ * @addtogroup PmemoryModule PMemory API functions
+ *
+ * @{
+ */
+
+/**
+ * Memory usage of one allocation tag.
+ */
+typedef struct PMemTagStats_t
+{
+  /**
+   * The tag, as passed to MALLOC() and friends.
+   */
+  const LCHAR* tag;
+  /**
+   * Bytes currently allocated under the tag.
+   */
+  size_t liveBytes;
+  /**
+   * Highest value liveBytes has reached.
+   */
+  size_t peakBytes;
+  /**
+   * Number of allocations made under the tag.
+   */
+  size_t allocCount;
+  /**
+   * Number of those allocations that were freed.
+   */
+  size_t freeCount;
+}
+PMemTagStats;
+
+/**
+ * malloc() charged to a tag.
+ */
+PORTABLE_API void *pmalloc_acct(size_t nbBytes, const LCHAR* tag);
+
+/**
+ * calloc() charged to a tag.
+ */
+PORTABLE_API void *pcalloc_acct(size_t nbItems, size_t itemSize, const LCHAR* tag);
+
+/**
+ * realloc() of memory from pmalloc_acct() or pcalloc_acct(); the memory keeps
+ * its tag.
+ */
+PORTABLE_API void *prealloc_acct(void* ptr, size_t newSize);
+
+/**
+ * free() of memory from pmalloc_acct(), pcalloc_acct() or prealloc_acct().
+ */
+PORTABLE_API void pfree_acct(void* ptr);
+
+/**
+ * Retrieves the usage of every tag allocated under so far.
+ *
+ * @param stats Array receiving one entry per tag
+ * @param count [in/out] Size of stats on input, number of tags on output
+ * @return ESR_BUFFER_OVERFLOW if stats is too small, in which case count is
+ * set to the required size; ESR_INVALID_ARGUMENT if count is null
+ */
+PORTABLE_API ESR_ReturnCode PMemGetTagStats(PMemTagStats* stats, size_t* count);
+
+/**
+ * Writes the usage of every tag, largest peak first.
+ *
+ * @param file The file to write to, or NULL for PSTDOUT
+ * @return ESR_OUT_OF_MEMORY if the report could not be built
+ */
+PORTABLE_API ESR_ReturnCode PMemDumpTagStats(PFile* file);
+
+/**
+ * @}
+ */
+
+#endif
+
 #else
 
 #ifdef DISABLE_MALLOC
@@ -331,6 +435,9 @@ PORTABLE_API ESR_ReturnCode PMemoryGetPoolSize(size_t *size);
  * @}
  */
 
+#define PMemGetTagStats(stats, count) ESR_NOT_SUPPORTED
+#define PMemDumpTagStats(f) ESR_NOT_SUPPORTED
+
 #endif
 
 #endif
@@ -0,0 +1,184 @@
+/*---------------------------------------------------------------------------*
+ *  parena.c  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "parena.h"
+#include "LCHAR.h"
+#include "pmemory.h"
+
+/* every allocation is rounded up to this, which is enough for any type the
+   recognizer keeps in an arena */
+#define PARENA_ALIGN (sizeof(double) > sizeof(void*) ? sizeof(double) : sizeof(void*))
+#define PARENA_ROUND(n) (((n) + PARENA_ALIGN - 1) & ~(PARENA_ALIGN - 1))
+
+typedef struct PArenaBlock_t
+{
+  struct PArenaBlock_t* next;
+  size_t size; /* bytes of data following the header */
+  size_t used;
+}
+PArenaBlock;
+
+#define PARENA_HEADER_SIZE PARENA_ROUND(sizeof(PArenaBlock))
+#define PARENA_BLOCK_DATA(block) ((char*)(block) + PARENA_HEADER_SIZE)
+
+struct PArena_t
+{
+  size_t blockSize;
+  const LCHAR* memTag;
+  /* blocks in use, the current one first */
+  PArenaBlock* blocks;
+  /* regular blocks freed up by the last reset */
+  PArenaBlock* spare;
+};
+
+static PArenaBlock* newBlock(PArena* self, size_t size)
+{
+  PArenaBlock* block;
+
+  if (size == self->blockSize && self->spare != NULL)
+  {
+    block = self->spare;
+    self->spare = block->next;
+  }
+  else
+  {
+    block = (PArenaBlock*) MALLOC(PARENA_HEADER_SIZE + size, self->memTag);
+    if (block == NULL)
+      return NULL;
+    block->size = size;
+  }
+  block->used = 0;
+  return block;
+}
+
+ESR_ReturnCode PArenaCreate(size_t blockSize, const LCHAR* memTag, PArena** self)
+{
+  PArena* tmp;
+
+  if (self == NULL)
+    return ESR_INVALID_ARGUMENT;
+  if ((tmp = NEW(PArena, memTag)) == NULL)
+    return ESR_OUT_OF_MEMORY;
+  tmp->blockSize = PARENA_ROUND(blockSize > 0 ? blockSize : PARENA_DEFAULT_BLOCK_SIZE);
+  tmp->memTag = memTag;
+  tmp->blocks = NULL;
+  tmp->spare = NULL;
+  *self = tmp;
+  return ESR_SUCCESS;
+}
+
+static void freeBlocks(PArenaBlock* block)
+{
+  PArenaBlock* next;
+
+  for (; block != NULL; block = next)
+  {
+    next = block->next;
+    FREE(block);
+  }
+}
+
+ESR_ReturnCode PArenaDestroy(PArena* self)
+{
+  if (self == NULL)
+    return ESR_INVALID_ARGUMENT;
+  freeBlocks(self->blocks);
+  freeBlocks(self->spare);
+  FREE(self);
+  return ESR_SUCCESS;
+}
+
+void* PArenaAlloc(PArena* self, size_t size)
+{
+  PArenaBlock* block;
+  void* result;
+
+  size = PARENA_ROUND(size > 0 ? size : 1);
+  block = self->blocks;
+  if (block != NULL && block->size - block->used >= size)
+  {
+    result = PARENA_BLOCK_DATA(block) + block->used;
+    block->used += size;
+    return result;
+  }
+
+  block = newBlock(self, size > self->blockSize ? size : self->blockSize);
+  if (block == NULL)
+    return NULL;
+  if (block->size > self->blockSize && self->blocks != NULL)
+  {
+    /* keep filling the current block, the oversized one is used up */
+    block->next = self->blocks->next;
+    self->blocks->next = block;
+  }
+  else
+  {
+    block->next = self->blocks;
+    self->blocks = block;
+  }
+  block->used = size;
+  return PARENA_BLOCK_DATA(block);
+}
+
+LCHAR* PArenaStrdup(PArena* self, const LCHAR* str)
+{
+  size_t size = (LSTRLEN(str) + 1) * sizeof(LCHAR);
+  LCHAR* result = (LCHAR*) PArenaAlloc(self, size);
+
+  if (result != NULL)
+    memcpy(result, str, size);
+  return result;
+}
+
+ESR_BOOL PArenaOwns(PArena* self, const void* ptr)
+{
+  PArenaBlock* block;
+  const char* p = (const char*) ptr;
+
+  for (block = self->blocks; block != NULL; block = block->next)
+  {
+    if (p >= PARENA_BLOCK_DATA(block) && p < PARENA_BLOCK_DATA(block) + block->used)
+      return ESR_TRUE;
+  }
+  return ESR_FALSE;
+}
+
+ESR_ReturnCode PArenaReset(PArena* self)
+{
+  PArenaBlock* block;
+  PArenaBlock* next;
+
+  if (self == NULL)
+    return ESR_INVALID_ARGUMENT;
+  for (block = self->blocks; block != NULL; block = next)
+  {
+    next = block->next;
+    if (block->size == self->blockSize)
+    {
+      block->next = self->spare;
+      self->spare = block;
+    }
+    else
+      FREE(block);
+  }
+  self->blocks = NULL;
+  return ESR_SUCCESS;
+}
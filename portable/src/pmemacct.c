@@ -0,0 +1,265 @@
+/*---------------------------------------------------------------------------*
+ *  pmemacct.c  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "pmemory.h"
+#include "LCHAR.h"
+#include "PFileSystem.h"
+#include "pstdio.h"
+
+#if defined(USE_STDLIB_MALLOC) && defined(PMEM_ACCOUNTING)
+
+/* number of distinct tags that can be told apart, a power of two; tags past
+   that are charged to PMEM_ACCT_OTHER */
+#define PMEM_ACCT_MAX_TAGS 1024
+#define PMEM_ACCT_OTHER PMEM_ACCT_MAX_TAGS
+
+/* largest request that still leaves room for the header */
+#define PMEM_ACCT_MAX_BYTES (((size_t) -1) - sizeof(PMemAcctHeader))
+
+/* The counters are shared by all threads and updated with atomic
+   operations, so no lock is taken on the allocation path and the peak of
+   a tag is exact even when it is allocated from several threads. */
+#if defined(__GNUC__)
+#define ACCT_ADD(p, n) __sync_add_and_fetch(p, n)
+#define ACCT_SUB(p, n) __sync_sub_and_fetch(p, n)
+#define ACCT_CAS(p, o, n) __sync_bool_compare_and_swap(p, o, n)
+#else
+/* no atomics: correct for single-threaded use only */
+#define ACCT_ADD(p, n) (*(p) += (n))
+#define ACCT_SUB(p, n) (*(p) -= (n))
+#define ACCT_CAS(p, o, n) (*(p) == (o) ? (*(p) = (n), 1) : 0)
+#endif
+
+typedef struct
+{
+  const LCHAR* volatile tag;
+  volatile size_t liveBytes;
+  volatile size_t peakBytes;
+  volatile size_t allocCount;
+  volatile size_t freeCount;
+}
+PMemTagSlot;
+
+/* placed in front of every allocation; the union keeps the user memory as
+   aligned as what malloc() returns */
+typedef union
+{
+  struct
+  {
+    size_t size;
+    size_t slot;
+  } h;
+  double align;
+}
+PMemAcctHeader;
+
+static PMemTagSlot gTags[PMEM_ACCT_MAX_TAGS + 1];
+
+static const LCHAR* const UNTAGGED = L("(untagged)");
+
+static size_t hashTag(const LCHAR* tag)
+{
+  size_t h = 0;
+
+  while (*tag)
+    h = h * 31 + (unsigned char) *tag++;
+  return h;
+}
+
+/* finds or claims the slot of a tag */
+static size_t findSlot(const LCHAR* tag)
+{
+  size_t i, n;
+  const LCHAR* current;
+
+  if (tag == NULL)
+    tag = UNTAGGED;
+  i = hashTag(tag) & (PMEM_ACCT_MAX_TAGS - 1);
+  for (n = 0; n < PMEM_ACCT_MAX_TAGS; ++n)
+  {
+    current = gTags[i].tag;
+    if (current == NULL)
+    {
+      if (ACCT_CAS(&gTags[i].tag, (const LCHAR*) NULL, tag))
+        return i;
+      current = gTags[i].tag;
+    }
+    if (current == tag || LSTRCMP(current, tag) == 0)
+      return i;
+    i = (i + 1) & (PMEM_ACCT_MAX_TAGS - 1);
+  }
+  return PMEM_ACCT_OTHER;
+}
+
+static void chargeBytes(PMemTagSlot* slot, size_t nbBytes)
+{
+  size_t live = ACCT_ADD(&slot->liveBytes, nbBytes);
+  size_t peak = slot->peakBytes;
+
+  while (live > peak && !ACCT_CAS(&slot->peakBytes, peak, live))
+    peak = slot->peakBytes;
+}
+
+static void* charge(PMemAcctHeader* header, size_t nbBytes, const LCHAR* tag)
+{
+  PMemTagSlot* slot;
+
+  if (header == NULL)
+    return NULL;
+  header->h.size = nbBytes;
+  header->h.slot = findSlot(tag);
+  slot = &gTags[header->h.slot];
+  ACCT_ADD(&slot->allocCount, 1);
+  chargeBytes(slot, nbBytes);
+  return header + 1;
+}
+
+void *pmalloc_acct(size_t nbBytes, const LCHAR* tag)
+{
+  if (nbBytes > PMEM_ACCT_MAX_BYTES)
+    return NULL;
+  return charge((PMemAcctHeader*) malloc(sizeof(PMemAcctHeader) + nbBytes), nbBytes, tag);
+}
+
+void *pcalloc_acct(size_t nbItems, size_t itemSize, const LCHAR* tag)
+{
+  size_t nbBytes;
+
+  if (itemSize != 0 && nbItems > PMEM_ACCT_MAX_BYTES / itemSize)
+    return NULL;
+  nbBytes = nbItems * itemSize;
+  return charge((PMemAcctHeader*) calloc(1, sizeof(PMemAcctHeader) + nbBytes), nbBytes, tag);
+}
+
+void *prealloc_acct(void* ptr, size_t newSize)
+{
+  PMemAcctHeader* header;
+  PMemTagSlot* slot;
+  size_t oldSize;
+
+  if (ptr == NULL)
+    return pmalloc_acct(newSize, NULL);
+  if (newSize > PMEM_ACCT_MAX_BYTES)
+    return NULL;
+  header = (PMemAcctHeader*) ptr - 1;
+  oldSize = header->h.size;
+  header = (PMemAcctHeader*) realloc(header, sizeof(PMemAcctHeader) + newSize);
+  if (header == NULL)
+    return NULL;
+  slot = &gTags[header->h.slot];
+  header->h.size = newSize;
+  if (newSize > oldSize)
+    chargeBytes(slot, newSize - oldSize);
+  else
+    ACCT_SUB(&slot->liveBytes, oldSize - newSize);
+  return header + 1;
+}
+
+void pfree_acct(void* ptr)
+{
+  PMemAcctHeader* header;
+  PMemTagSlot* slot;
+
+  if (ptr == NULL)
+    return;
+  header = (PMemAcctHeader*) ptr - 1;
+  slot = &gTags[header->h.slot];
+  ACCT_SUB(&slot->liveBytes, header->h.size);
+  ACCT_ADD(&slot->freeCount, 1);
+  free(header);
+}
+
+ESR_ReturnCode PMemGetTagStats(PMemTagStats* stats, size_t* count)
+{
+  size_t i, n = 0;
+
+  if (count == NULL)
+    return ESR_INVALID_ARGUMENT;
+  for (i = 0; i <= PMEM_ACCT_MAX_TAGS; ++i)
+  {
+    if (gTags[i].allocCount == 0)
+      continue;
+    if (stats != NULL && n < *count)
+    {
+      stats[n].tag = i == PMEM_ACCT_OTHER ? L("(other)") : gTags[i].tag;
+      stats[n].liveBytes = gTags[i].liveBytes;
+      stats[n].peakBytes = gTags[i].peakBytes;
+      stats[n].allocCount = gTags[i].allocCount;
+      stats[n].freeCount = gTags[i].freeCount;
+    }
+    ++n;
+  }
+  if (stats == NULL || n > *count)
+  {
+    *count = n;
+    return ESR_BUFFER_OVERFLOW;
+  }
+  *count = n;
+  return ESR_SUCCESS;
+}
+
+static int comparePeak(const void* a, const void* b)
+{
+  const PMemTagStats* sa = (const PMemTagStats*) a;
+  const PMemTagStats* sb = (const PMemTagStats*) b;
+
+  if (sa->peakBytes != sb->peakBytes)
+    return sa->peakBytes < sb->peakBytes ? 1 : -1;
+  return LSTRCMP(sa->tag, sb->tag);
+}
+
+ESR_ReturnCode PMemDumpTagStats(PFile* file)
+{
+  PMemTagStats* stats;
+  size_t count = PMEM_ACCT_MAX_TAGS + 1, i, live = 0, peak = 0;
+  ESR_ReturnCode rc;
+
+  if (file == NULL)
+    file = PSTDOUT;
+  /* taken straight from the system so that the report does not show up in
+     itself */
+  stats = (PMemTagStats*) malloc(count * sizeof(PMemTagStats));
+  if (stats == NULL)
+    return ESR_OUT_OF_MEMORY;
+  rc = PMemGetTagStats(stats, &count);
+  if (rc != ESR_SUCCESS)
+  {
+    free(stats);
+    return rc;
+  }
+  qsort(stats, count, sizeof(PMemTagStats), comparePeak);
+
+  pfprintf(file, L("%12s %12s %10s %10s  %s\n"), L("live"), L("peak"), L("allocs"), L("frees"), L("tag"));
+  for (i = 0; i < count; ++i)
+  {
+    pfprintf(file, L("%12lu %12lu %10lu %10lu  %s\n"), (unsigned long) stats[i].liveBytes,
+             (unsigned long) stats[i].peakBytes, (unsigned long) stats[i].allocCount,
+             (unsigned long) stats[i].freeCount, stats[i].tag);
+    live += stats[i].liveBytes;
+    peak += stats[i].peakBytes;
+  }
+  pfprintf(file, L("%12lu %12lu %10s %10s  %s\n"), (unsigned long) live, (unsigned long) peak,
+           L(""), L(""), L("(total, peak is the sum of the tag peaks)"));
+  free(stats);
+  return ESR_SUCCESS;
+}
+
+#endif
@@ -1202,6 +1202,7 @@ ESR_ReturnCode ESR_SessionTypeImportParFileImpl(ESR_SessionType* self,
   CHKLOG(rc, parameterList->put(parameterList, "SREC.voice_enroll.bufsz_kB", &Size_t));
   CHKLOG(rc, parameterList->put(parameterList, "SREC.voice_enroll.eos_comfort_frames", &Size_t));
   CHKLOG(rc, parameterList->put(parameterList, "SREC.voice_enroll.bos_comfort_frames", &Size_t));
+  CHKLOG(rc, parameterList->put(parameterList, "SREC.voice_enroll.nbest", &Size_t));
 
   CHKLOG(rc, parameterList->put(parameterList, "SREC.Confidence.sigmoid_param.gdiff.one_nbest", &PLChar));
   CHKLOG(rc, parameterList->put(parameterList, "SREC.Confidence.sigmoid_param.gdiff.many_nbest", &PLChar));
@@ -1315,6 +1316,7 @@ ESR_ReturnCode ESR_SessionTypeImportParFileImpl(ESR_SessionType* self,
   CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.wordpen", &Int));
   CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.viterbi_prune_thresh", &Int));
   CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.max_hmm_tokens", &Int));
+  CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.max_active_hmm_tokens", &Int));
   CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.max_fsmnode_tokens", &Int));
   CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.max_word_tokens", &Int));
   CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.max_altword_tokens", &Int));
@@ -1328,6 +1330,12 @@ ESR_ReturnCode ESR_SessionTypeImportParFileImpl(ESR_SessionType* self,
   CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.eou_threshold", &Int));
   CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.max_frames", &Int));
   CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.max_model_states", &Int));
+  CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.frame_budget_usec", &Int));
+  CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.phone_lookahead_margin", &Int));
+  CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.first_pass_pdfs", &Int));
+  CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.score_threads", &Int));
+  CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.max_grammars", &Int));
+  CHKLOG(rc, parameterList->put(parameterList, "CREC.Recognizer.enrollment_search", &Int));
   CHKLOG(rc, parameterList->put(parameterList, "thread.priority", &UInt16_t));
   /* for G2P */
   CHKLOG(rc, parameterList->put(parameterList, "G2P.Available", &Bool));
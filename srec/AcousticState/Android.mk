@@ -9,6 +9,7 @@ include $(ASR_MAKE_DIR)/Makefile.defs
 common_SRC_FILES:= \
 	src/AcousticState.c \
 	src/AcousticStateImpl.c \
+	src/AcousticStateStore.c \
 
 common_C_INCLUDES := \
 	$(ASR_ROOT_DIR)/portable/include \
@@ -0,0 +1,155 @@
+/*---------------------------------------------------------------------------*
+ *  SR_AcousticStateStore.h  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#ifndef __SR_ACOUSTICSTATESTORE_H
+#define __SR_ACOUSTICSTATESTORE_H
+
+
+
+#include "SR_AcousticStatePrefix.h"
+#include "SR_Recognizer.h"
+#include "ESR_ReturnCode.h"
+
+
+/**
+ * @addtogroup SR_AcousticStateStoreModule SR_AcousticStateStore API functions
+ * Keeps the channel normalization of several speakers or channels, so that
+ * a session for a known speaker starts from that speaker's adapted state
+ * rather than from the defaults of the parameter file.
+ *
+ * Every state is filed under a caller-supplied key, e.g. a speaker or a
+ * microphone ID.  When the store is full, the state that was used least
+ * recently is dropped to make room.  Stores are saved to and loaded from a
+ * compact binary file.
+ *
+ * @{
+ */
+
+/**
+ * Maximum length of a key, including the terminating null.
+ */
+#define SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH 64
+
+/** Typedef */
+typedef struct SR_AcousticStateStore_t SR_AcousticStateStore;
+
+/**
+ * Creates an empty store.
+ *
+ * @param capacity Maximum number of states the store keeps
+ * @param self [out] The store
+ * @return ESR_INVALID_ARGUMENT if self is null or capacity is 0; ESR_OUT_OF_MEMORY if
+ * system is out of memory
+ */
+SREC_ACOUSTICSTATE_API ESR_ReturnCode SR_AcousticStateStoreCreate(size_t capacity,
+    SR_AcousticStateStore** self);
+/**
+ * Destroys a store.  The store must not be selected by any recognizer.
+ *
+ * @param self The store
+ * @return ESR_INVALID_ARGUMENT if self is null
+ */
+SREC_ACOUSTICSTATE_API ESR_ReturnCode SR_AcousticStateStoreDestroy(SR_AcousticStateStore* self);
+/**
+ * Replaces the contents of a store with the states saved in a file.  If the
+ * file holds more states than the store can keep, the least recently used
+ * ones are dropped.
+ *
+ * @param self The store
+ * @param filename File to read from
+ * @return ESR_INVALID_ARGUMENT if self or filename is null; ESR_OPEN_ERROR if the file
+ * cannot be opened; ESR_INVALID_STATE if the file is not a store of this build;
+ * ESR_READ_ERROR if the file is truncated
+ */
+SREC_ACOUSTICSTATE_API ESR_ReturnCode SR_AcousticStateStoreLoad(SR_AcousticStateStore* self,
+    const LCHAR* filename);
+/**
+ * Saves a store to a file.
+ *
+ * @param self The store
+ * @param filename File to write into
+ * @return ESR_INVALID_ARGUMENT if self or filename is null; ESR_OPEN_ERROR if the file
+ * cannot be created; ESR_WRITE_ERROR if the file cannot be written
+ */
+SREC_ACOUSTICSTATE_API ESR_ReturnCode SR_AcousticStateStoreSave(SR_AcousticStateStore* self,
+    const LCHAR* filename);
+/**
+ * Returns the number of states in a store.
+ *
+ * @param self The store
+ * @param size [out] The number of states
+ * @return ESR_INVALID_ARGUMENT if self or size is null
+ */
+SREC_ACOUSTICSTATE_API ESR_ReturnCode SR_AcousticStateStoreGetSize(SR_AcousticStateStore* self,
+    size_t* size);
+/**
+ * Files the current acoustic state of a recognizer under a key, replacing
+ * any state already filed under it.
+ *
+ * @param self The store
+ * @param recognizer SR_Recognizer handle
+ * @param key Speaker or channel ID
+ * @return ESR_INVALID_ARGUMENT if an argument is null or key is too long
+ */
+SREC_ACOUSTICSTATE_API ESR_ReturnCode SR_AcousticStateStorePut(SR_AcousticStateStore* self,
+    SR_Recognizer* recognizer, const LCHAR* key);
+/**
+ * Sets the acoustic state of a recognizer to the state filed under a key.
+ * The recognizer is left untouched if there is none.
+ *
+ * @param self The store
+ * @param recognizer SR_Recognizer handle
+ * @param key Speaker or channel ID
+ * @return ESR_INVALID_ARGUMENT if an argument is null; ESR_NO_MATCH_ERROR if no state
+ * is filed under key
+ */
+SREC_ACOUSTICSTATE_API ESR_ReturnCode SR_AcousticStateStoreGet(SR_AcousticStateStore* self,
+    SR_Recognizer* recognizer, const LCHAR* key);
+/**
+ * Removes the state filed under a key.
+ *
+ * @param self The store
+ * @param key Speaker or channel ID
+ * @return ESR_INVALID_ARGUMENT if an argument is null; ESR_NO_MATCH_ERROR if no state
+ * is filed under key
+ */
+SREC_ACOUSTICSTATE_API ESR_ReturnCode SR_AcousticStateStoreRemove(SR_AcousticStateStore* self,
+    const LCHAR* key);
+/**
+ * Selects the speaker or channel of the next recognitions.  SR_RecognizerStart()
+ * starts from the state filed under key, or from the default state if there is
+ * none, and SR_RecognizerStop() files the adapted state back under key.  The
+ * state is only reloaded when the key changes; recognitions for the same key
+ * keep adapting from one to the next.
+ *
+ * @param recognizer SR_Recognizer handle
+ * @param store The store, or NULL to stop using a store
+ * @param key Speaker or channel ID, ignored if store is NULL
+ * @return ESR_INVALID_ARGUMENT if recognizer is null, or if store is not null and key
+ * is null or too long
+ */
+SREC_ACOUSTICSTATE_API ESR_ReturnCode SR_AcousticStateSelect(SR_Recognizer* recognizer,
+    SR_AcousticStateStore* store, const LCHAR* key);
+
+/**
+ * @}
+ */
+
+
+#endif /* __SR_ACOUSTICSTATESTORE_H */
@@ -0,0 +1,432 @@
+/*---------------------------------------------------------------------------*
+ *  AcousticStateStore.c  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "SR_AcousticStateStore.h"
+#include "SR_RecognizerImpl.h"
+#include "phashtable.h"
+#include "plog.h"
+#include "pmemory.h"
+#include "pstdio.h"
+
+#define MTAG __FILE__
+
+/* "ACS1"; a file written on a machine of the other byte order does not
+   match either */
+#define ACOUSTIC_STATE_STORE_FORMAT 0x41435331
+
+/* the header is { format, channel dimension, key length, number of states }
+   and every state is a key padded to SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH
+   followed by { num_frames_in_cmn, cmn[MAX_CHAN_DIM] }, least recently used
+   first so that loading them in order rebuilds the same LRU list */
+#define ACOUSTIC_STATE_HEADER_SIZE 4
+#define ACOUSTIC_STATE_VALUE_SIZE (1 + MAX_CHAN_DIM)
+
+typedef struct AcousticStateEntry_t
+{
+  LCHAR key[SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH];
+  swicms_state state;
+  /* more recently used; on the free list, the next free entry */
+  struct AcousticStateEntry_t* prev;
+  /* less recently used */
+  struct AcousticStateEntry_t* next;
+}
+AcousticStateEntry;
+
+struct SR_AcousticStateStore_t
+{
+  size_t capacity;
+  size_t size;
+  AcousticStateEntry* entries;
+  /* most and least recently used entries */
+  AcousticStateEntry* head;
+  AcousticStateEntry* tail;
+  AcousticStateEntry* freeEntries;
+  /* key -> entry, the keys are the ones in the entries */
+  PHashTable* index;
+};
+
+static void unlinkEntry(SR_AcousticStateStore* self, AcousticStateEntry* entry)
+{
+  if (entry->prev != NULL)
+    entry->prev->next = entry->next;
+  else
+    self->head = entry->next;
+  if (entry->next != NULL)
+    entry->next->prev = entry->prev;
+  else
+    self->tail = entry->prev;
+}
+
+static void pushEntry(SR_AcousticStateStore* self, AcousticStateEntry* entry)
+{
+  entry->prev = NULL;
+  entry->next = self->head;
+  if (self->head != NULL)
+    self->head->prev = entry;
+  else
+    self->tail = entry;
+  self->head = entry;
+}
+
+static void freeEntry(SR_AcousticStateStore* self, AcousticStateEntry* entry)
+{
+  entry->prev = self->freeEntries;
+  self->freeEntries = entry;
+}
+
+static ESR_ReturnCode checkKey(const LCHAR* key)
+{
+  if (key == NULL || LSTRLEN(key) >= SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  return ESR_SUCCESS;
+}
+
+static ESR_ReturnCode putState(SR_AcousticStateStore* self, const LCHAR* key,
+                               const swicms_state* state)
+{
+  AcousticStateEntry* entry;
+  ESR_ReturnCode rc;
+
+  rc = PHashTableGetValue(self->index, key, (void**) &entry);
+  if (rc == ESR_SUCCESS)
+    unlinkEntry(self, entry);
+  else if (rc == ESR_NO_MATCH_ERROR)
+  {
+    if (self->freeEntries != NULL)
+    {
+      entry = self->freeEntries;
+      self->freeEntries = entry->prev;
+    }
+    else
+    {
+      /* full, drop the least recently used state */
+      entry = self->tail;
+      unlinkEntry(self, entry);
+      CHKLOG(rc, PHashTableRemoveValue(self->index, entry->key, NULL));
+      --self->size;
+    }
+    LSTRCPY(entry->key, key);
+    rc = PHashTablePutValue(self->index, entry->key, entry, NULL);
+    if (rc != ESR_SUCCESS)
+    {
+      freeEntry(self, entry);
+      PLogError(ESR_rc2str(rc));
+      return rc;
+    }
+    ++self->size;
+  }
+  else
+  {
+    PLogError(ESR_rc2str(rc));
+    return rc;
+  }
+  memcpy(&entry->state, state, sizeof(swicms_state));
+  pushEntry(self, entry);
+  return ESR_SUCCESS;
+CLEANUP:
+  return rc;
+}
+
+ESR_ReturnCode SR_AcousticStateStoreCreate(size_t capacity, SR_AcousticStateStore** self)
+{
+  SR_AcousticStateStore* store;
+  PHashTableArgs hashArgs;
+  size_t i;
+  ESR_ReturnCode rc;
+
+  if (self == NULL || capacity == 0)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  store = NEW(SR_AcousticStateStore, MTAG);
+  if (store == NULL)
+  {
+    PLogError(L("ESR_OUT_OF_MEMORY"));
+    return ESR_OUT_OF_MEMORY;
+  }
+  store->capacity = capacity;
+  store->size = 0;
+  store->head = NULL;
+  store->tail = NULL;
+  store->freeEntries = NULL;
+  store->index = NULL;
+  store->entries = NEW_ARRAY(AcousticStateEntry, capacity, MTAG);
+  if (store->entries == NULL)
+  {
+    rc = ESR_OUT_OF_MEMORY;
+    PLogError(ESR_rc2str(rc));
+    goto CLEANUP;
+  }
+  for (i = capacity; i > 0; --i)
+    freeEntry(store, &store->entries[i - 1]);
+
+  hashArgs.capacity = capacity * 2 + 1;
+  hashArgs.maxLoadFactor = PHASH_TABLE_DEFAULT_MAX_LOAD_FACTOR;
+  hashArgs.hashFunction = PHASH_TABLE_DEFAULT_HASH_FUNCTION;
+  hashArgs.compFunction = PHASH_TABLE_DEFAULT_COMP_FUNCTION;
+  CHKLOG(rc, PHashTableCreate(&hashArgs, MTAG, &store->index));
+
+  *self = store;
+  return ESR_SUCCESS;
+CLEANUP:
+  SR_AcousticStateStoreDestroy(store);
+  return rc;
+}
+
+ESR_ReturnCode SR_AcousticStateStoreDestroy(SR_AcousticStateStore* self)
+{
+  if (self == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  if (self->index != NULL)
+    PHashTableDestroy(self->index);
+  if (self->entries != NULL)
+    FREE(self->entries);
+  FREE(self);
+  return ESR_SUCCESS;
+}
+
+ESR_ReturnCode SR_AcousticStateStoreLoad(SR_AcousticStateStore* self, const LCHAR* filename)
+{
+  SR_AcousticStateStore* loaded = NULL;
+  SR_AcousticStateStore swap;
+  PFile* file;
+  asr_int32_t header[ACOUSTIC_STATE_HEADER_SIZE];
+  asr_int32_t values[ACOUSTIC_STATE_VALUE_SIZE];
+  LCHAR key[SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH];
+  swicms_state state;
+  asr_int32_t i;
+  int j;
+  ESR_ReturnCode rc;
+
+  if (self == NULL || filename == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  file = pfopen(filename, L("rb"));
+  if (file == NULL)
+  {
+    PLogError(L("ESR_OPEN_ERROR: %s"), filename);
+    return ESR_OPEN_ERROR;
+  }
+  if (pfread(header, sizeof(header[0]), ACOUSTIC_STATE_HEADER_SIZE, file) != ACOUSTIC_STATE_HEADER_SIZE)
+  {
+    rc = ESR_READ_ERROR;
+    PLogError(L("%s: %s"), ESR_rc2str(rc), filename);
+    goto CLEANUP;
+  }
+  if (header[0] != ACOUSTIC_STATE_STORE_FORMAT || header[1] != MAX_CHAN_DIM ||
+      header[2] != SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH || header[3] < 0)
+  {
+    rc = ESR_INVALID_STATE;
+    PLogError(L("%s: %s is not an acoustic state store"), ESR_rc2str(rc), filename);
+    goto CLEANUP;
+  }
+
+  /* the states go into a store of their own, so that a file that fails
+     half way leaves this one as it was */
+  CHKLOG(rc, SR_AcousticStateStoreCreate(self->capacity, &loaded));
+  for (i = 0; i < header[3]; ++i)
+  {
+    if (pfread(key, sizeof(LCHAR), SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH, file) != SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH ||
+        pfread(values, sizeof(values[0]), ACOUSTIC_STATE_VALUE_SIZE, file) != ACOUSTIC_STATE_VALUE_SIZE)
+    {
+      rc = ESR_READ_ERROR;
+      PLogError(L("%s: %s"), ESR_rc2str(rc), filename);
+      goto CLEANUP;
+    }
+    key[SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH - 1] = L('\0');
+    state.num_frames_in_cmn = values[0];
+    for (j = 0; j < MAX_CHAN_DIM; ++j)
+      state.cmn[j] = values[1 + j];
+    CHKLOG(rc, putState(loaded, key, &state));
+  }
+  pfclose(file);
+  /* recognizers hold on to self, so it is the contents that are swapped */
+  swap = *self;
+  *self = *loaded;
+  *loaded = swap;
+  SR_AcousticStateStoreDestroy(loaded);
+  return ESR_SUCCESS;
+CLEANUP:
+  pfclose(file);
+  if (loaded != NULL)
+    SR_AcousticStateStoreDestroy(loaded);
+  return rc;
+}
+
+ESR_ReturnCode SR_AcousticStateStoreSave(SR_AcousticStateStore* self, const LCHAR* filename)
+{
+  PFile* file;
+  asr_int32_t header[ACOUSTIC_STATE_HEADER_SIZE];
+  asr_int32_t values[ACOUSTIC_STATE_VALUE_SIZE];
+  LCHAR key[SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH];
+  AcousticStateEntry* entry;
+  int j;
+
+  if (self == NULL || filename == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  file = pfopen(filename, L("wb"));
+  if (file == NULL)
+  {
+    PLogError(L("ESR_OPEN_ERROR: %s"), filename);
+    return ESR_OPEN_ERROR;
+  }
+  header[0] = ACOUSTIC_STATE_STORE_FORMAT;
+  header[1] = MAX_CHAN_DIM;
+  header[2] = SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH;
+  header[3] = (asr_int32_t) self->size;
+  if (pfwrite(header, sizeof(header[0]), ACOUSTIC_STATE_HEADER_SIZE, file) != ACOUSTIC_STATE_HEADER_SIZE)
+    goto WRITE_ERROR;
+  for (entry = self->tail; entry != NULL; entry = entry->prev)
+  {
+    /* pad the key so that no stale bytes end up in the file */
+    memset(key, 0, sizeof(key));
+    LSTRCPY(key, entry->key);
+    values[0] = entry->state.num_frames_in_cmn;
+    for (j = 0; j < MAX_CHAN_DIM; ++j)
+      values[1 + j] = entry->state.cmn[j];
+    if (pfwrite(key, sizeof(LCHAR), SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH, file) != SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH ||
+        pfwrite(values, sizeof(values[0]), ACOUSTIC_STATE_VALUE_SIZE, file) != ACOUSTIC_STATE_VALUE_SIZE)
+      goto WRITE_ERROR;
+  }
+  pfclose(file);
+  return ESR_SUCCESS;
+WRITE_ERROR:
+  PLogError(L("ESR_WRITE_ERROR: %s"), filename);
+  pfclose(file);
+  return ESR_WRITE_ERROR;
+}
+
+ESR_ReturnCode SR_AcousticStateStoreGetSize(SR_AcousticStateStore* self, size_t* size)
+{
+  if (self == NULL || size == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  *size = self->size;
+  return ESR_SUCCESS;
+}
+
+ESR_ReturnCode SR_AcousticStateStorePut(SR_AcousticStateStore* self,
+                                        SR_Recognizer* recognizer, const LCHAR* key)
+{
+  SR_RecognizerImpl* recogImpl = (SR_RecognizerImpl*) recognizer;
+  swicms_state state;
+  ESR_ReturnCode rc;
+
+  if (self == NULL || recognizer == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  CHKLOG(rc, checkKey(key));
+  CHKLOG(rc, CA_GetCMSState(recogImpl->wavein, &state));
+  return putState(self, key, &state);
+CLEANUP:
+  return rc;
+}
+
+ESR_ReturnCode SR_AcousticStateStoreGet(SR_AcousticStateStore* self,
+                                        SR_Recognizer* recognizer, const LCHAR* key)
+{
+  SR_RecognizerImpl* recogImpl = (SR_RecognizerImpl*) recognizer;
+  AcousticStateEntry* entry;
+  ESR_ReturnCode rc;
+
+  if (self == NULL || recognizer == NULL || key == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  rc = PHashTableGetValue(self->index, key, (void**) &entry);
+  if (rc != ESR_SUCCESS)
+    return rc;
+  CHKLOG(rc, CA_SetCMSState(recogImpl->wavein, &entry->state));
+  unlinkEntry(self, entry);
+  pushEntry(self, entry);
+  return ESR_SUCCESS;
+CLEANUP:
+  return rc;
+}
+
+ESR_ReturnCode SR_AcousticStateStoreRemove(SR_AcousticStateStore* self, const LCHAR* key)
+{
+  AcousticStateEntry* entry;
+  ESR_ReturnCode rc;
+
+  if (self == NULL || key == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  rc = PHashTableRemoveValue(self->index, key, (void**) &entry);
+  if (rc != ESR_SUCCESS)
+    return rc;
+  /* a missing key is not an error to the hashtable, its value is just NULL */
+  if (entry == NULL)
+    return ESR_NO_MATCH_ERROR;
+  unlinkEntry(self, entry);
+  freeEntry(self, entry);
+  --self->size;
+  return ESR_SUCCESS;
+}
+
+ESR_ReturnCode SR_AcousticStateSelect(SR_Recognizer* recognizer,
+                                      SR_AcousticStateStore* store, const LCHAR* key)
+{
+  SR_RecognizerImpl* impl = (SR_RecognizerImpl*) recognizer;
+  ESR_ReturnCode rc;
+
+  if (recognizer == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  if (store == NULL)
+  {
+    impl->acousticStateStore = NULL;
+    impl->acousticStateKey[0] = L('\0');
+    impl->acousticStateKeyChanged = ESR_FALSE;
+    return ESR_SUCCESS;
+  }
+  CHKLOG(rc, checkKey(key));
+  if (impl->acousticStateStore != store || LSTRCMP(impl->acousticStateKey, key) != 0)
+  {
+    impl->acousticStateStore = store;
+    LSTRCPY(impl->acousticStateKey, key);
+    impl->acousticStateKeyChanged = ESR_TRUE;
+  }
+  return ESR_SUCCESS;
+CLEANUP:
+  return rc;
+}
@@ -102,6 +102,27 @@ typedef struct SR_Grammar_t
   * @return ESR_INVALID_ARGUMENT if self or filename are null; ESR_INVALID_STATE if could not save the grammar
   */
   ESR_ReturnCode(*save)(struct SR_Grammar_t* self, const LCHAR* filename);
+
+  /**
+  * Saves only what was added to the slots since the grammar was loaded, to be
+  * loaded back onto the same grammar image with loadDelta.
+  *
+  * @param self SR_Grammar handle
+  * @param filename File to write the delta into
+  * @return ESR_INVALID_ARGUMENT if self or filename are null; ESR_INVALID_STATE if could not save the delta
+  */
+  ESR_ReturnCode(*saveDelta)(struct SR_Grammar_t* self, const LCHAR* filename);
+  
+  /**
+  * Adds the slot words of a delta written by saveDelta. The grammar must be the image
+  * the delta was saved from, with its slots reset.
+  *
+  * @param self SR_Grammar handle
+  * @param filename File to read the delta from
+  * @return ESR_INVALID_ARGUMENT if self or filename are null; ESR_READ_ERROR if the delta could
+  * not be loaded, in which case the slots are left reset
+  */
+  ESR_ReturnCode(*loadDelta)(struct SR_Grammar_t* self, const LCHAR* filename);
   
   /**
    * Indicates if a transcription is a valid result of a Grammar rule.
@@ -130,6 +151,24 @@ typedef struct SR_Grammar_t
   ESR_ReturnCode(*addWordToSlot)(struct SR_Grammar_t* self, const LCHAR* slot, const LCHAR* word, 
 		const LCHAR* pronunciation, int weight, const LCHAR* tag);
   
+  /**
+   * Adds a list of words to a rule slot in one operation.
+   *
+   * @param self SR_Grammar handle
+   * @param slot Slot name
+   * @param count Number of words in the list
+   * @param words Words to be added to the slot
+   * @param pronunciations Word pronunciations (optional). Pass NULL, or NULL entries, to omit.
+   * @param weights values to associate with the words (optional). Pass NULL for weight 0.
+   * @param tags eScript semantic expressions (tags) for the words (optional). Pass NULL to omit.
+   * @param results [out] result of adding each word, as returned by addWordToSlot (optional)
+   * @return ESR_INVALID_ARGUMENT if self or words is null; ESR_INVALID_STATE if the vocabulary is
+   * missing; ESR_OUT_OF_MEMORY if the words cannot be added to the grammar
+   */
+  ESR_ReturnCode(*addWordsToSlot)(struct SR_Grammar_t* self, const LCHAR* slot, size_t count,
+    const LCHAR** words, const LCHAR** pronunciations, const int* weights, const LCHAR** tags,
+    ESR_ReturnCode* results);
+  
   /**
    * Removes all elements from all slots.
    *
@@ -337,6 +376,26 @@ SREC_GRAMMAR_API ESR_ReturnCode SR_GrammarCompile(SR_Grammar* self);
 SREC_GRAMMAR_API ESR_ReturnCode SR_GrammarAddWordToSlot(SR_Grammar* self, const LCHAR* slot, 
 																												const LCHAR* word, const LCHAR* pronunciation, 
 																												int weight, const LCHAR* tag);
+/**
+ * Adds a list of words to a rule slot in one operation. This is much faster than
+ * calling SR_GrammarAddWordToSlot() for each word when populating a large slot.
+ *
+ * @param self SR_Grammar handle
+ * @param slot Slot name
+ * @param count Number of words in the list
+ * @param words Words to be added to the slot
+ * @param pronunciations Word pronunciations (optional). Pass NULL, or NULL entries, to omit.
+ * @param weights values to associate with the words (optional). Pass NULL for weight 0.
+ * @param tags eScript semantic expressions for the words (optional). Pass NULL to omit.
+ * @param results [out] result of adding each word, as returned by SR_GrammarAddWordToSlot (optional)
+ * @return ESR_INVALID_ARGUMENT if self or words is null; ESR_INVALID_STATE if the vocabulary is
+ * missing; ESR_OUT_OF_MEMORY if the words cannot be added to the grammar (addWords=X is too small)
+ */
+SREC_GRAMMAR_API ESR_ReturnCode SR_GrammarAddWordsToSlot(SR_Grammar* self, const LCHAR* slot,
+                                                         size_t count, const LCHAR** words,
+                                                         const LCHAR** pronunciations,
+                                                         const int* weights, const LCHAR** tags,
+                                                         ESR_ReturnCode* results);
 /**
  * Removes all elements from all slots.
  *
@@ -448,6 +507,23 @@ SREC_GRAMMAR_API ESR_ReturnCode SR_GrammarLoad(const LCHAR* filename, SR_Grammar
  * @return ESR_INVALID_ARGUMENT if self or filename are null; ESR_INVALID_STATE if could not save the grammar
  */
 SREC_GRAMMAR_API ESR_ReturnCode SR_GrammarSave(SR_Grammar* self, const LCHAR* filename);
+/**
+ * Saves the words added to the slots of a grammar, without its base image.
+ *
+ * @param self SR_Grammar handle
+ * @param filename File to write the delta into
+ * @return ESR_INVALID_ARGUMENT if self or filename are null; ESR_INVALID_STATE if could not save the delta
+ */
+SREC_GRAMMAR_API ESR_ReturnCode SR_GrammarSaveDelta(SR_Grammar* self, const LCHAR* filename);
+/**
+ * Adds the slot words saved by SR_GrammarSaveDelta() to a freshly loaded or reset grammar
+ * of the same image.
+ *
+ * @param self SR_Grammar handle
+ * @param filename File to read the delta from
+ * @return ESR_INVALID_ARGUMENT if self or filename are null; ESR_READ_ERROR if the delta could not be loaded
+ */
+SREC_GRAMMAR_API ESR_ReturnCode SR_GrammarLoadDelta(SR_Grammar* self, const LCHAR* filename);
 /**
  * Sets user dispatch function (used for parsed callback, etc)
  *
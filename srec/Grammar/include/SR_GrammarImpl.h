@@ -145,6 +145,14 @@ SREC_GRAMMAR_API ESR_ReturnCode SR_Grammar_AddWordToSlot(SR_Grammar* self, const
 /**
  * Default implementation.
  */
+SREC_GRAMMAR_API ESR_ReturnCode SR_Grammar_AddWordsToSlot(SR_Grammar* self, const LCHAR* slot,
+																													size_t count, const LCHAR** words,
+																													const LCHAR** pronunciations,
+																													const int* weights, const LCHAR** tags,
+																													ESR_ReturnCode* results);
+/**
+ * Default implementation.
+ */
 SREC_GRAMMAR_API ESR_ReturnCode SR_Grammar_ResetAllSlots(SR_Grammar* self);
 /**
  * Default implementation.
@@ -164,6 +172,8 @@ SREC_GRAMMAR_API ESR_ReturnCode SR_Grammar_Destroy(SR_Grammar* self);
  * Default implementation.
  */
 SREC_GRAMMAR_API ESR_ReturnCode SR_Grammar_Save(SR_Grammar* self, const LCHAR* filename);
+SREC_GRAMMAR_API ESR_ReturnCode SR_Grammar_SaveDelta(SR_Grammar* self, const LCHAR* filename);
+SREC_GRAMMAR_API ESR_ReturnCode SR_Grammar_LoadDelta(SR_Grammar* self, const LCHAR* filename);
 /**
  * Default implementation.
  */
@@ -48,6 +48,19 @@ ESR_ReturnCode SR_GrammarAddWordToSlot(SR_Grammar* self, const LCHAR* slot, cons
     }
 
 
+ESR_ReturnCode SR_GrammarAddWordsToSlot(SR_Grammar* self, const LCHAR* slot, size_t count,
+                                        const LCHAR** words, const LCHAR** pronunciations,
+                                        const int* weights, const LCHAR** tags,
+                                        ESR_ReturnCode* results)
+{
+  if (self == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT : Grammar Is Null"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  return self->addWordsToSlot(self, slot, count, words, pronunciations, weights, tags, results);
+}
+
 ESR_ReturnCode SR_GrammarResetAllSlots(SR_Grammar* self)
 {
   if (self == NULL)
@@ -89,6 +102,26 @@ ESR_ReturnCode SR_GrammarSave(SR_Grammar* self, const LCHAR* filename)
   return self->save(self, filename);
 }
 
+ESR_ReturnCode SR_GrammarSaveDelta(SR_Grammar* self, const LCHAR* filename)
+{
+  if (self == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  return self->saveDelta(self, filename);
+}
+
+ESR_ReturnCode SR_GrammarLoadDelta(SR_Grammar* self, const LCHAR* filename)
+{
+  if (self == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  return self->loadDelta(self, filename);
+}
+
 ESR_ReturnCode SR_GrammarSetParameter(SR_Grammar* self, const LCHAR* key, void* value)
 {
   if (self == NULL)
@@ -47,6 +47,7 @@ ESR_ReturnCode SR_Grammar_Create(SR_Grammar** self)
   
   impl->Interface.addNametagToSlot = &SR_Grammar_AddNametagToSlot;
   impl->Interface.addWordToSlot = &SR_Grammar_AddWordToSlot;
+  impl->Interface.addWordsToSlot = &SR_Grammar_AddWordsToSlot;
   impl->Interface.checkParse = &SR_Grammar_CheckParse;
   impl->Interface.compile = &SR_Grammar_Compile;
   impl->Interface.destroy = &SR_Grammar_Destroy;
@@ -54,6 +55,8 @@ ESR_ReturnCode SR_Grammar_Create(SR_Grammar** self)
   impl->Interface.getSize_tParameter = &SR_Grammar_GetSize_tParameter;
   impl->Interface.resetAllSlots = &SR_Grammar_ResetAllSlots;
   impl->Interface.save = &SR_Grammar_Save;
+  impl->Interface.saveDelta = &SR_Grammar_SaveDelta;
+  impl->Interface.loadDelta = &SR_Grammar_LoadDelta;
   impl->Interface.setDispatchFunction = &SR_Grammar_SetDispatchFunction;
   impl->Interface.setParameter = &SR_Grammar_SetParameter;
   impl->Interface.setSize_tParameter = &SR_Grammar_SetSize_tParameter;
@@ -137,6 +140,52 @@ ESR_ReturnCode SR_Grammar_Compile(SR_Grammar* self)
   return ESR_FATAL_ERROR;
 }
 
+/**
+ * Completes the addition of a word to a slot once it has been added to the syntax: on
+ * success, adds the word and its tag to the semantic graph, otherwise maps the syntax
+ * error to an ESR_ReturnCode.
+ */
+static ESR_ReturnCode SR_Grammar_AddWordToSemgraph(SR_GrammarImpl* impl, const LCHAR* slot,
+                                                   const LCHAR* word, const LCHAR* pronunciation,
+                                                   const LCHAR* tag, int ca_rc)
+{
+  ESR_ReturnCode rc = ESR_SUCCESS;
+  
+  switch (ca_rc)
+  {
+    case FST_SUCCESS:
+      /* successful, now add word & tag to semgraph */
+      CHKLOG(rc, impl->semgraph->addWordToSlot(impl->semgraph, slot, word, tag, 1));
+      break;
+    case FST_SUCCESS_ON_OLD_WORD:
+    case FST_FAILED_ON_HOMOGRAPH:
+      /* successful, now add word & tag to semgraph */
+      CHKLOG(rc, impl->semgraph->addWordToSlot(impl->semgraph, slot, word, tag, 0));
+      break;
+    case FST_FAILED_ON_MEMORY:
+      rc = ESR_OUT_OF_MEMORY;
+      PLogError(ESR_rc2str(rc));
+      break;
+    case FST_FAILED_ON_INVALID_ARGS:
+      rc = ESR_INVALID_ARGUMENT;
+      PLogError(ESR_rc2str(rc));
+      break;
+    case FST_FAILED_ON_HOMONYM:
+      rc = ESR_NOT_SUPPORTED;
+      /* remove this message from product */
+#if !defined(NDEBUG) || defined(_WIN32)
+      PLogError(L("%s: Homonym '%s' could not be added"), ESR_rc2str(rc), word);
+#endif
+      break;
+    default:
+      rc = ESR_INVALID_STATE;
+      PLogError(L("%s|%s|%s|ca_rc=%d"), word, pronunciation, ESR_rc2str(rc), ca_rc);
+      break;
+  }
+CLEANUP:
+  return rc;
+}
+
 /*
  * The buffer for the pron is set very large because the real size is lost later on
  * and all that is checked is whether a single phoneme will fit in the buffer. There
@@ -248,37 +297,9 @@ ESR_ReturnCode SR_Grammar_AddWordToSlot(SR_Grammar* self, const LCHAR* slot, con
    *                                                                                 else FST_FAILED
    */
   ca_rc = CA_AddWordToSyntax(impl->syntax, slot, word, pronunciation, weight);
-  switch (ca_rc)
-  {
-    case FST_SUCCESS:
-      /* successful, now add word & tag to semgraph */
-      CHKLOG(rc, impl->semgraph->addWordToSlot(impl->semgraph, slot, word, tag, 1));
-      break;
-    case FST_SUCCESS_ON_OLD_WORD:
-    case FST_FAILED_ON_HOMOGRAPH:
-      /* successful, now add word & tag to semgraph */
-      CHKLOG(rc, impl->semgraph->addWordToSlot(impl->semgraph, slot, word, tag, 0));
-      break;
-    case FST_FAILED_ON_MEMORY:
-      rc = ESR_OUT_OF_MEMORY;
-      PLogError(ESR_rc2str(rc));
-      goto CLEANUP;
-    case FST_FAILED_ON_INVALID_ARGS:
-      rc = ESR_INVALID_ARGUMENT;
-      PLogError(ESR_rc2str(rc));
-      goto CLEANUP;
-    case FST_FAILED_ON_HOMONYM:
-      rc = ESR_NOT_SUPPORTED;
-      /* remove this message from product */
-#if !defined(NDEBUG) || defined(_WIN32)
-      PLogError(L("%s: Homonym '%s' could not be added"), ESR_rc2str(rc), word);
-#endif
-      goto CLEANUP;
-    default:
-      rc = ESR_INVALID_STATE;
-      PLogError(L("%s|%s|%s|ca_rc=%d"), word, pronunciation, ESR_rc2str(rc), ca_rc);
-      goto CLEANUP;
-  }
+  rc = SR_Grammar_AddWordToSemgraph(impl, slot, word, pronunciation, tag, ca_rc);
+  if (rc != ESR_SUCCESS)
+    goto CLEANUP;
   
   if (impl->eventLog != NULL && (impl->logLevel & OSI_LOG_LEVEL_ADDWD))
   {
@@ -298,6 +319,184 @@ CLEANUP:
   return rc;
 }
 
+ESR_ReturnCode SR_Grammar_AddWordsToSlot(SR_Grammar* self, const LCHAR* slot, size_t count,
+                                         const LCHAR** words, const LCHAR** pronunciations,
+                                         const int* weights, const LCHAR** tags,
+                                         ESR_ReturnCode* results)
+{
+  SR_GrammarImpl* impl = (SR_GrammarImpl*) self;
+  SR_Vocabulary* vocab;
+  LCHAR buffer[4096];
+  size_t len;
+  LCHAR** prons = NULL;
+  const LCHAR** ca_words = NULL;
+  const LCHAR** ca_prons = NULL;
+  int* ca_weights = NULL;
+  int* ca_results = NULL;
+  size_t* ca_index = NULL;
+  size_t i, num_ca_words = 0;
+  const LCHAR* pronunciation;
+  const LCHAR* tag;
+  ESR_ReturnCode rc = ESR_SUCCESS, word_rc, logrc;
+  int ca_rc;
+
+  if (words == NULL || slot == NULL || strlen(slot) >= MAX_STRING_LEN)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  if (impl->vocabulary == NULL)
+  {
+    PLogError(L("ESR_INVALID_STATE"));
+    return ESR_INVALID_STATE;
+  }
+  if (count == 0)
+    return ESR_SUCCESS;
+  vocab = (SR_Vocabulary*) impl->vocabulary;
+
+  prons = NEW_ARRAY(LCHAR*, count, MTAG);
+  ca_words = NEW_ARRAY(const LCHAR*, count, MTAG);
+  ca_prons = NEW_ARRAY(const LCHAR*, count, MTAG);
+  ca_weights = NEW_ARRAY(int, count, MTAG);
+  ca_results = NEW_ARRAY(int, count, MTAG);
+  ca_index = NEW_ARRAY(size_t, count, MTAG);
+  if (prons == NULL || ca_words == NULL || ca_prons == NULL || ca_weights == NULL || ca_results == NULL || ca_index == NULL)
+  {
+    rc = ESR_OUT_OF_MEMORY;
+    PLogError(ESR_rc2str(rc));
+    goto CLEANUP;
+  }
+
+  /*
+   * Collect the words that can be added along with their pronunciations, as lists of
+   * null-terminated pronunciations ending with two consecutive null characters.
+   */
+  for (i = 0; i < count; ++i)
+  {
+    word_rc = ESR_SUCCESS;
+    pronunciation = pronunciations != NULL ? pronunciations[i] : NULL;
+
+    if (words[i] == NULL || strlen(words[i]) >= MAX_STRING_LEN ||
+        (pronunciation != NULL && strlen(pronunciation) >= MAX_STRING_LEN) ||
+        (tags != NULL && tags[i] != NULL && strlen(tags[i]) >= MAX_STRING_LEN))
+    {
+      PLogError(L("SR_Grammar_AddWordsToSlot word %u : invalid or too long : Max %d"), i, MAX_STRING_LEN - 1);
+      word_rc = ESR_INVALID_ARGUMENT;
+    }
+    else if (!pronunciation || !(*pronunciation) || !LSTRCMP(pronunciation, L("NULL")))
+    {
+      len = 4096;
+      word_rc = vocab->getPronunciation(vocab, words[i], buffer, &len);
+      if (word_rc == ESR_SUCCESS)
+      {
+        /* the list ends with two consecutive null characters */
+        for (len = 0; buffer[len] != L('\0'); len += LSTRLEN(buffer + len) + 1) ;
+        prons[i] = NEW_ARRAY(LCHAR, len + 1, MTAG);
+        if (prons[i] != NULL)
+          memcpy(prons[i], buffer, (len + 1) * sizeof(LCHAR));
+      }
+      else
+        PLogError(L("%s: no pronunciation for '%s'"), ESR_rc2str(word_rc), words[i]);
+    }
+    else
+    {
+      len = LSTRLEN(pronunciation);
+      prons[i] = NEW_ARRAY(LCHAR, len + 2, MTAG);
+      if (prons[i] != NULL)
+      {
+        LSTRCPY(prons[i], pronunciation);
+        prons[i][len + 1] = L('\0');
+      }
+    }
+    if (word_rc == ESR_SUCCESS && prons[i] == NULL)
+    {
+      rc = ESR_OUT_OF_MEMORY;
+      PLogError(ESR_rc2str(rc));
+      goto CLEANUP;
+    }
+
+    if (results != NULL)
+      results[i] = word_rc;
+    if (word_rc != ESR_SUCCESS)
+      continue;
+    ca_words[num_ca_words] = words[i];
+    ca_prons[num_ca_words] = prons[i];
+    ca_weights[num_ca_words] = weights != NULL ? weights[i] : 0;
+    ca_index[num_ca_words] = i;
+    ++num_ca_words;
+  }
+
+  if (num_ca_words > 0)
+  {
+    /* add all words to syntax at once, then each one to the semgraph */
+    ca_rc = CA_AddWordsToSyntax(impl->syntax, slot, (int) num_ca_words, ca_words, ca_prons,
+                                ca_weights, ca_results);
+    if (ca_rc < 0)
+    {
+      /* the batch failed as a whole, no word makes it into the semgraph, the
+         words added to the graph before a failure part-way through the batch
+         stay there until the slots are reset */
+      switch (ca_rc)
+      {
+        case FST_FAILED_ON_MEMORY:
+          rc = ESR_OUT_OF_MEMORY;
+          break;
+        case FST_FAILED_ON_INVALID_ARGS:
+          rc = ESR_INVALID_ARGUMENT;
+          break;
+        default:
+          rc = ESR_INVALID_STATE;
+          break;
+      }
+      PLogError(L("%s: could not add words to slot %s, ca_rc=%d"), ESR_rc2str(rc), slot, ca_rc);
+      for (i = 0; results != NULL && i < num_ca_words; ++i)
+        results[ca_index[i]] = rc;
+      goto CLEANUP;
+    }
+
+    for (i = 0; i < num_ca_words; ++i)
+    {
+      tag = tags != NULL && tags[ca_index[i]] != NULL && *tags[ca_index[i]] ? tags[ca_index[i]] : L(";");
+      word_rc = SR_Grammar_AddWordToSemgraph(impl, slot, ca_words[i], prons[ca_index[i]], tag, ca_results[i]);
+      if (results != NULL)
+        results[ca_index[i]] = word_rc;
+      if (word_rc == ESR_OUT_OF_MEMORY)
+        rc = word_rc;
+    }
+  }
+
+  if (impl->eventLog != NULL)
+  {
+    CHKLOG(logrc, SR_EventLogTokenPointer_BASIC(impl->eventLog, impl->logLevel, L("igrm"), impl));
+    CHKLOG(logrc, SR_EventLogToken_BASIC(impl->eventLog, impl->logLevel, L("SLOT"), slot));
+    CHKLOG(logrc, SR_EventLogTokenInt_BASIC(impl->eventLog, impl->logLevel, L("COUNT"), (int) count));
+    CHKLOG(logrc, SR_EventLogTokenInt_BASIC(impl->eventLog, impl->logLevel, L("ADDED"), (int) num_ca_words));
+    CHKLOG(logrc, SR_EventLogToken_BASIC(impl->eventLog, impl->logLevel, L("RSLT"), rc == ESR_SUCCESS ? L("ok") : L("err1")));
+    CHKLOG(logrc, SR_EventLogEvent_BASIC(impl->eventLog, impl->logLevel, L("ESRaddWds")));
+  }
+CLEANUP:
+  if (prons != NULL)
+  {
+    for (i = 0; i < count; ++i)
+    {
+      if (prons[i] != NULL)
+        FREE(prons[i]);
+    }
+    FREE(prons);
+  }
+  if (ca_words != NULL)
+    FREE(ca_words);
+  if (ca_prons != NULL)
+    FREE(ca_prons);
+  if (ca_weights != NULL)
+    FREE(ca_weights);
+  if (ca_results != NULL)
+    FREE(ca_results);
+  if (ca_index != NULL)
+    FREE(ca_index);
+  return rc;
+}
+
 ESR_ReturnCode SR_Grammar_ResetAllSlots(SR_Grammar* self)
 {
   ESR_ReturnCode rc, logrc;
@@ -482,6 +681,52 @@ ESR_ReturnCode SR_Grammar_Save(SR_Grammar* self, const LCHAR* filename)
   return ESR_SUCCESS;
 }
 
+ESR_ReturnCode SR_Grammar_SaveDelta(SR_Grammar* self, const LCHAR* filename)
+{
+  SR_GrammarImpl* impl = (SR_GrammarImpl*) self;
+
+  if (filename == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  if (CA_DumpSyntaxDelta(impl->syntax, filename)) /* returns 1 on failure */
+  {
+    PLogError(L("ESR_INVALID_STATE: could not save grammar delta %s"), filename);
+    return ESR_INVALID_STATE;
+  }
+  if (impl->semgraph->saveDelta(impl->semgraph, filename) != ESR_SUCCESS)
+  {
+    PLogError(L("ESR_INVALID_STATE: could not save semgraph delta %s"), filename);
+    return ESR_INVALID_STATE;
+  }
+  return ESR_SUCCESS;
+}
+
+ESR_ReturnCode SR_Grammar_LoadDelta(SR_Grammar* self, const LCHAR* filename)
+{
+  SR_GrammarImpl* impl = (SR_GrammarImpl*) self;
+
+  if (filename == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  if (CA_LoadSyntaxDelta(impl->syntax, filename)) /* resets the syntax on failure */
+  {
+    PLogError(L("ESR_READ_ERROR: could not load grammar delta %s"), filename);
+    return ESR_READ_ERROR;
+  }
+  if (impl->semgraph->loadDelta(impl->semgraph, filename) != ESR_SUCCESS)
+  {
+    PLogError(L("ESR_READ_ERROR: could not load semgraph delta %s"), filename);
+    impl->semgraph->reset(impl->semgraph);
+    CA_ResetSyntax(impl->syntax);
+    return ESR_READ_ERROR;
+  }
+  return ESR_SUCCESS;
+}
+
 ESR_ReturnCode SR_Grammar_SetParameter(SR_Grammar* self, const LCHAR* key, void* value)
 {
   /*TODO: complete with logging*/
@@ -29,6 +29,9 @@
 #include "SR_NametagDefs.h"
 #include "ESR_ReturnCode.h"
 
+/* SR_Recognizer.h includes this file */
+struct SR_Recognizer_t;
+
 
 /**
  * @addtogroup SR_NametagsModule SR_Nametags API functions
@@ -57,6 +60,14 @@ typedef struct SR_Nametags_t
    * @param filename File to write to
    */
   ESR_ReturnCode(*save)(struct SR_Nametags_t* self, const LCHAR* filename);
+
+  /**
+   * Appends the changes made since the last load or save to a nametag file.
+   *
+   * @param self Nametags handle
+   * @param filename File to append to
+   */
+  ESR_ReturnCode(*append)(struct SR_Nametags_t* self, const LCHAR* filename);
   
   /**
    * Adds nametag to collection.
@@ -66,6 +77,22 @@ typedef struct SR_Nametags_t
    */
   ESR_ReturnCode(*add)(struct SR_Nametags_t* self, SR_Nametag* nametag);
   
+  /**
+   * Enrolls a batch of recordings, one nametag per recording.
+   *
+   * @param self Nametags handle
+   * @param recognizer Recognizer with the voice-enrollment grammar active
+   * @param ids Nametag IDs
+   * @param samples Audio of each recording
+   * @param sampleCounts Number of samples of each recording
+   * @param count Number of recordings
+   * @param results Per recording return code, may be NULL
+   */
+  ESR_ReturnCode(*enroll)(struct SR_Nametags_t* self, struct SR_Recognizer_t* recognizer,
+                          const LCHAR** ids, asr_int16_t** samples,
+                          const size_t* sampleCounts, size_t count,
+                          ESR_ReturnCode* results);
+  
   /**
    * Removes nametag from collection.
    *
@@ -142,13 +169,27 @@ SREC_NAMETAG_API ESR_ReturnCode SR_NametagsCreate(SR_Nametags** self);
 SREC_NAMETAG_API ESR_ReturnCode SR_NametagsLoad(SR_Nametags* self, const LCHAR* filename);
 
 /**
- * Saves a nametag collection.
+ * Saves a nametag collection.  The file holds an index followed by the
+ * nametag values, so that loading it does not involve any parsing; files
+ * in the older text format are still accepted by SR_NametagsLoad().
  *
  * @param self Nametags handle
  * @param filename File to write to
  */
 SREC_NAMETAG_API ESR_ReturnCode SR_NametagsSave(SR_Nametags* self, const LCHAR* filename);
 
+/**
+ * Appends the nametags added and removed since the collection was last
+ * loaded or saved to the end of the file it was loaded from or saved to,
+ * rather than rewriting the whole file.  The file is rewritten as by
+ * SR_NametagsSave() instead if it is another file, if it is a text file,
+ * or if the appended changes would outgrow the nametags themselves.
+ *
+ * @param self Nametags handle
+ * @param filename File to append to
+ */
+SREC_NAMETAG_API ESR_ReturnCode SR_NametagsAppend(SR_Nametags* self, const LCHAR* filename);
+
 /**
  * Adds nametag to collection.
  *
@@ -157,6 +198,30 @@ SREC_NAMETAG_API ESR_ReturnCode SR_NametagsSave(SR_Nametags* self, const LCHAR*
  */
 SREC_NAMETAG_API ESR_ReturnCode SR_NametagsAdd(SR_Nametags* self, SR_Nametag* nametag);
 
+/**
+ * Enrolls a batch of recordings on one recognizer, adding a nametag for
+ * each recording that is recognized.  The frontend, models and grammar
+ * are set up once for the batch and the channel estimate of each recording
+ * carries over to the next, as with SR_RecognizerStart() and
+ * SR_RecognizerStop() on every recording in turn, but without the caller
+ * having to drive the recognizer.
+ *
+ * @param self Nametags handle
+ * @param recognizer Recognizer with the voice-enrollment grammar active
+ * @param ids Nametag IDs
+ * @param samples Audio of each recording
+ * @param sampleCounts Number of samples of each recording
+ * @param count Number of recordings
+ * @param results Per recording return code, ESR_NO_MATCH_ERROR if the
+ *                recording was not recognized; may be NULL
+ * @return ESR_SUCCESS if every recording was enrolled, otherwise the return
+ *         code of the first one that failed
+ */
+SREC_NAMETAG_API ESR_ReturnCode SR_NametagsEnroll(SR_Nametags* self, struct SR_Recognizer_t* recognizer,
+                                                  const LCHAR** ids, asr_int16_t** samples,
+                                                  const size_t* sampleCounts, size_t count,
+                                                  ESR_ReturnCode* results);
+
 /**
  * Removes nametag from collection.
  *
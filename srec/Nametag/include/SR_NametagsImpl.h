@@ -50,6 +50,24 @@ typedef struct SR_NametagsImpl_t
    * Eventlog logging level.
    */
   size_t logLevel;
+  /**
+   * IDs of the nametags added and removed since the last load or save, in
+   * order.
+   */
+  ArrayList* changes;
+  /**
+   * File the collection was last loaded from or saved to, empty if it was
+   * not a binary nametag file.
+   */
+  LCHAR path[P_PATH_MAX];
+  /**
+   * Size of the index and values written by the last save.
+   */
+  size_t compactSize;
+  /**
+   * Size of the changes appended to path since then.
+   */
+  size_t appendedSize;
 }
 SR_NametagsImpl;
 
@@ -62,10 +80,21 @@ SREC_NAMETAG_API ESR_ReturnCode SR_NametagsLoadImpl(SR_Nametags* self, const LCH
  * Default implementation.
  */
 SREC_NAMETAG_API ESR_ReturnCode SR_NametagsSaveImpl(SR_Nametags* self, const LCHAR* filename);
+/**
+ * Default implementation.
+ */
+SREC_NAMETAG_API ESR_ReturnCode SR_NametagsAppendImpl(SR_Nametags* self, const LCHAR* filename);
 /**
  * Default implementation.
  */
 SREC_NAMETAG_API ESR_ReturnCode SR_NametagsAddImpl(SR_Nametags* self, SR_Nametag* nametag);
+/**
+ * Default implementation.
+ */
+SREC_NAMETAG_API ESR_ReturnCode SR_NametagsEnrollImpl(SR_Nametags* self, SR_Recognizer* recognizer,
+                                                      const LCHAR** ids, asr_int16_t** samples,
+                                                      const size_t* sampleCounts, size_t count,
+                                                      ESR_ReturnCode* results);
 /**
  * Default implementation.
  */
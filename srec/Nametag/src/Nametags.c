@@ -40,6 +40,16 @@ ESR_ReturnCode SR_NametagsSave(SR_Nametags* self, const LCHAR* filename)
   return self->save(self, filename);
 }
 
+ESR_ReturnCode SR_NametagsAppend(SR_Nametags* self, const LCHAR* filename)
+{
+  if (self == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  return self->append(self, filename);
+}
+
 ESR_ReturnCode SR_NametagsAdd(SR_Nametags* self, SR_Nametag* nametag)
 {
   if (self == NULL)
@@ -50,6 +60,19 @@ ESR_ReturnCode SR_NametagsAdd(SR_Nametags* self, SR_Nametag* nametag)
   return self->add(self, nametag);
 }
 
+ESR_ReturnCode SR_NametagsEnroll(SR_Nametags* self, struct SR_Recognizer_t* recognizer,
+                                 const LCHAR** ids, asr_int16_t** samples,
+                                 const size_t* sampleCounts, size_t count,
+                                 ESR_ReturnCode* results)
+{
+  if (self == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  return self->enroll(self, recognizer, ids, samples, sampleCounts, count, results);
+}
+
 ESR_ReturnCode SR_NametagsRemove(SR_Nametags* self, const LCHAR* id)
 {
   if (self == NULL)
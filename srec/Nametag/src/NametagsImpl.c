@@ -27,6 +27,268 @@
 
 #define MTAG NULL
 
+/*
+ * Binary nametag file:
+ *
+ *   header   format, sizeof(LCHAR), number of nametags, size of the values
+ *   index    offset and size of the ID, offset and size of the value, per
+ *            nametag; offsets are relative to the start of the values
+ *   values   the IDs and values, each padded to a multiple of 4 bytes
+ *   changes  appended by SR_NametagsAppend(): an operation, the size of the
+ *            ID and the size of the value, followed by the padded ID and value
+ *
+ * All fields are 32-bit words, so the file can be used where it is read or
+ * mapped without copying it.
+ */
+#define NAMETAGS_FORMAT 0x4e544731 /* "NTG1" */
+#define NAMETAGS_FORMAT_SWAPPED 0x3147544e /* written on a host of the other byte order */
+#define NAMETAGS_HEADER_SIZE 4
+#define NAMETAGS_INDEX_SIZE 4
+#define NAMETAGS_CHANGE_SIZE 3
+#define NAMETAGS_ADD 1
+#define NAMETAGS_REMOVE 2
+#define NAMETAGS_PAD(n) (((n) + 3) & ~((size_t) 3))
+#define NAMETAGS_ENROLL_CHUNK 256 /* samples passed to the recognizer per advance */
+
+typedef struct
+{
+  ESR_BOOL removed;
+  LCHAR id[1];
+}
+NametagChange;
+
+static ESR_ReturnCode getNametagPath(const LCHAR* filename, LCHAR* path)
+{
+  size_t size = P_PATH_MAX;
+  ESR_ReturnCode rc;
+
+  if (filename == NULL)
+  {
+    rc = ESR_INVALID_STATE;
+    PLogError(ESR_rc2str(rc));
+    return rc;
+  }
+  CHKLOG(rc, ESR_SessionGetLCHAR(L("cmdline.nametagPath"), path, &size));
+  /* check if the filename has the path */
+  if (LSTRNCMP(filename, path, LSTRLEN(path)) != 0)
+    LSTRCAT(path, filename);
+  else
+    LSTRCPY(path, filename);
+  return ESR_SUCCESS;
+CLEANUP:
+  return rc;
+}
+
+static ESR_ReturnCode clearChanges(SR_NametagsImpl* impl)
+{
+  ArrayList* changes = impl->changes;
+  NametagChange* change;
+  size_t size, i;
+  ESR_ReturnCode rc;
+
+  CHKLOG(rc, changes->getSize(changes, &size));
+  for (i = 0; i < size; ++i)
+  {
+    CHKLOG(rc, changes->get(changes, i, (void **)&change));
+    FREE(change);
+  }
+  CHKLOG(rc, changes->removeAll(changes));
+  return ESR_SUCCESS;
+CLEANUP:
+  return rc;
+}
+
+static ESR_ReturnCode recordChange(SR_NametagsImpl* impl, const LCHAR* id, ESR_BOOL removed)
+{
+  NametagChange* change;
+  ESR_ReturnCode rc;
+
+  change = (NametagChange*) MALLOC(sizeof(NametagChange) + LSTRLEN(id) * sizeof(LCHAR), MTAG);
+  if (change == NULL)
+  {
+    PLogError(L("ESR_OUT_OF_MEMORY"));
+    return ESR_OUT_OF_MEMORY;
+  }
+  change->removed = removed;
+  LSTRCPY(change->id, id);
+  CHKLOG(rc, impl->changes->add(impl->changes, change));
+  return ESR_SUCCESS;
+CLEANUP:
+  FREE(change);
+  return rc;
+}
+
+static ESR_ReturnCode flushNametags(HashMap* nametags, size_t* count)
+{
+  SR_Nametag* nametag;
+  size_t i;
+  ESR_ReturnCode rc;
+
+  CHKLOG(rc, nametags->getSize(nametags, count));
+  for (i = 0; i < *count; ++i)
+  {
+    CHKLOG(rc, nametags->getValueAtIndex(nametags, 0, (void **)&nametag));
+    CHKLOG(rc, nametags->removeAtIndex(nametags, 0));
+    CHKLOG(rc, nametag->destroy(nametag));
+  }
+  return ESR_SUCCESS;
+CLEANUP:
+  return rc;
+}
+
+/* replaces the nametag filed under id, if any */
+static ESR_ReturnCode putNametag(HashMap* nametags, const LCHAR* id, const char* value, size_t len)
+{
+  SR_Nametag* nametag = NULL;
+  SR_Nametag* oldNametag;
+  ESR_BOOL exists;
+  ESR_ReturnCode rc;
+
+  CHKLOG(rc, SR_NametagCreateFromValue(id, value, len, &nametag));
+  CHKLOG(rc, nametags->containsKey(nametags, id, &exists));
+  if (exists)
+  {
+    CHKLOG(rc, nametags->get(nametags, id, (void **)&oldNametag));
+    CHKLOG(rc, nametags->remove(nametags, id));
+    oldNametag->destroy(oldNametag);
+  }
+  CHKLOG(rc, nametags->put(nametags, id, nametag));
+  return ESR_SUCCESS;
+CLEANUP:
+  if (nametag != NULL)
+    nametag->destroy(nametag);
+  return rc;
+}
+
+static ESR_ReturnCode removeNametag(HashMap* nametags, const LCHAR* id)
+{
+  SR_Nametag* nametag;
+  ESR_BOOL exists;
+  ESR_ReturnCode rc;
+
+  CHKLOG(rc, nametags->containsKey(nametags, id, &exists));
+  if (!exists)
+    return ESR_SUCCESS;
+  CHKLOG(rc, nametags->get(nametags, id, (void **)&nametag));
+  CHKLOG(rc, nametags->remove(nametags, id));
+  nametag->destroy(nametag);
+  return ESR_SUCCESS;
+CLEANUP:
+  return rc;
+}
+
+/* checks that an ID of len bytes at offset fits in size bytes and is terminated */
+static ESR_BOOL isValidID(const char* data, size_t size, size_t offset, size_t len)
+{
+  if (len < sizeof(LCHAR) || len % sizeof(LCHAR) != 0 || offset > size || len > size - offset)
+    return ESR_FALSE;
+  return ((const LCHAR*)(data + offset))[len / sizeof(LCHAR) - 1] == L('\0');
+}
+
+static ESR_ReturnCode loadBinary(SR_NametagsImpl* impl, const char* buffer, size_t size,
+                                 const LCHAR* path)
+{
+  HashMap* nametags = impl->value;
+  const asr_uint32_t* header = (const asr_uint32_t*) buffer;
+  const asr_uint32_t* index;
+  const asr_uint32_t* change;
+  const char* data;
+  size_t count, dataSize, pos, idLen, valueLen, i;
+  ESR_ReturnCode rc;
+
+  pos = NAMETAGS_HEADER_SIZE * sizeof(asr_uint32_t);
+  if (size < pos || header[1] != sizeof(LCHAR))
+  {
+    rc = ESR_INVALID_STATE;
+    PLogError(L("%s: %s is not a nametag file of this build"), ESR_rc2str(rc), path);
+    return rc;
+  }
+  count = header[2];
+  dataSize = header[3];
+  index = header + NAMETAGS_HEADER_SIZE;
+  if (count > (size - pos) / (NAMETAGS_INDEX_SIZE * sizeof(asr_uint32_t)))
+    goto READ_ERROR;
+  pos += count * NAMETAGS_INDEX_SIZE * sizeof(asr_uint32_t);
+  if (dataSize > size - pos)
+    goto READ_ERROR;
+  data = buffer + pos;
+
+  for (i = 0; i < count; ++i, index += NAMETAGS_INDEX_SIZE)
+  {
+    if (!isValidID(data, dataSize, index[0], index[1]) ||
+        index[2] > dataSize || index[3] > dataSize - index[2])
+      goto READ_ERROR;
+    CHKLOG(rc, putNametag(nametags, (const LCHAR*)(data + index[0]), data + index[2], index[3]));
+  }
+  pos += dataSize;
+  impl->compactSize = pos;
+
+  /* replay the changes appended since; a change cut short by a failed append,
+     or one with an unknown operation, is dropped along with everything after
+     it */
+  while (size - pos >= NAMETAGS_CHANGE_SIZE * sizeof(asr_uint32_t))
+  {
+    change = (const asr_uint32_t*)(buffer + pos);
+    idLen = change[1];
+    valueLen = change[2];
+    pos += NAMETAGS_CHANGE_SIZE * sizeof(asr_uint32_t);
+    if ((change[0] != NAMETAGS_ADD && change[0] != NAMETAGS_REMOVE) ||
+        !isValidID(buffer, size, pos, idLen) || NAMETAGS_PAD(idLen) > size - pos ||
+        valueLen > size - pos - NAMETAGS_PAD(idLen) ||
+        NAMETAGS_PAD(valueLen) > size - pos - NAMETAGS_PAD(idLen))
+    {
+      pos -= NAMETAGS_CHANGE_SIZE * sizeof(asr_uint32_t);
+      break;
+    }
+    if (change[0] == NAMETAGS_ADD)
+      CHKLOG(rc, putNametag(nametags, (const LCHAR*)(buffer + pos), buffer + pos + NAMETAGS_PAD(idLen), valueLen));
+    else if (change[0] == NAMETAGS_REMOVE)
+      CHKLOG(rc, removeNametag(nametags, (const LCHAR*)(buffer + pos)));
+    pos += NAMETAGS_PAD(idLen) + NAMETAGS_PAD(valueLen);
+  }
+  impl->appendedSize = pos - impl->compactSize;
+  if (pos != size)
+  {
+    /* leave path empty, so that the next append rewrites the file rather
+       than adding changes behind the ones dropped here */
+    PLogError(L("%s: ignoring truncated changes at the end of %s"), ESR_rc2str(ESR_READ_ERROR), path);
+  }
+  else
+    LSTRCPY(impl->path, path);
+  return ESR_SUCCESS;
+READ_ERROR:
+  rc = ESR_READ_ERROR;
+  PLogError(L("%s: %s"), ESR_rc2str(rc), path);
+CLEANUP:
+  return rc;
+}
+
+/* writes len bytes followed by the padding up to the next 32-bit word */
+static ESR_BOOL writePadded(PFile* file, const void* data, size_t len)
+{
+  static const char padding[sizeof(asr_uint32_t)] = { 0 };
+  size_t padLen = NAMETAGS_PAD(len) - len;
+
+  if (len > 0 && pfwrite(data, 1, len, file) != len)
+    return ESR_FALSE;
+  return padLen == 0 || pfwrite(padding, 1, padLen, file) == padLen;
+}
+
+static ESR_BOOL writeChange(PFile* file, asr_uint32_t op, const LCHAR* id, const char* value,
+                            size_t valueLen, size_t* written)
+{
+  asr_uint32_t change[NAMETAGS_CHANGE_SIZE];
+
+  change[0] = op;
+  change[1] = (asr_uint32_t)((LSTRLEN(id) + 1) * sizeof(LCHAR));
+  change[2] = (asr_uint32_t) valueLen;
+  if (pfwrite(change, sizeof(change[0]), NAMETAGS_CHANGE_SIZE, file) != NAMETAGS_CHANGE_SIZE ||
+      !writePadded(file, id, change[1]) || !writePadded(file, value, valueLen))
+    return ESR_FALSE;
+  *written += sizeof(change) + NAMETAGS_PAD(change[1]) + NAMETAGS_PAD(valueLen);
+  return ESR_TRUE;
+}
+
 ESR_ReturnCode SR_NametagsCreate(SR_Nametags** self)
 {
   SR_NametagsImpl* impl;
@@ -46,7 +308,9 @@ ESR_ReturnCode SR_NametagsCreate(SR_Nametags** self)
 
   impl->Interface.load = &SR_NametagsLoadImpl;
   impl->Interface.save = &SR_NametagsSaveImpl;
+  impl->Interface.append = &SR_NametagsAppendImpl;
   impl->Interface.add = &SR_NametagsAddImpl;
+  impl->Interface.enroll = &SR_NametagsEnrollImpl;
   impl->Interface.remove = &SR_NametagsRemoveImpl;
   impl->Interface.getSize = &SR_NametagsGetSizeImpl;
   impl->Interface.get = &SR_NametagsGetImpl;
@@ -55,8 +319,13 @@ ESR_ReturnCode SR_NametagsCreate(SR_Nametags** self)
   impl->Interface.destroy = &SR_NametagsDestroyImpl;
   impl->value = NULL;
   impl->eventLog = NULL;
+  impl->changes = NULL;
+  impl->path[0] = L('\0');
+  impl->compactSize = 0;
+  impl->appendedSize = 0;
 
   CHKLOG(rc, HashMapCreate(&impl->value));
+  CHKLOG(rc, ArrayListCreate(&impl->changes));
   CHKLOG(rc, ESR_SessionGetSize_t(L("SREC.Recognizer.osi_log_level"), &impl->logLevel));
   if (impl->logLevel > 0)
     CHKLOG(rc, ESR_SessionGetProperty(L("eventlog"), (void **)&impl->eventLog, TYPES_SR_EVENTLOG));
@@ -79,30 +348,20 @@ ESR_ReturnCode SR_NametagsLoadImpl(SR_Nametags* self, const LCHAR* filename)
   LCHAR* id;
   LCHAR* value;
   SR_Nametag* newNametag = NULL;
-  SR_Nametag* oldNametag;
   HashMap* nametags = impl->value;
-  size_t size, len, i;
+  size_t size, len;
   LCHAR devicePath[P_PATH_MAX];
+  asr_uint32_t format = 0;
+  char* buffer = NULL;
+  long fileSize;
   LCHAR number[MAX_UINT_DIGITS+1];
 #define NAMETAGID_LENGTH 20
   /* strlen("token\0") == 6 */
 #define TOKEN_LENGTH 6 + NAMETAGID_LENGTH
   LCHAR tokenName[TOKEN_LENGTH];
 
-  if (filename == NULL)
-  {
-    rc = ESR_INVALID_STATE;
-    PLogError(ESR_rc2str(rc));
-    goto CLEANUP;
-  }
-  size = P_PATH_MAX;
-  CHKLOG(rc, ESR_SessionGetLCHAR(L("cmdline.nametagPath"), devicePath, &size));
-  /* check if the filename has the path */
-  if (LSTRNCMP(filename, devicePath, LSTRLEN(devicePath)) != 0)
-    LSTRCAT(devicePath, filename);
-  else
-    LSTRCPY(devicePath, filename);
-  file = pfopen ( devicePath, L("r"));
+  CHKLOG(rc, getNametagPath(filename, devicePath));
+  file = pfopen ( devicePath, L("rb"));
 /*  CHKLOG(rc, PFileSystemCreatePFile(devicePath, ESR_TRUE, &file));
   CHKLOG(rc, file->open(file, L("r")));*/
 
@@ -110,18 +369,48 @@ ESR_ReturnCode SR_NametagsLoadImpl(SR_Nametags* self, const LCHAR* filename)
     goto CLEANUP;
 
   /* Flush collection */
-  CHKLOG(rc, nametags->getSize(nametags, &size));
-  for (i = 0; i < size; ++i)
-  {
-    CHKLOG(rc, nametags->getValueAtIndex(nametags, 0, (void **)&oldNametag));
-    CHKLOG(rc, nametags->removeAtIndex(nametags, 0));
-    CHKLOG(rc, oldNametag->destroy(oldNametag));
-  }
+  CHKLOG(rc, flushNametags(nametags, &size));
+  CHKLOG(rc, clearChanges(impl));
+  impl->path[0] = L('\0');
   len = MAX_UINT_DIGITS + 1;
   CHKLOG(rc, lultostr(size, number, &len, 10));
   CHKLOG(rc, SR_EventLogToken_BASIC(impl->eventLog, impl->logLevel, L("removeCount"), number));
 
-  while (ESR_TRUE)
+  /* binary files are read in one go; anything else is the text format */
+  pfseek(file, 0, SEEK_END);
+  fileSize = pftell(file);
+  pfseek(file, 0, SEEK_SET);
+  if (fileSize >= (long) sizeof(format) && pfread(&format, sizeof(format), 1, file) == 1 &&
+      format == NAMETAGS_FORMAT)
+  {
+    buffer = (char*) MALLOC(fileSize, MTAG);
+    if (buffer == NULL)
+    {
+      rc = ESR_OUT_OF_MEMORY;
+      PLogError(ESR_rc2str(rc));
+      goto CLEANUP;
+    }
+    pfseek(file, 0, SEEK_SET);
+    if (pfread(buffer, 1, fileSize, file) != (size_t) fileSize)
+    {
+      rc = ESR_READ_ERROR;
+      PLogError(L("%s: %s"), ESR_rc2str(rc), devicePath);
+      goto CLEANUP;
+    }
+    CHKLOG(rc, loadBinary(impl, buffer, fileSize, devicePath));
+    FREE(buffer);
+    buffer = NULL;
+  }
+  else if (format == NAMETAGS_FORMAT_SWAPPED)
+  {
+    rc = ESR_INVALID_STATE;
+    PLogError(L("%s: %s is not a nametag file of this build"), ESR_rc2str(rc), devicePath);
+    goto CLEANUP;
+  }
+  else
+    pfseek(file, 0, SEEK_SET);
+
+  while (format != NAMETAGS_FORMAT)
   {
     result = pfgets ( line, 256, file );
     if (result == NULL)
@@ -184,6 +473,8 @@ ESR_ReturnCode SR_NametagsLoadImpl(SR_Nametags* self, const LCHAR* filename)
 CLEANUP:
   if (file != NULL)
     pfclose (file);
+  if (buffer != NULL)
+    FREE(buffer);
   if (newNametag != NULL)
     newNametag->destroy(newNametag);
   return rc;
@@ -198,58 +489,66 @@ ESR_ReturnCode SR_NametagsSaveImpl(SR_Nametags* self, const LCHAR* filename)
   HashMap* nametags = impl->value;
   SR_NametagImpl* nametag;
   LCHAR* id;
-  size_t len;
+  size_t len, dataSize;
   LCHAR devicePath[P_PATH_MAX];
-#define NAMETAG_LENGTH 200
-  LCHAR nametagBuffer[NAMETAG_LENGTH];
+  asr_uint32_t header[NAMETAGS_HEADER_SIZE];
+  asr_uint32_t index[NAMETAGS_INDEX_SIZE];
   LCHAR number[MAX_UINT_DIGITS+1];
 #define NAMETAGID_LENGTH 20
   /* "token\0" == 6 */
 #define TOKEN_LENGTH 6 + NAMETAGID_LENGTH
   LCHAR tokenName[TOKEN_LENGTH];
-  size_t num_written;
 
-  if (filename == NULL)
-  {
-    rc = ESR_INVALID_STATE;
-    PLogError(ESR_rc2str(rc));
-    goto CLEANUP;
-  }
-  size = P_PATH_MAX;
-  CHKLOG(rc, ESR_SessionGetLCHAR(L("cmdline.nametagPath"), devicePath, &size));
-
-  if (LSTRNCMP(filename, devicePath, LSTRLEN(devicePath)) != 0)
-    LSTRCAT(devicePath, filename);
-  else
-    LSTRCPY(devicePath, filename);
-
-  file = pfopen ( devicePath, L("w"));
+  CHKLOG(rc, getNametagPath(filename, devicePath));
+  file = pfopen ( devicePath, L("wb"));
 /*  CHKLOG(rc, PFileSystemCreatePFile(devicePath, ESR_TRUE, &file));
   CHKLOG(rc, file->open(file, L("w")));*/
-  CHKLOG(rc, nametags->getSize(nametags, &size));
-
   if ( file == NULL )
+  {
+    rc = ESR_OPEN_ERROR;
+    PLogError(L("%s: %s"), ESR_rc2str(rc), devicePath);
     goto CLEANUP;
+  }
+  impl->path[0] = L('\0');
+  CHKLOG(rc, nametags->getSize(nametags, &size));
 
+  /* the index comes first, so the size of the values is needed up front */
+  dataSize = 0;
   for (i = 0; i < size; ++i)
   {
     CHKLOG(rc, nametags->getValueAtIndex(nametags, i, (void **)&nametag));
-
     CHKLOG(rc, nametag->Interface.getID(&nametag->Interface, &id));
+    dataSize += NAMETAGS_PAD((LSTRLEN(id) + 1) * sizeof(LCHAR)) + NAMETAGS_PAD(nametag->value_len);
+  }
+  header[0] = NAMETAGS_FORMAT;
+  header[1] = sizeof(LCHAR);
+  header[2] = (asr_uint32_t) size;
+  header[3] = (asr_uint32_t) dataSize;
+  if (pfwrite(header, sizeof(header[0]), NAMETAGS_HEADER_SIZE, file) != NAMETAGS_HEADER_SIZE)
+    goto WRITE_ERROR;
+
+  dataSize = 0;
+  for (i = 0; i < size; ++i)
+  {
+    CHKLOG(rc, nametags->getValueAtIndex(nametags, i, (void **)&nametag));
+    CHKLOG(rc, nametag->Interface.getID(&nametag->Interface, &id));
+    index[0] = (asr_uint32_t) dataSize;
+    index[1] = (asr_uint32_t)((LSTRLEN(id) + 1) * sizeof(LCHAR));
+    dataSize += NAMETAGS_PAD(index[1]);
+    index[2] = (asr_uint32_t) dataSize;
+    index[3] = (asr_uint32_t) nametag->value_len;
+    dataSize += NAMETAGS_PAD(index[3]);
+    if (pfwrite(index, sizeof(index[0]), NAMETAGS_INDEX_SIZE, file) != NAMETAGS_INDEX_SIZE)
+      goto WRITE_ERROR;
+  }
 
-    if (LSTRLEN(id) + 1 + LSTRLEN(nametag->value) + 2 >= NAMETAG_LENGTH)
-    {
-      rc = ESR_BUFFER_OVERFLOW;
-      PLogError(ESR_rc2str(rc));
-      goto CLEANUP;
-    }
-    psprintf(nametagBuffer, L("%s %s\n"), id, nametag->value);
-    len = LSTRLEN(nametagBuffer);
-/*    CHKLOG(rc, file->write(file, nametagBuffer, sizeof(LCHAR), &len));*/
-    num_written = pfwrite ( nametagBuffer, sizeof ( LCHAR ), len, file );
-
-    if ( num_written != len )
-        goto CLEANUP;
+  for (i = 0; i < size; ++i)
+  {
+    CHKLOG(rc, nametags->getValueAtIndex(nametags, i, (void **)&nametag));
+    CHKLOG(rc, nametag->Interface.getID(&nametag->Interface, &id));
+    if (!writePadded(file, id, (LSTRLEN(id) + 1) * sizeof(LCHAR)) ||
+        !writePadded(file, nametag->value, nametag->value_len))
+      goto WRITE_ERROR;
 
     if (LSTRLEN(id) > NAMETAGID_LENGTH)
     {
@@ -260,13 +559,110 @@ ESR_ReturnCode SR_NametagsSaveImpl(SR_Nametags* self, const LCHAR* filename)
     psprintf(tokenName, L("nametag[%s]"), id);
     CHKLOG(rc, SR_EventLogToken_BASIC(impl->eventLog, impl->logLevel, tokenName, nametag->value));
   }
+  pfclose (file);
+  file = NULL;
+  impl->compactSize = (NAMETAGS_HEADER_SIZE + size * NAMETAGS_INDEX_SIZE) * sizeof(asr_uint32_t) + dataSize;
+  impl->appendedSize = 0;
+  LSTRCPY(impl->path, devicePath);
+  CHKLOG(rc, clearChanges(impl));
+
   CHKLOG(rc, SR_EventLogToken_BASIC(impl->eventLog, impl->logLevel, L("filename"), filename));
   len = MAX_UINT_DIGITS + 1;
   CHKLOG(rc, lultostr(size, (LCHAR*) &number, &len, 10));
   CHKLOG(rc, SR_EventLogToken_BASIC(impl->eventLog, impl->logLevel, L("saveCount"), number));
   CHKLOG(rc, SR_EventLogEvent_BASIC(impl->eventLog, impl->logLevel, L("SR_NametagsSave")));
-  pfclose (file);
   return ESR_SUCCESS;
+WRITE_ERROR:
+  rc = ESR_WRITE_ERROR;
+  PLogError(L("%s: %s"), ESR_rc2str(rc), devicePath);
+CLEANUP:
+  if (file != NULL)
+    pfclose (file);
+  return rc;
+}
+
+ESR_ReturnCode SR_NametagsAppendImpl(SR_Nametags* self, const LCHAR* filename)
+{
+  SR_NametagsImpl* impl = (SR_NametagsImpl*) self;
+  ESR_ReturnCode rc;
+  PFile* file = NULL;
+  HashMap* nametags = impl->value;
+  ArrayList* changes = impl->changes;
+  NametagChange* change;
+  SR_NametagImpl* nametag;
+  ESR_BOOL exists;
+  size_t size, i, len, written = 0;
+  LCHAR devicePath[P_PATH_MAX];
+  LCHAR number[MAX_UINT_DIGITS+1];
+
+  CHKLOG(rc, getNametagPath(filename, devicePath));
+  CHKLOG(rc, changes->getSize(changes, &size));
+
+  len = 0;
+  for (i = 0; i < size; ++i)
+  {
+    CHKLOG(rc, changes->get(changes, i, (void **)&change));
+    len += NAMETAGS_CHANGE_SIZE * sizeof(asr_uint32_t) + NAMETAGS_PAD((LSTRLEN(change->id) + 1) * sizeof(LCHAR));
+    if (change->removed)
+      continue;
+    CHKLOG(rc, nametags->containsKey(nametags, change->id, &exists));
+    if (!exists)
+      continue;
+    CHKLOG(rc, nametags->get(nametags, change->id, (void **)&nametag));
+    len += NAMETAGS_PAD(nametag->value_len);
+  }
+  /* compact the file once the changes take more room than the nametags */
+  if (impl->path[0] == L('\0') || LSTRCMP(impl->path, devicePath) != 0 ||
+      impl->appendedSize + len > impl->compactSize)
+    return self->save(self, filename);
+  if (size == 0)
+    return ESR_SUCCESS;
+
+  file = pfopen ( devicePath, L("ab"));
+  if ( file == NULL )
+  {
+    rc = ESR_OPEN_ERROR;
+    PLogError(L("%s: %s"), ESR_rc2str(rc), devicePath);
+    goto CLEANUP;
+  }
+  /* until the changes are all written, the file can only be rewritten */
+  impl->path[0] = L('\0');
+  for (i = 0; i < size; ++i)
+  {
+    CHKLOG(rc, changes->get(changes, i, (void **)&change));
+    if (change->removed)
+    {
+      if (!writeChange(file, NAMETAGS_REMOVE, change->id, NULL, 0, &written))
+        goto WRITE_ERROR;
+      continue;
+    }
+    /* a nametag that is gone again has its removal further down */
+    CHKLOG(rc, nametags->containsKey(nametags, change->id, &exists));
+    if (!exists)
+      continue;
+    CHKLOG(rc, nametags->get(nametags, change->id, (void **)&nametag));
+    if (!writeChange(file, NAMETAGS_ADD, change->id, nametag->value, nametag->value_len, &written))
+      goto WRITE_ERROR;
+  }
+  if (pfclose (file) != 0)
+  {
+    file = NULL;
+    goto WRITE_ERROR;
+  }
+  file = NULL;
+  impl->appendedSize += written;
+  LSTRCPY(impl->path, devicePath);
+  CHKLOG(rc, clearChanges(impl));
+
+  CHKLOG(rc, SR_EventLogToken_BASIC(impl->eventLog, impl->logLevel, L("filename"), filename));
+  len = MAX_UINT_DIGITS + 1;
+  CHKLOG(rc, lultostr(size, (LCHAR*) &number, &len, 10));
+  CHKLOG(rc, SR_EventLogToken_BASIC(impl->eventLog, impl->logLevel, L("appendCount"), number));
+  CHKLOG(rc, SR_EventLogEvent_BASIC(impl->eventLog, impl->logLevel, L("SR_NametagsAppend")));
+  return ESR_SUCCESS;
+WRITE_ERROR:
+  rc = ESR_WRITE_ERROR;
+  PLogError(L("%s: %s"), ESR_rc2str(rc), devicePath);
 CLEANUP:
   if (file != NULL)
     pfclose (file);
@@ -294,6 +690,7 @@ ESR_ReturnCode SR_NametagsAddImpl(SR_Nametags* self, SR_Nametag* nametag)
     goto CLEANUP;
   }
   CHKLOG(rc, nametags->put(nametags, id, nametag));
+  CHKLOG(rc, recordChange(impl, id, ESR_FALSE));
 
   CHKLOG(rc, SR_EventLogToken_BASIC(impl->eventLog, impl->logLevel, L("id"), id));
   CHKLOG(rc, SR_EventLogEvent_BASIC(impl->eventLog, impl->logLevel, L("SR_NametagsAdd")));
@@ -302,6 +699,112 @@ CLEANUP:
   return rc;
 }
 
+/**
+ * Runs one recording through the recognizer and adds its nametag.
+ */
+static ESR_ReturnCode enrollRecording(SR_Nametags* self, SR_Recognizer* recognizer,
+                                      const LCHAR* id, asr_int16_t* samples, size_t sampleCount)
+{
+  SR_RecognizerStatus status = SR_RECOGNIZER_EVENT_INVALID;
+  SR_RecognizerResultType type = SR_RECOGNIZER_RESULT_TYPE_INVALID;
+  SR_RecognizerResult* result = NULL;
+  SR_Nametag* nametag = NULL;
+  ESR_BOOL isLast = ESR_FALSE;
+  size_t offset = 0, len;
+  ESR_ReturnCode rc, stopRc;
+
+  CHKLOG(rc, recognizer->start(recognizer));
+  do
+  {
+    len = sampleCount - offset;
+    if (len > NAMETAGS_ENROLL_CHUNK)
+      len = NAMETAGS_ENROLL_CHUNK;
+    isLast = offset + len == sampleCount;
+    rc = recognizer->putAudio(recognizer, samples + offset, &len, isLast);
+    if (rc == ESR_BUFFER_OVERFLOW)
+      isLast = ESR_FALSE; /* len holds what was taken, the rest goes after the advance */
+    else if (rc != ESR_SUCCESS)
+    {
+      PLogError(ESR_rc2str(rc));
+      goto STOP;
+    }
+    offset += len;
+    do
+    {
+      rc = recognizer->advance(recognizer, &status, &type, &result);
+      if (rc != ESR_SUCCESS)
+      {
+        PLogError(ESR_rc2str(rc));
+        goto STOP;
+      }
+    }
+    while (status == SR_RECOGNIZER_EVENT_INCOMPLETE);
+  }
+  while (!isLast && type != SR_RECOGNIZER_RESULT_TYPE_COMPLETE);
+  while (type != SR_RECOGNIZER_RESULT_TYPE_COMPLETE)
+  {
+    rc = recognizer->advance(recognizer, &status, &type, &result);
+    if (rc != ESR_SUCCESS)
+    {
+      PLogError(ESR_rc2str(rc));
+      goto STOP;
+    }
+  }
+
+  /* the result belongs to the recognizer until it is stopped */
+  if (status == SR_RECOGNIZER_EVENT_RECOGNITION_RESULT)
+  {
+    rc = SR_NametagCreate(result, id, &nametag);
+    if (rc == ESR_SUCCESS)
+    {
+      rc = self->add(self, nametag);
+      if (rc == ESR_SUCCESS)
+        nametag = NULL;
+    }
+  }
+  else
+    rc = ESR_NO_MATCH_ERROR;
+STOP:
+  if (nametag != NULL)
+    nametag->destroy(nametag);
+  stopRc = recognizer->stop(recognizer);
+  if (rc == ESR_SUCCESS)
+    rc = stopRc;
+  return rc;
+CLEANUP:
+  return rc;
+}
+
+ESR_ReturnCode SR_NametagsEnrollImpl(SR_Nametags* self, SR_Recognizer* recognizer,
+                                     const LCHAR** ids, asr_int16_t** samples,
+                                     const size_t* sampleCounts, size_t count,
+                                     ESR_ReturnCode* results)
+{
+  SR_NametagsImpl* impl = (SR_NametagsImpl*) self;
+  ESR_ReturnCode rc = ESR_SUCCESS, recordingRc;
+  size_t i;
+
+  if (recognizer == NULL || (count > 0 && (ids == NULL || samples == NULL || sampleCounts == NULL)))
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  /* the recognizer keeps its frontend, models, grammar and channel estimate
+     from one recording to the next, only the search is started over */
+  for (i = 0; i < count; ++i)
+  {
+    recordingRc = enrollRecording(self, recognizer, ids[i], samples[i], sampleCounts[i]);
+    if (results != NULL)
+      results[i] = recordingRc;
+    if (recordingRc != ESR_SUCCESS && rc == ESR_SUCCESS)
+      rc = recordingRc;
+  }
+  SR_EventLogTokenInt_BASIC(impl->eventLog, impl->logLevel, L("count"), (int) count);
+  SR_EventLogToken_BASIC(impl->eventLog, impl->logLevel, L("rc"), ESR_rc2str(rc));
+  SR_EventLogEvent_BASIC(impl->eventLog, impl->logLevel, L("SR_NametagsEnroll"));
+  return rc;
+}
+
 ESR_ReturnCode SR_NametagsRemoveImpl(SR_Nametags* self, const LCHAR* id)
 {
   SR_NametagsImpl* impl = (SR_NametagsImpl*) self;
@@ -309,6 +812,7 @@ ESR_ReturnCode SR_NametagsRemoveImpl(SR_Nametags* self, const LCHAR* id)
   ESR_ReturnCode rc;
 
   CHKLOG(rc, nametags->remove(nametags, id));
+  CHKLOG(rc, recordChange(impl, id, ESR_TRUE));
 
   CHKLOG(rc, SR_EventLogToken_BASIC(impl->eventLog, impl->logLevel, L("id"), id));
   CHKLOG(rc, SR_EventLogEvent_BASIC(impl->eventLog, impl->logLevel, L("SR_NametagsRemove")));
@@ -400,6 +904,12 @@ ESR_ReturnCode SR_NametagsDestroyImpl(SR_Nametags* self)
     list->destroy(list);
     impl->value = NULL;
   }
+  if (impl->changes != NULL)
+  {
+    CHKLOG(rc, clearChanges(impl));
+    impl->changes->destroy(impl->changes);
+    impl->changes = NULL;
+  }
   CHKLOG(rc, SR_EventLogTokenPointer_BASIC(impl->eventLog, impl->logLevel, L("pointer"), self));
   CHKLOG(rc, SR_EventLogEvent_BASIC(impl->eventLog, impl->logLevel, L("SR_NametagsDestroy")));
   impl->eventLog = NULL;
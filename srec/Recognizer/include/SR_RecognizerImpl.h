@@ -27,7 +27,9 @@
 #include "ESR_ReturnCode.h"
 #include "ESR_SessionType.h"
 #include "HashMap.h"
+#include "parena.h"
 #include "SR_AcousticState.h"
+#include "SR_AcousticStateStore.h"
 #include "SR_Recognizer.h"
 #include "SR_EventLog.h"
 #include "ptimestamp.h"
@@ -101,6 +103,11 @@ typedef enum
 #define DEFAULT_BOS_COMFORT_FRAMES              2
 #define DEFAULT_EOS_COMFORT_FRAMES              2
 
+/**
+ * Number of choices computed for a voice enrollment (SREC.voice_enroll.nbest)
+ **/
+#define DEFAULT_VOICE_ENROLL_NBEST              1
+
 typedef enum
 {
   WAVEFORM_BUFFERING_OFF,             /* no buffering */
@@ -201,6 +208,12 @@ typedef struct SR_RecognizerImpl_t
    * Recognition result.
    */
   SR_RecognizerResult* result;
+  /**
+   * Storage for the per-utterance parts of the result (semantic results and
+   * the values the recognizer adds to them); reset when the result is
+   * destroyed.
+   */
+  PArena* resultArena;
   /**
    * Recognizer parameters.
    */
@@ -209,6 +222,19 @@ typedef struct SR_RecognizerImpl_t
    * AcousticState associated with Recognizer.
    */
   SR_AcousticState* acousticState;
+  /**
+   * Store selected with SR_AcousticStateSelect(), or NULL.
+   */
+  SR_AcousticStateStore* acousticStateStore;
+  /**
+   * Speaker or channel whose state is filed in acousticStateStore.
+   */
+  LCHAR acousticStateKey[SR_ACOUSTICSTATESTORE_MAX_KEY_LENGTH];
+  /**
+   * Set when acousticStateKey was selected since the last start, so that the
+   * next start loads its state.
+   */
+  ESR_BOOL acousticStateKeyChanged;
   /**
    * Total number of frames pushed by SR_RecognizerPutAudio().
    */
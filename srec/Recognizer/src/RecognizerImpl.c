@@ -72,13 +72,18 @@ ESR_ReturnCode SR_RecognizerToSessionImpl()
   /* CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.max_acoustic_models", 2)); */
   CHKLOG(rc, ESR_SessionSetBoolIfEmpty("CREC.Recognizer.partial_results", ESR_FALSE));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.NBest", 1));
+  CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.enrollment_search", 1));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.eou_threshold", 100));
+  CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.first_pass_pdfs", 0));
+  CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.frame_budget_usec", 0));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.max_altword_tokens", 400));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.max_frames", 1000));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.max_fsm_arcs", 3000));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.max_fsm_nodes", 3000));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.max_fsmnode_tokens", 1000));
+  CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.max_grammars", 1));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.max_hmm_tokens", 1000));
+  CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.max_active_hmm_tokens", 0));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.max_model_states", 1000));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.max_searches", 2));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.max_word_tokens", 1000));
@@ -86,7 +91,9 @@ ESR_ReturnCode SR_RecognizerToSessionImpl()
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.num_wordends_per_frame", 10));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.often", 10));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.optional_terminal_timeout", 30));
+  CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.phone_lookahead_margin", 0));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.reject", 500));
+  CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.score_threads", 1));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.terminal_timeout", 10));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.viterbi_prune_thresh", 5000));
   CHKLOG(rc, ESR_SessionSetIntIfEmpty("CREC.Recognizer.wordpen", 0));
@@ -584,13 +591,18 @@ ESR_ReturnCode SR_AcousticModels_LoadLegacyRecognizerParameters(CA_RecInputParam
   params->is_loaded = ESR_FALSE;
   CHKLOG(rc, ESR_SessionGetBool("CREC.Recognizer.partial_results", &params->do_partial));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.NBest", &params->top_choices));
+  CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.enrollment_search", &params->enrollment_search));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.eou_threshold", &params->eou_threshold));
+  CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.first_pass_pdfs", &params->first_pass_pdfs));
+  CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.frame_budget_usec", &params->frame_budget_usec));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.max_altword_tokens", &params->max_altword_tokens));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.max_frames", &params->max_frames));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.max_fsm_arcs", &params->max_fsm_arcs));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.max_fsm_nodes", &params->max_fsm_nodes));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.max_fsmnode_tokens", &params->max_fsmnode_tokens));
+  CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.max_grammars", &params->max_grammars));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.max_hmm_tokens", &params->max_hmm_tokens));
+  CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.max_active_hmm_tokens", &params->max_active_hmm_tokens));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.max_model_states", &params->max_model_states));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.max_searches", &params->max_searches));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.max_word_tokens", &params->max_word_tokens));
@@ -598,7 +610,9 @@ ESR_ReturnCode SR_AcousticModels_LoadLegacyRecognizerParameters(CA_RecInputParam
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.num_wordends_per_frame", &params->num_wordends_per_frame));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.often", &params->traceback_freq));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.optional_terminal_timeout", &params->optional_terminal_timeout));
+  CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.phone_lookahead_margin", &params->phone_lookahead_margin));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.reject", &params->reject_score));
+  CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.score_threads", &params->score_threads));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.terminal_timeout", &params->terminal_timeout));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.viterbi_prune_thresh", &params->viterbi_prune_thresh));
   CHKLOG(rc, ESR_SessionGetInt("CREC.Recognizer.wordpen", &params->word_penalty));
@@ -674,8 +688,12 @@ ESR_ReturnCode SR_RecognizerCreate(SR_Recognizer** self)
   impl->models = NULL;
   impl->grammars = NULL;
   impl->result = NULL;
+  impl->resultArena = NULL;
   impl->parameters = NULL;
   impl->acousticState = NULL;
+  impl->acousticStateStore = NULL;
+  impl->acousticStateKey[0] = L('\0');
+  impl->acousticStateKeyChanged = ESR_FALSE;
   impl->audioBuffer = NULL;
   impl->buffer = NULL;
   impl->frames = impl->processed;
@@ -750,6 +768,7 @@ ESR_ReturnCode SR_RecognizerCreate(SR_Recognizer** self)
   CA_ConfigureRecognition(impl->recognizer, recogParams);
   CA_FreeRecognitionParameters(recogParams);
   CHKLOG(rc, HashMapCreate(&impl->grammars));
+  CHKLOG(rc, PArenaCreate(0, MTAG, &impl->resultArena));
   CHKLOG(rc, CircularBufferCreate(sizeof(asr_int16_t) * AUDIO_CIRC_BUFFER_SIZE, MTAG, &impl->buffer));
   CHKLOG(rc, ESR_SessionGetSize_t("CREC.Frontend.samplerate", &impl->sampleRate));
 
@@ -806,6 +825,11 @@ ESR_ReturnCode SR_RecognizerDestroyImpl(SR_Recognizer* self)
     SR_RecognizerResult_Destroy(impl->result);
     impl->result = NULL;
   }
+  if (impl->resultArena != NULL)
+  {
+    PArenaDestroy(impl->resultArena);
+    impl->resultArena = NULL;
+  }
 
   if (impl->eventLog != NULL)
   {
@@ -996,6 +1020,20 @@ ESR_ReturnCode SR_RecognizerStartImpl(SR_Recognizer* self)
     return ESR_INVALID_STATE;
   }
 
+  /* a newly selected speaker starts from its own state, or from scratch */
+  if (impl->acousticStateStore != NULL && impl->acousticStateKeyChanged)
+  {
+    rc = SR_AcousticStateStoreGet(impl->acousticStateStore, self, impl->acousticStateKey);
+    if (rc == ESR_NO_MATCH_ERROR)
+      rc = SR_AcousticStateReset(self);
+    if (rc != ESR_SUCCESS)
+    {
+      PLogError(L("%s: could not load the acoustic state of %s"), ESR_rc2str(rc), impl->acousticStateKey);
+      return rc;
+    }
+    impl->acousticStateKeyChanged = ESR_FALSE;
+  }
+
   if (!CA_OpenWaveFromDevice(impl->wavein, DEVICE_RAW_PCM, impl->frontend->samplerate, 0, WAVE_DEVICE_RAW))
   {
     rc = ESR_INVALID_STATE;
@@ -1243,6 +1281,14 @@ ESR_ReturnCode SR_RecognizerStopImpl(SR_Recognizer* self)
   CA_CalculateCMSParameters(impl->wavein);
   CA_CloseDevice(impl->wavein);
 
+  /* keep what this utterance taught us about the selected speaker */
+  if (impl->acousticStateStore != NULL)
+  {
+    rc = SR_AcousticStateStorePut(impl->acousticStateStore, self, impl->acousticStateKey);
+    if (rc != ESR_SUCCESS)
+      PLogError(L("%s: could not save the acoustic state of %s"), ESR_rc2str(rc), impl->acousticStateKey);
+  }
+
   /* record the OSI event */
   CHKLOG(rc, SR_EventLogEvent_BASIC(impl->eventLog, impl->osi_log_level, L("SWIstop")));
 
@@ -1251,6 +1297,8 @@ ESR_ReturnCode SR_RecognizerStopImpl(SR_Recognizer* self)
     CHKLOG(rc, SR_RecognizerResult_Destroy(impl->result));
     impl->result = NULL;
   }
+  /* everything the result kept in the arena is gone with it */
+  CHKLOG(rc, PArenaReset(impl->resultArena));
 
   if (impl->lockFunction)
     impl->lockFunction(ESR_LOCK, impl->lockData);
@@ -1645,6 +1693,7 @@ ESR_ReturnCode SR_RecognizerDeactivateRuleImpl(SR_Recognizer* self, SR_Grammar*
   }
   else
     CHKLOG(rc, HashMapRemove(impl->grammars, ruleName));
+  CA_DeactivateSyntaxForRecognizer(grammarImpl->syntax, impl->recognizer);
   grammarImpl->isActivated = ESR_FALSE;
   return ESR_SUCCESS;
 CLEANUP:
@@ -1995,6 +2044,7 @@ ESR_ReturnCode SR_RecognizerCreateResultImpl(SR_Recognizer* self, SR_RecognizerS
     PLogError(L("ESR_INVALID_STATE"));
     return ESR_INVALID_STATE;
   }
+  CA_RescoreRecognition(impl->recognizer, modelsImpl->pattern);
 
   /* check if the forward search was successful */
   valid = CA_FullResultLabel(impl->recognizer, result, MAX_ENTRY_LENGTH - 1);
@@ -2063,7 +2113,21 @@ ESR_ReturnCode SR_RecognizerCreateResultImpl(SR_Recognizer* self, SR_RecognizerS
   if (valid == FULL_RESULT)
   {
     /* Populate SR_RecognizerResult */
-    resultImpl->nbestList = CA_PrepareNBestList(impl->recognizer, 10, &raws);
+    nbestSize = 10;
+    if (CA_IsEnrollmentRecognition(impl->recognizer))
+    {
+      /* the enrollment takes the Viterbi path as its top choice (see below),
+         alternatives are of little use and the A* search over a phone loop
+         lattice is costly */
+      ESR_SessionContains(L("SREC.voice_enroll.nbest"), &containsKey);
+      if (containsKey)
+        ESR_SessionGetSize_t(L("SREC.voice_enroll.nbest"), &nbestSize);
+      else
+        nbestSize = DEFAULT_VOICE_ENROLL_NBEST;
+      if (nbestSize < 1)
+        nbestSize = 1;
+    }
+    resultImpl->nbestList = CA_PrepareNBestList(impl->recognizer, (int) nbestSize, &raws);
     if (resultImpl->nbestList == NULL)
     {
       /*
@@ -2134,12 +2198,23 @@ ESR_ReturnCode SR_RecognizerCreateResultImpl(SR_Recognizer* self, SR_RecognizerS
   }
 
   /**
-   * All grammars associated with the recognizer are considered to be active
-   * and therefore, I do a semantic parse on each. On the first grammar that
-   * gives one or more semantic results, I stop parsing the other grammars.
+   * All grammars associated with the recognizer are decoded at once, the
+   * n-best list comes from the search that scored best, so the semantic
+   * parse is done with the grammar of that search.
    */
   CHKLOG(rc, impl->grammars->getSize(impl->grammars, &grammarSize));
-  ASSERT( grammarSize == 1);
+  ASSERT( grammarSize >= 1);
+  grammarIndex_for_iBest = 0;
+  for (k = 0; k < grammarSize; ++k)
+  {
+    CHKLOG(rc, impl->grammars->getKeyAtIndex(impl->grammars, k, &pkey));
+    CHKLOG(rc, impl->grammars->get(impl->grammars, pkey, (void **)&pgrammar));
+    if (CA_IsBestResultSyntax(pgrammar->syntax, impl->recognizer))
+    {
+      grammarIndex_for_iBest = k;
+      break;
+    }
+  }
 
   for (iBest = 0; iBest < nbestSize; ++iBest)
   {
@@ -2163,7 +2238,6 @@ ESR_ReturnCode SR_RecognizerCreateResultImpl(SR_Recognizer* self, SR_RecognizerS
     CHKLOG(rc, ArrayListCreate(&semanticList));
     CHKLOG(rc, resultImpl->results->add(resultImpl->results, semanticList));
 
-    grammarIndex_for_iBest = 0;
     CHKLOG(rc, impl->grammars->getKeyAtIndex(impl->grammars, grammarIndex_for_iBest, &pkey));
     CHKLOG(rc, impl->grammars->get(impl->grammars, pkey, (void **)&pgrammar));
 
@@ -2172,7 +2246,7 @@ ESR_ReturnCode SR_RecognizerCreateResultImpl(SR_Recognizer* self, SR_RecognizerS
 
     /* I need to manage my semantic results external to the check parse function */
     for (k = 0; k < MAX_SEM_RESULTS; ++k)
-      SR_SemanticResultCreate(&semanticResults[k]);
+      SR_SemanticResultCreateInArena(&semanticResults[k], impl->resultArena);
 
     /*
        The code here tries to make the voice-enrollment more effective.
@@ -2287,7 +2361,7 @@ ESR_ReturnCode SR_RecognizerCreateResultImpl(SR_Recognizer* self, SR_RecognizerS
        * If there was no semantic result... then I need to create one so that I can store
        * literal, conf, meaning which are default keys that must ALWAYS exist
        */
-      CHKLOG(rc, SR_SemanticResultCreate(&semanticResult));
+      CHKLOG(rc, SR_SemanticResultCreateInArena(&semanticResult, impl->resultArena));
       CHKLOG(rc, semanticList->add(semanticList, semanticResult));
       semanticResultsSize = 1;
     }
@@ -2304,39 +2378,16 @@ ESR_ReturnCode SR_RecognizerCreateResultImpl(SR_Recognizer* self, SR_RecognizerS
       semanticImpl = (SR_SemanticResultImpl*) semanticResult;
 
       /* put in the literal */
-      lValue = MALLOC(sizeof(LCHAR) * (LSTRLEN(label) + 1), MTAG);
-      if (lValue == NULL)
-      {
-        PLogError(L("ESR_OUT_OF_MEMORY"));
-        return ESR_OUT_OF_MEMORY;
-      }
-      LSTRCPY(lValue, label);
-      CHKLOG(rc, semanticImpl->results->put(semanticImpl->results, L("literal"), lValue));
+      CHKLOG(rc, SR_SemanticResult_PutValueCopy(semanticImpl, L("literal"), label));
 
       /* if the meaning is not set, then put in the meaning which will be the literal */
       CHKLOG(rc, semanticImpl->results->containsKey(semanticImpl->results, L("meaning"), &containsKey));
       if (!containsKey)
-      {
-        lValue = MALLOC(sizeof(LCHAR) * (LSTRLEN(label) + 1), MTAG);
-        if (lValue == NULL)
-        {
-          PLogError(L("ESR_OUT_OF_MEMORY"));
-          return ESR_OUT_OF_MEMORY;
-        }
-        LSTRCPY(lValue, label);
-        CHKLOG(rc, semanticImpl->results->put(semanticImpl->results, L("meaning"), lValue));
-      }
+        CHKLOG(rc, SR_SemanticResult_PutValueCopy(semanticImpl, L("meaning"), label));
 
       /* put in the raw score */
       psprintf(label, L("%d"), raws);
-      lValue = MALLOC(sizeof(LCHAR) * (LSTRLEN(label) + 1), MTAG);
-      if (lValue == NULL)
-      {
-        PLogError(L("ESR_OUT_OF_MEMORY"));
-        return ESR_OUT_OF_MEMORY;
-      }
-      LSTRCPY(lValue, label);
-      CHKLOG(rc, semanticImpl->results->put(semanticImpl->results, L("raws"), lValue));
+      CHKLOG(rc, SR_SemanticResult_PutValueCopy(semanticImpl, L("raws"), label));
     }
   }
 
@@ -2420,14 +2471,7 @@ ESR_ReturnCode SR_RecognizerCreateResultImpl(SR_Recognizer* self, SR_RecognizerS
       return ESR_ARGUMENT_OUT_OF_BOUNDS;
 
     psprintf(label, L("%d"), confValue);
-    lValue = MALLOC(sizeof(LCHAR) * (LSTRLEN(label) + 1), MTAG);
-      if (lValue == NULL)
-      {
-        PLogError(L("ESR_OUT_OF_MEMORY"));
-        return ESR_OUT_OF_MEMORY;
-      }
-      LSTRCPY(lValue, label);
-      CHKLOG(rc, semanticImpl->results->put(semanticImpl->results, L("conf"),lValue));
+    CHKLOG(rc, SR_SemanticResult_PutValueCopy(semanticImpl, L("conf"), label));
     }
   CHKLOG(rc, SR_EventLogTokenInt_BASIC(impl->eventLog, impl->osi_log_level, L("CMPT"), 0));
   }
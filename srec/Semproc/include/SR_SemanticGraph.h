@@ -76,6 +76,22 @@ typedef struct SR_SemanticGraph_t
    * @param version_number Target file format version.
    */
   ESR_ReturnCode(*save)(struct SR_SemanticGraph_t* self, const LCHAR* filename, int version_number);
+
+  /**
+   * Appends the words added to slots, with their scripts, to a grammar delta.
+   *
+   * @param self SR_SemanticGraph handle
+   * @param filename Grammar delta, as written by CA_DumpSyntaxDelta().
+   */
+  ESR_ReturnCode(*saveDelta)(struct SR_SemanticGraph_t* self, const LCHAR* filename);
+
+  /**
+   * Adds the slot words of a grammar delta, after CA_LoadSyntaxDelta() loaded it.
+   *
+   * @param self SR_SemanticGraph handle
+   * @param filename Grammar delta, as written by saveDelta.
+   */
+  ESR_ReturnCode(*loadDelta)(struct SR_SemanticGraph_t* self, const LCHAR* filename);
   
   /**
    * Adds a word to the semantic graph at the specified slot. Tag may be defined or NULL.
@@ -132,6 +132,14 @@ SREC_SEMPROC_API ESR_ReturnCode SR_SemanticGraph_Unload(SR_SemanticGraph* self);
  * Default implementation.
  */
 SREC_SEMPROC_API ESR_ReturnCode SR_SemanticGraph_Save(SR_SemanticGraph* self, const LCHAR* filename, int version_number);
+/**
+ * Default implementation.
+ */
+SREC_SEMPROC_API ESR_ReturnCode SR_SemanticGraph_SaveDelta(SR_SemanticGraph* self, const LCHAR* filename);
+/**
+ * Default implementation.
+ */
+SREC_SEMPROC_API ESR_ReturnCode SR_SemanticGraph_LoadDelta(SR_SemanticGraph* self, const LCHAR* filename);
 /**
  * Default implementation.
  */
@@ -24,6 +24,7 @@
 
 #include "ESR_ReturnCode.h"
 #include "HashMap.h"
+#include "parena.h"
 
 
 /**
@@ -40,9 +41,32 @@ typedef struct SR_SemanticResultImpl_t
    * Semantic [key, value] pairs.
    */
   HashMap* results;
+
+  /**
+   * Arena holding this object, or NULL if it was allocated on its own.
+   * Values owned by the arena are not freed when the result is destroyed.
+   */
+  PArena* arena;
 }
 SR_SemanticResultImpl;
 
+/**
+ * Creates a semantic result in an arena.  The result must still be destroyed
+ * before the arena is reset, to free the values that do not live in the arena.
+ *
+ * @param self SemanticResult handle
+ * @param arena Arena to allocate the result from
+ */
+SREC_SEMPROC_API ESR_ReturnCode SR_SemanticResultCreateInArena(SR_SemanticResult** self, PArena* arena);
+/**
+ * Associates a value with a key, copying the value into the result's arena
+ * (or to the heap if the result has no arena).  Any previous value is freed.
+ *
+ * @param self SemanticResult handle
+ * @param key The key
+ * @param value The value to copy
+ */
+SREC_SEMPROC_API ESR_ReturnCode SR_SemanticResult_PutValueCopy(SR_SemanticResultImpl* self, const LCHAR* key, const LCHAR* value);
 /**
  * Default implementation.
  */
@@ -58,6 +58,8 @@ ESR_ReturnCode SR_SemanticGraphCreate(SR_SemanticGraph** self)
   impl->Interface.unload = &SR_SemanticGraph_Unload;
   impl->Interface.load = &SR_SemanticGraph_Load;
   impl->Interface.save = &SR_SemanticGraph_Save;
+  impl->Interface.saveDelta = &SR_SemanticGraph_SaveDelta;
+  impl->Interface.loadDelta = &SR_SemanticGraph_LoadDelta;
   impl->Interface.addWordToSlot = &SR_SemanticGraph_AddWordToSlot;
   impl->Interface.reset = &SR_SemanticGraph_Reset;
   impl->script_olabel_offset = SEMGRAPH_SCRIPT_OFFSET;
@@ -398,7 +400,7 @@ ESR_ReturnCode SR_SemanticGraph_LoadFromTextFiles(SR_SemanticGraph* self, wordma
   {
     if (num_arcs == MAXarcID)
       break; /* error */
-	if (sscanf(line, "%hu\t%hu\t%[^\t]\t%[^\t\n\r]", &from_node, &into_node, iword, oword) == 4)
+	if (sscanf(line, "%" ID_FMT "\t%" ID_FMT "\t%[^\t]\t%[^\t\n\r]", &from_node, &into_node, iword, oword) == 4)
     {
 		if (IS_SCOPE_MARKER(oword)) {
 			num_scope_words++;
@@ -420,7 +422,7 @@ ESR_ReturnCode SR_SemanticGraph_LoadFromTextFiles(SR_SemanticGraph* self, wordma
   i = 0;
   while (pfgets(line, MAX_STRING_LEN, p_text_file))
   {
-    if (sscanf(line, "%hu\t%hu\t%[^\t]\t%[^\t\n\r]", &from_node, &into_node, iword, oword) == 4)
+    if (sscanf(line, "%" ID_FMT "\t%" ID_FMT "\t%[^\t]\t%[^\t\n\r]", &from_node, &into_node, iword, oword) == 4)
     {
       /* the cost is 0 by default */
       cost = 0;
@@ -458,7 +460,7 @@ ESR_ReturnCode SR_SemanticGraph_LoadFromTextFiles(SR_SemanticGraph* self, wordma
       }
 
     }
-    else if (sscanf(line, "%hu", &from_node) == 1)
+    else if (sscanf(line, "%" ID_FMT, &from_node) == 1)
     {
       into_node = MAXnodeID;
       ilabel = MAXwordID;
@@ -1015,6 +1017,75 @@ ESR_ReturnCode make_union_of_scripts(LCHAR* union_script, const size_t max_len,
   return ESR_SUCCESS;
 }
 
+#define FST_GROW_FACTOR   12/10
+#define FST_GROWARCS_MIN    100  
+
+/**
+ * Takes a free arc token, growing the list if there is none left, and puts it at the
+ * head of the slot.  Returns NULL when out of memory.
+ */
+static arc_token* sr_semanticgraph_new_slot_arc(SR_SemanticGraphImpl* impl, wordID slotID)
+{
+  arc_token *token, *tmp;
+  arc_token *tmp_arc_token_list;
+  int i;
+  int tmp_arc_token_list_len;
+  int offset;
+
+  token = impl->arcs_for_slot[slotID];
+  tmp = arc_tokens_get_free(impl->arc_token_list, &(impl->arc_token_freelist));
+  if (tmp == NULL)
+    {
+#if defined (FST_GROW_FACTOR)
+	tmp_arc_token_list_len = impl->arc_token_list_len * FST_GROW_FACTOR;
+	if(tmp_arc_token_list_len - impl->arc_token_list_len <=FST_GROWARCS_MIN)
+	  tmp_arc_token_list_len+=FST_GROWARCS_MIN;
+	
+	tmp_arc_token_list= NEW_ARRAY(arc_token,tmp_arc_token_list_len, L("semgraph.wordgraph"));
+	if(!tmp_arc_token_list) {
+	  PLogError(L("ESR_OUT_OF_MEMORY: Could not extend allocation of semgraph.wordgraph"));
+	  return NULL;
+	}
+	memcpy(tmp_arc_token_list,impl->arc_token_list, impl->arc_token_list_len*sizeof(arc_token));
+	
+	for(i=0; i<MAX_NUM_SLOTS;i++)
+	  {
+	    if(impl->arcs_for_slot[i] != NULL) { 
+	      offset = impl->arcs_for_slot[i] - impl->arc_token_list;
+	      impl->arcs_for_slot[i] = tmp_arc_token_list + offset;
+	    }
+	  }
+	token = impl->arcs_for_slot[slotID];
+	
+	ASSERT( impl->arc_token_freelist == NULL);
+	
+	impl->arc_token_freelist = tmp_arc_token_list + impl->arc_token_list_len;
+	
+	FREE(impl->arc_token_list);
+	impl->arc_token_insert_start = tmp_arc_token_list + (impl->arc_token_insert_start - impl->arc_token_list); //Rabih fix
+	impl->arc_token_list = tmp_arc_token_list;
+
+	for (i = impl->arc_token_list_len; i < tmp_arc_token_list_len - 1; i++)
+	  {
+	    impl->arc_token_list[i].first_next_arc = ARC_TOKEN_NULL;
+	    impl->arc_token_list[i].next_token_index = ARC_TOKEN_LNK(impl->arc_token_list, (i + 1));
+	  }
+	impl->arc_token_list[i].first_next_arc = ARC_TOKEN_NULL;
+	impl->arc_token_list[i].next_token_index = ARC_TOKEN_NULL;
+	
+	impl->arc_token_list_len = tmp_arc_token_list_len;
+	tmp = arc_tokens_get_free(impl->arc_token_list, &(impl->arc_token_freelist));
+    }
+#endif
+  if(tmp == NULL) {
+    PLogError(L("ESR_OUT_OF_MEMORY: Error adding more arcs to graph\n"));
+    return NULL;
+  }
+  impl->arcs_for_slot[slotID] = tmp;
+  tmp->next_token_index = ARC_TOKEN_PTR2LNK(impl->arc_token_list, token);
+  return tmp;
+}
+
 /**
  * Default implementation.
  */
@@ -1022,13 +1093,10 @@ ESR_ReturnCode SR_SemanticGraph_AddWordToSlot(SR_SemanticGraph* self, const LCHA
 {
   struct SR_SemanticGraphImpl_t *impl = (struct SR_SemanticGraphImpl_t*) self;
   arc_token *token, *tmp;
-  arc_token *tmp_arc_token_list;
   wordID wdID, scriptID, old_scriptID;
   wordID slotID;
   LCHAR union_script[MAX_STRING_LEN]; /* sizeof used elsewhere */
-  ESR_ReturnCode rc; int i;
-  int tmp_arc_token_list_len;
-  int offset;
+  ESR_ReturnCode rc;
 #define MAX_WORD_LEN 128
   char veslot[MAX_WORD_LEN];
 
@@ -1070,8 +1138,6 @@ ESR_ReturnCode SR_SemanticGraph_AddWordToSlot(SR_SemanticGraph* self, const LCHA
   else
     token = arc_tokens_find_ilabel(impl->arc_token_list, impl->arcs_for_slot[slotID], wdID);
 
-#define FST_GROW_FACTOR   12/10
-#define FST_GROWARCS_MIN    100  
   if (token == NULL) /* new word to add to slot */
   {
     /* add the script if new  */
@@ -1084,57 +1150,9 @@ ESR_ReturnCode SR_SemanticGraph_AddWordToSlot(SR_SemanticGraph* self, const LCHA
       return ESR_OUT_OF_MEMORY;
     }
 
-    token = impl->arcs_for_slot[slotID];
-    tmp = arc_tokens_get_free(impl->arc_token_list, &(impl->arc_token_freelist));
+    tmp = sr_semanticgraph_new_slot_arc(impl, slotID);
     if (tmp == NULL)
-      {
-#if defined (FST_GROW_FACTOR)
-	tmp_arc_token_list_len = impl->arc_token_list_len * FST_GROW_FACTOR;
-	if(tmp_arc_token_list_len - impl->arc_token_list_len <=FST_GROWARCS_MIN)
-	  tmp_arc_token_list_len+=FST_GROWARCS_MIN;
-	
-	tmp_arc_token_list= NEW_ARRAY(arc_token,tmp_arc_token_list_len, L("semgraph.wordgraph"));
-	if(!tmp_arc_token_list) {
-	  PLogError(L("ESR_OUT_OF_MEMORY: Could not extend allocation of semgraph.wordgraph"));
-	  return ESR_OUT_OF_MEMORY;
-	}
-	memcpy(tmp_arc_token_list,impl->arc_token_list, impl->arc_token_list_len*sizeof(arc_token));
-	
-	for(i=0; i<MAX_NUM_SLOTS;i++)
-	  {
-	    if(impl->arcs_for_slot[i] != NULL) { 
-	      offset = impl->arcs_for_slot[i] - impl->arc_token_list;
-	      impl->arcs_for_slot[i] = tmp_arc_token_list + offset;
-	    }
-	  }
-	token = impl->arcs_for_slot[slotID];
-	
-	ASSERT( impl->arc_token_freelist == NULL);
-	
-	impl->arc_token_freelist = tmp_arc_token_list + impl->arc_token_list_len;
-	
-	FREE(impl->arc_token_list);
-	impl->arc_token_insert_start = tmp_arc_token_list + (impl->arc_token_insert_start - impl->arc_token_list); //Rabih fix
-	impl->arc_token_list = tmp_arc_token_list;
-
-	for (i = impl->arc_token_list_len; i < tmp_arc_token_list_len - 1; i++)
-	  {
-	    impl->arc_token_list[i].first_next_arc = ARC_TOKEN_NULL;
-	    impl->arc_token_list[i].next_token_index = ARC_TOKEN_LNK(impl->arc_token_list, (i + 1));
-	  }
-	impl->arc_token_list[i].first_next_arc = ARC_TOKEN_NULL;
-	impl->arc_token_list[i].next_token_index = ARC_TOKEN_NULL;
-	
-	impl->arc_token_list_len = tmp_arc_token_list_len;
-	tmp = arc_tokens_get_free(impl->arc_token_list, &(impl->arc_token_freelist));
-      }
-#endif
-    if(tmp == NULL) {
-      PLogError(L("ESR_OUT_OF_MEMORY: Error adding more arcs to graph\n"));
       return ESR_OUT_OF_MEMORY;
-    }
-    impl->arcs_for_slot[slotID] = tmp;
-    tmp->next_token_index = ARC_TOKEN_PTR2LNK(impl->arc_token_list, token);
     tmp->ilabel = wdID;
     tmp->olabel = (wordID)(impl->script_olabel_offset + scriptID);
   }
@@ -1222,6 +1240,181 @@ ESR_ReturnCode SR_SemanticGraph_Reset(SR_SemanticGraph* self)
   return ESR_SUCCESS;
 }
 
+#define SEMGR_DELTA_FORMAT 478932785
+
+/**
+ * Appends the slot words and their scripts to a grammar delta written by
+ * CA_DumpSyntaxDelta().  Word ids are kept as is, loading the delta adds the
+ * words back so that every slot lists them in the same order.
+ */
+ESR_ReturnCode SR_SemanticGraph_SaveDelta(SR_SemanticGraph* self, const LCHAR* filename)
+{
+  SR_SemanticGraphImpl* impl = (SR_SemanticGraphImpl*) self;
+  ESR_ReturnCode rc = ESR_SUCCESS;
+  PFile* fp;
+  asr_uint32_t tmp[2];
+  asr_uint16_t len;
+  const LCHAR* script;
+  arc_token* atok;
+  arc_token** slot_arcs = NULL;
+  asr_uint32_t num_slot_arcs;
+  wordID slotid;
+
+  fp = pfopen ( filename, L("r+b"));
+  if ( fp == NULL )
+  {
+    rc = ESR_OPEN_ERROR;
+    PLogError(L("%s: %s"), ESR_rc2str(rc), filename);
+    return rc;
+  }
+  pfseek(fp, 0, SEEK_END);
+
+  tmp[0] = SEMGR_DELTA_FORMAT;
+  tmp[1] = 0;
+  for (slotid = 1; slotid < impl->ilabels->num_slots; slotid++)
+    for (atok = impl->arcs_for_slot[slotid]; atok; atok = ARC_TOKEN_PTR(impl->arc_token_list, atok->next_token_index))
+      tmp[1]++;
+  if (pfwrite(tmp, sizeof(tmp[0]), 2, fp) != 2)
+  {
+    rc = ESR_WRITE_ERROR;
+    PLogError(L("ESR_WRITE_ERROR: could not write semgraph delta"));
+    goto CLEANUP;
+  }
+
+  if (tmp[1] > 0)
+  {
+    slot_arcs = NEW_ARRAY(arc_token*, tmp[1], MTAG);
+    if (slot_arcs == NULL)
+    {
+      rc = ESR_OUT_OF_MEMORY;
+      PLogError(L("ESR_OUT_OF_MEMORY: could not write semgraph delta"));
+      goto CLEANUP;
+    }
+  }
+
+  for (slotid = 1; slotid < impl->ilabels->num_slots; slotid++)
+  {
+    /* a slot keeps its newest word first and loading puts every word in
+       front, so the words are written oldest first */
+    num_slot_arcs = 0;
+    for (atok = impl->arcs_for_slot[slotid]; atok; atok = ARC_TOKEN_PTR(impl->arc_token_list, atok->next_token_index))
+      slot_arcs[num_slot_arcs++] = atok;
+    while (num_slot_arcs > 0)
+    {
+      atok = slot_arcs[--num_slot_arcs];
+      script = impl->scripts->words[atok->olabel - impl->script_olabel_offset];
+      len = (asr_uint16_t)(LSTRLEN(script) + 1);
+      tmp[0] = slotid;
+      tmp[1] = atok->ilabel;
+      if (pfwrite(tmp, sizeof(tmp[0]), 2, fp) != 2 ||
+          pfwrite(&len, sizeof(len), 1, fp) != 1 ||
+          pfwrite(script, sizeof(LCHAR), len, fp) != len)
+      {
+        rc = ESR_WRITE_ERROR;
+        PLogError(L("ESR_WRITE_ERROR: could not write semgraph delta"));
+        goto CLEANUP;
+      }
+    }
+  }
+CLEANUP:
+  if (slot_arcs != NULL)
+    FREE(slot_arcs);
+  pfclose(fp);
+  return rc;
+}
+
+/**
+ * Replays the slot words of a grammar delta, once CA_LoadSyntaxDelta() has added
+ * its words to the shared word labels.  A word already in its slot takes the
+ * script of the delta.
+ */
+ESR_ReturnCode SR_SemanticGraph_LoadDelta(SR_SemanticGraph* self, const LCHAR* filename)
+{
+  SR_SemanticGraphImpl* impl = (SR_SemanticGraphImpl*) self;
+  ESR_ReturnCode rc = ESR_SUCCESS;
+  PFile* fp;
+  struct
+  {
+    asr_uint32_t rec_context_delta_size;
+    /*  data size of the recognition graph delta */
+    asr_uint32_t format;
+  }
+  header;
+  asr_uint32_t tmp[2], i, num_entries;
+  asr_uint16_t len;
+  LCHAR script[MAX_STRING_LEN];
+  wordID slotid, wdid, scriptID;
+  arc_token* atok;
+
+  fp = pfopen ( filename, L("rb"));
+  if ( fp == NULL )
+  {
+    rc = ESR_OPEN_ERROR;
+    PLogError(L("%s: %s"), ESR_rc2str(rc), filename);
+    return rc;
+  }
+
+  if (pfread(&header, 4, 2, fp) != 2 || header.format != IMAGE_FORMAT_DELTA ||
+      pfseek(fp, header.rec_context_delta_size, SEEK_SET))
+  {
+    rc = ESR_READ_ERROR;
+    PLogError(L("ESR_READ_ERROR: could not seek to semgraph delta"));
+    goto CLEANUP;
+  }
+  if (pfread(tmp, sizeof(tmp[0]), 2, fp) != 2 || tmp[0] != SEMGR_DELTA_FORMAT)
+  {
+    rc = ESR_READ_ERROR;
+    PLogError(L("ESR_READ_ERROR: could not read semgraph delta"));
+    goto CLEANUP;
+  }
+  num_entries = tmp[1];
+
+  for (i = 0; i < num_entries; i++)
+  {
+    if (pfread(tmp, sizeof(tmp[0]), 2, fp) != 2 ||
+        pfread(&len, sizeof(len), 1, fp) != 1 || len == 0 || len > MAX_STRING_LEN ||
+        pfread(script, sizeof(LCHAR), len, fp) != len || script[len-1] != L('\0'))
+    {
+      rc = ESR_READ_ERROR;
+      PLogError(L("ESR_READ_ERROR: could not read semgraph delta entry %d"), i);
+      goto CLEANUP;
+    }
+    if (tmp[0] == 0 || tmp[0] >= impl->ilabels->num_slots || tmp[1] >= impl->ilabels->num_words)
+    {
+      rc = ESR_INVALID_STATE;
+      PLogError(L("ESR_INVALID_STATE: semgraph delta entry %d does not match the grammar"), i);
+      goto CLEANUP;
+    }
+    slotid = (wordID)tmp[0];
+    wdid = (wordID)tmp[1];
+
+    scriptID = wordmap_find_index(impl->scripts, script);
+    if (scriptID == MAXwordID)
+      scriptID = wordmap_add_word(impl->scripts, script);
+    if (scriptID == MAXwordID)
+    {
+      rc = ESR_OUT_OF_MEMORY;
+      PLogError(L("ESR_OUT_OF_MEMORY: Could not add script to wordmap"));
+      goto CLEANUP;
+    }
+    atok = arc_tokens_find_ilabel(impl->arc_token_list, impl->arcs_for_slot[slotid], wdid);
+    if (atok == NULL)
+    {
+      atok = sr_semanticgraph_new_slot_arc(impl, slotid);
+      if (atok == NULL)
+      {
+        rc = ESR_OUT_OF_MEMORY;
+        goto CLEANUP;
+      }
+      atok->ilabel = wdid;
+    }
+    atok->olabel = (wordID)(impl->script_olabel_offset + scriptID);
+  }
+CLEANUP:
+  pfclose(fp);
+  return rc;
+}
+
 static ESR_ReturnCode serializeArcTokenInfoV2(SR_SemanticGraphImpl *impl,
     PFile* fp)
 {
@@ -1229,7 +1422,7 @@ static ESR_ReturnCode serializeArcTokenInfoV2(SR_SemanticGraphImpl *impl,
   asr_uint32_t idx;
   arcID tmp[32];
 
-  if (pfwrite(&impl->arc_token_list_len, 2, 1, fp) != 1)
+  if (pfwrite(&impl->arc_token_list_len, sizeof(impl->arc_token_list_len), 1, fp) != 1)
     return ESR_WRITE_ERROR;
 
   idx = PTR_TO_IDX(impl->arc_token_freelist, impl->arc_token_list);
@@ -1278,7 +1471,7 @@ static ESR_ReturnCode deserializeArcTokenInfoV2(SR_SemanticGraphImpl *impl,
   ESR_ReturnCode rc = ESR_SUCCESS;
   arcID tmp[32];
 
-  if (pfread(&impl->arc_token_list_len, 2, 1, fp) != 1)
+  if (pfread(&impl->arc_token_list_len, sizeof(impl->arc_token_list_len), 1, fp) != 1)
   {
     rc = ESR_READ_ERROR;
     PLogError(L("ESR_READ_ERROR: could not read arc_token_list_len"));
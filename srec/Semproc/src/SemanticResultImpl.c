@@ -26,10 +26,30 @@
 static const char* MTAG = __FILE__;
 
 
+static ESR_ReturnCode SR_SemanticResultInit(SR_SemanticResultImpl* impl, PArena* arena, SR_SemanticResult** self)
+{
+  ESR_ReturnCode rc;
+  
+  impl->Interface.destroy = &SR_SemanticResult_Destroy;
+  impl->Interface.getKeyCount = &SR_SemanticResult_GetKeyCount;
+  impl->Interface.getKeyList = &SR_SemanticResult_GetKeyList;
+  impl->Interface.getValue = &SR_SemanticResult_GetValue;
+  impl->results = NULL;
+  impl->arena = arena;
+  
+  rc = HashMapCreate(&impl->results);
+  if (rc != ESR_SUCCESS)
+    goto CLEANUP;
+  *self = (SR_SemanticResult*) impl;
+  return ESR_SUCCESS;
+CLEANUP:
+  impl->Interface.destroy(&impl->Interface);
+  return rc;
+}
+
 ESR_ReturnCode SR_SemanticResultCreate(SR_SemanticResult** self)
 {
   SR_SemanticResultImpl* impl;
-  ESR_ReturnCode rc;
   
   if (self == NULL)
   {
@@ -42,20 +62,60 @@ ESR_ReturnCode SR_SemanticResultCreate(SR_SemanticResult** self)
     PLogError(L("ESR_OUT_OF_MEMORY"));
     return ESR_OUT_OF_MEMORY;
   }
+  return SR_SemanticResultInit(impl, NULL, self);
+}
+
+ESR_ReturnCode SR_SemanticResultCreateInArena(SR_SemanticResult** self, PArena* arena)
+{
+  SR_SemanticResultImpl* impl;
   
-  impl->Interface.destroy = &SR_SemanticResult_Destroy;
-  impl->Interface.getKeyCount = &SR_SemanticResult_GetKeyCount;
-  impl->Interface.getKeyList = &SR_SemanticResult_GetKeyList;
-  impl->Interface.getValue = &SR_SemanticResult_GetValue;
-  impl->results = NULL;
+  if (self == NULL || arena == NULL)
+  {
+    PLogError(L("ESR_INVALID_ARGUMENT"));
+    return ESR_INVALID_ARGUMENT;
+  }
+  impl = (SR_SemanticResultImpl*) PArenaAlloc(arena, sizeof(SR_SemanticResultImpl));
+  if (impl == NULL)
+  {
+    PLogError(L("ESR_OUT_OF_MEMORY"));
+    return ESR_OUT_OF_MEMORY;
+  }
+  return SR_SemanticResultInit(impl, arena, self);
+}
+
+/* frees a value unless it lives in the result's arena */
+static void SR_SemanticResultFreeValue(SR_SemanticResultImpl* impl, void* value)
+{
+  if (value != NULL && (impl->arena == NULL || !PArenaOwns(impl->arena, value)))
+    FREE(value);
+}
+
+ESR_ReturnCode SR_SemanticResult_PutValueCopy(SR_SemanticResultImpl* impl, const LCHAR* key, const LCHAR* value)
+{
+  LCHAR* copy;
+  void* oldValue;
+  ESR_BOOL exists;
+  ESR_ReturnCode rc;
   
-  rc = HashMapCreate(&impl->results);
-  if (rc != ESR_SUCCESS)
-    goto CLEANUP;
-  *self = (SR_SemanticResult*) impl;
+  if (impl->arena != NULL)
+    copy = PArenaStrdup(impl->arena, value);
+  else if ((copy = MALLOC(sizeof(LCHAR) * (LSTRLEN(value) + 1), MTAG)) != NULL)
+    LSTRCPY(copy, value);
+  if (copy == NULL)
+  {
+    PLogError(L("ESR_OUT_OF_MEMORY"));
+    return ESR_OUT_OF_MEMORY;
+  }
+  CHKLOG(rc, impl->results->containsKey(impl->results, key, &exists));
+  if (exists)
+  {
+    CHKLOG(rc, impl->results->get(impl->results, key, &oldValue));
+    SR_SemanticResultFreeValue(impl, oldValue);
+  }
+  CHKLOG(rc, impl->results->put(impl->results, key, copy));
   return ESR_SUCCESS;
 CLEANUP:
-  impl->Interface.destroy(&impl->Interface);
+  SR_SemanticResultFreeValue(impl, copy);
   return rc;
 }
 
@@ -124,10 +184,27 @@ ESR_ReturnCode SR_SemanticResult_Destroy(SR_SemanticResult* self)
 {
   SR_SemanticResultImpl* impl = (SR_SemanticResultImpl*) self;
   ESR_ReturnCode rc = ESR_SUCCESS;
+  void* value;
+  size_t size, i;
   
-  CHKLOG(rc, HashMapRemoveAndFreeAll(impl->results));
-  CHKLOG(rc, HashMapDestroy(impl->results));
-  FREE(impl);
+  if (impl->results != NULL)
+  {
+    if (impl->arena == NULL)
+      CHKLOG(rc, HashMapRemoveAndFreeAll(impl->results));
+    else
+    {
+      CHKLOG(rc, HashMapGetSize(impl->results, &size));
+      for (i = 0; i < size; ++i)
+      {
+        CHKLOG(rc, HashMapGetValueAtIndex(impl->results, i, &value));
+        SR_SemanticResultFreeValue(impl, value);
+      }
+      CHKLOG(rc, HashMapRemoveAll(impl->results));
+    }
+    CHKLOG(rc, HashMapDestroy(impl->results));
+  }
+  if (impl->arena == NULL)
+    FREE(impl);
   return rc;
 CLEANUP:
   return rc;
@@ -58,9 +58,11 @@ common_SRC_FILES:= \
 	../crec/srec.c \
 	../crec/srec_context.c \
 	../crec/srec_debug.c \
+	../crec/srec_enroll.c \
 	../crec/srec_eosd.c \
 	../crec/srec_initialize.c \
 	../crec/srec_results.c \
+	../crec/srec_score_pool.c \
 	../crec/srec_stats.c \
 	../crec/srec_tokens.c \
 	../crec/text_parser.c \
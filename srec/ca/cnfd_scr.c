@@ -128,172 +128,133 @@ void CA_UnloadConfidenceScorer(CA_ConfidenceScorer* hConfidenceScorer)
 
 
 
-static int CA_ConfScorerGetFeatures(CA_Recog* recog, CA_NBestList *nbestlist, float* features, int *num_features,
-									int choice_number, int num_choices_left);
+/* features of the choice_number'th choice, from the costs and speech
+   boundaries of all the choices */
+static void CA_ConfScorerGetFeatures(const srec_nbest_choice_info* infos, float* features,
+                                     int choice_number, int num_choices_left)
+{
+  const srec_nbest_choice_info* info = &infos[choice_number];
+  asr_int32_t num_speech_frames = info->num_speech_frames;
+  asr_int32_t speech_cost0 = info->speech_frames_cost;
+  asr_int32_t cost0 = info->cost;
+
+  /* @F=(,"gdiff","sdiff12","sdiff13","spf1","speechcost0","gdiffpf");
+            0       1          2        3         4           5      */
+  features[CONF_FEATURE_ABSOLUTE_SCORE] = ((float)(speech_cost0));
+  features[CONF_FEATURE_SCORE_PER_FRAME] = ((float)(speech_cost0)) / (float)num_speech_frames;
+  if (num_choices_left > 1)
+  {
+    features[CONF_FEATURE_SCORE_DIFF] = ((float)info[1].cost - (float)cost0);
+    if (num_choices_left > 2)
+      features[CONF_FEATURE_SCORE_DIFF13] = ((float)info[2].cost - (float)cost0);
+    else
+      features[CONF_FEATURE_SCORE_DIFF13] = ((float)info[1].cost - (float)cost0);
+  }
+  else
+  {
+    features[CONF_FEATURE_SCORE_DIFF] = 400;
+    features[CONF_FEATURE_SCORE_DIFF13] = 400;
+  }
+
+  features[CONF_FEATURE_GDIFF] = (float)(speech_cost0 - info->gsm_cost);
+  /* should never happen */
+  if (num_speech_frames == 0) num_speech_frames = 1;
+  features[CONF_FEATURE_GDIFF_PER_FRAME] = ((float)(speech_cost0 - info->gsm_cost)) / (float)num_speech_frames;
+
+#define DUMP_FEATURES_FOR_RETRAIN 0
+#if DUMP_FEATURES_FOR_RETRAIN
+  printf("REJFEATS:");
+  printf(" cost0(%d)", cost0);
+  printf(" cost1(%d)", num_choices_left > 1 ? info[1].cost : -1);
+  printf(" cost2(%d)", num_choices_left > 2 ? info[2].cost : -1);
+  printf(" speechcost0(%d)", speech_cost0);
+  printf(" nframes0(%d)", info->num_speech_frames);
+  printf(" nwords0(%d)", infos[0].num_words);
+  printf(" gsmcost(%d)", infos[0].gsm_cost);
+  printf("\n");
+#endif
+}
+
+/* product over the features of sigmoid(scale*feature+offset)^weight; the
+   features with weight 0 (or skipped) contribute exactly 1 and those with
+   weight 1 need no pow(), so both are left out without changing the
+   result */
+static double CA_ConfScorerEvaluate(const Confidence_model_parameters* params, const float* features,
+                                    int skip_score_diffs)
+{
+  double confidence_value = 1.0, confidence_feature;
+  int i;
+
+  for (i = 0; i < NUM_CONF_FEATURES; i++)
+  {
+    if (skip_score_diffs && (i == CONF_FEATURE_SCORE_DIFF || i == CONF_FEATURE_SCORE_DIFF13))
+      continue;
+    if (params->weight[i] == 0.0)
+      continue;
+    confidence_feature = 1.0/(1.0 + exp((params->scale[i] * features[i]) + params->offset[i]));
+    if (params->weight[i] != 1.0)
+      confidence_feature = pow(confidence_feature, params->weight[i]);
+    confidence_value = confidence_value * confidence_feature;
+  }
+  return confidence_value;
+}
 
 int CA_ComputeConfidenceValues(CA_ConfidenceScorer* hConfidenceScorer, CA_Recog* recog,
                                                             CA_NBestList *nbestlist)
 {
-  float features[12];
-  double value=1.0, final_value, confidence_value;
-  double confidence_feature, confidence_feature_weighted;
-  int i, num_features,current_choice;
-  int rc, error_check;
+  float features[NUM_CONF_FEATURES];
+  double value=1.0, final_value = 0, confidence_value;
+  int current_choice;
+  int error_check;
   int num_choices,num_choices_left;
+  srec_nbest_choice_info* infos;
 
-  confidence_value = 1.0;
-  num_choices_left = num_choices = srec_nbest_get_num_choices(nbestlist);
+  if (!nbestlist)
+    return 0;
+  num_choices = srec_nbest_get_num_choices(nbestlist);
+  if (num_choices == 0)
+    return 0;
+
+  /* the costs and speech boundaries of all the choices, in one pass */
+  infos = (srec_nbest_choice_info*) CALLOC(num_choices, sizeof(srec_nbest_choice_info), "ca.confidence.choices");
+  if (infos == NULL)
+  {
+    PLogError("confscor failed\n");
+    return 1;
+  }
+  num_choices = srec_nbest_get_choice_infos(nbestlist, infos, num_choices);
 
   for(current_choice=0;current_choice<num_choices;current_choice++)
     {
-      confidence_value = 1.0;
-      rc = CA_ConfScorerGetFeatures(recog, nbestlist, features, &num_features, current_choice, num_choices_left);
-      if (rc)
-        {
-          PLogError("confscor failed\n");
-          error_check = srec_nbest_put_confidence_value(nbestlist, current_choice, 0);
-          if(error_check)
-            return 1;
-          num_choices_left--;
-          continue;
-        }
+      num_choices_left = num_choices - current_choice;
+      CA_ConfScorerGetFeatures(infos, features, current_choice, num_choices_left);
 
       if (num_choices_left == 1)
-        {
-          for (i=0;i<NUM_CONF_FEATURES;i++) {
-            if(i==CONF_FEATURE_SCORE_DIFF || i==CONF_FEATURE_SCORE_DIFF13) {
-              confidence_feature_weighted = 1.0;
-            }
-            else {
-              confidence_feature = 1.0/(1.0 + exp((hConfidenceScorer->one_nbest.scale[i] *
-                                                   features[i]) + hConfidenceScorer->one_nbest.offset[i]));
-              confidence_feature_weighted = pow(confidence_feature,hConfidenceScorer->one_nbest.weight[i]);
-            }
-            confidence_value = confidence_value * confidence_feature_weighted;
-          }
-        }
+        confidence_value = CA_ConfScorerEvaluate(&hConfidenceScorer->one_nbest, features, 1);
       else
-        {
-          for (i=0;i<NUM_CONF_FEATURES;i++) {
-            confidence_feature = 1.0/(1.0 + exp((hConfidenceScorer->many_nbest.scale[i] *
-                                                 features[i]) + hConfidenceScorer->many_nbest.offset[i]));
-            confidence_value = confidence_value * pow(confidence_feature, hConfidenceScorer->many_nbest.weight[i]);
-          }
-        }
+        confidence_value = CA_ConfScorerEvaluate(&hConfidenceScorer->many_nbest, features, 0);
 
       value *= confidence_value;
       final_value = 1000.0 * value;
       error_check = srec_nbest_put_confidence_value(nbestlist, current_choice, (int)final_value);
       if(error_check)
-        return 1;
-      num_choices_left--;
+        {
+          FREE(infos);
+          return 1;
+        }
 	}
+  FREE(infos);
 	num_choices_left = srec_nbest_fix_homonym_confidence_values( nbestlist);
 #ifdef SREC_ENGINE_VERBOSE_LOGGING
-  PLogMessage("confidence %d features ", (int)final_value);
-  for (i = 0; i < num_features; i++)
-    PLogMessage(" %s %f", conf_feature_names[i], features[i]);
-#endif
-
-  return 0;
-}
-
-int CA_ConfScorerGetFeatures(CA_Recog* recog, CA_NBestList *nbestlist, float* features, int *num_features,
-							 int choice_number, int num_choices_left)
-{
-  //static char* rejfeat_type = (char*) - 1;
-  int rc;
-  asr_int32_t num_speech_frames = 400;
-#define MAX_ENTRY_LENGTH 512
-  char label0[MAX_ENTRY_LENGTH];
-  char label1[MAX_ENTRY_LENGTH];
-  asr_int32_t cost0, cost1, cost2;
-  asr_int32_t speech_cost0;
-  asr_int32_t gsm_cost = 0, am_index = 0, num_words = 0;
-
-  if (!nbestlist)
-    return 1;
-
-  ASSERT(features);
-  ASSERT(num_features);
-  ASSERT(nbestlist);
-  ASSERT(recog);
-
-  /* @F=(,"gdiff","sdiff12","sdiff13","spf1","speechcost0","gdiffpf");
-            0       1          2        3         4           5      */
- if (num_choices_left > 0)
   {
-    rc = srec_nbest_get_result(nbestlist, choice_number, label0, MAX_ENTRY_LENGTH, &cost0, choice_number);
-    if (rc) return rc;
-    rc = srec_nbest_get_choice_info(nbestlist, choice_number, &num_speech_frames, "num_speech_frames");
-    if (rc) return rc;
-    rc = srec_nbest_get_choice_info(nbestlist, choice_number, &speech_cost0, "speech_frames_cost");
-    if (rc) return rc;
-    ASSERT(!rc);
-    features[CONF_FEATURE_ABSOLUTE_SCORE] = ((float)(speech_cost0));
-    features[CONF_FEATURE_SCORE_PER_FRAME] = ((float)(speech_cost0)) / (float)num_speech_frames;
-    if (num_choices_left> 1)
-    {
-      rc = srec_nbest_get_result(nbestlist, choice_number+1, label1, MAX_ENTRY_LENGTH, &cost1, choice_number);
-      if (rc) return rc;
-      features[CONF_FEATURE_SCORE_DIFF] = ((float)cost1 - (float)cost0);
-      if (num_choices_left > 2)
-      {
-        rc = srec_nbest_get_result(nbestlist, choice_number+2, label1, MAX_ENTRY_LENGTH, &cost2, choice_number);
-        if (rc) return rc;
-        features[CONF_FEATURE_SCORE_DIFF13] = ((float)cost2 - (float)cost0);
-      }
-      else
-      {
-        cost2 = (-1);
-        features[CONF_FEATURE_SCORE_DIFF13] = ((float)cost1 - (float)cost0);
-      }
-    }
-    else
-    {
-      features[CONF_FEATURE_SCORE_DIFF] = 400;
-      features[CONF_FEATURE_SCORE_DIFF13] = 400;
-      cost1 = cost2 = (-1);
-    }
-
-
-    srec_nbest_get_choice_info(nbestlist, choice_number, &gsm_cost, "gsm_cost");
-    srec_nbest_get_choice_info(nbestlist, choice_number, &am_index, "acoustic_model_index");
-    srec_nbest_get_choice_info(nbestlist, choice_number, &num_words, "num_words");
-
-    features[CONF_FEATURE_GDIFF] = (float)(speech_cost0 - gsm_cost);
-    /* should never happen */
-    if (num_speech_frames == 0) num_speech_frames = 1;
-    features[CONF_FEATURE_GDIFF_PER_FRAME] = ((float)(speech_cost0 - gsm_cost)) / (float)num_speech_frames;
-    // features[CONF_FEATURE_GENDER_VALUE] = (float)am_index;
-    *num_features = NUM_CONF_FEATURES;
-    rc = 0;
+    int i;
+    PLogMessage("confidence %d features ", (int)final_value);
+    for (i = 0; i < NUM_CONF_FEATURES; i++)
+      PLogMessage(" %s %f", conf_feature_names[i], features[i]);
   }
-  else
-  {
-    *num_features = 0;
-    rc = 1;
-  }
-
-#define DUMP_FEATURES_FOR_RETRAIN 0
-#if DUMP_FEATURES_FOR_RETRAIN
-  srec_nbest_get_choice_info(nbestlist, 0, &gsm_cost, "gsm_cost");
-  srec_nbest_get_choice_info(nbestlist, 0, &am_index, "acoustic_model_index");
-  srec_nbest_get_choice_info(nbestlist, 0, &num_words, "num_words");
-
-  printf("REJFEATS:");
-  printf(" cost0(%d)", cost0);
-  printf(" cost1(%d)", cost1);
-  printf(" cost2(%d)", cost2);
-  printf(" speechcost0(%d)", speech_cost0);
-  printf(" nframes0(%d)", num_speech_frames);
-  printf(" nwords0(%d)", num_words);
-  printf(" gsmcost(%d)", gsm_cost);
-  printf(" amindex(%d)", am_index);
-  /* printf(" glmcost(%d)", glm_cost);*/
-  printf("\n");
 #endif
-  return rc; /* no error reported */
+
+  return 0;
 }
 
 
@@ -81,6 +81,7 @@ int CA_ConfigureRecognition(CA_Recog *hRecog, CA_RecInputParams *hRecInput)
   rc = allocate_recognition(hRecog->recm,
                             hRecInput->viterbi_prune_thresh,
                             hRecInput->max_hmm_tokens,
+                            hRecInput->max_active_hmm_tokens,
                             hRecInput->max_fsmnode_tokens,
                             hRecInput->max_word_tokens,
                             hRecInput->max_altword_tokens,
@@ -89,7 +90,13 @@ int CA_ConfigureRecognition(CA_Recog *hRecog, CA_RecInputParams *hRecInput)
                             hRecInput->max_fsm_arcs,
                             hRecInput->max_frames,
                             hRecInput->max_model_states,
-                            hRecInput->max_searches);
+                            hRecInput->max_searches,
+                            hRecInput->frame_budget_usec,
+                            hRecInput->phone_lookahead_margin,
+                            hRecInput->first_pass_pdfs,
+                            hRecInput->score_threads,
+                            hRecInput->max_grammars,
+                            hRecInput->enrollment_search);
   if (rc) return rc;
 
   /*rc =*/
@@ -201,6 +208,22 @@ void CA_AdvanceRecognitionByFrame(CA_Recog *hRecog, CA_Pattern *hPattern,
 }
 
 
+void CA_RescoreRecognition(CA_Recog *hRecog, CA_Pattern *hPattern)
+{
+  TRY_CA_EXCEPT
+  ASSERT(hRecog);
+  ASSERT(hPattern);
+  if (hPattern->is_loaded == False)
+    SERVICE_ERROR(PATTERN_NOT_LOADED);
+
+  rescore_recognition(hRecog->recm, hRecog->eosd_parms, &hPattern->data);
+  return;
+
+  BEG_CATCH_CA_EXCEPT
+  END_CATCH_CA_EXCEPT(hRecog)
+}
+
+
 int CA_EndRecognition(CA_Recog *hRecog, CA_Pattern *hPattern,
                       CA_Utterance *hUtterance)
 {
@@ -59,6 +59,16 @@ int CA_AddWordToSyntax(CA_Syntax* syntax, const char* slot,
   return rc;
 }
 
+int CA_AddWordsToSyntax(CA_Syntax* syntax, const char* slot, int num_words,
+                        const char **phrases, const char** pronunciations,
+                        const int* weights, int* results)
+{
+  int rc;
+  rc = FST_AddWordsToGrammar(syntax->synx, slot, num_words, phrases, pronunciations,
+                             weights, results);
+  return rc;
+}
+
 int CA_ResetSyntax(CA_Syntax* syntax)
 {
   int rc;
@@ -209,6 +219,34 @@ CLEANUP:
   return 0;
 }
 
+int CA_DumpSyntaxDelta(CA_Syntax* hSyntax, const char* deltaname)
+{
+  int result;
+  PFile* fp;
+
+  fp = pfopen ( deltaname, L("wb") );
+  if ( fp == NULL )
+    return 1;
+
+  result = FST_DumpContextDelta(hSyntax->synx, fp);
+  pfclose(fp);
+  return result ? 1 : 0;
+}
+
+int CA_LoadSyntaxDelta(CA_Syntax* hSyntax, const LCHAR* deltaname)
+{
+  int result;
+  PFile* fp;
+
+  fp = pfopen ( deltaname, L("rb") );
+  if ( fp == NULL )
+    return 1;
+
+  result = FST_LoadContextDelta(hSyntax->synx, fp);
+  pfclose(fp);
+  return result ? 1 : 0;
+}
+
 /* from syn_file.c */
 
 CA_Syntax *CA_AllocateSyntax(void)
@@ -357,3 +395,27 @@ void CA_ClearSyntaxForRecognizer(CA_Syntax *hSyntax, CA_Recog *hRecog)
   rc = clear_grammars_for_recognition(hRecog->recm);
   return;
 }
+
+void CA_DeactivateSyntaxForRecognizer(CA_Syntax *hSyntax, CA_Recog *hRecog)
+{
+  if (!hSyntax || !hRecog)
+    return;
+  deactivate_grammar_for_recognition(hRecog->recm, hSyntax->synx);
+}
+
+int CA_IsBestResultSyntax(CA_Syntax *hSyntax, CA_Recog *hRecog)
+{
+  if (!hSyntax || !hRecog)
+    return 0;
+  return srec_get_bestcost_context(hRecog->recm) == hSyntax->synx;
+}
+
+int CA_IsEnrollmentRecognition(CA_Recog *hRecog)
+{
+  srec_context* context;
+
+  if (!hRecog)
+    return 0;
+  context = srec_get_bestcost_context(hRecog->recm);
+  return context != NULL && FST_IsVoiceEnrollment(context);
+}
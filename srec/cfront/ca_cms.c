@@ -68,6 +68,24 @@ ESR_ReturnCode CA_GetCMSParameters ( CA_Wave *hWave, LCHAR *param_string, size_t
 }
 
 
+ESR_ReturnCode CA_GetCMSState ( CA_Wave *hWave, swicms_state *state )
+{
+  if ( hWave == NULL || hWave->data.channel->swicms == NULL )
+    return ( ESR_INVALID_STATE );
+  swicms_get_state ( hWave->data.channel->swicms, state );
+  return ( ESR_SUCCESS );
+}
+
+
+ESR_ReturnCode CA_SetCMSState ( CA_Wave *hWave, const swicms_state *state )
+{
+  if ( hWave == NULL || hWave->data.channel->swicms == NULL )
+    return ( ESR_INVALID_STATE );
+  swicms_set_state ( hWave->data.channel->swicms, state );
+  return ( ESR_SUCCESS );
+}
+
+
 void CA_ReLoadCMSParameters(CA_Wave *hWave, const char *basename)
 {
   ASSERT(hWave);
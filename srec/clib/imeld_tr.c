@@ -37,27 +37,40 @@
 
 static const char imeld_tr[] = "$Id: imeld_tr.c,v 1.2.10.10 2008/04/01 18:23:20 dahan Exp $";
 
-void linear_transform_frame(preprocessed *prep, imeldata *fram, int do_shift)
+/*  Number of frames transformed together by linear_transform_frames()
+*/
+#define TRANSFORM_BLOCK 4
+
+static PINLINE imeldata transform_row(const imeldata *row, const imeldata *fram,
+                                      int dim)
 /*
-**  Note the matrix is the transpose of the transformation
-**  To transform a single frame in place */
+**  One output element of the transform.  The products are summed in four
+**  independent chains so that they can be kept in vector lanes; an integer
+**  sum does not depend on its order, so the result is the one of the plain
+**  loop */
 {
-  int      ii, jj;
-  imeldata vec[MAX_DIMEN];
-  int dim = prep->dim;
+  int      jj;
+  imeldata s0 = 0, s1 = 0, s2 = 0, s3 = 0;
 
-  ASSERT(prep);
-  ASSERT(prep->dim < MAX_DIMEN);
-  ASSERT(fram);
-  for (ii = 0; ii < dim; ii++)
+  for (jj = 0; jj + 3 < dim; jj += 4)
   {
-    vec[ii] = 0;
-    for (jj = 0; jj < prep->dim; jj++)
-      vec[ii] += prep->matrix[ii][jj] * fram[jj];
-    ASSERT(prep->imel_shift > 0);
-    vec[ii] = (imeldata) SHIFT_DOWN((int)vec[ii],
-                                    (unsigned int)prep->imel_shift);
+    s0 += row[jj] * fram[jj];
+    s1 += row[jj + 1] * fram[jj + 1];
+    s2 += row[jj + 2] * fram[jj + 2];
+    s3 += row[jj + 3] * fram[jj + 3];
   }
+  for (; jj < dim; jj++)
+    s0 += row[jj] * fram[jj];
+  return ((s0 + s1) + (s2 + s3));
+}
+
+static PINLINE void store_transformed(preprocessed *prep, imeldata *fram,
+                                      const imeldata *vec, int do_shift)
+/*
+**  Offsets and clamps a transformed frame to 8 bits, or copies it unchanged */
+{
+  int ii;
+  int dim = prep->dim;
 
   if (do_shift)
   {
@@ -73,6 +86,118 @@ void linear_transform_frame(preprocessed *prep, imeldata *fram, int do_shift)
     for (ii = 0; ii < dim; ii++)
       fram[ii] = vec[ii];
   }
+}
+
+void linear_transform_frame(preprocessed *prep, imeldata *fram, int do_shift)
+/*
+**  Note the matrix is the transpose of the transformation
+**  To transform a single frame in place */
+{
+  int      ii;
+  imeldata vec[MAX_DIMEN];
+  int dim = prep->dim;
+  unsigned int shift = (unsigned int) prep->imel_shift;
+
+  ASSERT(prep);
+  ASSERT(prep->dim < MAX_DIMEN);
+  ASSERT(prep->imel_shift > 0);
+  ASSERT(fram);
+  for (ii = 0; ii < dim; ii++)
+    vec[ii] = (imeldata) SHIFT_DOWN((int) transform_row(prep->matrix[ii], fram, dim),
+                                    shift);
+  store_transformed(prep, fram, vec, do_shift);
+  return;
+}
+
+void linear_transform_frames(preprocessed *prep, imeldata **frames,
+                             int num_frames, int do_shift)
+/*
+**  To transform several frames in place, with the same result as
+**  linear_transform_frame() on each of them.  The frames are taken
+**  TRANSFORM_BLOCK at a time so that every matrix row is read once per block
+**  rather than once per frame */
+{
+  int      ii, jj, ff;
+  imeldata vec[TRANSFORM_BLOCK][MAX_DIMEN];
+  int dim = prep->dim;
+  unsigned int shift = (unsigned int) prep->imel_shift;
+
+  ASSERT(prep);
+  ASSERT(prep->dim < MAX_DIMEN);
+  ASSERT(prep->imel_shift > 0);
+  ASSERT(frames);
+  for (ff = 0; ff + TRANSFORM_BLOCK <= num_frames; ff += TRANSFORM_BLOCK)
+  {
+    const imeldata *f0 = frames[ff];
+    const imeldata *f1 = frames[ff + 1];
+    const imeldata *f2 = frames[ff + 2];
+    const imeldata *f3 = frames[ff + 3];
+
+    for (ii = 0; ii < dim; ii++)
+    {
+      const imeldata *row = prep->matrix[ii];
+      imeldata s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+      for (jj = 0; jj < dim; jj++)
+      {
+        s0 += row[jj] * f0[jj];
+        s1 += row[jj] * f1[jj];
+        s2 += row[jj] * f2[jj];
+        s3 += row[jj] * f3[jj];
+      }
+      vec[0][ii] = (imeldata) SHIFT_DOWN((int) s0, shift);
+      vec[1][ii] = (imeldata) SHIFT_DOWN((int) s1, shift);
+      vec[2][ii] = (imeldata) SHIFT_DOWN((int) s2, shift);
+      vec[3][ii] = (imeldata) SHIFT_DOWN((int) s3, shift);
+    }
+    for (jj = 0; jj < TRANSFORM_BLOCK; jj++)
+      store_transformed(prep, frames[ff + jj], vec[jj], do_shift);
+  }
+  for (; ff < num_frames; ff++)
+    linear_transform_frame(prep, frames[ff], do_shift);
+  return;
+}
+
+void transform_and_normalize_frame(preprocessed *prep, imeldata *fram,
+                                   imeldata *unnorm, const imeldata *adjust,
+                                   int adjust_dim)
+/*
+**  The whole post-processing of a data frame in one pass: the channel
+**  offset, the linear transformation with its offset and 8-bit clamp, and
+**  the channel normalization of the first adjust_dim elements.  fram is
+**  overwritten with the normalized frame and unnorm receives the frame
+**  before normalization.  adjust may be NULL to skip the normalization */
+{
+  int      ii;
+  imeldata in[MAX_DIMEN];
+  imeldata vec[MAX_DIMEN];
+  int dim = prep->dim;
+  unsigned int shift = (unsigned int) prep->imel_shift;
+  const imeldata *src = fram;
+
+  ASSERT(prep);
+  ASSERT(prep->dim < MAX_DIMEN);
+  ASSERT(prep->imel_shift > 0);
+  ASSERT(fram);
+  ASSERT(unnorm);
+  ASSERT(adjust_dim <= dim);
+  if (prep->chan_offset)
+  {
+    for (ii = 0; ii < dim; ii++)
+      in[ii] = fram[ii] + prep->chan_offset[ii];
+    src = in;
+  }
+  for (ii = 0; ii < dim; ii++)
+    vec[ii] = (imeldata) SHIFT_DOWN((int) transform_row(prep->matrix[ii], src, dim),
+                                    shift);
+  store_transformed(prep, unnorm, vec, True);
+
+  if (!adjust)
+    adjust_dim = 0;
+  for (ii = 0; ii < adjust_dim; ii++)
+    fram[ii] = MAKEBYTE(unnorm[ii] + adjust[ii]);
+  for (; ii < dim; ii++)
+    fram[ii] = unnorm[ii];
   return;
 }
 
@@ -450,6 +450,37 @@ ESR_ReturnCode swicms_set_cmn ( swicms_norm_info* swicms, const char *cmn_params
 }
 
 
+void swicms_get_state(swicms_norm_info* swicms, swicms_state* state)
+{
+  int i;
+
+  /* the adapted mean lives in lda_cmn once the first frame went through */
+  for (i = 0; i < MAX_CHAN_DIM; i++)
+    state->cmn[i] = swicms->is_valid ? swicms->lda_cmn[i] : swicms->cmn[i];
+  if (swicms->is_valid)
+    inverse_transform_frame(swicms->_prep, state->cmn, 1 /*do_shift*/);
+  state->num_frames_in_cmn = swicms->num_frames_in_cmn;
+}
+
+
+void swicms_set_state(swicms_norm_info* swicms, const swicms_state* state)
+{
+  int i;
+
+  for (i = 0; i < MAX_CHAN_DIM; i++)
+    swicms->cmn[i] = state->cmn[i];
+  swicms->num_frames_in_cmn = state->num_frames_in_cmn;
+
+  /* lda_cmn and adjust are recalculated by swicms_lda_process() on the
+     next frame, and the in-utt estimate belonged to the previous channel */
+  swicms->is_valid = 0;
+  swicms->inutt.num_frames_since_bou = 0;
+  swicms->inutt.num_frames_in_accum = 0;
+  for (i = 0; i < MAX_CHAN_DIM; i++)
+    swicms->inutt.accum[i] = 0;
+}
+
+
 int swicms_cache_frame(swicms_norm_info* swicms, imeldata* frame, int dimen)
 {
   int i;
@@ -644,11 +675,13 @@ int swicms_update(swicms_norm_info* swicms, int speech_start, int speech_end)
 int swicms_lda_process(swicms_norm_info* swicms, preprocessed* prep)
 {
   int i;
+  imeldata* means[2];
 
   for (i = 0; i < MAX_CHAN_DIM; i++) swicms->lda_tmn[i] = swicms->tmn[i];
   for (i = 0; i < MAX_CHAN_DIM; i++) swicms->lda_cmn[i] = swicms->cmn[i];
-  linear_transform_frame(prep, swicms->lda_tmn, 1 /*do_shift*/);
-  linear_transform_frame(prep, swicms->lda_cmn, 1 /*do_shift*/);
+  means[0] = swicms->lda_tmn;
+  means[1] = swicms->lda_cmn;
+  linear_transform_frames(prep, means, 2, 1 /*do_shift*/);
 
   for (i = 0; i < MAX_CHAN_DIM; i++)
   {
@@ -431,10 +431,10 @@ static PINLINE prdata Gaussian_Grand_Density_Swimodel(const preprocessed *data,
   return (pval);
 }
 
-scodata mixture_diagonal_gaussian_swimodel(const preprocessed *prep,
-    const SWIhmmState *spd, short num_dims)
+static PINLINE scodata Mixture_Diagonal_Gaussian_Swimodel(const preprocessed *prep,
+    const SWIhmmState *spd, short num_dims, int num_pdfs)
 /*
-**  Observation probability function
+**  Observation probability function, over the first num_pdfs pdfs
 */
 {
   int ii;
@@ -452,7 +452,7 @@ scodata mixture_diagonal_gaussian_swimodel(const preprocessed *prep,
   meanptr = spd->means;
   weightptr = spd->weights;
 
-  for (ii = 0; ii < spd->num_pdfs; ii++)
+  for (ii = 0; ii < num_pdfs; ii++)
   {
     gval = ((prdata) * (weightptr++) * prep->add.scale
             + Gaussian_Grand_Density_Swimodel(prep, meanptr));
@@ -480,3 +480,20 @@ scodata mixture_diagonal_gaussian_swimodel(const preprocessed *prep,
 
   return ((scodata)pval);
 }
+
+scodata mixture_diagonal_gaussian_swimodel(const preprocessed *prep,
+    const SWIhmmState *spd, short num_dims)
+{
+  return Mixture_Diagonal_Gaussian_Swimodel(prep, spd, num_dims, spd->num_pdfs);
+}
+
+/* only the first max_pdfs pdfs of the state, a cheaper approximation
+   for the first pass of two-pass decoding */
+
+scodata mixture_diagonal_gaussian_swimodel_npdfs(const preprocessed *prep,
+    const SWIhmmState *spd, short num_dims, short max_pdfs)
+{
+  if (max_pdfs <= 0 || max_pdfs >= spd->num_pdfs)
+    return Mixture_Diagonal_Gaussian_Swimodel(prep, spd, num_dims, spd->num_pdfs);
+  return Mixture_Diagonal_Gaussian_Swimodel(prep, spd, num_dims, max_pdfs);
+}
@@ -64,6 +64,48 @@ static const char voc_read[] = "$Id: voc_read.c,v 1.14.6.18 2008/03/05 21:18:44
 
 #ifndef _RTT
 
+/* the labels of two entries are equal up to the ' ' terminating them */
+static int same_label(const char* a, const char* b) {
+  while (*a == *b && *a != ' ' && *a != '\n') {
+    a++;
+    b++;
+  }
+  return (*a == ' ' || *a == '\n') && (*b == ' ' || *b == '\n');
+}
+
+/**
+ *  Build a sorted table with the offset of the first entry of each distinct
+ *  label, so that get_prons() can binary search without scanning for newlines
+ *  and find the homographs of a label as one contiguous range.
+ *  returns -1 on error
+ */
+static int build_label_index(vocab_info* voc)
+{
+  const char* entry;
+  const char* prev;
+  const char* end = voc->ok_file_data + voc->ok_file_data_length;
+  int num_entries = 0;
+
+  for (entry = voc->first_entry; entry < end; entry++)
+    if (*entry == '\n') num_entries++;
+
+  voc->label_index = (asr_uint32_t*) CALLOC(num_entries + 1, sizeof(asr_uint32_t), "clib.voc.label_index");
+  if (voc->label_index == NULL) return -1;
+
+  voc->num_labels = 0;
+  prev = NULL;
+  for (entry = voc->first_entry; entry < end; ) {
+    if (prev == NULL || !same_label(prev, entry))
+      voc->label_index[voc->num_labels++] = (asr_uint32_t)(entry - voc->ok_file_data);
+    prev = entry;
+    while (*entry++ != '\n') ;
+  }
+  /* sentinel, the end of the last label's range */
+  voc->label_index[voc->num_labels] = (asr_uint32_t) voc->ok_file_data_length;
+
+  return 0;
+}
+
 /**
  *  Read word models and their phoneme transcriptions from .ok or .voc files.
  *  returns -1 on error
@@ -142,6 +184,11 @@ int read_word_transcription(const LCHAR* basename, vocab_info* voc, ESR_Locale*
     while (*ok++ != '\n') ;
   }
 
+  if (build_label_index(voc)) {
+    PLogError(L("read_word_transcription: failed to index %s\n"), basename);
+    goto CLEANUP;
+  }
+
   return 0;
 
 CLEANUP:
@@ -164,78 +211,54 @@ static int kompare(const char* label, const char* entry) {
 
 int get_prons(const vocab_info* voc, const char* label, char* prons, int prons_len) {
   int num_prons;
-  const char* low;
-  const char* middle;
-  const char* high;
+  int low;
+  int middle;
+  int high;
+  const char* entry;
+  const char* end;
 
   //PLogError(L("get_prons '%s'"), label);
 
   /* dictionaries are usually lower case, so do this for speed */
   if (!voc->hasUpper && 'A' <= *label && *label <= 'Z') return 0;
 
-  /* binary search to find matching entry */
-  low = voc->first_entry;
-  high = voc->last_entry;
+  /* binary search the label index to find the matching label */
+  low = 0;
+  high = voc->num_labels - 1;
   while (1) {
-    /* pick a point in the middle and align to next entry */
-    middle = low + ((high - low) >> 1) - 1;
-    while (*middle++ != '\n') ;
+    /* nothing found */
+    if (low > high) return 0;
+
+    middle = low + ((high - low) >> 1);
 
     /* compare 'label' to 'middle' */
-    int diff = kompare(label, middle);
+    int diff = kompare(label, voc->ok_file_data + voc->label_index[middle]);
     if (diff == 0) break;
 
-    /* nothing found */
-    if (low == high) return 0;
-
-    /* 'middle' aligned to 'high', so move 'high' down */
-    if (middle == high) {
-      high -= 2;
-      while (*high != '\n') high--;
-      high++;
-      continue;
-    }
-
-    if (diff > 0) low = middle;
-    else high = middle;
-  }
-
-  /* back up to find the first entry equal to 'label' */
-  low = middle;
-  while (voc->first_entry < low) {
-    const char* lo;
-    for (lo = low - 2; *lo != '\n'; lo--) ;
-    lo++;
-    if (kompare(label, lo)) break;
-    low = lo;
+    if (diff > 0) low = middle + 1;
+    else high = middle - 1;
   }
 
-  /* move forward to the last entry equal to 'label' */
-  high = middle;
-  while (high < voc->last_entry) {
-    const char* hi;
-    for (hi = high; *hi != '\n'; hi++) ;
-    hi++;
-    if (kompare(label, hi)) break;
-    high = hi;
-  }
+  /* all entries for 'label' lie between this label and the next one */
+  entry = voc->ok_file_data + voc->label_index[middle];
+  end = voc->ok_file_data + voc->label_index[middle + 1];
 
   /* loop over all the entries */
   num_prons = 0;
-  while (low <= high) {
+  while (entry < end) {
     /* scan over the label */
-    while (*low++ != ' ') ;
+    while (*entry++ != ' ') ;
 
     /* skip the whitespace */
-    while (*low == ' ') low++;
+    while (*entry == ' ') entry++;
 
     /* copy the pron */
-    while (*low != '\n') {
+    while (*entry != '\n') {
       if (--prons_len <= 2) return -1;
-      *prons++ = *low++;
+      *prons++ = *entry++;
     }
     *prons++ = 0;
-    low++;
+    entry++;
     num_prons++;
   }
   *prons++ = 0;
@@ -249,6 +272,9 @@ void delete_word_transcription(vocab_info* voc)
 
   voc->first_entry = 0;
   voc->last_entry = 0;
+  if (voc->label_index) FREE(voc->label_index);
+  voc->label_index = NULL;
+  voc->num_labels = 0;
   if (voc->ok_file_data) munmap_zip(voc->ok_file_data, voc->ok_file_data_length);
   voc->ok_file_data = NULL;
   voc->ok_file_data_length = 0;
@@ -44,6 +44,7 @@ static const char *rcsid = 0 ? (const char *) &rcsid :
 													         check on complete paths */
 #define ASTAR_PRUNE_DELTA 20000
 #define DEBUG_PARP_MANAGEMENT 0
+#define DUMP_ASTAR_LATTICES   0 /* for tools/astar_bench */
 
 #if PRINT_ASTAR_DETAILS
 static int do_draw_as_dotty = 0;
@@ -52,6 +53,10 @@ static int do_draw_file_idx = 0;
 int astar_draw_tree_as_dotty(const char* file, srec* rec, AstarStack* stack);
 #endif
 
+#if DUMP_ASTAR_LATTICES
+static int do_dump_file_idx = 0;
+#endif
+
 /*
   The word graph is represented as an arc_token_list,
   arc_token's are chained together 2 linked lists,
@@ -245,6 +250,10 @@ void print_path(partial_path* path, srec* rec, char* msg);
 void sort_partial_paths(partial_path** parps, int num_parps);
 void insert_partial_path(partial_path** parps, int *pnum_parps,
                          partial_path* insert_parp);
+static partial_path* pop_best_partial_path(partial_path** parps, int *pnum_parps);
+static partial_path* remove_worst_partial_path(partial_path** parps, int *pnum_parps);
+static int find_worst_partial_path(partial_path** parps, int num_parps);
+static void heapify_partial_paths(partial_path** parps, int num_parps);
 partial_path* make_new_partial_path(AstarStack* stack);
 /*void free_partial_path(AstarStack* stack, partial_path* parp); put the proto in astar.h */
 
@@ -444,11 +453,10 @@ partial_path* make_new_partial_path(AstarStack* stack)
 #if PRINT_ASTAR_DETAILS
     printf("Warning: ran out of partial_paths, reprune\n");
 #endif
-    /* kill the last one, and return it, this may free more than one parp! */
+    /* kill the worst one, and return it, this may free more than one parp! */
     if (stack->num_active_paths == 0)
       return 0;
-    stack->num_active_paths--;
-    return_parp = stack->active_paths[stack->num_active_paths];
+    return_parp = remove_worst_partial_path(stack->active_paths, &stack->num_active_paths);
     hash_del((FixedSizeHash*)stack->pphash, return_parp);
     free_partial_path(stack, return_parp);
     return_parp = stack->free_parp_list;
@@ -608,14 +616,28 @@ int astar_stack_prepare(AstarStack* stack, int request_nbest_len, srec* rec)
       /* here .. check for dups ?? */
       stack->complete_paths[ stack->num_complete_paths++] = parp;
       if (stack->num_complete_paths == request_nbest_len)
-        return 0;
+        break;
     }
     else if (parp)
     {
       stack->active_paths[ stack->num_active_paths++] = parp;
     }
   }
+  heapify_partial_paths(stack->active_paths, stack->num_active_paths);
   
+#if DUMP_ASTAR_LATTICES
+  {
+    char tmp[32];
+    PFile* fp;
+    sprintf(tmp, "astar.%.3d.lat", do_dump_file_idx++);
+    fp = pfopen(tmp, L("wb"));
+    if (fp)
+    {
+      srec_dump_word_lattice(rec, fp);
+      pfclose(fp);
+    }
+  }
+#endif
   list_free_parps(stack, "astar_stack_prepare ");
   
   return 0;
@@ -706,9 +728,7 @@ int astar_stack_do_backwards_search(srec* rec, int request_nbest_len)
 #endif
                         
     /* pop this one */
-    for (i = 0; i < stack->num_active_paths - 1; i++)
-      stack->active_paths[i] = stack->active_paths[i+1];
-    stack->num_active_paths--;
+    pop_best_partial_path(stack->active_paths, &stack->num_active_paths);
     
     if (wtoken->end_time != MAXframeID)
     {
@@ -770,7 +790,8 @@ int astar_stack_do_backwards_search(srec* rec, int request_nbest_len)
       }
       else if (stack->num_active_paths == stack->max_active_paths)
       {
-        max_cost = stack->active_paths[ stack->num_active_paths-1]->costsofar;
+        i = find_worst_partial_path(stack->active_paths, stack->num_active_paths);
+        max_cost = stack->active_paths[i]->costsofar;
       }
       else if (stack->num_active_paths > 0)
       {
@@ -819,9 +840,8 @@ int astar_stack_do_backwards_search(srec* rec, int request_nbest_len)
 #endif
         if (stack->num_active_paths == stack->max_active_paths)
         {
-          /* kill the last one */
-          stack->num_active_paths--;
-          tparp = stack->active_paths[stack->num_active_paths];
+          /* kill the worst one */
+          tparp = remove_worst_partial_path(stack->active_paths, &stack->num_active_paths);
           hash_del((FixedSizeHash*)stack->pphash, tparp);
           free_partial_path(stack, tparp);
         }
@@ -880,44 +900,103 @@ int astar_stack_do_backwards_search(srec* rec, int request_nbest_len)
   return 0;
 }
 
+/* stable, so paths of equal cost keep the order they completed in */
+
 void sort_partial_paths(partial_path** parps, int num_parps)
 {
   int i, j;
-  for (i = 0; i < num_parps; i++)
+  partial_path* parp;
+  for (i = 1; i < num_parps; i++)
   {
-    for (j = 0; j < num_parps - 1; j++)
-    {
-      if (parps[j]->costsofar > parps[j+1]->costsofar)
-      {
-        partial_path* parp = parps[j];
-        parps[j] = parps[j+1];
-        parps[j+1] = parp;
-      }
-    }
+    parp = parps[i];
+    for (j = i; j > 0 && parps[j-1]->costsofar > parp->costsofar; j--)
+      parps[j] = parps[j-1];
+    parps[j] = parp;
   }
 }
 
-void insert_partial_path(partial_path** parps, int *pnum_parps, partial_path* insert_parp)
+/* the active paths are kept as a binary heap on costsofar, with the
+   best path at parps[0].  A sorted array is also a valid heap, so
+   astar_stack_prepare_from_active_search() can fill it in order */
+
+static void sift_up_partial_path(partial_path** parps, int i)
 {
-  int i, j, insert_index;
-  int num_parps = *pnum_parps;
-  
-  /* maintain the list sorted, search the list linearly for now,
-     do priority_q type heap later */
-  insert_index = num_parps;
-  for (i = 0; i < num_parps; i++)
+  partial_path* parp = parps[i];
+  int parent;
+  for (; i > 0; i = parent)
   {
-    if (insert_parp->costsofar < parps[i]->costsofar)
-    {
-      insert_index = i;
+    parent = (i - 1) / 2;
+    if (parps[parent]->costsofar <= parp->costsofar)
       break;
-    }
+    parps[i] = parps[parent];
+  }
+  parps[i] = parp;
+}
+
+static void sift_down_partial_path(partial_path** parps, int num_parps, int i)
+{
+  partial_path* parp = parps[i];
+  int child;
+  for (; (child = 2 * i + 1) < num_parps; i = child)
+  {
+    if (child + 1 < num_parps && parps[child+1]->costsofar < parps[child]->costsofar)
+      child++;
+    if (parp->costsofar <= parps[child]->costsofar)
+      break;
+    parps[i] = parps[child];
   }
-  for (j = num_parps; j > insert_index; --j)
-    parps[j] = parps[j-1];
-  parps[j] = insert_parp;
-  num_parps++;
-  *pnum_parps = num_parps;
+  parps[i] = parp;
+}
+
+static void heapify_partial_paths(partial_path** parps, int num_parps)
+{
+  int i;
+  for (i = num_parps / 2 - 1; i >= 0; i--)
+    sift_down_partial_path(parps, num_parps, i);
+}
+
+void insert_partial_path(partial_path** parps, int *pnum_parps, partial_path* insert_parp)
+{
+  parps[*pnum_parps] = insert_parp;
+  sift_up_partial_path(parps, *pnum_parps);
+  (*pnum_parps)++;
+}
+
+static partial_path* remove_partial_path_at(partial_path** parps, int *pnum_parps, int i)
+{
+  partial_path* parp = parps[i];
+  int num_parps = --(*pnum_parps);
+  if (i < num_parps)
+  {
+    parps[i] = parps[num_parps];
+    sift_down_partial_path(parps, num_parps, i);
+    sift_up_partial_path(parps, i);
+  }
+  return parp;
+}
+
+static partial_path* pop_best_partial_path(partial_path** parps, int *pnum_parps)
+{
+  return remove_partial_path_at(parps, pnum_parps, 0);
+}
+
+/* the worst path is always a leaf, ie. in the second half */
+
+static int find_worst_partial_path(partial_path** parps, int num_parps)
+{
+  int i, worst = num_parps - 1;
+  for (i = num_parps / 2; i < num_parps - 1; i++)
+  {
+    if (parps[i]->costsofar > parps[worst]->costsofar)
+      worst = i;
+  }
+  return worst;
+}
+
+static partial_path* remove_worst_partial_path(partial_path** parps, int *pnum_parps)
+{
+  return remove_partial_path_at(parps, pnum_parps,
+                                find_worst_partial_path(parps, *pnum_parps));
 }
 
 void print_path(partial_path* ipath, srec* rec, char* msg)
@@ -40,6 +40,12 @@ void hash_init(FixedSizeHash* hash, srec* rec_debug)
   hash->rec = rec_debug;
 }
 
+/* home bin for a hash value, the multiply spreads out the low bits
+   which are mostly the word id */
+
+#define FSH_HOME(hv) ((unsigned int)(((hv) * 2654435761U) >> (32 - FSH_HASHBITS)) & (FSH_HASHSIZE - 1))
+#define FSH_NEXT(i)  (((i) + 1) & (FSH_HASHSIZE - 1))
+
 /* compare a couple of paths,
    ie see whether the word history is the same */
 
@@ -93,16 +99,16 @@ unsigned int hashfunc(partial_path* parp)
 
 int hash_get(FixedSizeHash* hash, partial_path* parp, void** hval)
 {
-  unsigned int hkey_index = hashfunc(parp);
+  unsigned int hashval = hashfunc(parp);
+  unsigned int i, count;
   partial_path* p_return;
   
-  hkey_index = hkey_index % hash->hashsize;
-  p_return = hash->items[hkey_index];
-  if (!p_return)
-    return FSH_NO_SUCH_KEY;
-  for (; p_return; p_return = p_return->hashlink)
+  for (i = FSH_HOME(hashval), count = 0; count < FSH_HASHSIZE; i = FSH_NEXT(i), count++)
   {
-    if (compare_parp(p_return, parp, hash->rec) == 0)
+    p_return = hash->items[i];
+    if (!p_return)
+      break;
+    if (p_return->hashval == hashval && compare_parp(p_return, parp, hash->rec) == 0)
     {
       *hval = p_return;
       return FSH_SUCCESS;
@@ -115,58 +121,76 @@ int hash_get(FixedSizeHash* hash, partial_path* parp, void** hval)
 
 int hash_set(FixedSizeHash* hash, partial_path* parp)
 {
-  unsigned int hkey_index = hashfunc(parp);
-  partial_path** p_insert;
+  unsigned int hashval = hashfunc(parp);
+  unsigned int i, count;
+  partial_path* p_insert;
   
-  hkey_index = hkey_index % hash->hashsize;
-  p_insert = &hash->items[hkey_index];
-  for (; *p_insert; p_insert = &((*p_insert)->hashlink))
+  for (i = FSH_HOME(hashval), count = 0; count < FSH_HASHSIZE; i = FSH_NEXT(i), count++)
   {
-    if (*p_insert == parp)
+    p_insert = hash->items[i];
+    if (!p_insert)
+    {
+      hash->items[i] = parp;
+      parp->hashval = hashval;
+#if DEBUG_PPHASH
+      printf("setting at %d ", i);
+      print_path(parp, hash->rec, "");
+#endif
+      return FSH_SUCCESS;
+    }
+    if (p_insert == parp)
     {
 #if 1||DEBUG_PPHASH
       print_path(parp, hash->rec, "problem in astar_pphash hash_set ");
 #endif
       return FSH_SUCCESS;
     }
-    else if (compare_parp(*p_insert, parp, hash->rec) == 0)
+    else if (p_insert->hashval == hashval && compare_parp(p_insert, parp, hash->rec) == 0)
     {
 #if DEBUG_PPHASH
-      print_path(*p_insert, hash->rec, "key taken in astar_pphash hash_set ");
+      print_path(p_insert, hash->rec, "key taken in astar_pphash hash_set ");
 #endif
       return FSH_KEY_OCCUPIED;
     }
   }
-  *p_insert = parp;
-#if DEBUG_PPHASH
-  printf("setting at %d ", hkey_index);
-  print_path(parp, hash->rec, "");
-#endif
-  parp->hashlink = FSH_NULL;
-  return FSH_SUCCESS;
+  /* cannot happen while the table is larger than the parp pool,
+     but treating it as a dup just drops the path */
+  return FSH_KEY_OCCUPIED;
 }
 
-/* delete an element */
+/* delete an element, the entries that follow in the probe sequence
+   are shifted back so that no tombstones are needed */
 
 int hash_del(FixedSizeHash* hash, partial_path* parp)
 {
-  unsigned int hkey_index = hashfunc(parp);
-  partial_path** p_insert;
+  unsigned int hashval = hashfunc(parp);
+  unsigned int i, j, home, count;
   
-  hkey_index = hkey_index % hash->hashsize;
-  p_insert = &hash->items[hkey_index];
-  for (; *p_insert; p_insert = &((*p_insert)->hashlink))
+  for (i = FSH_HOME(hashval), count = 0; count < FSH_HASHSIZE; i = FSH_NEXT(i), count++)
   {
-    if (compare_parp(*p_insert, parp, hash->rec) == 0)
-    {
-      *p_insert = parp->hashlink;
+    if (!hash->items[i])
+      return FSH_NO_SUCH_KEY;
+    if (hash->items[i] == parp)
+      break;
+  }
+  if (count == FSH_HASHSIZE)
+    return FSH_NO_SUCH_KEY;
 #if DEBUG_PPHASH
-      printf("delhash at %d\n", hkey_index);
-      print_path(parp, hash->rec, "deleted ");
+  printf("delhash at %d\n", i);
+  print_path(parp, hash->rec, "deleted ");
 #endif
-      return FSH_SUCCESS;
+  
+  for (j = FSH_NEXT(i); hash->items[j]; j = FSH_NEXT(j))
+  {
+    /* move items[j] into the hole at i, unless its home bin lies
+       cyclically in (i,j], in which case it is still reachable */
+    home = FSH_HOME(hash->items[j]->hashval);
+    if (i <= j ? (home <= i || home > j) : (home <= i && home > j))
+    {
+      hash->items[i] = hash->items[j];
+      i = j;
     }
   }
-  return FSH_NO_SUCH_KEY;
+  hash->items[i] = FSH_NULL;
+  return FSH_SUCCESS;
 }
-
@@ -23,15 +23,16 @@
 #define FSH_SUCCESS       0
 #define FSH_KEY_OCCUPIED  1
 #define FSH_NO_SUCH_KEY   2
-#define FSH_HASHSIZE     37
+#define FSH_HASHBITS     10
+#define FSH_HASHSIZE     (1<<FSH_HASHBITS) /* > MAX_NUM_PARPS, see astar.c */
 #define FSH_NULL 0
 
 #include "astar.h"
 
 /**
  * The FixedSizeHash is a hash that does not grow in size.
- * In each bin there are a number of elements, which are maintained
- * via a linked list.
+ * It is open addressed with linear probing, and is sized so that it
+ * can hold every partial_path in the stack's pool.
  * This is used to find out whether a path with the same word history
  * as the one being expanded has already been search.  If yes, we can
  * abort this one.
@@ -27,6 +27,35 @@
 #include "srec_context.h"
 #include "srec.h"
 
+/* the first pass of two-pass decoding scores fewer pdfs, so its scores
+   are noisier, it gets this much wider a beam to keep the right words */
+#define FIRST_PASS_BEAM_WIDEN 1.25
+
+/* lays the searches out grammar by grammar, one per acoustic model, so
+   rec[i] decodes grammar[i / num_swimodels] with swimodel[i % num_swimodels].
+   Fails if that takes more searches than were allocated */
+
+static int assign_searches(multi_srec* recm, int num_swimodels, int num_grammars)
+{
+  int i, num_recs;
+
+  num_recs = num_swimodels * (num_grammars > 0 ? num_grammars : 1);
+  if (num_recs > recm->num_allocated_recs)
+    return 1;
+  recm->num_activated_recs = num_recs;
+  for (i = 0; i < recm->num_allocated_recs; i++)
+  {
+    recm->rec[i].swimodel_index = (asr_int16_t)(num_swimodels > 0 ? i % num_swimodels : 0);
+    if (num_grammars == 0)
+      recm->rec[i].context = NULL;
+    else if (num_swimodels > 0 && i / num_swimodels < num_grammars)
+      recm->rec[i].context = recm->grammar[i / num_swimodels];
+    else
+      recm->rec[i].context = recm->grammar[num_grammars - 1];
+  }
+  return 0;
+}
+
 int add_acoustic_model_for_recognition(multi_srec* recm, const SWIModel* model)
 {
   if (recm->num_swimodels >= MAX_ACOUSTIC_MODELS)
@@ -34,7 +63,7 @@ int add_acoustic_model_for_recognition(multi_srec* recm, const SWIModel* model)
     log_report("Error: recognizer can't hold any more acoustic models\n");
     return 0;
   }
-  if (recm->num_activated_recs >= recm->num_allocated_recs)
+  if (assign_searches(recm, recm->num_swimodels + 1, recm->num_grammars))
   {
     log_report("Error: too few recognizers allocated\n");
     return 0;
@@ -50,8 +79,6 @@ int add_acoustic_model_for_recognition(multi_srec* recm, const SWIModel* model)
 
   recm->swimodel[ recm->num_swimodels] = model;
   recm->num_swimodels++;
-
-  recm->num_activated_recs++;
   return 1;
 }
 
@@ -62,16 +89,76 @@ int clear_acoustic_models_for_recognition(multi_srec* recm)
   return 0;
 }
 
+/* searches on the same acoustic models share their state scores, the
+   cache is forgotten at the start of every utterance (and pass) */
+
+static void setup_score_cache(multi_srec *recm)
+{
+  int i, j;
+
+  recm->score_cache.model = NULL;
+  for (i = 0; i < recm->num_allocated_recs; i++)
+  {
+    recm->rec[i].score_cache = NULL;
+    if (!recm->score_cache.stamp || i >= recm->num_activated_recs)
+      continue;
+    for (j = 0; j < recm->num_activated_recs; j++)
+    {
+      if (j != i && recm->swimodel[recm->rec[j].swimodel_index] == recm->swimodel[recm->rec[i].swimodel_index])
+        recm->rec[i].score_cache = &recm->score_cache;
+    }
+  }
+}
+
+/* the enrollment search is a single pass, it keeps no first pass words */
+
+static int enrollment_search_runs(multi_srec *recm)
+{
+  int i;
+
+  for (i = 0; i < recm->num_activated_recs; i++)
+  {
+    if (recm->rec[i].enrollment_search && recm->rec[i].context
+        && FST_IsVoiceEnrollment(recm->rec[i].context))
+      return 1;
+  }
+  return 0;
+}
+
 void begin_recognition(multi_srec *recm, int begin_syn_node)
 {
   int i = 0;
+  if (recm->search_pass != SEARCH_PASS_RESCORE)
+  {
+    recm->search_pass = recm->first_pass_pdfs && !enrollment_search_runs(recm) ? SEARCH_PASS_FIRST : SEARCH_PASS_SINGLE;
+    recm->num_first_pass_frames = 0;
+    for (i = 0; i < recm->num_allocated_recs; i++)
+      recm->rec[i].first_pass_num_frames = 0;
+  }
+  recm->begin_syn_node = begin_syn_node;
+  /* every utterance (and pass) starts from the configured beam */
+  recm->pass_prune_delta = recm->base_prune_delta;
+  if (recm->search_pass == SEARCH_PASS_FIRST)
+  {
+    if (FIRST_PASS_BEAM_WIDEN * recm->base_prune_delta < MAXcostdata)
+      recm->pass_prune_delta = (costdata)(FIRST_PASS_BEAM_WIDEN * recm->base_prune_delta);
+    else
+      recm->pass_prune_delta = MAXcostdata;
+  }
+  for (i = 0; i < recm->num_allocated_recs; i++)
+  {
+    recm->rec[i].prune_delta = recm->pass_prune_delta;
+    recm->rec[i].score_max_pdfs = (asr_int16_t)(recm->search_pass == SEARCH_PASS_FIRST ? recm->first_pass_pdfs : 0);
+  }
+  setup_score_cache(recm);
+  recm->avg_frame_usec = 0;
+  i = 0;
 #if DO_ALLOW_MULTIPLE_MODELS
-  ASSERT(recm->num_activated_recs == recm->num_swimodels);
+  ASSERT(recm->num_activated_recs % recm->num_swimodels == 0);
   for (i = 0; i < recm->num_activated_recs; i++)
 #endif
     srec_begin(&recm->rec[i], begin_syn_node);
-  for (i = 0;i < recm->max_fsm_nodes;i++)
-    recm->best_token_for_node[i] = MAXftokenID;
+  reset_best_token_for_nodes(&recm->rec[0]);
   recm->eos_status = VALID_SPEECH_CONTINUING;
 }
 
@@ -88,9 +175,69 @@ void end_recognition(multi_srec *recm)
   /* srec_get_result(rec);  */
 }
 
+/* second pass of two-pass decoding, replays the frames the first pass
+   kept with the full acoustic models, over the words of the first
+   lattice only, each near where it started and ended there.  Only run
+   for an utterance that gets a result, not on stop or abort */
+
+static void replay_first_pass_frames(multi_srec *recm, srec_eos_detector_parms* eosd,
+                                     pattern_info *replay, frameID num_frames)
+{
+  frameID ifr;
+
+  begin_recognition(recm, recm->begin_syn_node);
+  for (ifr = 0; ifr < num_frames; ifr++)
+  {
+    replay->prep->seq = recm->first_pass_frames + ifr * recm->first_pass_frame_dim;
+    if (multi_srec_viterbi(recm, eosd, replay, NULL))
+      break;
+  }
+  end_recognition(recm);
+}
+
+int rescore_recognition(multi_srec *recm, srec_eos_detector_parms* eosd, pattern_info *pattern)
+{
+  preprocessed prep;
+  pattern_info replay;
+  frameID num_frames;
+  EOSrc eos_status;
+  int i;
+
+  if (recm->search_pass != SEARCH_PASS_FIRST || recm->num_first_pass_frames == 0)
+  {
+    recm->search_pass = SEARCH_PASS_SINGLE;
+    return 0;
+  }
+  i = 0;
+#if DO_ALLOW_MULTIPLE_MODELS
+  for (i = 0; i < recm->num_activated_recs; i++)
+#endif
+    srec_keep_first_pass_words(&recm->rec[i]);
+
+  /* the replayed frames are stored without the unused leading channels */
+  prep = *pattern->prep;
+  prep.use_from = 0;
+  replay = *pattern;
+  replay.prep = &prep;
+
+  eos_status = recm->eos_status;
+  num_frames = recm->num_first_pass_frames;
+  recm->search_pass = SEARCH_PASS_RESCORE;
+  replay_first_pass_frames(recm, eosd, &replay, num_frames);
+  for (i = 0; i < recm->num_allocated_recs; i++)
+    recm->rec[i].first_pass_num_frames = 0;
+  recm->eos_status = eos_status;
+  recm->search_pass = SEARCH_PASS_SINGLE;
+  return 0;
+}
+
+/* with max_grammars 1 the grammar replaces the active one, otherwise it
+   is decoded alongside them, in searches of its own */
+
 int activate_grammar_for_recognition(multi_srec* recm, srec_context* grammar, const char* rule)
 {
   srec_context* context = grammar;
+  int i, num_grammars;
 
   context->max_searchable_nodes = recm->max_fsm_nodes;
   context->max_searchable_arcs  = recm->max_fsm_arcs;
@@ -104,9 +251,33 @@ int activate_grammar_for_recognition(multi_srec* recm, srec_context* grammar, co
   }
   else
   {
-    int i, rc = 0;
-    for (i = 0; i < recm->num_allocated_recs; i++)
-      recm->rec[i].context = context;
+    int rc = 0;
+    for (i = 0; i < recm->num_grammars; i++)
+    {
+      if (recm->grammar[i] == context)
+        break;
+    }
+    if (i == recm->num_grammars)
+    {
+      num_grammars = recm->num_grammars;
+      if (recm->max_grammars == 1)
+        num_grammars = i = 0;
+      else if (num_grammars >= recm->max_grammars)
+      {
+        PLogError(L("Error: can't activate more than %d grammars at once, set CREC.Recognizer.max_grammars higher\n"),
+                  recm->max_grammars);
+        return 1;
+      }
+      if (recm->num_swimodels * (num_grammars + 1) > recm->num_allocated_recs)
+      {
+        PLogError(L("Error: %d grammars on %d acoustic models need more than %d searches, set CREC.Recognizer.max_searches higher\n"),
+                  num_grammars + 1, recm->num_swimodels, recm->num_allocated_recs);
+        return 1;
+      }
+      recm->grammar[i] = context;
+      recm->num_grammars = num_grammars + 1;
+      assign_searches(recm, recm->num_swimodels, recm->num_grammars);
+    }
     rc = FST_PrepareContext(context);
     if (rc)
       return rc;
@@ -115,13 +286,27 @@ int activate_grammar_for_recognition(multi_srec* recm, srec_context* grammar, co
   }
 }
 
-int clear_grammars_for_recognition(multi_srec* recm)
+int deactivate_grammar_for_recognition(multi_srec* recm, srec_context* grammar)
 {
   int i;
-  for (i = 0; i < recm->num_allocated_recs; i++)
+  for (i = 0; i < recm->num_grammars; i++)
   {
-    recm->rec[i].context = NULL;
+    if (recm->grammar[i] == grammar)
+      break;
   }
+  if (i == recm->num_grammars)
+    return 0;
+  recm->num_grammars--;
+  for (; i < recm->num_grammars; i++)
+    recm->grammar[i] = recm->grammar[i+1];
+  assign_searches(recm, recm->num_swimodels, recm->num_grammars);
+  return 0;
+}
+
+int clear_grammars_for_recognition(multi_srec* recm)
+{
+  recm->num_grammars = 0;
+  assign_searches(recm, recm->num_swimodels, 0);
   return 0;
 }
 
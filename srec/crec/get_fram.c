@@ -193,13 +193,22 @@ int get_data_frame(preprocessed *prep, utterance_info *utt)
     else if (status_code == -1) return(1);
   }
 
-  if (prep->chan_offset)
-    apply_channel_offset(prep);
-
-  /*  Apply linear transformation if necessary
+  /*  With a linear transformation, the channel offset and normalization
+  **  are applied in the same pass
   */
   if (prep->post_proc & LIN_TRAN)
-    linear_transform_frame(prep, prep->seq, True);
+  {
+    if (utt->gen_utt.channorm)
+      transform_and_normalize_frame(prep, prep->seq, prep->seq_unnorm,
+                                    utt->gen_utt.channorm->imelda_adjust,
+                                    utt->gen_utt.channorm->dim);
+    else
+      transform_and_normalize_frame(prep, prep->seq, prep->seq_unnorm, NULL, 0);
+    return (1);
+  }
+
+  if (prep->chan_offset)
+    apply_channel_offset(prep);
 
   memcpy(prep->seq_unnorm, prep->seq, prep->dim * sizeof(imeldata));
   if (utt->gen_utt.channorm)
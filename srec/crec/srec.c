@@ -20,6 +20,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
 
 #include "pstdio.h"
 #include "passert.h"
@@ -37,6 +38,7 @@
 #include "srec_tokens.h"
 #include "word_lattice.h"
 #include "swimodel.h"
+#include "srec_score_pool.h"
 #if USE_COMP_STATS
 #include "comp_stats.h"
 #endif
@@ -47,10 +49,8 @@ static const char *rcsid = 0 ? (const char *) &rcsid :
 "$Id: srec.c,v 1.39.4.31 2008/06/23 17:20:39 dahan Exp $";
 #endif
 
-#define SILENCE_MODEL_INDEX 0
-#define PRUNE_TIGHTEN 0.9     /*if we run out of room in the state arrays,
-                                keep multiplying pruning thresh by this amount
-                                until there is room */
+#define BEAM_MIN_FRACTION 0.25 /* the frame budget controller never narrows
+                                  the beam below this fraction of viterbi_prune_thresh */
 
 /*--------------------------------------------------------------------------*
  *                                                                          *
@@ -312,41 +312,232 @@ static altword_token* sizewise_altwords(srec* rec, altword_token* awtoken_head)
  *                                                                          *
  *--------------------------------------------------------------------------*/
 
-#define DO_COMPUTE_MODEL     0
-#define DO_NOT_COMPUTE_MODEL MAXcostdata
+/* takes the states another search with the same models already scored
+   this frame from the cache, returns how many are left to score, on
+   cache->miss_list */
 
-static asr_uint16_t best_uint16(asr_uint16_t* p, int n)
+static int lookup_score_cache(srec_score_cache *cache, costdata *current_model_scores,
+                              const SWIModel *acoustic_models, frameID current_search_frame, int max_pdfs,
+                              const modelID *needed_model_list, int num_needed_models)
 {
-  asr_uint16_t rv = p[0];
-  for (;--n > 0;p++) if (rv > *p) rv = *p;
-  return rv;
+  int i, num_misses = 0;
+  modelID model_index;
+
+  if (cache->model != acoustic_models || cache->frame != current_search_frame ||
+      cache->max_pdfs != max_pdfs)
+  {
+    cache->model = acoustic_models;
+    cache->frame = current_search_frame;
+    cache->max_pdfs = (asr_int16_t)max_pdfs;
+    if (cache->epoch == MAXtokenepoch)
+    {
+      memset(cache->stamp, 0, acoustic_models->num_hmmstates * sizeof(tokenepoch));
+      cache->epoch = 0;
+    }
+    cache->epoch++;
+  }
+  for (i = 0; i < num_needed_models; i++)
+  {
+    model_index = needed_model_list[i];
+    if (cache->stamp[model_index] == cache->epoch)
+      current_model_scores[model_index] = cache->score[model_index];
+    else
+      cache->miss_list[num_misses++] = model_index;
+  }
+  return num_misses;
 }
-static int compute_model_scores(costdata *current_model_scores, const SWIModel *acoustic_models,
-                                pattern_info *pattern, frameID current_search_frame)
+
+/* scores the states on needed_model_list (all of them DO_COMPUTE_MODEL),
+   every other entry of current_model_scores is DO_NOT_COMPUTE_MODEL, but
+   for a silence score handed over from the other gender.  Returns the best
+   score of the frame */
+
+static costdata compute_model_scores(srec *rec, const SWIModel *acoustic_models, pattern_info *pattern)
 {
   int i;
-  int num_models_computed = 0;
+  modelID model_index;
+  costdata *current_model_scores = rec->current_model_scores;
+  int max_pdfs = rec->score_max_pdfs;
+  srec_score_cache *cache = rec->score_cache;
+  const modelID *score_list = rec->needed_model_list;
+  int num_to_score = rec->num_needed_models;
+  costdata best_cost = MAXcostdata;
+
+  if (cache)
+  {
+    num_to_score = lookup_score_cache(cache, current_model_scores, acoustic_models,
+                                      rec->current_search_frame, max_pdfs,
+                                      rec->needed_model_list, rec->num_needed_models);
+    score_list = cache->miss_list;
+  }
 
-  for (i = 0; i < acoustic_models->num_hmmstates; i++)
+  /* large frames are split across the scoring threads */
+  if (rec->score_pool == NULL || num_to_score < SCORE_POOL_MIN_STATES ||
+      score_pool_compute(rec->score_pool, current_model_scores, score_list, num_to_score,
+                         acoustic_models, pattern->prep, max_pdfs) != 0)
+  {
+    for (i = 0; i < num_to_score; i++)
+    {
+      model_index = score_list[i];
+      {
+        scodata score = max_pdfs ?
+                mixture_diagonal_gaussian_swimodel_npdfs(pattern->prep,
+                    &acoustic_models->hmmstates[model_index], acoustic_models->num_dims, (short)max_pdfs) :
+                mixture_diagonal_gaussian_swimodel(pattern->prep,
+                    &acoustic_models->hmmstates[model_index], acoustic_models->num_dims);
+        ASSERT(score <= 0 && "model score out of range");
+
+        current_model_scores[model_index] = (costdata) - score;
+      }
+    }
+  }
+  if (cache)
   {
-    if (current_model_scores[i] == DO_COMPUTE_MODEL)
+    for (i = 0; i < num_to_score; i++)
     {
-      scodata score = mixture_diagonal_gaussian_swimodel(pattern->prep,
-              &acoustic_models->hmmstates[i], acoustic_models->num_dims);
-      ASSERT(score <= 0 && "model score out of range");
+      model_index = score_list[i];
+      cache->score[model_index] = current_model_scores[model_index];
+      cache->stamp[model_index] = cache->epoch;
+    }
+  }
+  for (i = 0; i < rec->num_needed_models; i++)
+  {
+    if (best_cost > current_model_scores[rec->needed_model_list[i]])
+      best_cost = current_model_scores[rec->needed_model_list[i]];
+  }
+  /* silence is off the list when its score was handed over, it is only
+     read now, before scoring it could still be DO_COMPUTE_MODEL */
+  if (best_cost > current_model_scores[SILENCE_MODEL_INDEX])
+    best_cost = current_model_scores[SILENCE_MODEL_INDEX];
+  return best_cost;
+}
 
-      current_model_scores[i] = (costdata) - score;
-      num_models_computed++;
+/*--------------------------------------------------------------------------*
+ *                                                                          *
+ * phone look-ahead                                                         *
+ *                                                                          *
+ *--------------------------------------------------------------------------*/
+
+/* Before the first state of every arc leaving an active fsm node gets
+   scored, we score one stand-in state per phoneme, the first state of the
+   allophone reached by failing every context question.  Arcs whose
+   phoneme scores too far behind the best phoneme are not entered this
+   frame, so their allophone states need not be scored at all.  The tables
+   are built from the arbdata attached to the context, and rebuilt when a
+   grammar brings a different one */
+
+static void lookahead_mark_hmms(tree_node* node, asr_int16_t* phoneme_for_hmm,
+                                int num_hmms, asr_int16_t phoneme)
+{
+  while (node && node->node.quest_index >= 0)
+  {
+    lookahead_mark_hmms((tree_node*)node->node.pass, phoneme_for_hmm, num_hmms, phoneme);
+    node = (tree_node*)node->node.fail;
+  }
+  if (node && node->term.pelid >= 0 && node->term.pelid < num_hmms)
+    phoneme_for_hmm[node->term.pelid] = phoneme;
+}
+
+void srec_free_phone_lookahead(srec* rec)
+{
+  if (rec->lookahead_phoneme_for_hmm)
+    FREE(rec->lookahead_phoneme_for_hmm);
+  if (rec->lookahead_state_for_phoneme)
+    FREE(rec->lookahead_state_for_phoneme);
+  if (rec->lookahead_penalty)
+    FREE(rec->lookahead_penalty);
+  rec->lookahead_phoneme_for_hmm = NULL;
+  rec->lookahead_state_for_phoneme = NULL;
+  rec->lookahead_penalty = NULL;
+  rec->lookahead_allotree = NULL;
+  rec->lookahead_num_phonemes = 0;
+}
+
+static int setup_phone_lookahead(srec* rec, const SWIModel *acoustic_models)
+{
+  srec_arbdata* allotree = rec->context->allotree;
+  tree_node* node;
+  modelID state;
+  int i;
+
+  if (allotree && rec->lookahead_allotree == allotree)
+    return 0;
+  srec_free_phone_lookahead(rec);
+  if (!allotree || allotree->num_phonemes <= 0 || allotree->num_hmms <= 0)
+    return 1;
+
+  rec->lookahead_phoneme_for_hmm = (asr_int16_t*)CALLOC(allotree->num_hmms, sizeof(asr_int16_t), "search.srec.lookahead_phoneme_for_hmm");
+  rec->lookahead_state_for_phoneme = (modelID*)CALLOC(allotree->num_phonemes, sizeof(modelID), "search.srec.lookahead_state_for_phoneme");
+  rec->lookahead_penalty = (costdata*)CALLOC(allotree->num_phonemes, sizeof(costdata), "search.srec.lookahead_penalty");
+  if (!rec->lookahead_phoneme_for_hmm || !rec->lookahead_state_for_phoneme || !rec->lookahead_penalty)
+  {
+    srec_free_phone_lookahead(rec);
+    return 1;
+  }
+
+  for (i = 0; i < allotree->num_hmms; i++)
+    rec->lookahead_phoneme_for_hmm[i] = -1;
+  for (i = 0; i < allotree->num_phonemes; i++)
+  {
+    node = allotree->pdata[i].model_nodes;
+    lookahead_mark_hmms(node, rec->lookahead_phoneme_for_hmm, allotree->num_hmms, (asr_int16_t)i);
+    while (node && node->node.quest_index >= 0)
+      node = (tree_node*)node->node.fail;
+    if (!node || node->term.pelid < 0 || node->term.pelid >= allotree->num_hmms ||
+        allotree->hmm_infos[node->term.pelid].num_states <= 0)
+    {
+      PLogError("warning: no default allophone for phoneme %d, phone look-ahead disabled\n", i);
+      srec_free_phone_lookahead(rec);
+      return 1;
+    }
+    state = allotree->hmm_infos[node->term.pelid].state_indices[0];
+    if (state >= acoustic_models->num_hmmstates)
+    {
+      srec_free_phone_lookahead(rec);
+      return 1;
     }
+    rec->lookahead_state_for_phoneme[i] = state;
+  }
+  rec->lookahead_num_phonemes = allotree->num_phonemes;
+  rec->lookahead_allotree = allotree;
+  return 0;
+}
+
+static void compute_phone_lookahead(srec* rec, const SWIModel *acoustic_models, pattern_info *pattern)
+{
+  int i;
+  costdata best_cost = MAXcostdata;
+  costdata* penalty = rec->lookahead_penalty;
+  scodata score;
+
+  for (i = 0; i < rec->lookahead_num_phonemes; i++)
+  {
+    score = mixture_diagonal_gaussian_swimodel(pattern->prep,
+            &acoustic_models->hmmstates[rec->lookahead_state_for_phoneme[i]], acoustic_models->num_dims);
+    penalty[i] = (costdata) - score;
+    if (penalty[i] < best_cost)
+      best_cost = penalty[i];
   }
-  return num_models_computed;
+  for (i = 0; i < rec->lookahead_num_phonemes; i++)
+    penalty[i] = (costdata)(penalty[i] - best_cost);
 }
 
+/* whether an arc leaving a node at node_cost is worth entering this frame */
 
+static int phone_lookahead_allows(srec* rec, costdata node_cost, FSMarc* fsm_arc)
+{
+  int hmm = fsm_arc->ilabel - rec->context->hmm_ilabel_offset;
+  asr_int32_t cost;
+
+  if (hmm < 0 || hmm >= rec->lookahead_allotree->num_hmms || rec->lookahead_phoneme_for_hmm[hmm] < 0)
+    return 1;
+  cost = (asr_int32_t)node_cost + fsm_arc->cost + rec->lookahead_penalty[rec->lookahead_phoneme_for_hmm[hmm]];
+  return cost < (asr_int32_t)rec->current_prune_delta + rec->phone_lookahead_margin;
+}
 
 /*precompute all needed models to be used by next frame of search*/
 
-static int find_which_models_to_compute(srec *rec, const SWIModel *acoustic_models)
+static int find_which_models_to_compute(srec *rec, const SWIModel *acoustic_models, pattern_info *pattern)
 {
   int i;
   modelID model_index;
@@ -360,9 +551,14 @@ static int find_which_models_to_compute(srec *rec, const SWIModel *acoustic_mode
   HMMInfo* hmm_info;
   FSMnode* fsm_node;
   FSMarc* fsm_arc;
+  int use_lookahead;
+  modelID *needed_model_list;
+  int num_needed_models;
   /*use the current_model_scores array both to tell the model computing stuff
     what models to compute and to get the scores back.  This is a bit ugly, but
-    saves having another array to allocate*/
+    saves having another array to allocate.  The needed states also go on
+    needed_model_list, once each, as the DO_NOT_COMPUTE_MODEL mark guards
+    against duplicates, so scoring and resetting only visit those*/
 
   /* this belongs elsewhere at initialization,
      eg. where we'll associate search to acoustic models
@@ -370,11 +566,13 @@ static int find_which_models_to_compute(srec *rec, const SWIModel *acoustic_mode
   rec->avg_state_durations = acoustic_models->avg_state_durations;
 
   current_model_scores = rec->current_model_scores;
+  needed_model_list = rec->needed_model_list;
 
-  for (model_index = 0; model_index < acoustic_models->num_hmmstates; model_index++)
-  {
-    current_model_scores[model_index] = DO_NOT_COMPUTE_MODEL;
-  }
+  /* only last frame's states (and a handed over silence score) are set */
+  for (i = 0; i < rec->num_needed_models; i++)
+    current_model_scores[needed_model_list[i]] = DO_NOT_COMPUTE_MODEL;
+  current_model_scores[SILENCE_MODEL_INDEX] = DO_NOT_COMPUTE_MODEL;
+  num_needed_models = 0;
 
   current_token_index = rec->active_fsmarc_tokens;
 
@@ -392,7 +590,11 @@ static int find_which_models_to_compute(srec *rec, const SWIModel *acoustic_mode
           ((i > 0) && current_token->cost[i-1] != MAXcostdata))
       {
         model_index = hmm_info->state_indices[i];
-        current_model_scores[model_index] = DO_COMPUTE_MODEL;
+        if (current_model_scores[model_index] == DO_NOT_COMPUTE_MODEL)
+        {
+          current_model_scores[model_index] = DO_COMPUTE_MODEL;
+          needed_model_list[num_needed_models++] = model_index;
+        }
       }
     }
     current_token_index = current_token->next_token_index;
@@ -400,6 +602,13 @@ static int find_which_models_to_compute(srec *rec, const SWIModel *acoustic_mode
 
   /*for each active FSM node, find models which can come from node*/
 
+  use_lookahead = 0;
+  if (rec->phone_lookahead_margin > 0 && setup_phone_lookahead(rec, acoustic_models) == 0)
+  {
+    compute_phone_lookahead(rec, acoustic_models, pattern);
+    use_lookahead = 1;
+  }
+
   current_ftoken_index = rec->active_fsmnode_tokens;
 
   while (current_ftoken_index != MAXftokenID)
@@ -419,7 +628,14 @@ static int find_which_models_to_compute(srec *rec, const SWIModel *acoustic_mode
 
           /* we should build in here a check that this arc has reasonable weight */
           /* if(fsm_arc->cost < rec->prune_delta)  */
-          current_model_scores[hmm_info->state_indices[0]] = DO_COMPUTE_MODEL;
+          if (use_lookahead && !phone_lookahead_allows(rec, current_ftoken->cost, fsm_arc))
+            continue;
+          model_index = hmm_info->state_indices[0];
+          if (current_model_scores[model_index] == DO_NOT_COMPUTE_MODEL)
+          {
+            current_model_scores[model_index] = DO_COMPUTE_MODEL;
+            needed_model_list[num_needed_models++] = model_index;
+          }
         }
       }
     }
@@ -428,7 +644,8 @@ static int find_which_models_to_compute(srec *rec, const SWIModel *acoustic_mode
 
   /*compute the scores in a batch - this allows the model computing code to
     chunk it up however it wants*/
-  return 0;
+  rec->num_needed_models = num_needed_models;
+  return num_needed_models;
 }
 
 /*--------------------------------------------------------------------------*
@@ -487,18 +704,58 @@ static int prune_new_tokens(srec *rec, costdata current_prune_thresh)
   return num_deleted;
 }
 
-static void reprune_word_tokens_if_necessary(srec *rec)
+/* histogram pruning: buckets the best state cost of each active token
+   within the beam, and returns the narrowest prune delta (to bin
+   resolution) that keeps no more than max_active_hmm_tokens alive.  If
+   the best bin alone holds more than that, we keep just that bin */
+
+static costdata histogram_prune_delta(srec *rec, costdata current_best_cost, costdata current_prune_delta)
 {
-  word_token* wtoken;
-  wtokenID wtoken_index = rec->word_token_freelist;
-  wtokenID num_free_wtokens = 0;
+  int i, bin, num_kept;
+  int count[HISTOGRAM_PRUNE_BINS];
+  costdata bin_width, token_cost;
+  stokenID token_index;
+  fsmarc_token *token;
+
+  bin_width = (costdata)((current_prune_delta + HISTOGRAM_PRUNE_BINS - 1) / HISTOGRAM_PRUNE_BINS);
+  if (bin_width == 0)
+    return current_prune_delta;
+  for (bin = 0; bin < HISTOGRAM_PRUNE_BINS; bin++)
+    count[bin] = 0;
 
-  for (; wtoken_index != MAXwtokenID; wtoken_index = wtoken->next_token_index)
+  for (token_index = rec->active_fsmarc_tokens; token_index != MAXstokenID;
+       token_index = token->next_token_index)
   {
-    wtoken = &rec->word_token_array[ wtoken_index];
-    num_free_wtokens++;
+    token = &(rec->fsmarc_token_array[token_index]);
+    token_cost = MAXcostdata;
+    for (i = 0; i < token->num_hmm_states; i++)
+      if (token->cost[i] < token_cost)
+        token_cost = token->cost[i];
+    if (token_cost >= current_best_cost + current_prune_delta)
+      continue;
+    bin = token_cost > current_best_cost ? (token_cost - current_best_cost) / bin_width : 0;
+    count[bin]++;
+  }
+
+  num_kept = 0;
+  for (bin = 0; bin < HISTOGRAM_PRUNE_BINS; bin++)
+  {
+    num_kept += count[bin];
+    if (num_kept > rec->max_active_hmm_tokens)
+    {
+      if (bin == 0)
+        bin = 1;
+      if ((costdata)(bin * bin_width) < current_prune_delta)
+        current_prune_delta = (costdata)(bin * bin_width);
+      break;
+    }
   }
-  if (num_free_wtokens < 2*rec->word_priority_q->max_in_q)
+  return current_prune_delta;
+}
+
+static void reprune_word_tokens_if_necessary(srec *rec)
+{
+  if (count_free_word_tokens(rec) < 2*rec->word_priority_q->max_in_q)
     reprune_word_tokens(rec, 0);
 }
 
@@ -624,6 +881,29 @@ static costdata reprune_fsmnode_tokens(srec *rec, costdata current_best_cost, co
   return current_prune_delta;
 }
 
+/* invalidates every entry in best_token_for_arc[], the stamps only need
+   clearing when the epoch wraps, ie. once every 65535 frames */
+
+void reset_best_token_for_arcs(srec* rec)
+{
+  if (*rec->best_token_for_arc_epoch == MAXtokenepoch)
+  {
+    memset(rec->best_token_for_arc_stamp, 0, rec->max_fsm_arcs * sizeof(tokenepoch));
+    *rec->best_token_for_arc_epoch = 0;
+  }
+  (*rec->best_token_for_arc_epoch)++;
+}
+
+void reset_best_token_for_nodes(srec* rec)
+{
+  if (*rec->best_token_for_node_epoch == MAXtokenepoch)
+  {
+    memset(rec->best_token_for_node_stamp, 0, rec->max_fsm_nodes * sizeof(tokenepoch));
+    *rec->best_token_for_node_epoch = 0;
+  }
+  (*rec->best_token_for_node_epoch)++;
+}
+
 
 void reset_best_cost_to_zero(srec* rec, costdata current_best_cost)
 {
@@ -631,6 +911,11 @@ void reset_best_cost_to_zero(srec* rec, costdata current_best_cost)
   stokenID token_index;
   short i, num_states;
 
+  if (SREC_ENROLL_ACTIVE(rec))
+  {
+    srec_enroll_reset_best_cost_to_zero(rec, current_best_cost);
+    return;
+  }
 
   /*do the state tokens*/
   for (token_index = rec->active_fsmarc_tokens;
@@ -707,6 +992,127 @@ static int block_fsmnodes_per_backtrace(srec *rec, wtokenID wtoken_id)
   return num_ftokens_blocked;
 }
 
+/* two-pass decoding: before rescoring, the words in the lattice of the
+   first pass are kept by the frame they start in, with their end frame,
+   the rescoring pass then only enters a word within FIRST_PASS_WORD_SLACK
+   frames of where the first pass started it, and only lets it end near
+   where that same word ended, so it only searches the lattice arcs of the
+   first pass over their time spans */
+
+#define FIRST_PASS_WORD_SLACK 5
+
+static frameID first_pass_word_begin(srec* rec, wtokenID word_backtrace)
+{
+  if (word_backtrace == MAXwtokenID)
+    return 0;
+  return (frameID)(rec->word_token_array[word_backtrace].end_time + 1);
+}
+
+void srec_keep_first_pass_words(srec* rec)
+{
+  frameID ifr, begin, num_frames;
+  wtokenID wtoken_index;
+  word_token* wtoken;
+  asr_int32_t i, num_words;
+  int pass, sanity_counter;
+
+  rec->first_pass_num_frames = 0;
+  if (!rec->first_pass_word_start || !rec->first_pass_words || !rec->first_pass_word_end)
+    return;
+  num_frames = (frameID)(rec->current_search_frame + 1);
+  if (num_frames > rec->word_lattice->max_frames)
+    num_frames = rec->word_lattice->max_frames;
+
+  /* counted by start frame on the first walk, placed on the second */
+  for (ifr = 0; ifr <= num_frames; ifr++)
+    rec->first_pass_word_start[ifr] = 0;
+  for (pass = 0; pass < 2; pass++)
+  {
+    num_words = 0;
+    for (ifr = 0; ifr < num_frames; ifr++)
+    {
+      sanity_counter = 0;
+      for (wtoken_index = rec->word_lattice->words_for_frame[ifr];
+           wtoken_index != MAXwtokenID && sanity_counter++ < rec->word_token_array_size;
+           wtoken_index = wtoken->next_token_index)
+      {
+        wtoken = &rec->word_token_array[wtoken_index];
+        if (num_words++ >= rec->word_token_array_size)
+          break;
+        begin = first_pass_word_begin(rec, wtoken->backtrace);
+        if (begin >= num_frames)
+          begin = (frameID)(num_frames - 1);
+        if (pass == 0)
+        {
+          rec->first_pass_word_start[begin+1]++;
+        }
+        else
+        {
+          i = rec->first_pass_word_start[begin]++;
+          rec->first_pass_words[i] = wtoken->word;
+          rec->first_pass_word_end[i] = ifr;
+        }
+      }
+    }
+    if (pass == 0)
+    {
+      for (ifr = 0; ifr < num_frames; ifr++)
+        rec->first_pass_word_start[ifr+1] += rec->first_pass_word_start[ifr];
+    }
+  }
+  /* placing moved every start up to the next one, move them back */
+  for (ifr = num_frames; ifr > 0; ifr--)
+    rec->first_pass_word_start[ifr] = rec->first_pass_word_start[ifr-1];
+  rec->first_pass_word_start[0] = 0;
+  rec->first_pass_num_frames = num_frames;
+}
+
+/* a word may start at this frame, is one of its arcs in the first lattice */
+
+static int first_pass_allows_word_start(srec* rec, wordID word)
+{
+  int lo, hi;
+  asr_int32_t i;
+
+  lo = rec->current_search_frame - FIRST_PASS_WORD_SLACK;
+  hi = rec->current_search_frame + FIRST_PASS_WORD_SLACK;
+  if (lo < 0)
+    lo = 0;
+  if (hi >= rec->first_pass_num_frames)
+    hi = rec->first_pass_num_frames - 1;
+  if (lo > hi)
+    return 0;
+  for (i = rec->first_pass_word_start[lo]; i < rec->first_pass_word_start[hi+1]; i++)
+    if (rec->first_pass_words[i] == word)
+      return 1;
+  return 0;
+}
+
+/* a word started at begin may end at this frame */
+
+static int first_pass_allows_word(srec* rec, wordID word, frameID begin)
+{
+  int lo, hi;
+  asr_int32_t i;
+
+  lo = begin - FIRST_PASS_WORD_SLACK;
+  hi = begin + FIRST_PASS_WORD_SLACK;
+  if (lo < 0)
+    lo = 0;
+  if (hi >= rec->first_pass_num_frames)
+    hi = rec->first_pass_num_frames - 1;
+  if (lo > hi)
+    return 0;
+  for (i = rec->first_pass_word_start[lo]; i < rec->first_pass_word_start[hi+1]; i++)
+  {
+    if (rec->first_pass_words[i] == word
+        && rec->first_pass_word_end[i] + FIRST_PASS_WORD_SLACK >= rec->current_search_frame
+        && rec->first_pass_word_end[i] <= rec->current_search_frame + FIRST_PASS_WORD_SLACK)
+      return 1;
+  }
+  return 0;
+}
+
 /* processing a word boundary,
    current_token is the fsmnode_token to the left of the boundary
    cost is the cost through this frame
@@ -736,6 +1142,9 @@ static wtokenID srec_process_word_boundary_nbest(srec* rec,
       return MAXwtokenID;
     }
   }
+  if (rec->first_pass_num_frames
+      && !first_pass_allows_word(rec, word, first_pass_word_begin(rec, word_backtrace)))
+    return MAXwtokenID;
   /*make new word token*/
   wtoken_index = create_word_token(rec);
   //ASSERT(wtoken_index != MAXwtokenID);
@@ -914,7 +1323,7 @@ static int do_epsilon_updates(srec *rec, costdata prune_delta,
         }
 
 		new_ftoken = NULL;
-        new_ftoken_index = rec->best_token_for_node[ fsm_arc->to_node];
+        new_ftoken_index = BEST_TOKEN_FOR_NODE(rec, fsm_arc->to_node);
         if(new_ftoken_index != MAXftokenID)
           new_ftoken = &rec->fsmnode_token_array[ new_ftoken_index];
         if( new_ftoken && (current_ftoken->cost+fsm_arc->cost)<new_ftoken->cost) {
@@ -994,7 +1403,7 @@ static int do_epsilon_updates(srec *rec, costdata prune_delta,
               new_ftoken->aword_backtrace = AWTNULL;
               new_ftoken->next_token_index = current_ftoken->next_token_index;
               current_ftoken->next_token_index = new_ftoken_index;
-              rec->best_token_for_node[fsm_arc->to_node] = new_ftoken_index;
+              SET_BEST_TOKEN_FOR_NODE(rec, fsm_arc->to_node, new_ftoken_index);
             } else if(new_ftoken && cost_with_wtw<new_ftoken->cost) {
               /* update token on the other side */
               ftokenID *parent_ftoken_index;
@@ -1013,7 +1422,7 @@ static int do_epsilon_updates(srec *rec, costdata prune_delta,
               *parent_ftoken_index = new_ftoken->next_token_index;
               new_ftoken->next_token_index = current_ftoken->next_token_index;
               current_ftoken->next_token_index = new_ftoken_index;
-              rec->best_token_for_node[ fsm_arc->to_node] = new_ftoken_index;
+              SET_BEST_TOKEN_FOR_NODE(rec, fsm_arc->to_node, new_ftoken_index);
 	      /* new_ftoken->aword_backtrace must be null, alts here were
 		 processed and dropped in srec_process_word_boundary_nbest() */
               if(new_ftoken->aword_backtrace != AWTNULL) {
@@ -1040,7 +1449,7 @@ static int do_epsilon_updates(srec *rec, costdata prune_delta,
             new_ftoken->aword_backtrace = refcopy_altwords(rec, current_ftoken->aword_backtrace);
             new_ftoken->next_token_index = current_ftoken->next_token_index;
             current_ftoken->next_token_index = new_ftoken_index;
-            rec->best_token_for_node[fsm_arc->to_node] = new_ftoken_index;
+            SET_BEST_TOKEN_FOR_NODE(rec, fsm_arc->to_node, new_ftoken_index);
           } else if(new_ftoken && cost_with_wtw<new_ftoken->cost) {
             /* update token on the other side */
             ftokenID *parent_ftoken_index;
@@ -1068,7 +1477,7 @@ static int do_epsilon_updates(srec *rec, costdata prune_delta,
             *parent_ftoken_index = new_ftoken->next_token_index;
             new_ftoken->next_token_index = current_ftoken->next_token_index;
             current_ftoken->next_token_index = new_ftoken_index;
-            rec->best_token_for_node[ fsm_arc->to_node] = new_ftoken_index;
+            SET_BEST_TOKEN_FOR_NODE(rec, fsm_arc->to_node, new_ftoken_index);
           } else {
             /* token on other side is same or better, just leave it */
 	    /* todo: maybe merge alternative lists? */
@@ -1099,6 +1508,8 @@ static void update_internal_hmm_states(srec *rec, costdata *pcurrent_prune_delta
 {
   stokenID current_token_index;
   fsmarc_token *current_token;
+  stokenID *active_list;
+  stokenID i, num_active;
   costdata current_best_cost;
   costdata current_prune_thresh;
   costdata current_prune_delta;
@@ -1122,20 +1533,32 @@ static void update_internal_hmm_states(srec *rec, costdata *pcurrent_prune_delta
   /* best_token_for_arc must be reset here, cuz the same array might have
      been used by another gender.  Alternatively we could have let each
      recog use it's own array thereby save cpu at expense of memory */
-  for (fsm_arc_index = 0; fsm_arc_index < rec->context->num_arcs; fsm_arc_index++)
-    rec->best_token_for_arc[fsm_arc_index] = MAXstokenID;
+  reset_best_token_for_arcs(rec);
+
+  /* walk the linked list once, packing it into an array, so the loop
+     below does not wait on next_token_index before it can start the
+     next token.  The tokens must still be done in list order, since
+     current_prune_thresh tightens as we go */
+  active_list = rec->active_fsmarc_token_list;
+  num_active = 0;
+  for (current_token_index = rec->active_fsmarc_tokens; current_token_index != MAXstokenID;
+       current_token_index = current_token->next_token_index)
+  {
+    current_token = &(rec->fsmarc_token_array[current_token_index]);
+    active_list[num_active++] = current_token_index;
 
-  current_token_index = rec->active_fsmarc_tokens;
-  while (current_token_index != MAXstokenID)
+    /* best_token_for_arc must be set here, cuz it was reset above */
+    SET_BEST_TOKEN_FOR_ARC(rec, current_token->FSMarc_index, current_token_index);
+  }
+
+  for (i = 0; i < num_active; i++)
   {
+    current_token_index = active_list[i];
     current_token = &(rec->fsmarc_token_array[current_token_index]);
 
     fsm_arc_index = current_token->FSMarc_index;
     fsm_arc = &rec->context->FSMarc_list[fsm_arc_index];
 
-    /* best_token_for_arc must be set here, cuz it was reset above */
-    rec->best_token_for_arc[fsm_arc_index] = current_token_index;
-
     hmm_info = &rec->context->hmm_info_for_ilabel[ fsm_arc->ilabel];
     any_alive = 0;
     end_state = current_token->num_hmm_states - 1;
@@ -1225,7 +1648,6 @@ static void update_internal_hmm_states(srec *rec, costdata *pcurrent_prune_delta
         }
       }
     }
-    current_token_index = current_token->next_token_index;
   }
   *pcurrent_best_cost = current_best_cost;
   *pcurrent_prune_delta = current_prune_delta;
@@ -1311,7 +1733,7 @@ static int update_from_hmms_to_fsmnodes(srec *rec, costdata prune_delta, costdat
       end_cost = (costdata)(end_cost + (costdata) duration_penalty_depart(rec->avg_state_durations[end_model_index],
                             current_token->duration[end_state]));
       to_node_index = fsm_arc->to_node;
-      new_ftoken_index = rec->best_token_for_node[to_node_index];
+      new_ftoken_index = BEST_TOKEN_FOR_NODE(rec, to_node_index);
       if (new_ftoken_index == MAXftokenID)
       {
         /*we need to make sure there is room in the new_states array
@@ -1360,7 +1782,7 @@ static int update_from_hmms_to_fsmnodes(srec *rec, costdata prune_delta, costdat
           ftoken->aword_backtrace = AWTNULL;
         }
         rec->active_fsmnode_tokens = new_ftoken_index;
-        rec->best_token_for_node[to_node_index] = new_ftoken_index;
+        SET_BEST_TOKEN_FOR_NODE(rec, to_node_index, new_ftoken_index);
       }
       else /* a token already exists, use it! */
       {
@@ -1583,6 +2005,15 @@ static int update_from_current_fsm_nodes_into_new_HMMs(srec* rec,
 
           model_index = hmm_info->state_indices[0];
 
+          /* not scored, the phone look-ahead turned away every arc into it */
+          if (precomputed_model_scores[model_index] == DO_NOT_COMPUTE_MODEL)
+            continue;
+
+          /* rescoring, this word was not started here in the first lattice */
+          if (olabel != WORD_EPSILON_LABEL && rec->first_pass_num_frames
+              && !first_pass_allows_word_start(rec, olabel))
+            continue;
+
           cost = prev_cost + precomputed_model_scores[model_index];
           cost = (costdata)(cost + (costdata) fsm_arc->cost);
 
@@ -1591,7 +2022,7 @@ static int update_from_current_fsm_nodes_into_new_HMMs(srec* rec,
             /*new node to keep*/
 
             /* look for the fsmarc_token* token, into which to maximize, else create new one */
-            if (rec->best_token_for_arc[fsm_arc_index] == MAXstokenID)
+            if (BEST_TOKEN_FOR_ARC(rec, fsm_arc_index) == MAXstokenID)
             {
 
               /*make sure there is room for another state token - if not, prune
@@ -1612,12 +2043,12 @@ static int update_from_current_fsm_nodes_into_new_HMMs(srec* rec,
               rec->active_fsmarc_tokens = new_token_index;
               rec->num_new_states++;
 
-              rec->best_token_for_arc[fsm_arc_index] = new_token_index;
+              SET_BEST_TOKEN_FOR_ARC(rec, fsm_arc_index, new_token_index);
               token->cost[0] = MAXcostdata;
             }
             else
             {
-              new_token_index = rec->best_token_for_arc[fsm_arc_index];
+              new_token_index = BEST_TOKEN_FOR_ARC(rec, fsm_arc_index);
               token = &(rec->fsmarc_token_array[ new_token_index]);
             }
 
@@ -1699,7 +2130,7 @@ int srec_begin(srec *rec, int begin_syn_node)
   fsmnode_token *token;
   stokenID new_token_index;
   nodeID node_index;
-  arcID arc_index;
+  int i;
 
   if (!rec || !rec->context)
   {
@@ -1735,24 +2166,33 @@ int srec_begin(srec *rec, int begin_syn_node)
     log_report("Error: srec_begin failing due to too many grammar nodes\n");
     return 1;
   }
-  for (node_index = 0;node_index < rec->context->num_nodes;node_index++)
-  {
-    rec->best_token_for_node[node_index] = MAXftokenID;
-  }
+  reset_best_token_for_nodes(rec);
   if (rec->context->num_arcs > rec->max_fsm_arcs)
   {
     log_report("Error: srec_begin failing due to too many grammar arcs\n");
     return 1;
   }
-  for (arc_index = 0;arc_index < rec->context->num_arcs;arc_index++)
-  {
-    rec->best_token_for_arc[arc_index] = MAXstokenID;
-  }
+  reset_best_token_for_arcs(rec);
+  /* from here on, only the states on needed_model_list get reset */
+  for (i = 0; i < rec->num_model_slots_allocated; i++)
+    rec->current_model_scores[i] = DO_NOT_COMPUTE_MODEL;
+  rec->num_needed_models = 0;
   rec->srec_ended = 0;
   rec->num_new_states = 0;
   rec->current_best_cost = 0;
   rec->current_prune_delta = rec->prune_delta;
 
+  rec->active_fsmarc_tokens = MAXstokenID;
+  rec->active_fsmnode_tokens = MAXftokenID;
+  rec->current_search_frame = 0;
+
+  /* enrollment grammars run on the search of srec_enroll.c, if it can */
+  if (rec->enroll)
+    rec->enroll->graph = NULL;
+  if (rec->enrollment_search && FST_IsVoiceEnrollment(rec->context)
+      && srec_enroll_begin(rec) == 0)
+    return 0;
+
   /*need help from johan - does ths FSM only have one start node?
   Which one is it?   assume just one and it is node 0*/
 
@@ -1774,7 +2214,7 @@ int srec_begin(srec *rec, int begin_syn_node)
   token->next_token_index = MAXftokenID;
   token->aword_backtrace = AWTNULL;
 
-  rec->best_token_for_node[node_index] = new_token_index;
+  SET_BEST_TOKEN_FOR_NODE(rec, node_index, new_token_index);
   rec->active_fsmnode_tokens = new_token_index;
   rec->current_search_frame = 0;
 
@@ -1856,6 +2296,12 @@ void srec_no_more_frames(srec* rec)
     rec->accumulated_cost_offset[ rec->current_search_frame-1];
   rec->cost_offset_for_frame[ rec->current_search_frame] = 0;
 
+  if (SREC_ENROLL_ACTIVE(rec))
+  {
+    srec_enroll_no_more_frames(rec);
+    return;
+  }
+
   /* watch out if using the best_token_for_node[] array here
      is it valid? not if multiple recognizers, maybe we
      should remember best_token_for_end_node separately */
@@ -1921,6 +2367,9 @@ void srec_terminate(srec* rec)
   wtokenID wtoken_index, next_wtoken_index;
   word_token* wtoken;
 
+  if (SREC_ENROLL_ACTIVE(rec))
+    srec_enroll_terminate(rec);
+
   /* release all state tokens */
   for (stoken_index = rec->active_fsmarc_tokens; stoken_index != MAXstokenID;
        stoken_index = next_stoken_index)
@@ -1999,14 +2448,105 @@ void srec_viterbi_part1(srec *rec,
 
 void srec_viterbi_part2(srec *rec);
 
+/* wall clock for the beam control below, in microseconds.  clock() counts
+   the cpu time of the whole process, so other searches and threads
+   would be charged to this one, and PTimeStamp only counts milliseconds */
+
+static asr_uint32_t search_clock_usec(void)
+{
+#ifdef _WIN32
+  LARGE_INTEGER now, freq;
+  if (!QueryPerformanceCounter(&now) || !QueryPerformanceFrequency(&freq) || freq.QuadPart == 0)
+    return 0;
+  return (asr_uint32_t)((now.QuadPart / freq.QuadPart) * 1000000
+                        + (now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart);
+#elif defined(POSIX)
+  struct timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+    return 0;
+  return (asr_uint32_t)((asr_uint32_t)now.tv_sec * 1000000 + now.tv_nsec / 1000);
+#else
+  return (asr_uint32_t)((float)clock() * 1000000 / CLOCKS_PER_SEC);
+#endif
+}
+
+/* closed loop beam control, keeps the (smoothed) search time per frame
+   under recm->frame_budget_usec by narrowing prune_delta, and lets it
+   back up towards the beam of this pass once there is time to spare.  The
+   per frame adjustments of current_prune_delta then work off this */
+
+static void adapt_prune_delta(multi_srec *recm, asr_uint32_t elapsed_usec)
+{
+  asr_int32_t frame_usec;
+  costdata prune_delta, min_prune_delta;
+  int i;
+
+  frame_usec = elapsed_usec > 0x7fffffff ? 0x7fffffff : (asr_int32_t)elapsed_usec;
+  recm->avg_frame_usec = (3 * recm->avg_frame_usec + frame_usec) / 4;
+
+  prune_delta = recm->rec[0].prune_delta;
+  min_prune_delta = (costdata)(BEAM_MIN_FRACTION * recm->pass_prune_delta);
+  if (recm->avg_frame_usec > recm->frame_budget_usec)
+  {
+    prune_delta = (costdata)(PRUNE_TIGHTEN * prune_delta);
+    if (prune_delta < min_prune_delta)
+      prune_delta = min_prune_delta;
+  }
+  else if (recm->avg_frame_usec < recm->frame_budget_usec * 3 / 4 &&
+           prune_delta < recm->pass_prune_delta)
+  {
+    prune_delta = (costdata)(prune_delta + (recm->pass_prune_delta - prune_delta) / 8 + 1);
+    if (prune_delta > recm->pass_prune_delta)
+      prune_delta = recm->pass_prune_delta;
+  }
+  for (i = 0; i < recm->num_allocated_recs; i++)
+    recm->rec[i].prune_delta = prune_delta;
+}
+
+/* the first pass of two-pass decoding keeps the features of each frame
+   it searched, so that the rescoring pass can go over them again */
+
+static void keep_first_pass_frame(multi_srec *recm, pattern_info *pattern)
+{
+  const preprocessed *prep = pattern->prep;
+  imeldata *frame;
+
+  if (recm->first_pass_frame_dim != prep->use_dim)
+  {
+    if (recm->num_first_pass_frames > 0)
+    {
+      PLogError("warning: feature dimension changed mid utterance, no rescoring\n");
+      recm->search_pass = SEARCH_PASS_SINGLE;
+      return;
+    }
+    if (recm->first_pass_frames)
+      FREE(recm->first_pass_frames);
+    recm->first_pass_frame_dim = prep->use_dim;
+    recm->first_pass_frames = (imeldata*)CALLOC(recm->max_frames * prep->use_dim, sizeof(imeldata), "search.srec.first_pass_frames");
+    if (!recm->first_pass_frames)
+    {
+      PLogError("warning: no memory to keep first pass frames, no rescoring\n");
+      recm->first_pass_frame_dim = 0;
+      recm->search_pass = SEARCH_PASS_SINGLE;
+      return;
+    }
+  }
+  if (recm->num_first_pass_frames >= recm->max_frames)
+    return;
+  frame = recm->first_pass_frames + recm->num_first_pass_frames * recm->first_pass_frame_dim;
+  memcpy(frame, prep->seq + prep->use_from, prep->use_dim * sizeof(imeldata));
+  recm->num_first_pass_frames++;
+}
+
 int multi_srec_viterbi(multi_srec *recm,
                        srec_eos_detector_parms* eosd,
                        pattern_info *pattern,
                        utterance_info* utt_not_used)
 {
-  EOSrc eosrc1 = SPEECH_ENDED, eosrc2 = SPEECH_ENDED;
+  EOSrc eosrc1 = SPEECH_ENDED;
+  asr_uint32_t frame_start = (recm->frame_budget_usec && recm->search_pass != SEARCH_PASS_RESCORE) ? search_clock_usec() : 0;
 #if DO_ALLOW_MULTIPLE_MODELS
-  ASSERT(recm->num_activated_recs == recm->num_swimodels);
+  ASSERT(recm->num_activated_recs % recm->num_swimodels == 0);
     if (recm->num_activated_recs == 1)
   {
 #endif
@@ -2031,130 +2571,99 @@ int multi_srec_viterbi(multi_srec *recm,
     recm->eos_status = eosrc1;
 #if DO_ALLOW_MULTIPLE_MODELS
     }
-  else if (recm->num_activated_recs == 2)
+  else
   {
-    srec* rec1 = &recm->rec[0];
-    srec* rec2 = &recm->rec[1];
-    const SWIModel* acoustic_models1 = recm->swimodel[0];
-    const SWIModel* acoustic_models2 = recm->swimodel[1];
+    srec* rec;
     costdata diff;
-    costdata current_best_cost;
-
-    ASSERT(rec1->prune_delta == rec2->prune_delta);
-    /* in part 1 we need to operate by adjusting the prune delta, 'cuz we want
-       to operate on scores after consumption of a frame */
-    if ((rec1->current_best_cost > MAXcostdata / 2 && !rec1->srec_ended) ||
-        (rec2->current_best_cost > MAXcostdata / 2 && !rec2->srec_ended))
+    costdata current_best_cost = MAXcostdata;
+    costdata silence_model_cost = DO_NOT_COMPUTE_MODEL;
+    int i, best_i = 0;
+
+    /* the searches are the genders, times the grammars decoded at once.
+       Pruning is joint (i.e. prune every search relative to the overall
+       best).  Before part1 we don't yet know the overall best, so we use
+       the score gaps from the last frame, and make the prune of the worse
+       searches accordingly more aggressive */
+    for (i = 0; i < recm->num_activated_recs; i++)
     {
-      printf("hey %d %d\n", rec1->current_best_cost, rec2->current_best_cost);
+      if (current_best_cost > recm->rec[i].current_best_cost)
+        current_best_cost = recm->rec[i].current_best_cost;
     }
-
-    /* figure out the prune_delta for the different genders, we
-       want that pruning should be joint (i.e. prune male and
-       female relative to overall best).  Before part1 we don't
-       yet know the overall best, so we use the gender score gap
-       from the last frame, and make the prune the worse gender
-       accordingly more aggressive */
-
-    if (!rec2->srec_ended && rec1->current_best_cost < rec2->current_best_cost)
-    {
-      diff = rec2->current_best_cost - rec1->current_best_cost;
-      if (rec2->current_search_frame >= (rec2->word_lattice->max_frames - 1))
-      {
-        return 1;
-      }
-      if (diff > rec2->prune_delta)
-      {
-        srec_terminate(rec2);
-#ifdef SREC_ENGINE_VERBOSE_LOGGING
-        PLogMessage("T: terminate_viterbi(rec2) @%d", rec2->current_search_frame);
-#endif
-      }
-      else
-        rec2->current_prune_delta = rec2->prune_delta - diff;
-      rec1->current_prune_delta = rec1->prune_delta;
-    }
-    else if (!rec1->srec_ended)
+    for (i = 0; i < recm->num_activated_recs; i++)
     {
-      if (rec1->current_search_frame >= (rec1->word_lattice->max_frames - 1))
-      {
+      rec = &recm->rec[i];
+      if (rec->srec_ended)
+        continue;
+      if (rec->current_search_frame >= (rec->word_lattice->max_frames - 1))
         return 1;
-      }
-      diff = rec1->current_best_cost - rec2->current_best_cost;
-      if (diff > rec1->prune_delta)
+      diff = rec->current_best_cost - current_best_cost;
+      if (diff > rec->prune_delta)
       {
-        srec_terminate(rec1);
+        srec_terminate(rec);
 #ifdef SREC_ENGINE_VERBOSE_LOGGING
-        PLogMessage("T: terminate_viterbi(rec1) @%d", rec1->current_search_frame);
+        PLogMessage("T: terminate_viterbi(rec%d) @%d", i + 1, rec->current_search_frame);
 #endif
       }
       else
-        rec1->current_prune_delta = rec1->prune_delta - diff;
-      rec2->current_prune_delta = rec2->prune_delta;
-    }
-
-    /* now run part1 for each gender */
-    if (!rec1->srec_ended)
-    {
-      srec_viterbi_part1(rec1, acoustic_models1, pattern, DO_NOT_COMPUTE_MODEL);
-      SREC_STATS_UPDATE(rec1);
+        rec->current_prune_delta = rec->prune_delta - diff;
     }
 
-    if (!rec2->srec_ended)
+    /* now run part1 for each search, silence is scored once for all of
+       them, searches on the same models share the other scores through
+       the score cache */
+    for (i = 0; i < recm->num_activated_recs; i++)
     {
-      srec_viterbi_part1(rec2, acoustic_models2, pattern, rec1->current_model_scores[SILENCE_MODEL_INDEX]);
-      SREC_STATS_UPDATE(rec2);
+      rec = &recm->rec[i];
+      if (rec->srec_ended)
+        continue;
+      srec_viterbi_part1(rec, recm->swimodel[rec->swimodel_index], pattern, silence_model_cost);
+      SREC_STATS_UPDATE(rec);
+      if (silence_model_cost == DO_NOT_COMPUTE_MODEL)
+        silence_model_cost = rec->current_model_scores[SILENCE_MODEL_INDEX];
     }
 
-    /* now adjust score offsets, score offsets are shared across genders */
-
-    if (rec1->current_best_cost <= rec2->current_best_cost)
+    /* now adjust score offsets, score offsets are shared across searches,
+       the winning one sets them and the others are pruned harder */
+    current_best_cost = MAXcostdata;
+    for (i = 0; i < recm->num_activated_recs; i++)
     {
-      /* am1 is winning, prune 2 harder */
-      current_best_cost = rec1->current_best_cost;
-      reset_cost_offsets(recm, rec1->current_search_frame, current_best_cost);
-    }
-    else
-    {
-      /* am2 is winning, prune 1 harder */
-      current_best_cost = rec2->current_best_cost;
-      reset_cost_offsets(recm, rec2->current_search_frame, current_best_cost);
+      if (current_best_cost > recm->rec[i].current_best_cost)
+      {
+        current_best_cost = recm->rec[i].current_best_cost;
+        best_i = i;
+      }
     }
+    reset_cost_offsets(recm, recm->rec[best_i].current_search_frame, current_best_cost);
 
-    /* jean: some cleanup needed here */
-    /** best_token_for_arc = rec1->best_token_for_arc;
-      rec1->best_token_for_arc = 0; **/
-    if (!rec1->srec_ended)
-    {
-      reset_best_cost_to_zero(rec1, current_best_cost);
-      rec1->current_best_cost = (costdata)(rec1->current_best_cost - (costdata) current_best_cost);
-      srec_viterbi_part2(rec1);
-      if (rec1->active_fsmnode_tokens == MAXftokenID)
-        srec_terminate(rec1);
-      if (!rec1->srec_ended)
-        eosrc1 = srec_check_end_of_speech(eosd, rec1);
-    }
-    /** rec1->best_token_for_arc = best_token_for_arc;
-      best_token_for_arc = rec2->best_token_for_arc;
-      rec2->best_token_for_arc = 0; **/
-    if (!rec2->srec_ended)
+    /* the end of speech status is that of the best search */
+    for (i = 0; i < recm->num_activated_recs; i++)
     {
-      reset_best_cost_to_zero(rec2, current_best_cost);
-      rec2->current_best_cost = (costdata)(rec2->current_best_cost - (costdata) current_best_cost);
-      srec_viterbi_part2(rec2);
-      if (rec2->active_fsmnode_tokens == MAXftokenID)
-        srec_terminate(rec2);
-      if (!rec2->srec_ended)
-        eosrc2 = srec_check_end_of_speech(eosd, rec2);
+      EOSrc eosrc = SPEECH_ENDED;
+      rec = &recm->rec[i];
+      if (!rec->srec_ended)
+      {
+        reset_best_cost_to_zero(rec, current_best_cost);
+        rec->current_best_cost = (costdata)(rec->current_best_cost - (costdata) current_best_cost);
+        srec_viterbi_part2(rec);
+        if (SREC_ENROLL_ACTIVE(rec) ? rec->enroll->num_active_nodes == 0
+            : rec->active_fsmnode_tokens == MAXftokenID)
+          srec_terminate(rec);
+        if (!rec->srec_ended)
+          eosrc = srec_check_end_of_speech(eosd, rec);
+      }
+      SREC_STATS_UPDATE(rec);
+      if (i == 0 || rec->current_best_cost < recm->rec[best_i].current_best_cost)
+      {
+        best_i = i;
+        recm->eos_status = eosrc;
+      }
     }
-    /** rec2->best_token_for_arc = best_token_for_arc; **/
-    SREC_STATS_UPDATE(rec1);
-    SREC_STATS_UPDATE(rec2);
-    recm->eos_status = eosrc1;
-    if (rec1->current_best_cost > rec2->current_best_cost)
-      recm->eos_status = eosrc2;
   }
 #endif
+    if (recm->frame_budget_usec && recm->search_pass != SEARCH_PASS_RESCORE)
+      adapt_prune_delta(recm, search_clock_usec() - frame_start);
+    if (recm->search_pass == SEARCH_PASS_FIRST)
+      keep_first_pass_frame(recm, pattern);
     return 0;
 }
 
@@ -2180,15 +2689,40 @@ void srec_viterbi_part1(srec *rec,
   /*first go ahead and compute scores for all models which are needed by the search at this point*/
 
 
-  find_which_models_to_compute(rec, acoustic_models);
+  if (SREC_ENROLL_ACTIVE(rec))
+    srec_enroll_find_models(rec, acoustic_models);
+  else
+    find_which_models_to_compute(rec, acoustic_models, pattern);
   /* communication happens via rec->current_model_scores */
 #define SCORE_FIRST_SILENCE_ONLY
 #ifdef SCORE_FIRST_SILENCE_ONLY
   if (silence_model_cost != DO_NOT_COMPUTE_MODEL)
+  {
+    /* take silence off the list, its score is given */
+    int i;
+    for (i = 0; i < rec->num_needed_models; i++)
+    {
+      if (rec->needed_model_list[i] == SILENCE_MODEL_INDEX)
+      {
+        rec->needed_model_list[i] = rec->needed_model_list[--rec->num_needed_models];
+        break;
+      }
+    }
     rec->current_model_scores[SILENCE_MODEL_INDEX] = silence_model_cost;
+  }
+#endif
+  num_models_computed = rec->num_needed_models;
+  rec->best_model_cost_for_frame[rec->current_search_frame] =
+    compute_model_scores(rec, acoustic_models, pattern);
+
+  if (SREC_ENROLL_ACTIVE(rec))
+  {
+#if USE_COMP_STATS
+    end_cs_clock(&comp_stats->models, num_models_computed);
 #endif
-  num_models_computed = compute_model_scores(rec->current_model_scores, acoustic_models, pattern, rec->current_search_frame);
-  rec->best_model_cost_for_frame[rec->current_search_frame] = best_uint16(rec->current_model_scores, acoustic_models->num_hmmstates);
+    srec_enroll_viterbi_part1(rec, rec->current_model_scores);
+    return;
+  }
 
 #if USE_COMP_STATS
   end_cs_clock(&comp_stats->models, num_models_computed);
@@ -2240,6 +2774,11 @@ void srec_viterbi_part1(srec *rec,
   start_cs_clock(&comp_stats->prune);
 #endif
 
+  /* beam pruning alone lets the active set explode on noisy input,
+     so narrow the beam for the rest of this frame if need be */
+  if (rec->max_active_hmm_tokens > 0 && rec->num_new_states > rec->max_active_hmm_tokens)
+    current_prune_delta = histogram_prune_delta(rec, current_best_cost, current_prune_delta);
+
   prune_new_tokens(rec, (costdata)(current_best_cost + current_prune_delta));
 
   /* it's nice to do word token pruning here 'cuz we only need to traceback
@@ -2258,18 +2797,21 @@ void srec_viterbi_part1(srec *rec,
 void srec_viterbi_part2(srec *rec)
 {
   wtokenID word_token_index;
-  nodeID inode, num_fsm_nodes_updated;
+  nodeID num_fsm_nodes_updated;
   costdata current_prune_delta = rec->current_prune_delta;
   costdata current_best_cost = rec->current_best_cost;
-  ftokenID* ftmp;
   int num_updates;
 
+  if (SREC_ENROLL_ACTIVE(rec))
+  {
+    srec_enroll_viterbi_part2(rec);
+    return;
+  }
+
   /* first we clear the best_token_for_node array, there are no live
      fsmnode_tokens at this point, and we don't want leftovers from
      the last frame */
-  ftmp = rec->best_token_for_node;
-  for (inode = 0; inode < rec->context->num_nodes; inode++)
-    *ftmp++ = MAXftokenID;
+  reset_best_token_for_nodes(rec);
 
   /*------------------------------------------------------------------------*
     4. reset best cost to 0 (to keep scores in range).  We can do this here
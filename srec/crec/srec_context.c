@@ -110,8 +110,11 @@ int printf_node1(srec_context* fst, FSMnode* node);
 int fst_add_arcs(srec_context* fst, nodeID start_node, nodeID end_node,
                  wordID olabel, costdata cost,
                  modelID* model_sequence, int num_models);
+int fst_reserve_arcs(srec_context* fst, int num_arcs);
+int fst_reserve_nodes(srec_context* fst, int num_nodes);
 int fst_push_arc_olabel(srec_context* fst, FSMarc* arc);
 int fst_push_arc_cost(srec_context* fst, FSMarc* arc);
+int fst_pull_arc_cost(srec_context* fst, FSMarc* arc);
 int fst_pull_arc_olabel(srec_context* fst, FSMarc* arc);
 int fst_free_arc(srec_context* fst, FSMarc* arc);
 int fst_free_node(srec_context* fst, FSMnode* node);
@@ -148,10 +151,16 @@ static ESR_ReturnCode wordmap_populate ( wordmap *word_map, wordID num_words );
 
 int FST_IsVoiceEnrollment(srec_context* context)
 {
-  if (context->olabels == NULL) return 0;
-  if (context->olabels->num_words < 2) return 0;
-  if (strstr(context->olabels->words[1], "enroll")) return 1;
-  return 0;
+  /* words added later go at the end of the word map, so the answer does
+     not change once the map is there */
+  if (!context->voice_enrollment_known)
+  {
+    if (context->olabels == NULL) return 0;
+    if (context->olabels->num_words < 2) return 0;
+    context->is_voice_enrollment = (asr_int16_t)(strstr(context->olabels->words[1], "enroll") != NULL);
+    context->voice_enrollment_known = 1;
+  }
+  return context->is_voice_enrollment;
 }
 
 int FST_LoadContext(const char* synbase, srec_context** pcontext,
@@ -217,6 +226,7 @@ void FST_UnloadContext(srec_context* context)
   FST_UnloadWordMap(&context->olabels);
   FST_UnloadGraph(context);
   FST_UnloadReverseWordGraph(context);
+  srec_enroll_graph_free(context);
   FREE(context);
 }
 
@@ -233,6 +243,9 @@ int FST_PrepareContext(srec_context* context)
   if (i != context->num_nodes)
     rc = fst_fill_node_info(context);
 
+  /* every change to the graph leaves it unprepared, so a compact copy
+     made for the enrollment search is out of date */
+  srec_enroll_graph_free(context);
   context->whether_prepared = 1;
   return rc ? FST_FAILED_ON_INVALID_ARGS : FST_SUCCESS;
 }
@@ -244,6 +257,7 @@ void fst_set_wb_costs( srec_context* context, costdata wbcost)
     if(context->FSMarc_list[i].ilabel == WORD_BOUNDARY)
       context->FSMarc_list[i].cost = wbcost;
   }
+  srec_enroll_graph_free(context);
 }
 
 int FST_LoadParams(srec_context* context, PFile* fp)
@@ -447,7 +461,7 @@ int FST_DumpWordMap(PFile* fp, wordmap* wmap)
   wordID my_wID;
   for (my_wID = 0; my_wID < wmap->num_words; my_wID++)
   {
-    pfprintf(fp, "%s %hu\n", wmap->words[my_wID], my_wID);
+    pfprintf(fp, "%s %" ID_FMT "\n", wmap->words[my_wID], my_wID);
   }
   return FST_SUCCESS;
 }
@@ -1166,40 +1180,33 @@ int FST_DumpGraph(srec_context* fst, PFile* fp)
         if (atoken->cost != FREEcostdata)
         {
           /* regular arc */
-          pfprintf(fp, "%hu\t%hu\t%s\t%s\t%hu\n",
+          pfprintf(fp, "%" ID_FMT "\t%" ID_FMT "\t%s\t%s\t%hu\n",
                   from_node, into_node, ilabel, olabel, atoken->cost);
         }
         else
         {
           /* regular zero cost arc */
-          pfprintf(fp, "%hu\t%hu\t%s\t%s\n",
+          pfprintf(fp, "%" ID_FMT "\t%" ID_FMT "\t%s\t%s\n",
                   from_node, into_node, ilabel, olabel);
         }
       }
     }
     else
     {
-      pfprintf(fp, "%hu\n", from_node);
+      pfprintf(fp, "%" ID_FMT "\n", from_node);
     }
   }
   return rc;
 }
 
-int FST_AddWordToGrammar(srec_context* fst, const char* _slot,
-                         const char* word, const char* pron,
-                         const int cost)
+/* finds the start and end nodes of the slot, with caching because
+   developers call AddWord with the same slot many times */
+static int fst_find_slot_nodes(srec_context* fst, const char* _slot,
+                               nodeID* pstart_node, nodeID* pend_node)
 {
-  int num_pron_ampersands = 0, num_prons_added = 0, num_words_added = 0;
-  int i, pron_len, model_sequence_len;
-  modelID model_sequence[MAX_PRON_LEN];
-  char phoneme_sequence[MAX_PRON_LEN];
-  wordID olabel = MAXwordID;
-  int irc, rc = FST_SUCCESS;
+  int i;
   nodeID start_node = MAXnodeID, end_node = MAXnodeID;
   char veslot[MAX_WORD_LEN];
-#if USE_HMM_BASED_ENROLLMENT
-  const char* Tpron;
-#endif
 
   /* The addword from voice enroll still use @, and to test voice enroll, @ sign was removed and __ was added at the begining and ending of a word. Xufang */
   if(_slot[0] == '@') {
@@ -1209,12 +1216,6 @@ int FST_AddWordToGrammar(srec_context* fst, const char* _slot,
   } else
     strcpy(veslot, _slot);
 
-#if USE_COMP_STATS
-  if (!comp_stats)
-    comp_stats = init_comp_stats1();
-  start_cs_clock1(&comp_stats->word_addition);
-#endif
-
   /* we expect developers to call AddWord with the same slot many times,
   so we cache the slot start and end nodes and re-use on subseq calls */
   if( fst->addWordCaching_lastslot_num == MAXwordID )
@@ -1236,8 +1237,7 @@ int FST_AddWordToGrammar(srec_context* fst, const char* _slot,
       for (i = 1; i < (size_t) fst->olabels->num_slots; ++i)
         pfprintf(PSTDOUT, "%s, ", fst->olabels->words[i]);
       pfprintf(PSTDOUT, L("] possible\n"));
-      rc = FST_FAILED_ON_INVALID_ARGS;
-      goto RETRC;
+      return FST_FAILED_ON_INVALID_ARGS;
     }
 
     fst->addWordCaching_lastslot_name = fst->olabels->words[fst->addWordCaching_lastslot_num];
@@ -1270,15 +1270,31 @@ int FST_AddWordToGrammar(srec_context* fst, const char* _slot,
       {
 	PLogError("error: (internal) finding olabel %d %d %d\n", fst->addWordCaching_lastslot_num,
 		  start_node, end_node);
-	goto RETRC;
+	return FST_FAILED_INTERNAL;
       }
   } /* cached or not */
 
   i = fst->addWordCaching_lastslot_ifsm_exit_point;
-  start_node = fst->fsm_exit_points[i].from_node_index;
-  end_node = fst->fsm_exit_points[i].wbto_node_index;
+  *pstart_node = fst->fsm_exit_points[i].from_node_index;
+  *pend_node = fst->fsm_exit_points[i].wbto_node_index;
+  return FST_SUCCESS;
+}
+
+/* adds all the prons of a word between the start and end nodes of the
+   current (cached) slot, see FST_AddWordToGrammar() for return codes */
+static int fst_add_word_prons(srec_context* fst, nodeID start_node, nodeID end_node,
+                              const char* word, const char* pron, const int cost)
+{
+  int num_pron_ampersands = 0, num_prons_added = 0, num_words_added = 0;
+  int i, pron_len, model_sequence_len;
+  modelID model_sequence[MAX_PRON_LEN];
+  char phoneme_sequence[MAX_PRON_LEN];
+  wordID olabel = MAXwordID;
+  int irc, rc = FST_SUCCESS;
+#if USE_HMM_BASED_ENROLLMENT
+  const char* Tpron;
+#endif
 
-  /* now start_node and end_node are known */
   if (!word || !*word || !pron || !*pron)
     {
       rc = FST_FAILED_ON_INVALID_ARGS;
@@ -1483,12 +1499,6 @@ int FST_AddWordToGrammar(srec_context* fst, const char* _slot,
 
 
  RETRC:
-  /* set this to make sure that FST_Prepare gets called after add word */
-  fst->whether_prepared = 0;
-#if USE_COMP_STATS
-  end_cs_clock1(&comp_stats->word_addition, 1);
-#endif
-
   if (rc < 0 && rc != FST_FAILED_ON_HOMONYM)
     return rc;
 
@@ -1511,6 +1521,112 @@ int FST_AddWordToGrammar(srec_context* fst, const char* _slot,
     }
 }
 
+int FST_AddWordToGrammar(srec_context* fst, const char* _slot,
+                         const char* word, const char* pron,
+                         const int cost)
+{
+  int rc;
+  nodeID start_node, end_node;
+
+#if USE_COMP_STATS
+  if (!comp_stats)
+    comp_stats = init_comp_stats1();
+  start_cs_clock1(&comp_stats->word_addition);
+#endif
+
+  rc = fst_find_slot_nodes(fst, _slot, &start_node, &end_node);
+  if (rc == FST_SUCCESS)
+    rc = fst_add_word_prons(fst, start_node, end_node, word, pron, cost);
+
+  /* set this to make sure that FST_Prepare gets called after add word */
+  fst->whether_prepared = 0;
+#if USE_COMP_STATS
+  end_cs_clock1(&comp_stats->word_addition, 1);
+#endif
+  return rc;
+}
+
+/* estimates the arcs (and nodes) needed to add a double-null terminated
+   list of prons, a pron with optional silences is added twice */
+static int fst_estimate_arcs_for_prons(const char* pron)
+{
+  int num_arcs = 0, pron_len;
+  if (!pron)
+    return 0;
+  for ( ; *pron != '\0'; pron += pron_len + 1) {
+    pron_len = strlen(pron);
+    /* the pron, plus the post silence and the word boundary */
+    num_arcs += pron_len + 2;
+    if (strchr(pron, OPTSILENCE_CODE))
+      num_arcs += pron_len + 2;
+  }
+  return num_arcs;
+}
+
+int FST_AddWordsToGrammar(srec_context* fst, const char* slot, int num_words,
+                          const char** words, const char** prons,
+                          const int* costs, int* results)
+{
+  int i, irc, rc, num_arcs_needed = 0;
+  nodeID start_node, end_node;
+
+  if (num_words <= 0 || !words || !prons)
+    {
+      for (i = 0; results && i < num_words; i++)
+        results[i] = FST_FAILED_ON_INVALID_ARGS;
+      return FST_FAILED_ON_INVALID_ARGS;
+    }
+
+#if USE_COMP_STATS
+  if (!comp_stats)
+    comp_stats = init_comp_stats1();
+  start_cs_clock1(&comp_stats->word_addition);
+#endif
+
+  /* one slot lookup for the whole batch */
+  rc = fst_find_slot_nodes(fst, slot, &start_node, &end_node);
+  if (rc != FST_SUCCESS)
+    {
+      for (i = 0; results && i < num_words; i++)
+        results[i] = rc;
+      goto RETRC;
+    }
+
+  /* one growth of the arc and node pools for the whole batch, rather
+     than many small re-allocations as the words trickle in, if this
+     fails the pools still grow word by word below */
+  for (i = 0; i < num_words; i++)
+    num_arcs_needed += fst_estimate_arcs_for_prons(prons[i]);
+  if (fst_reserve_arcs(fst, num_arcs_needed) == FST_SUCCESS)
+    fst_reserve_nodes(fst, num_arcs_needed);
+
+  /* each word is still merged into the slot's prefix tree on its own,
+     walking the prefix it shares with the words already there, a failure
+     on one word does not stop the batch, the caller gets a code per word */
+  for (i = 0; i < num_words; i++)
+    {
+      irc = fst_add_word_prons(fst, start_node, end_node, words[i], prons[i],
+                               costs ? costs[i] : 0);
+      if (results)
+        results[i] = irc;
+      if (irc == FST_FAILED_ON_MEMORY || irc == FST_FAILED_INTERNAL)
+        {
+          rc = irc;
+          for (i++; results && i < num_words; i++)
+            results[i] = irc;
+          break;
+        }
+    }
+
+ RETRC:
+  /* set this to make sure that FST_Prepare gets called after add word */
+  fst->whether_prepared = 0;
+#if USE_COMP_STATS
+  end_cs_clock1(&comp_stats->word_addition, num_words);
+#endif
+  return rc;
+}
+
 /* remove arcs leaving a node, arcs added via word add, are just discarded
 to be cleaned up for re-use by other functions */
 void remove_added_arcs_leaving(srec_context* fst, nodeID ni)
@@ -1790,13 +1906,13 @@ int FST_LoadReverseWordGraph(srec_context* context, int num_words_to_add, PFile*
   i = 0;
   while (pfgets(line, MAX_LINE_LENGTH, fp))
   {
-    if (sscanf(line, "%hu\t%hu\t%s", &from_node, &into_node, word_label_as_str) == 3)
+    if (sscanf(line, "%" ID_FMT "\t%" ID_FMT "\t%s", &from_node, &into_node, word_label_as_str) == 3)
     {
       word_label = wordmap_find_index(context->olabels, word_label_as_str);
       // ASSERT(word_label >= 0);
       cost = FREEcostdata;
     }
-    else if (sscanf(line, "%hu", &from_node) == 1)
+    else if (sscanf(line, "%" ID_FMT, &from_node) == 1)
     {
       into_node = MAXnodeID;
       word_label = MAXwordID;
@@ -2075,6 +2191,42 @@ int fst_push_arc_cost(srec_context* fst, FSMarc* arc)
   arc->cost = FREEcostdata;
   return FST_SUCCESS;
 }
+
+/* moves the cheapest cost among the arcs leaving this arc up onto the arc
+   itself, so that a shared prefix carries the best cost reachable through
+   it and the search can prune unpromising branches before they fan out.
+   Path costs are unchanged since every path through the arc continues on
+   exactly one of those arcs */
+int fst_pull_arc_cost(srec_context* fst, FSMarc* arc)
+{
+  FSMarc_ptr atok;
+  FSMarc* atoken;
+  costdata min_cost = MAXcostdata;
+
+  if (arc->to_node == FSMNODE_NULL || num_arcs_arriving_gt_1(fst, NODE_XtoP(arc->to_node)))
+    return FST_CONTINUE;
+  for (atok = FIRST_NEXT(arc->to_node); atok != FSMARC_NULL; atok = atoken->linkl_next_arc)
+  {
+    atoken = ARC_XtoP(atok);
+    /* never touch the base grammar nor disabled arcs */
+    if (ARC_XtoI(atok) < fst->num_base_arcs || atoken->cost == DISABLE_ARC_COST)
+      return FST_CONTINUE;
+    if (atoken->cost < min_cost)
+      min_cost = atoken->cost;
+  }
+  if (min_cost == MAXcostdata || min_cost == FREEcostdata)
+    return FST_SUCCESS;
+  if ((int)arc->cost + min_cost >= DISABLE_ARC_COST)
+    return FST_CONTINUE;
+
+  for (atok = FIRST_NEXT(arc->to_node); atok != FSMARC_NULL; atok = atoken->linkl_next_arc)
+  {
+    atoken = ARC_XtoP(atok);
+    atoken->cost = (costdata)(atoken->cost - min_cost);
+  }
+  arc->cost = (costdata)(arc->cost + min_cost);
+  return FST_SUCCESS;
+}
 #endif
 
 
@@ -2119,7 +2271,7 @@ int fst_pull_arc_olabel(srec_context* fst, FSMarc* arc)
     }
     atoken->olabel = arc->olabel;
 #if DO_WEIGHTED_ADDWORD
-    atoken->cost = arc->cost;
+    atoken->cost = (costdata)(atoken->cost + arc->cost);
 #endif
     IF_DEBUG_WDADD(atoken->olabel_str = arc->olabel_str);
   }
@@ -2265,6 +2417,7 @@ int split_node_for_arc(srec_context* fst, FSMarc* arc)
     new_next_p->to_node = atoken->to_node;
     new_next_p->fr_node = arc->to_node;
     new_next_p->olabel = atoken->olabel;
+    new_next_p->cost = atoken->cost;
     IF_DEBUG_WDADD(new_next_p->ilabel_str = atoken->ilabel_str);
     IF_DEBUG_WDADD(new_next_p->olabel_str = atoken->olabel_str);
     new_next_p->linkl_next_arc = FSMARC_NULL; /* set at next loop */
@@ -2274,34 +2427,18 @@ int split_node_for_arc(srec_context* fst, FSMarc* arc)
   return FST_SUCCESS;
 }
 
-int fst_add_arcs(srec_context* fst, nodeID start_node, nodeID end_node,
-                 wordID add_tree_olabel, costdata add_tree_cost,
-                 modelID* add_tree_start, int add_tree_len)
-{
-  int rc = FST_SUCCESS;
-  FSMarc_ptr atok = (FSMarc_ptr)0, last_atok = (FSMarc_ptr)0;
-  FSMarc* atoken = NULL;
-  FSMarc *next_atoken, *prev_atoken;
-  FSMarc *append_to;
-  FSMnode *late_start_node, *early_end_node;
-  FSMnode *ntoken, *last_ntoken;
-  FSMnode_ptr ntok, last_ntok;
-  modelID *add_tree_end = add_tree_start + add_tree_len - 1;
-  modelID *add_tree_late_start, *add_tree_early_end;
-  modelID *add_tree;
-  arcID new_arc_id, atokid;
-  nodeID new_node_id, atokid_node;
-  wordID add_tree_olabel_use = add_tree_olabel;
-  wordID add_tree_cost_use   = add_tree_cost;
-
-  append_to = NULL;
-  add_tree = add_tree_start;
 #define FST_GROW_MINARCS  100
 #define FST_GROW_MINNODES 100
+
+/* makes sure at least num_arcs more arcs are available on the free list,
+   growing the arc pool once by enough for all of them if needed */
+int fst_reserve_arcs(srec_context* fst, int num_arcs)
+{
 #if defined(FST_GROW_FACTOR)
+  FSMarc* atoken;
+  arcID atokid;
 
-  /* make sure we have enough arcs available */
-  if(fst->num_arcs + add_tree_len >= fst->FSMarc_list_len)
+  if(fst->num_arcs + num_arcs >= fst->FSMarc_list_len)
    {
 	FSMarc* tmp_FSMarc_list;
 	arcID tmp_FSMarc_list_len;
@@ -2310,8 +2447,8 @@ int fst_add_arcs(srec_context* fst, nodeID start_node, nodeID end_node,
 	if( itmp_FSMarc_list_len - fst->FSMarc_list_len < FST_GROW_MINARCS)
 		itmp_FSMarc_list_len += FST_GROW_MINARCS;
 
-	if( itmp_FSMarc_list_len - fst->FSMarc_list_len < add_tree_len)
-		itmp_FSMarc_list_len += add_tree_len;
+	if( itmp_FSMarc_list_len - fst->FSMarc_list_len < num_arcs)
+		itmp_FSMarc_list_len += num_arcs;
 
     if(itmp_FSMarc_list_len >= (int)MAXarcID)
 	     return FST_FAILED_ON_MEMORY;
@@ -2348,9 +2485,19 @@ int fst_add_arcs(srec_context* fst, nodeID start_node, nodeID end_node,
     fst->FSMarc_list = tmp_FSMarc_list;
     fst->FSMarc_list_len = tmp_FSMarc_list_len;
    }
+#endif
+  return FST_SUCCESS;
+}
+
+/* makes sure at least num_nodes more nodes are available on the free list,
+   growing the node pool once by enough for all of them if needed */
+int fst_reserve_nodes(srec_context* fst, int num_nodes)
+{
+#if defined(FST_GROW_FACTOR)
+  FSMnode* ntoken;
+  nodeID atokid_node;
 
-   /* make sure we have enough nodes available */
-   if(fst->num_nodes + add_tree_len >= fst->FSMnode_list_len)
+   if(fst->num_nodes + num_nodes >= fst->FSMnode_list_len)
    {
      FSMnode* tmp_FSMnode_list;
 	 nodeID tmp_FSMnode_list_len;
@@ -2360,8 +2507,8 @@ int fst_add_arcs(srec_context* fst, nodeID start_node, nodeID end_node,
 	 if( itmp_FSMnode_list_len - fst->FSMnode_list_len < FST_GROW_MINNODES)
 		itmp_FSMnode_list_len += FST_GROW_MINNODES;
 
-	 if( itmp_FSMnode_list_len - fst->FSMnode_list_len < add_tree_len)
-		itmp_FSMnode_list_len += add_tree_len;
+	 if( itmp_FSMnode_list_len - fst->FSMnode_list_len < num_nodes)
+		itmp_FSMnode_list_len += num_nodes;
 
 	 if(itmp_FSMnode_list_len >= (int)MAXnodeID)
 	     return FST_FAILED_ON_MEMORY;
@@ -2415,7 +2562,39 @@ int fst_add_arcs(srec_context* fst, nodeID start_node, nodeID end_node,
     fst->FSMnode_list_len = tmp_FSMnode_list_len;
 }
 #endif
-   late_start_node = &fst->FSMnode_list[start_node];
+  return FST_SUCCESS;
+}
+
+int fst_add_arcs(srec_context* fst, nodeID start_node, nodeID end_node,
+                 wordID add_tree_olabel, costdata add_tree_cost,
+                 modelID* add_tree_start, int add_tree_len)
+{
+  int rc = FST_SUCCESS;
+  FSMarc_ptr atok = (FSMarc_ptr)0, last_atok = (FSMarc_ptr)0;
+  FSMarc* atoken = NULL;
+  FSMarc *next_atoken, *prev_atoken;
+  FSMarc *append_to, *last_shared_arc;
+  FSMnode *late_start_node, *early_end_node;
+  FSMnode *ntoken, *last_ntoken;
+  FSMnode_ptr ntok, last_ntok;
+  modelID *add_tree_end = add_tree_start + add_tree_len - 1;
+  modelID *add_tree_late_start, *add_tree_early_end;
+  modelID *add_tree;
+  arcID new_arc_id;
+  nodeID new_node_id;
+  wordID add_tree_olabel_use = add_tree_olabel;
+  wordID add_tree_cost_use   = add_tree_cost;
+
+  append_to = NULL;
+  last_shared_arc = NULL;
+  add_tree = add_tree_start;
+  rc = fst_reserve_arcs(fst, add_tree_len);
+  if (rc == FST_SUCCESS)
+    rc = fst_reserve_nodes(fst, add_tree_len);
+  if (rc != FST_SUCCESS)
+    return rc;
+
+  late_start_node = &fst->FSMnode_list[start_node];
 
   while (1)
   {
@@ -2436,7 +2615,9 @@ int fst_add_arcs(srec_context* fst, nodeID start_node, nodeID end_node,
 
       if (num_arcs_arriving_gt_1(fst, NODE_XtoP(next_atoken->to_node)))
       {
-        split_node_for_arc(fst, next_atoken);
+        rc = split_node_for_arc(fst, next_atoken);
+        if (rc != FST_SUCCESS)
+          return rc;
         /* unfortunate side effect here, that if we later find out this
            was a homonym addition, then this expansion was useless and
            for now we don't undo it! */
@@ -2469,6 +2650,7 @@ int fst_add_arcs(srec_context* fst, nodeID start_node, nodeID end_node,
       }
       add_tree++;
       late_start_node = NODE_XtoP(next_atoken->to_node);
+      last_shared_arc = next_atoken;
     }
     else
     {
@@ -2651,6 +2833,22 @@ int fst_add_arcs(srec_context* fst, nodeID start_node, nodeID end_node,
     TO_NODE(last_atok) = NODE_PtoX(early_end_node);
     append_arc_arriving_node(fst, early_end_node, last_atok);
   }
+
+#if DO_WEIGHTED_ADDWORD
+  /* the walk above pushed the costs of the shared prefix down to where
+     this word branches off, now pull the cheapest of them back up towards
+     the slot start so the prefix tree is scored as early as possible */
+  for (atoken = last_shared_arc; atoken != NULL;)
+  {
+    if (fst_pull_arc_cost(fst, atoken) != FST_SUCCESS)
+      break;
+    ntoken = NODE_XtoP(atoken->fr_node);
+    if (ntoken == &fst->FSMnode_list[start_node] || num_arcs_arriving_gt_1(fst, ntoken))
+      break;
+    atok = FIRST_PREV(atoken->fr_node);
+    atoken = (atok == FSMARC_NULL) ? NULL : ARC_XtoP(atok);
+  }
+#endif
   return rc;
 }
 
@@ -2696,10 +2894,10 @@ int sprintf_arc(char* buf, srec_context* fst, FSMarc* arc)
   FSMnode* to_node = NODE_XtoP(arc->to_node);
   arcID arc_index = (arcID)(arc - fst->FSMarc_list);
   if (to_node->un_ptr.first_next_arc == FSMARC_NULL)
-    rc = sprintf(buf, "arc%hu\n", arc_index);
+    rc = sprintf(buf, "arc%" ID_FMT "\n", arc_index);
   else
   {
-    rc = sprintf(buf, "arc%hu\t%hu,%hu\t%s\t%s\t%hu\n",
+    rc = sprintf(buf, "arc%" ID_FMT "\t%" ID_FMT ",%" ID_FMT "\t%s\t%s\t%hu\n",
                  arc_index,
                  ARC_XtoI(to_node->un_ptr.first_next_arc),
                  arc->linkl_next_arc != FSMARC_NULL ? ARC_XtoI(arc->linkl_next_arc) : -1,
@@ -2897,10 +3095,10 @@ static ESR_ReturnCode serializeArcToken(arc_token *token_base,
   arc_token *token = token_base + i;
   asr_uint32_t idx;
 
-  if (pfwrite(&token->ilabel, 2, 1, fp) != 1)
+  if (pfwrite(&token->ilabel, sizeof(token->ilabel), 1, fp) != 1)
     return ESR_WRITE_ERROR;
 
-  if (pfwrite(&token->olabel, 2, 1, fp) != 1)
+  if (pfwrite(&token->olabel, sizeof(token->olabel), 1, fp) != 1)
     return ESR_WRITE_ERROR;
 
   /* if (pfwrite(&token->cost, 2, 1, fp) != 1)
@@ -2925,7 +3123,7 @@ static ESR_ReturnCode serializeArcTokenInfo(srec_context *context,
   asr_uint32_t idx;
   ESR_ReturnCode rc;
 
-  if (pfwrite(&context->arc_token_list_len, 2, 1, fp) != 1)
+  if (pfwrite(&context->arc_token_list_len, sizeof(context->arc_token_list_len), 1, fp) != 1)
     return ESR_WRITE_ERROR;
 
   idx = PTR_TO_IDX(context->arc_token_freelist, context->arc_token_list);
@@ -2952,14 +3150,11 @@ static ESR_ReturnCode deserializeArcToken(arc_token *token_base,
 {
   arc_token *token = token_base + i;
   asr_uint32_t idx[2];
-  asr_uint16_t labels[2];
 
-  if (pfread(labels, 2, 2, fp) != 2)
+  if (pfread(&token->ilabel, sizeof(token->ilabel), 1, fp) != 1 ||
+      pfread(&token->olabel, sizeof(token->olabel), 1, fp) != 1)
     return ESR_READ_ERROR;
 
-  token->ilabel = labels[0];
-  token->olabel = labels[1];
-
   /* if (pfread(&token->cost, 2, 1, fp) != 1)
      return ESR_READ_ERROR; */
 
@@ -2979,7 +3174,7 @@ static ESR_ReturnCode deserializeArcTokenInfo(srec_context *context,
   int i;
   asr_uint32_t idx;
 
-  if (pfread(&context->arc_token_list_len, 2, 1, fp) != 1) {
+  if (pfread(&context->arc_token_list_len, sizeof(context->arc_token_list_len), 1, fp) != 1) {
     PLogError("pfread failed in deserializeArcTokenInfo()\n");
     return ESR_READ_ERROR;
   }
@@ -3189,11 +3384,11 @@ int FST_DumpContextAsImageV2(srec_context* context, PFile* fp)
     q = p + MAX_NUM_SLOTS;
     while (p < q)
     {
-      if (pfwrite(&p->from_node_index, 2, 1, fp) != 1)
+      if (pfwrite(&p->from_node_index, sizeof(p->from_node_index), 1, fp) != 1)
         return ESR_WRITE_ERROR;
-      if (pfwrite(&p->arc_index, 2, 1, fp) != 1)
+      if (pfwrite(&p->arc_index, sizeof(p->arc_index), 1, fp) != 1)
         return ESR_WRITE_ERROR;
-      if (pfwrite(&p->wbto_node_index, 2, 1, fp) != 1)
+      if (pfwrite(&p->wbto_node_index, sizeof(p->wbto_node_index), 1, fp) != 1)
         return ESR_WRITE_ERROR;
       ++p;
     }
@@ -3451,11 +3646,11 @@ int FST_LoadContextFromImageV2(srec_context* fst, PFile* fp)
   q = p + MAX_NUM_SLOTS;
   while (p < q)
   {
-    if (pfread(&p->from_node_index, 2, 1, fp) != 1)
+    if (pfread(&p->from_node_index, sizeof(p->from_node_index), 1, fp) != 1)
       return ESR_WRITE_ERROR;
-    if (pfread(&p->arc_index, 2, 1, fp) != 1)
+    if (pfread(&p->arc_index, sizeof(p->arc_index), 1, fp) != 1)
       return ESR_WRITE_ERROR;
-    if (pfread(&p->wbto_node_index, 2, 1, fp) != 1)
+    if (pfread(&p->wbto_node_index, sizeof(p->wbto_node_index), 1, fp) != 1)
       return ESR_WRITE_ERROR;
     ++p;
   }
@@ -3564,9 +3759,17 @@ int FST_LoadContextFromImage(srec_context** pcontext, PFile* fp)
     if (rc != FST_SUCCESS)
       goto CLEANUP;
   }
+  else if (header[1] == IMAGE_FORMAT_V2_NARROW || header[1] == IMAGE_FORMAT_V2_WIDE)
+  {
+    PLogError("FST_LoadContextFromImage() image has %s ids, rebuild it with this recognizer\n",
+              header[1] == IMAGE_FORMAT_V2_WIDE ? "32-bit" : "16-bit");
+    rc = FST_FAILED_ON_INVALID_ARGS;
+    goto CLEANUP;
+  }
   else
   {
     PLogError("FST_LoadContextFromImage() failed on image_format\n");
+    rc = FST_FAILED_ON_INVALID_ARGS;
     goto CLEANUP;
   }
   *pcontext = context;
@@ -3578,6 +3781,266 @@ CLEANUP:
 }
 
 
+/* like the image, the delta starts with its own size and format, so that
+   the semantic graph entries appended after it can be found */
+#define DELTA_HEADER_FIELDS 9
+
+int FST_DumpContextDelta(srec_context* context, PFile* fp)
+{
+  srec_context* fst = context;
+  asr_uint32_t header[DELTA_HEADER_FIELDS];
+  arcID tmp[5], nfields;
+  nodeID* node_map;
+  nodeID i, num_added_nodes;
+  arcID num_added_arcs;
+  wordID wdid;
+  asr_uint16_t len;
+  FSMarc_ptr atok;
+  FSMarc* atoken;
+  FSMnode* ntoken;
+  int rc = FST_SUCCESS;
+
+  if (!fp)
+    return FST_FAILED_ON_INVALID_ARGS;
+
+  /* added nodes are renumbered to follow the base nodes contiguously */
+  node_map = NEW_ARRAY(nodeID, fst->FSMnode_list_len, L("srec.graph.delta.nodemap"));
+  if (!node_map)
+    return FST_FAILED_ON_MEMORY;
+  for (i = 0; i < fst->FSMnode_list_len; i++)
+    node_map[i] = (i < fst->num_base_nodes) ? i : MAXnodeID;
+
+  num_added_arcs = 0;
+  for (i = 0; i < fst->FSMnode_list_len; i++)
+  {
+    ntoken = &fst->FSMnode_list[i];
+    if (ntoken->first_prev_arc == FSMARC_FREE)
+      continue;
+    for (atok = ntoken->un_ptr.first_next_arc; atok != FSMARC_NULL; atok = atoken->linkl_next_arc)
+    {
+      atoken = ARC_XtoP(atok);
+      if (ARC_XtoI(atok) < fst->num_base_arcs)
+        continue;
+      if (i >= fst->num_base_nodes)
+        node_map[i] = 0;
+      if (atoken->to_node >= fst->num_base_nodes)
+        node_map[atoken->to_node] = 0;
+      num_added_arcs++;
+    }
+  }
+  num_added_nodes = 0;
+  for (i = fst->num_base_nodes; i < fst->FSMnode_list_len; i++)
+  {
+    if (node_map[i] != MAXnodeID)
+      node_map[i] = (nodeID)(fst->num_base_nodes + num_added_nodes++);
+  }
+
+  header[0] = 0; /* the size, written once known */
+  header[1] = IMAGE_FORMAT_DELTA;
+  header[2] = fst->modelid;
+  header[3] = fst->num_base_arcs;
+  header[4] = fst->num_base_nodes;
+  header[5] = fst->olabels->num_base_words;
+  header[6] = fst->olabels->num_words - fst->olabels->num_base_words;
+  header[7] = num_added_nodes;
+  header[8] = num_added_arcs;
+  if (pfwrite(header, sizeof(header[0]), DELTA_HEADER_FIELDS, fp) != DELTA_HEADER_FIELDS)
+  {
+    PLogError("FST_DumpContextDelta: could not write header.\n");
+    rc = FST_FAILED_INTERNAL;
+    goto CLEANUP;
+  }
+
+  /* the added words, already carrying their slot suffix */
+  for (wdid = fst->olabels->num_base_words; wdid < fst->olabels->num_words; wdid++)
+  {
+    len = (asr_uint16_t)(strlen(fst->olabels->words[wdid]) + 1);
+    if (pfwrite(&len, sizeof(len), 1, fp) != 1 ||
+        pfwrite(fst->olabels->words[wdid], sizeof(char), len, fp) != len)
+    {
+      rc = FST_FAILED_INTERNAL;
+      goto CLEANUP;
+    }
+  }
+
+  /* the added arcs, in the order they leave their nodes */
+  for (i = 0; i < fst->FSMnode_list_len; i++)
+  {
+    ntoken = &fst->FSMnode_list[i];
+    if (ntoken->first_prev_arc == FSMARC_FREE)
+      continue;
+    for (atok = ntoken->un_ptr.first_next_arc; atok != FSMARC_NULL; atok = atoken->linkl_next_arc)
+    {
+      atoken = ARC_XtoP(atok);
+      if (ARC_XtoI(atok) < fst->num_base_arcs)
+        continue;
+      nfields = 0;
+      tmp[nfields++] = node_map[i];
+      tmp[nfields++] = node_map[atoken->to_node];
+      tmp[nfields++] = atoken->ilabel;
+      tmp[nfields++] = atoken->olabel;
+      tmp[nfields++] = atoken->cost;
+      if (pfwrite(tmp, sizeof(tmp[0]), nfields, fp) != nfields)
+      {
+        rc = FST_FAILED_INTERNAL;
+        goto CLEANUP;
+      }
+    }
+  }
+
+  header[0] = pftell(fp);
+  if (pfseek(fp, 0, SEEK_SET) ||
+      pfwrite(header, sizeof(header[0]), 1, fp) != 1 ||
+      pfseek(fp, 0, SEEK_END))
+  {
+    PLogError("FST_DumpContextDelta: could not write the delta size.\n");
+    rc = FST_FAILED_INTERNAL;
+  }
+
+CLEANUP:
+  FREE(node_map);
+  return rc;
+}
+
+int FST_LoadContextDelta(srec_context* context, PFile* fp)
+{
+  srec_context* fst = context;
+  asr_uint32_t header[DELTA_HEADER_FIELDS];
+  arcID tmp[5], nfields, j;
+  nodeID* node_map = NULL;
+  nodeID i, num_added_nodes, fr_node, to_node;
+  arcID num_added_arcs, new_arc_id;
+  wordID num_added_words, wdid;
+  asr_uint16_t len;
+  char word[MAX_LINE_LENGTH];
+  FSMarc_ptr atok;
+  FSMarc* atoken;
+  int rc = FST_SUCCESS;
+
+  if (!fp)
+    return FST_FAILED_ON_INVALID_ARGS;
+
+  if (pfread(header, sizeof(header[0]), DELTA_HEADER_FIELDS, fp) != DELTA_HEADER_FIELDS)
+  {
+    PLogError("FST_LoadContextDelta: could not read header.\n");
+    return FST_FAILED_INTERNAL;
+  }
+  if (header[1] != IMAGE_FORMAT_DELTA)
+  {
+    PLogError("FST_LoadContextDelta: bad image format %d\n", header[1]);
+    return FST_FAILED_ON_INVALID_ARGS;
+  }
+  /* the delta is only meaningful on top of the very base it came from */
+  if (header[2] != fst->modelid ||
+      header[3] != fst->num_base_arcs ||
+      header[4] != fst->num_base_nodes ||
+      header[5] != fst->olabels->num_base_words)
+  {
+    PLogError("FST_LoadContextDelta: delta does not match the base grammar\n");
+    return FST_FAILED_ON_INVALID_ARGS;
+  }
+  if (fst->num_arcs != fst->num_base_arcs ||
+      fst->olabels->num_words != fst->olabels->num_base_words)
+  {
+    PLogError("FST_LoadContextDelta: grammar must be reset before loading a delta\n");
+    return FST_FAILED_ON_INVALID_ARGS;
+  }
+  num_added_words = (wordID)header[6];
+  num_added_nodes = (nodeID)header[7];
+  num_added_arcs  = (arcID)header[8];
+
+  for (wdid = 0; wdid < num_added_words; wdid++)
+  {
+    if (pfread(&len, sizeof(len), 1, fp) != 1 || len == 0 || len > MAX_LINE_LENGTH ||
+        pfread(word, sizeof(char), len, fp) != len || word[len-1] != '\0')
+    {
+      PLogError("FST_LoadContextDelta: could not read word %d\n", wdid);
+      rc = FST_FAILED_INTERNAL;
+      goto CLEANUP;
+    }
+    if (wordmap_add_word(fst->olabels, word) != fst->olabels->num_base_words + wdid)
+    {
+      rc = FST_FAILED_ON_MEMORY;
+      goto CLEANUP;
+    }
+  }
+
+  rc = fst_reserve_nodes(fst, num_added_nodes);
+  if (rc == FST_SUCCESS)
+    rc = fst_reserve_arcs(fst, num_added_arcs);
+  if (rc != FST_SUCCESS)
+    goto CLEANUP;
+
+  if (num_added_nodes > 0)
+  {
+    node_map = NEW_ARRAY(nodeID, num_added_nodes, L("srec.graph.delta.nodemap"));
+    if (!node_map)
+    {
+      rc = FST_FAILED_ON_MEMORY;
+      goto CLEANUP;
+    }
+    for (i = 0; i < num_added_nodes; i++)
+    {
+      node_map[i] = fst_get_free_node(fst);
+      if (node_map[i] == MAXnodeID)
+      {
+        rc = FST_FAILED_ON_MEMORY;
+        goto CLEANUP;
+      }
+    }
+  }
+
+  for (j = 0; j < num_added_arcs; j++)
+  {
+    nfields = 5;
+    if (pfread(tmp, sizeof(tmp[0]), nfields, fp) != nfields)
+    {
+      PLogError("FST_LoadContextDelta: could not read arc %d\n", j);
+      rc = FST_FAILED_INTERNAL;
+      goto CLEANUP;
+    }
+    fr_node = tmp[0];
+    to_node = tmp[1];
+    if (fr_node >= fst->num_base_nodes + num_added_nodes ||
+        to_node >= fst->num_base_nodes + num_added_nodes ||
+        tmp[3] >= fst->olabels->num_words)
+    {
+      PLogError("FST_LoadContextDelta: bad arc %d->%d\n", fr_node, to_node);
+      rc = FST_FAILED_INTERNAL;
+      goto CLEANUP;
+    }
+    if (fr_node >= fst->num_base_nodes)
+      fr_node = node_map[fr_node - fst->num_base_nodes];
+    if (to_node >= fst->num_base_nodes)
+      to_node = node_map[to_node - fst->num_base_nodes];
+
+    new_arc_id = fst_get_free_arc(fst);
+    if (new_arc_id == MAXarcID)
+    {
+      rc = FST_FAILED_ON_MEMORY;
+      goto CLEANUP;
+    }
+    atok = ARC_ItoX(new_arc_id);
+    atoken = ARC_XtoP(atok);
+    atoken->fr_node = NODE_ItoX(fr_node);
+    atoken->to_node = NODE_ItoX(to_node);
+    atoken->ilabel = tmp[2];
+    atoken->olabel = tmp[3];
+    atoken->cost   = tmp[4];
+    append_arc_leaving_node(fst, &fst->FSMnode_list[fr_node], atok);
+    append_arc_arriving_node(fst, &fst->FSMnode_list[to_node], atok);
+  }
+  fst->whether_prepared = 0;
+
+CLEANUP:
+  if (node_map)
+    FREE(node_map);
+  if (rc != FST_SUCCESS)
+    FST_ResetGrammar(fst);
+  return rc;
+}
+
+
 int FST_DumpReverseWordGraph(srec_context* context, PFile* fp)
 {
   /* not implemented, use FST_DumpSyntaxAsImage() for now */
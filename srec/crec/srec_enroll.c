@@ -0,0 +1,1287 @@
+/*---------------------------------------------------------------------------*
+ *  srec_enroll.c  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pstdio.h"
+#include "passert.h"
+#include "portable.h"
+
+#include "srec_sizes.h"
+#include "search_network.h"
+#include "srec_context.h"
+#include "srec.h"
+#include "srec_tokens.h"
+#include "word_lattice.h"
+#include "swimodel.h"
+
+/* Voice enrollment search.
+
+   An enrollment grammar (see FST_IsVoiceEnrollment) is a loop of phoneme
+   hmms, and all an enrollment wants is the phoneme sequence of the best
+   path.  The general search of srec.c walks the linked arc lists of the
+   grammar, takes its tokens off freelists, carries alternative words for
+   the n-best and keeps word tokens on the lattice for every frame.  For a
+   phoneme loop this is mostly overhead, so here
+
+   - the grammar is flattened once into a srec_enroll_graph, shared by
+     all the searches on it and kept across utterances,
+   - there is one token per graph arc and per graph node, in arrays,
+   - the epsilon updates are one pass over the nodes in topological order,
+   - every word end is a small record, only those on the best path become
+     word tokens on the lattice, when there are no more frames.
+
+   The viterbi recursion, the duration model, the pruning and the word
+   queue of a frame are those of the general search, so it finds the same
+   best path.  There are no alternative words, the enrollment takes the
+   viterbi path anyway (see CA_FullResultWordIDs). */
+
+#define ENROLL_MIN_WORDS 256   /* first allocation of the word records */
+
+/*--------------------------------------------------------------------------*
+ *                                                                          *
+ * the compact graph                                                        *
+ *                                                                          *
+ *--------------------------------------------------------------------------*/
+
+void srec_enroll_graph_free(srec_context* context)
+{
+  srec_enroll_graph* graph = context->enroll_graph;
+
+  if (!graph)
+    return;
+  FREE(graph->first_hmm_arc);
+  FREE(graph->hmm_arcs);
+  FREE(graph->first_eps_arc);
+  FREE(graph->eps_arcs);
+  FREE(graph->eps_order);
+  FREE(graph);
+  context->enroll_graph = NULL;
+}
+
+static int is_enroll_hmm_arc(srec_context* context, FSMarc* arc)
+{
+  return arc->ilabel >= EPSILON_OFFSET && arc->ilabel != MAXlabelID
+         && context->hmm_info_for_ilabel[arc->ilabel].num_states > 0;
+}
+
+static int is_enroll_eps_arc(FSMarc* arc)
+{
+  return arc->ilabel == EPSILON_LABEL || arc->ilabel == WORD_BOUNDARY;
+}
+
+/* the nodes are those reached from the start node, freed nodes are not on
+   the arc lists.  Returns NULL if the grammar does not fit, ie. an hmm
+   longer than MAX_HMM or a loop of epsilon arcs, the general search then
+   runs the grammar */
+
+static srec_enroll_graph* enroll_graph_build(srec_context* context)
+{
+  srec_enroll_graph* graph;
+  nodeID num_nodes = context->num_nodes;
+  nodeID node, *queue = NULL, queue_head, queue_tail, num_reached;
+  asr_int32_t *indegree = NULL;
+  char* reached = NULL;
+  arcID arc_index, num_hmm_arcs, num_eps_arcs, ihmm, ieps;
+  FSMarc* arc;
+  HMMInfo* hmm_info;
+  int i, failed = 0;
+
+  if (!context->hmm_info_for_ilabel || context->start_node >= num_nodes)
+    return NULL;
+  graph = NEW(srec_enroll_graph, "search.srec.enroll_graph");
+  if (!graph)
+    return NULL;
+  memset(graph, 0, sizeof(*graph));
+  graph->hmm_info_for_ilabel = context->hmm_info_for_ilabel;
+  graph->num_nodes = num_nodes;
+  graph->first_hmm_arc = (arcID*)CALLOC_CLR(num_nodes + 1, sizeof(arcID), "search.srec.enroll_graph.first_hmm_arc");
+  graph->first_eps_arc = (arcID*)CALLOC_CLR(num_nodes + 1, sizeof(arcID), "search.srec.enroll_graph.first_eps_arc");
+  graph->eps_order = (nodeID*)CALLOC_CLR(num_nodes, sizeof(nodeID), "search.srec.enroll_graph.eps_order");
+  queue = (nodeID*)CALLOC_CLR(num_nodes, sizeof(nodeID), "search.srec.enroll_graph.queue");
+  indegree = (asr_int32_t*)CALLOC_CLR(num_nodes, sizeof(asr_int32_t), "search.srec.enroll_graph.indegree");
+  reached = (char*)CALLOC_CLR(num_nodes, sizeof(char), "search.srec.enroll_graph.reached");
+  if (!graph->first_hmm_arc || !graph->first_eps_arc || !graph->eps_order || !queue || !indegree || !reached)
+  {
+    failed = 1;
+    goto CLEANUP;
+  }
+
+  /* breadth first from the start node, counting the arcs of each node */
+  queue_head = queue_tail = 0;
+  queue[queue_tail++] = context->start_node;
+  reached[context->start_node] = 1;
+  num_hmm_arcs = num_eps_arcs = 0;
+  while (queue_head < queue_tail && !failed)
+  {
+    node = queue[queue_head++];
+    for (arc_index = context->FSMnode_list[node].un_ptr.first_next_arc; arc_index != MAXarcID;
+         arc_index = arc->linkl_next_arc)
+    {
+      arc = &context->FSMarc_list[arc_index];
+      if (arc->to_node >= num_nodes)
+      {
+        failed = 1;
+        break;
+      }
+      if (is_enroll_hmm_arc(context, arc))
+      {
+        if (context->hmm_info_for_ilabel[arc->ilabel].num_states > MAX_HMM)
+        {
+          failed = 1;
+          break;
+        }
+        graph->first_hmm_arc[node+1]++;
+        num_hmm_arcs++;
+      }
+      else if (is_enroll_eps_arc(arc))
+      {
+        graph->first_eps_arc[node+1]++;
+        num_eps_arcs++;
+        indegree[arc->to_node]++;
+      }
+      if (!reached[arc->to_node])
+      {
+        reached[arc->to_node] = 1;
+        queue[queue_tail++] = arc->to_node;
+      }
+    }
+  }
+  if (failed)
+    goto CLEANUP;
+  num_reached = queue_tail;
+  for (node = 0; node < num_nodes; node++)
+  {
+    graph->first_hmm_arc[node+1] += graph->first_hmm_arc[node];
+    graph->first_eps_arc[node+1] += graph->first_eps_arc[node];
+  }
+
+  graph->num_hmm_arcs = num_hmm_arcs;
+  graph->hmm_arcs = (srec_enroll_hmm_arc*)CALLOC_CLR(num_hmm_arcs + 1, sizeof(srec_enroll_hmm_arc), "search.srec.enroll_graph.hmm_arcs");
+  graph->eps_arcs = (srec_enroll_eps_arc*)CALLOC_CLR(num_eps_arcs + 1, sizeof(srec_enroll_eps_arc), "search.srec.enroll_graph.eps_arcs");
+  if (!graph->hmm_arcs || !graph->eps_arcs)
+  {
+    failed = 1;
+    goto CLEANUP;
+  }
+
+  /* fill in, the arcs of a node keep the order of its arc list */
+  for (i = 0; i < num_reached; i++)
+  {
+    node = queue[i];
+    ihmm = graph->first_hmm_arc[node];
+    ieps = graph->first_eps_arc[node];
+    for (arc_index = context->FSMnode_list[node].un_ptr.first_next_arc; arc_index != MAXarcID;
+         arc_index = arc->linkl_next_arc)
+    {
+      arc = &context->FSMarc_list[arc_index];
+      if (is_enroll_hmm_arc(context, arc))
+      {
+        srec_enroll_hmm_arc* hmm_arc = &graph->hmm_arcs[ihmm++];
+        int j;
+        hmm_info = &context->hmm_info_for_ilabel[arc->ilabel];
+        hmm_arc->to_node = arc->to_node;
+        hmm_arc->olabel = arc->olabel;
+        hmm_arc->cost = arc->cost;
+        hmm_arc->num_states = hmm_info->num_states;
+        for (j = 0; j < hmm_info->num_states; j++)
+          hmm_arc->state_indices[j] = (modelID)hmm_info->state_indices[j];
+      }
+      else if (is_enroll_eps_arc(arc))
+      {
+        srec_enroll_eps_arc* eps_arc = &graph->eps_arcs[ieps++];
+        eps_arc->to_node = arc->to_node;
+        eps_arc->ilabel = arc->ilabel;
+        eps_arc->olabel = arc->olabel;
+        eps_arc->cost = arc->cost;
+      }
+    }
+  }
+
+  /* topological order of the epsilon arcs, the reached nodes nothing
+     arrives at by epsilon go first */
+  queue_head = queue_tail = 0;
+  for (i = 0; i < num_reached; i++)
+  {
+    node = queue[i];
+    if (indegree[node] == 0)
+      reached[node] = 2;
+  }
+  for (node = 0; node < num_nodes; node++)
+    if (reached[node] == 2)
+      queue[queue_tail++] = node;
+  graph->num_eps_order = 0;
+  while (queue_head < queue_tail)
+  {
+    node = queue[queue_head++];
+    if (graph->first_eps_arc[node] < graph->first_eps_arc[node+1])
+      graph->eps_order[graph->num_eps_order++] = node;
+    for (ieps = graph->first_eps_arc[node]; ieps < graph->first_eps_arc[node+1]; ieps++)
+    {
+      if (--indegree[graph->eps_arcs[ieps].to_node] == 0)
+        queue[queue_tail++] = graph->eps_arcs[ieps].to_node;
+    }
+  }
+  if (queue_tail != num_reached)
+  {
+    PLogError("warning: epsilon loop in the enrollment grammar, using the general search\n");
+    failed = 1;
+  }
+
+CLEANUP:
+  if (queue)
+    FREE(queue);
+  if (indegree)
+    FREE(indegree);
+  if (reached)
+    FREE(reached);
+  if (failed)
+  {
+    if (graph->first_hmm_arc)
+      FREE(graph->first_hmm_arc);
+    if (graph->first_eps_arc)
+      FREE(graph->first_eps_arc);
+    if (graph->eps_order)
+      FREE(graph->eps_order);
+    if (graph->hmm_arcs)
+      FREE(graph->hmm_arcs);
+    if (graph->eps_arcs)
+      FREE(graph->eps_arcs);
+    FREE(graph);
+    return NULL;
+  }
+  return graph;
+}
+
+/*--------------------------------------------------------------------------*
+ *                                                                          *
+ * tokens                                                                   *
+ *                                                                          *
+ *--------------------------------------------------------------------------*/
+
+/* node_tokens[].active, a pruned node stays on the active list until
+   the list is cleared, so it can come back without being linked twice */
+#define ENROLL_NODE_FREE   0
+#define ENROLL_NODE_ACTIVE 1
+#define ENROLL_NODE_PRUNED 2
+
+static int enroll_search_setup(srec* rec, srec_enroll_graph* graph)
+{
+  srec_enroll_search* es = rec->enroll;
+  arcID i;
+  nodeID node;
+
+  if (!es)
+  {
+    es = NEW(srec_enroll_search, "search.srec.enroll");
+    if (!es)
+      return 1;
+    memset(es, 0, sizeof(*es));
+    rec->enroll = es;
+  }
+  if (es->arc_tokens_size < graph->num_hmm_arcs || !es->arc_tokens)
+  {
+    if (es->arc_tokens)
+      FREE(es->arc_tokens);
+    es->arc_tokens_size = 0;
+    es->arc_tokens = (srec_enroll_arc_token*)CALLOC_CLR(graph->num_hmm_arcs + 1, sizeof(srec_enroll_arc_token), "search.srec.enroll.arc_tokens");
+    if (!es->arc_tokens)
+      return 1;
+    es->arc_tokens_size = graph->num_hmm_arcs;
+  }
+  if (es->node_tokens_size < graph->num_nodes || !es->node_tokens)
+  {
+    if (es->node_tokens)
+      FREE(es->node_tokens);
+    es->node_tokens_size = 0;
+    es->node_tokens = (srec_enroll_node_token*)CALLOC_CLR(graph->num_nodes, sizeof(srec_enroll_node_token), "search.srec.enroll.node_tokens");
+    if (!es->node_tokens)
+      return 1;
+    es->node_tokens_size = graph->num_nodes;
+  }
+  if (es->max_in_queue < rec->word_priority_q->max_in_q || !es->queue)
+  {
+    if (es->queue)
+      FREE(es->queue);
+    es->max_in_queue = 0;
+    es->queue = (asr_int32_t*)CALLOC_CLR(rec->word_priority_q->max_in_q + 1, sizeof(asr_int32_t), "search.srec.enroll.queue");
+    if (!es->queue)
+      return 1;
+  }
+  es->max_in_queue = rec->word_priority_q->max_in_q;
+  es->num_in_queue = 0;
+  es->queue_threshold = MAXcostdata;
+  for (i = 0; i < graph->num_hmm_arcs; i++)
+    es->arc_tokens[i].active = 0;
+  for (node = 0; node < graph->num_nodes; node++)
+    es->node_tokens[node].active = ENROLL_NODE_FREE;
+  es->active_arcs = MAXarcID;
+  es->num_active_arcs = 0;
+  es->active_nodes = MAXnodeID;
+  es->num_active_nodes = 0;
+  es->num_words = 0;
+  return 0;
+}
+
+static srec_enroll_node_token* enroll_activate_node(srec_enroll_search* es, nodeID node)
+{
+  srec_enroll_node_token* ntoken = &es->node_tokens[node];
+
+  ASSERT(ntoken->active != ENROLL_NODE_ACTIVE);
+  if (ntoken->active == ENROLL_NODE_FREE)
+  {
+    ntoken->next_active = es->active_nodes;
+    es->active_nodes = node;
+  }
+  ntoken->active = ENROLL_NODE_ACTIVE;
+  es->num_active_nodes++;
+  return ntoken;
+}
+
+static void enroll_clear_nodes(srec_enroll_search* es)
+{
+  nodeID node;
+
+  for (node = es->active_nodes; node != MAXnodeID; node = es->node_tokens[node].next_active)
+    es->node_tokens[node].active = ENROLL_NODE_FREE;
+  es->active_nodes = MAXnodeID;
+  es->num_active_nodes = 0;
+}
+
+static void enroll_prune_nodes(srec_enroll_search* es, costdata current_prune_thresh, nodeID not_this_one)
+{
+  nodeID node;
+  srec_enroll_node_token* ntoken;
+
+  for (node = es->active_nodes; node != MAXnodeID; node = ntoken->next_active)
+  {
+    ntoken = &es->node_tokens[node];
+    if (ntoken->active == ENROLL_NODE_ACTIVE && node != not_this_one && ntoken->cost >= current_prune_thresh)
+    {
+      ntoken->active = ENROLL_NODE_PRUNED;
+      es->num_active_nodes--;
+    }
+  }
+}
+
+/* the general search has max_fsmnode_tokens tokens, and tightens the beam
+   when it runs out, see reprune_fsmnode_tokens() */
+
+static costdata enroll_reprune_nodes(srec* rec, costdata current_best_cost, costdata current_prune_delta,
+                                     nodeID not_this_one)
+{
+  srec_enroll_search* es = rec->enroll;
+
+  enroll_prune_nodes(es, (costdata)(current_best_cost + current_prune_delta), not_this_one);
+  while (es->num_active_nodes >= rec->fsmnode_token_array_size && current_prune_delta > 1)
+  {
+    current_prune_delta = (costdata)(PRUNE_TIGHTEN * current_prune_delta);
+    enroll_prune_nodes(es, (costdata)(current_best_cost + current_prune_delta), not_this_one);
+  }
+  return current_prune_delta;
+}
+
+static void enroll_prune_arcs(srec_enroll_search* es, costdata current_prune_thresh)
+{
+  arcID arc_index, *parc_index;
+  srec_enroll_arc_token* token;
+  int i, any_alive;
+
+  parc_index = &es->active_arcs;
+  for (arc_index = es->active_arcs; arc_index != MAXarcID; arc_index = token->next_active)
+  {
+    token = &es->arc_tokens[arc_index];
+    any_alive = 0;
+    for (i = 0; i < es->graph->hmm_arcs[arc_index].num_states; i++)
+    {
+      if (token->cost[i] < current_prune_thresh)
+        any_alive = 1;
+    }
+    if (!any_alive)
+    {
+      *parc_index = token->next_active;
+      token->active = 0;
+      es->num_active_arcs--;
+    }
+    else
+      parc_index = &token->next_active;
+  }
+}
+
+/* the general search has max_hmm_tokens tokens, and tightens the beam
+   when it runs out, see reprune_new_states() */
+
+static costdata enroll_reprune_arcs(srec* rec, costdata current_best_cost, costdata current_prune_delta)
+{
+  srec_enroll_search* es = rec->enroll;
+
+  enroll_prune_arcs(es, (costdata)(current_best_cost + current_prune_delta));
+  while ((es->num_active_arcs >= rec->max_new_states - 1 || es->num_active_arcs >= rec->fsmarc_token_array_size)
+         && current_prune_delta > 1)
+  {
+    current_prune_delta = (costdata)(PRUNE_TIGHTEN * current_prune_delta);
+    enroll_prune_arcs(es, (costdata)(current_best_cost + current_prune_delta));
+  }
+  return current_prune_delta;
+}
+
+static costdata enroll_histogram_prune_delta(srec* rec, costdata current_best_cost, costdata current_prune_delta)
+{
+  srec_enroll_search* es = rec->enroll;
+  int i, bin, num_kept;
+  int count[HISTOGRAM_PRUNE_BINS];
+  costdata bin_width, token_cost;
+  arcID arc_index;
+  srec_enroll_arc_token* token;
+
+  bin_width = (costdata)((current_prune_delta + HISTOGRAM_PRUNE_BINS - 1) / HISTOGRAM_PRUNE_BINS);
+  if (bin_width == 0)
+    return current_prune_delta;
+  for (bin = 0; bin < HISTOGRAM_PRUNE_BINS; bin++)
+    count[bin] = 0;
+
+  for (arc_index = es->active_arcs; arc_index != MAXarcID; arc_index = token->next_active)
+  {
+    token = &es->arc_tokens[arc_index];
+    token_cost = MAXcostdata;
+    for (i = 0; i < es->graph->hmm_arcs[arc_index].num_states; i++)
+      if (token->cost[i] < token_cost)
+        token_cost = token->cost[i];
+    if (token_cost >= current_best_cost + current_prune_delta)
+      continue;
+    bin = token_cost > current_best_cost ? (token_cost - current_best_cost) / bin_width : 0;
+    count[bin]++;
+  }
+
+  num_kept = 0;
+  for (bin = 0; bin < HISTOGRAM_PRUNE_BINS; bin++)
+  {
+    num_kept += count[bin];
+    if (num_kept > rec->max_active_hmm_tokens)
+    {
+      if (bin == 0)
+        bin = 1;
+      if ((costdata)(bin * bin_width) < current_prune_delta)
+        current_prune_delta = (costdata)(bin * bin_width);
+      break;
+    }
+  }
+  return current_prune_delta;
+}
+
+/* the word queue of a frame, as the word_priority_q of the general search
+   (see add_word_token_to_priority_q()), keeps the num_wordends_per_frame
+   best words, worst first, and a word ending at the same node on the same
+   history as one in there only takes its place if it is better */
+
+static int enroll_same_history(srec_enroll_search* es, srec_enroll_word* w1, srec_enroll_word* w2)
+{
+  if (w1->word != w2->word || w1->end_node != w2->end_node)
+    return 0;
+  if (w1->backtrace < 0 || w2->backtrace < 0)
+    return w1->backtrace < 0 && w2->backtrace < 0;
+  return es->words[w1->backtrace].word == es->words[w2->backtrace].word
+         && es->words[w1->backtrace].end_time == es->words[w2->backtrace].end_time;
+}
+
+/* the nodes whose path ends in a word the queue dropped are not searched
+   further, see block_fsmnodes_per_backtrace() */
+
+static int enroll_block_nodes(srec_enroll_search* es, asr_int32_t word_index)
+{
+  srec_enroll_node_token* ntoken;
+  nodeID node;
+  int num_blocked = 0;
+
+  for (node = es->active_nodes; node != MAXnodeID; node = ntoken->next_active)
+  {
+    ntoken = &es->node_tokens[node];
+    if (ntoken->active == ENROLL_NODE_ACTIVE && ntoken->word_backtrace == word_index)
+    {
+      ntoken->cost = MAXcostdata;
+      num_blocked++;
+    }
+  }
+  return num_blocked;
+}
+
+/* a word ends at node, on the path with word_backtrace, returns the index
+   of its record or -1 if it did not make it onto the queue.  As in
+   srec_process_word_boundary_nbest(), a path cannot end two words in the
+   same frame */
+
+static asr_int32_t enroll_queue_word(srec* rec, nodeID node, wordID word, asr_int32_t word_backtrace,
+                                     costdata cost, frameID silence_duration, int* num_blocked)
+{
+  srec_enroll_search* es = rec->enroll;
+  srec_enroll_word* words;
+  srec_enroll_word* wrecord;
+  asr_int32_t word_index, max_words;
+  int i, place, duplicate;
+
+  if (word_backtrace >= 0 && es->words[word_backtrace].end_time >= rec->current_search_frame)
+    return -1;
+  if (es->num_in_queue >= es->max_in_queue && cost >= es->queue_threshold)
+    return -1;
+
+  if (es->num_words == es->max_words)
+  {
+    max_words = es->max_words ? 2 * es->max_words : ENROLL_MIN_WORDS;
+    words = (srec_enroll_word*)REALLOC(es->words, max_words * sizeof(srec_enroll_word));
+    if (!words)
+    {
+      PLogError("srec_enroll: no memory for %d word ends\n", max_words);
+      return -1;
+    }
+    es->words = words;
+    es->max_words = max_words;
+  }
+  word_index = es->num_words;
+  wrecord = &es->words[word_index];
+  wrecord->word = word;
+  wrecord->end_time = rec->current_search_frame;
+  wrecord->word_end_time = (frameID)(rec->current_search_frame - silence_duration);
+  wrecord->end_node = node;
+  wrecord->cost = cost;
+  wrecord->backtrace = word_backtrace;
+  wrecord->kept = 1;
+
+  place = -1;
+  duplicate = -1;
+  for (i = 0; i < es->num_in_queue; i++)
+  {
+    srec_enroll_word* qrecord = &es->words[es->queue[i]];
+    if (enroll_same_history(es, qrecord, wrecord))
+    {
+      if (qrecord->cost < cost)
+        return -1;
+      duplicate = i;
+    }
+    if (qrecord->cost < cost && place < 0)
+      place = i;
+  }
+  if (place < 0)
+    place = es->num_in_queue;
+  es->num_words++;
+
+  memmove(&es->queue[place+1], &es->queue[place], (es->num_in_queue - place) * sizeof(es->queue[0]));
+  es->queue[place] = word_index;
+  es->num_in_queue++;
+  if (duplicate >= place)
+    duplicate++;
+
+  if (duplicate >= 0)
+  {
+    /* the path through the worse one carries on, as in the general search */
+    es->words[es->queue[duplicate]].kept = 0;
+    memmove(&es->queue[duplicate], &es->queue[duplicate+1], (es->num_in_queue - duplicate - 1) * sizeof(es->queue[0]));
+    es->num_in_queue--;
+  }
+  else if (es->num_in_queue > es->max_in_queue)
+  {
+    es->words[es->queue[0]].kept = 0;
+    *num_blocked += enroll_block_nodes(es, es->queue[0]);
+    memmove(&es->queue[0], &es->queue[1], (es->num_in_queue - 1) * sizeof(es->queue[0]));
+    es->num_in_queue--;
+  }
+  if (es->num_in_queue >= es->max_in_queue)
+    es->queue_threshold = es->words[es->queue[0]].cost;
+  else
+    es->queue_threshold = MAXcostdata;
+  return word_index;
+}
+
+/*--------------------------------------------------------------------------*
+ *                                                                          *
+ * updates, each mirrors its counterpart in srec.c                          *
+ *                                                                          *
+ *--------------------------------------------------------------------------*/
+
+/* see do_epsilon_updates(), a node only reaches nodes after it in
+   eps_order, so one pass finds the best paths into all of them */
+
+static void enroll_epsilon_updates(srec* rec, costdata prune_delta, costdata best_cost)
+{
+  srec_enroll_search* es = rec->enroll;
+  srec_enroll_graph* graph = es->graph;
+  srec_enroll_node_token *ntoken, *new_ntoken;
+  srec_enroll_eps_arc* arc;
+  costdata current_prune_delta = prune_delta;
+  costdata current_prune_thresh = (costdata)(best_cost + prune_delta);
+  costdata current_word_threshold = MAXcostdata;
+  costdata cost_with_wtw;
+  wordID word_with_wtw;
+  asr_int32_t word_index;
+  nodeID i, node;
+  arcID arc_index;
+  int num_blocked;
+
+  es->num_in_queue = 0;
+  es->queue_threshold = MAXcostdata;
+
+  for (i = 0; i < graph->num_eps_order; i++)
+  {
+    node = graph->eps_order[i];
+    ntoken = &es->node_tokens[node];
+    if (ntoken->active != ENROLL_NODE_ACTIVE)
+      continue;
+    if (ntoken->cost >= current_prune_thresh)
+    {
+      ntoken->active = ENROLL_NODE_PRUNED;
+      es->num_active_nodes--;
+      continue;
+    }
+    num_blocked = 0;
+    for (arc_index = graph->first_eps_arc[node]; arc_index < graph->first_eps_arc[node+1]; arc_index++)
+    {
+      arc = &graph->eps_arcs[arc_index];
+      if (ntoken->cost >= current_prune_thresh || arc->cost >= current_prune_thresh)
+        continue;
+      cost_with_wtw = (costdata)(ntoken->cost + arc->cost);
+      word_with_wtw = ntoken->word;
+      if (arc->olabel != WORD_EPSILON_LABEL)
+        word_with_wtw = arc->olabel;
+      if (arc->ilabel == WORD_BOUNDARY && cost_with_wtw >= current_word_threshold)
+        continue;
+
+      new_ntoken = &es->node_tokens[arc->to_node];
+      if (new_ntoken->active != ENROLL_NODE_ACTIVE && es->num_active_nodes >= rec->fsmnode_token_array_size)
+      {
+        current_prune_delta = enroll_reprune_nodes(rec, best_cost, current_prune_delta, node);
+        current_prune_thresh = (costdata)(best_cost + current_prune_delta);
+      }
+
+      if (arc->ilabel == WORD_BOUNDARY)
+      {
+        word_index = enroll_queue_word(rec, node, word_with_wtw, ntoken->word_backtrace,
+                                       cost_with_wtw, ntoken->silence_duration, &num_blocked);
+        if (word_index < 0)
+          continue;
+        current_word_threshold = es->queue_threshold;
+        if (new_ntoken->active == ENROLL_NODE_ACTIVE && cost_with_wtw >= new_ntoken->cost)
+          continue;
+        if (new_ntoken->active != ENROLL_NODE_ACTIVE)
+          enroll_activate_node(es, arc->to_node);
+        new_ntoken->cost = cost_with_wtw;
+        new_ntoken->word_backtrace = word_index;
+        new_ntoken->word = WORD_EPSILON_LABEL;
+        new_ntoken->silence_duration = 0;
+      }
+      else
+      {
+        if (new_ntoken->active == ENROLL_NODE_ACTIVE && cost_with_wtw >= new_ntoken->cost)
+          continue;
+        if (new_ntoken->active != ENROLL_NODE_ACTIVE)
+          enroll_activate_node(es, arc->to_node);
+        new_ntoken->cost = cost_with_wtw;
+        new_ntoken->word_backtrace = ntoken->word_backtrace;
+        new_ntoken->word = word_with_wtw;
+        new_ntoken->silence_duration = ntoken->silence_duration;
+      }
+    }
+    if (num_blocked)
+      enroll_prune_nodes(es, MAXcostdata / 2, node);
+  }
+}
+
+/* see update_internal_hmm_states() */
+
+static void enroll_update_internal_hmm_states(srec* rec, costdata* pcurrent_prune_delta,
+                                              costdata* pcurrent_best_cost,
+                                              const costdata* precomputed_model_scores)
+{
+  srec_enroll_search* es = rec->enroll;
+  srec_enroll_arc_token* token;
+  srec_enroll_hmm_arc* arc;
+  costdata current_best_cost = *pcurrent_best_cost;
+  costdata current_prune_delta = *pcurrent_prune_delta;
+  costdata current_prune_thresh = (costdata)(current_best_cost + current_prune_delta);
+  costdata model_cost, prev_cost, self_loop_cost;
+  modelID model_index;
+  arcID arc_index;
+  int internal_state;
+
+  for (arc_index = es->active_arcs; arc_index != MAXarcID; arc_index = token->next_active)
+  {
+    token = &es->arc_tokens[arc_index];
+    arc = &es->graph->hmm_arcs[arc_index];
+    for (internal_state = arc->num_states - 1; internal_state >= 0; internal_state--)
+    {
+      model_index = arc->state_indices[internal_state];
+      model_cost = precomputed_model_scores[model_index];
+
+      if (internal_state > 0)
+      {
+        prev_cost = token->cost[internal_state-1];
+        if (prev_cost < current_prune_thresh)
+        {
+          prev_cost = (costdata)(prev_cost + model_cost);
+          prev_cost = (costdata)(prev_cost + (costdata) duration_penalty_depart(rec->avg_state_durations[arc->state_indices[internal_state-1]],
+                                 token->duration[internal_state-1]));
+        }
+      }
+      else
+      {
+        prev_cost = MAXcostdata;
+      }
+
+      self_loop_cost = token->cost[internal_state];
+      if (self_loop_cost < current_prune_thresh)
+      {
+        self_loop_cost = (costdata)(self_loop_cost + model_cost);
+        self_loop_cost = (costdata)(self_loop_cost + (costdata) duration_penalty_loop(rec->avg_state_durations[model_index],
+                                    token->duration[internal_state]));
+      }
+
+      if (prev_cost < self_loop_cost)
+      {
+        token->cost[internal_state] = prev_cost;
+        token->word_backtrace[internal_state] = token->word_backtrace[internal_state-1];
+        token->word[internal_state] = token->word[internal_state-1];
+        token->duration[internal_state] = 1;
+      }
+      else
+      {
+        token->cost[internal_state] = self_loop_cost;
+        token->duration[internal_state]++;
+      }
+
+      if (token->cost[internal_state] < current_prune_thresh
+          && token->cost[internal_state] < current_best_cost)
+      {
+        current_best_cost = token->cost[internal_state];
+        current_prune_thresh = (costdata)(current_best_cost + current_prune_delta);
+      }
+    }
+  }
+  *pcurrent_best_cost = current_best_cost;
+  *pcurrent_prune_delta = current_prune_delta;
+}
+
+/* see update_from_current_fsm_nodes_into_new_HMMs(), the nodes are all
+   done with afterwards */
+
+static void enroll_update_from_nodes_into_hmms(srec* rec, costdata* pcurrent_prune_delta,
+                                               costdata* pcurrent_best_cost,
+                                               const costdata* precomputed_model_scores)
+{
+  srec_enroll_search* es = rec->enroll;
+  srec_enroll_graph* graph = es->graph;
+  srec_enroll_node_token* ntoken;
+  srec_enroll_arc_token* token;
+  srec_enroll_hmm_arc* arc;
+  costdata current_best_cost = *pcurrent_best_cost;
+  costdata current_prune_delta = *pcurrent_prune_delta;
+  costdata orig_prune_delta = current_prune_delta;
+  costdata current_prune_thresh = (costdata)(current_best_cost + current_prune_delta);
+  costdata prev_cost, cost;
+  modelID model_index;
+  arcID arc_index;
+  nodeID node;
+  int i;
+
+  for (node = es->active_nodes; node != MAXnodeID; node = ntoken->next_active)
+  {
+    ntoken = &es->node_tokens[node];
+    if (ntoken->active != ENROLL_NODE_ACTIVE)
+      continue;
+    prev_cost = ntoken->cost;
+    if (node == rec->context->end_node)
+      prev_cost = MAXcostdata;
+    if (prev_cost >= current_prune_thresh)
+      continue;
+
+    for (arc_index = graph->first_hmm_arc[node]; arc_index < graph->first_hmm_arc[node+1]; arc_index++)
+    {
+      arc = &graph->hmm_arcs[arc_index];
+      model_index = arc->state_indices[0];
+      if (precomputed_model_scores[model_index] == DO_NOT_COMPUTE_MODEL)
+        continue;
+      cost = (costdata)(prev_cost + precomputed_model_scores[model_index]);
+      cost = (costdata)(cost + arc->cost);
+      if (cost >= current_prune_thresh)
+        continue;
+
+      token = &es->arc_tokens[arc_index];
+      if (!token->active)
+      {
+        if (es->num_active_arcs >= rec->fsmarc_token_array_size)
+        {
+          current_prune_delta = enroll_reprune_arcs(rec, current_best_cost, current_prune_delta);
+          if (es->num_active_arcs >= rec->fsmarc_token_array_size)
+            continue;
+        }
+        for (i = 0; i < arc->num_states; i++)
+        {
+          token->cost[i] = MAXcostdata;
+          token->word[i] = MAXwordID;
+          token->word_backtrace[i] = -1;
+          token->duration[i] = MAXframeID;
+        }
+        token->active = 1;
+        token->next_active = es->active_arcs;
+        es->active_arcs = arc_index;
+        es->num_active_arcs++;
+      }
+
+      if (cost < token->cost[0])
+      {
+        token->cost[0] = cost;
+        token->duration[0] = 1;
+        token->word_backtrace[0] = ntoken->word_backtrace;
+        token->word[0] = arc->olabel != WORD_EPSILON_LABEL ? arc->olabel : ntoken->word;
+        if (cost < current_best_cost)
+        {
+          current_best_cost = cost;
+          current_prune_delta = orig_prune_delta;
+          current_prune_thresh = (costdata)(cost + current_prune_delta);
+        }
+      }
+    }
+  }
+  enroll_clear_nodes(es);
+
+  *pcurrent_best_cost = current_best_cost;
+  *pcurrent_prune_delta = current_prune_delta;
+}
+
+/* see update_from_hmms_to_fsmnodes() */
+
+static int enroll_update_from_hmms_to_nodes(srec* rec, costdata prune_delta, costdata best_cost)
+{
+  srec_enroll_search* es = rec->enroll;
+  srec_enroll_graph* graph = es->graph;
+  srec_enroll_arc_token* token;
+  srec_enroll_hmm_arc* arc;
+  srec_enroll_node_token* ntoken;
+  costdata current_prune_delta = prune_delta;
+  costdata current_prune_thresh = (costdata)(best_cost + prune_delta);
+  costdata end_cost;
+  costdata best_node_cost[NODE_INFO_NUMS];
+  modelID end_model_index;
+  arcID arc_index;
+  FSMnode_info node_info;
+  int end_state, i, end_cost_equality_hack;
+  int num_node_updates = 0;
+
+  for (i = 0; i < NODE_INFO_NUMS; i++)
+  {
+    best_node_cost[i] = MAXcostdata / 2;
+    es->best_node[i] = MAXnodeID;
+  }
+
+  for (arc_index = es->active_arcs; arc_index != MAXarcID; arc_index = token->next_active)
+  {
+    token = &es->arc_tokens[arc_index];
+    arc = &graph->hmm_arcs[arc_index];
+    end_state = arc->num_states - 1;
+    end_cost = token->cost[end_state];
+    if (end_cost >= current_prune_thresh)
+      continue;
+
+    num_node_updates++;
+    end_model_index = arc->state_indices[end_state];
+    end_cost = (costdata)(end_cost + (costdata) duration_penalty_depart(rec->avg_state_durations[end_model_index],
+                          token->duration[end_state]));
+    ntoken = &es->node_tokens[arc->to_node];
+    if (ntoken->active != ENROLL_NODE_ACTIVE)
+    {
+      if (es->num_active_nodes >= rec->fsmnode_token_array_size)
+      {
+        current_prune_delta = enroll_reprune_nodes(rec, best_cost, current_prune_delta, MAXnodeID);
+        current_prune_thresh = (costdata)(best_cost + current_prune_delta);
+        if (es->num_active_nodes >= rec->fsmnode_token_array_size)
+          continue;
+      }
+      enroll_activate_node(es, arc->to_node);
+    }
+    else
+    {
+      /* prefers the shorter of the backtrace words when scores are equal */
+      end_cost_equality_hack = 0;
+      if (end_cost == ntoken->cost && token->word_backtrace[end_state] != ntoken->word_backtrace
+          && token->word_backtrace[end_state] >= 0)
+      {
+        frameID ct_end_time = es->words[token->word_backtrace[end_state]].end_time, et_end_time = 0;
+        if (ntoken->word_backtrace >= 0)
+          et_end_time = es->words[ntoken->word_backtrace].end_time;
+        if (ct_end_time < et_end_time)
+          end_cost_equality_hack = 1;
+      }
+      if (end_cost >= ntoken->cost && !end_cost_equality_hack)
+        end_cost = MAXcostdata;
+    }
+    if (end_cost != MAXcostdata)
+    {
+      ntoken->cost = end_cost;
+      ntoken->word_backtrace = token->word_backtrace[end_state];
+      ntoken->word = token->word[end_state];
+      if (end_model_index == SILENCE_MODEL_INDEX && ntoken->word != rec->context->beg_silence_word)
+        ntoken->silence_duration = token->duration[end_state];
+      else
+        ntoken->silence_duration = 0;
+    }
+
+    node_info = rec->context->FSMnode_info_list[arc->to_node];
+    ASSERT(node_info < NODE_INFO_NUMS);
+    if (ntoken->cost < best_node_cost[(int)node_info])
+    {
+      best_node_cost[(int)node_info] = ntoken->cost;
+      es->best_node[(int)node_info] = arc->to_node;
+    }
+    if (ntoken->cost < best_node_cost[NODE_INFO_UNKNOWN])
+    {
+      best_node_cost[NODE_INFO_UNKNOWN] = ntoken->cost;
+      es->best_node[NODE_INFO_UNKNOWN] = arc->to_node;
+    }
+  }
+  return num_node_updates;
+}
+
+/*--------------------------------------------------------------------------*
+ *                                                                          *
+ * the search, called from srec.c                                           *
+ *                                                                          *
+ *--------------------------------------------------------------------------*/
+
+/* sets up the first frame as srec_begin() does, returns nonzero if the
+   grammar cannot be searched here */
+
+int srec_enroll_begin(srec* rec)
+{
+  srec_context* context = rec->context;
+  srec_enroll_search* es;
+  srec_enroll_node_token* ntoken;
+
+  if (context->enroll_graph
+      && ((srec_enroll_graph*)context->enroll_graph)->hmm_info_for_ilabel != context->hmm_info_for_ilabel)
+    srec_enroll_graph_free(context);
+  if (!context->enroll_graph)
+    context->enroll_graph = enroll_graph_build(context);
+  if (!context->enroll_graph || enroll_search_setup(rec, context->enroll_graph))
+    return 1;
+  es = rec->enroll;
+  es->graph = context->enroll_graph;
+
+  ntoken = enroll_activate_node(es, context->start_node);
+  ntoken->cost = 0;
+  ntoken->word = MAXwordID;
+  ntoken->word_backtrace = -1;
+  ntoken->silence_duration = 0;
+  enroll_epsilon_updates(rec, rec->prune_delta, 0);
+  return 0;
+}
+
+/* see find_which_models_to_compute(), there is no phone look-ahead, the
+   phoneme loop would enter every phoneme anyway */
+
+void srec_enroll_find_models(srec* rec, const SWIModel* acoustic_models)
+{
+  srec_enroll_search* es = rec->enroll;
+  srec_enroll_graph* graph = es->graph;
+  costdata* current_model_scores = rec->current_model_scores;
+  modelID* needed_model_list = rec->needed_model_list;
+  srec_enroll_arc_token* token;
+  srec_enroll_hmm_arc* arc;
+  modelID model_index;
+  arcID arc_index;
+  nodeID node;
+  int i, num_needed_models;
+
+  rec->avg_state_durations = acoustic_models->avg_state_durations;
+
+  for (i = 0; i < rec->num_needed_models; i++)
+    current_model_scores[needed_model_list[i]] = DO_NOT_COMPUTE_MODEL;
+  current_model_scores[SILENCE_MODEL_INDEX] = DO_NOT_COMPUTE_MODEL;
+  num_needed_models = 0;
+
+  for (arc_index = es->active_arcs; arc_index != MAXarcID; arc_index = token->next_active)
+  {
+    token = &es->arc_tokens[arc_index];
+    arc = &graph->hmm_arcs[arc_index];
+    for (i = 0; i < arc->num_states; i++)
+    {
+      if (token->cost[i] != MAXcostdata || (i > 0 && token->cost[i-1] != MAXcostdata))
+      {
+        model_index = arc->state_indices[i];
+        if (current_model_scores[model_index] == DO_NOT_COMPUTE_MODEL)
+        {
+          current_model_scores[model_index] = DO_COMPUTE_MODEL;
+          needed_model_list[num_needed_models++] = model_index;
+        }
+      }
+    }
+  }
+
+  for (node = es->active_nodes; node != MAXnodeID; node = es->node_tokens[node].next_active)
+  {
+    if (es->node_tokens[node].active != ENROLL_NODE_ACTIVE)
+      continue;
+    for (arc_index = graph->first_hmm_arc[node]; arc_index < graph->first_hmm_arc[node+1]; arc_index++)
+    {
+      model_index = graph->hmm_arcs[arc_index].state_indices[0];
+      if (current_model_scores[model_index] == DO_NOT_COMPUTE_MODEL)
+      {
+        current_model_scores[model_index] = DO_COMPUTE_MODEL;
+        needed_model_list[num_needed_models++] = model_index;
+      }
+    }
+  }
+  rec->num_needed_models = num_needed_models;
+}
+
+/* the rest of srec_viterbi_part1(), once the states are scored */
+
+void srec_enroll_viterbi_part1(srec* rec, costdata* current_model_scores)
+{
+  srec_enroll_search* es = rec->enroll;
+  costdata current_best_cost = (costdata)(MAXcostdata - ((costdata)2) * rec->prune_delta);
+  costdata current_prune_delta = rec->current_prune_delta;
+
+  enroll_update_internal_hmm_states(rec, &current_prune_delta, &current_best_cost, current_model_scores);
+  enroll_update_from_nodes_into_hmms(rec, &current_prune_delta, &current_best_cost, current_model_scores);
+  if (rec->max_active_hmm_tokens > 0 && es->num_active_arcs > rec->max_active_hmm_tokens)
+    current_prune_delta = enroll_histogram_prune_delta(rec, current_best_cost, current_prune_delta);
+  enroll_prune_arcs(es, (costdata)(current_best_cost + current_prune_delta));
+
+  rec->current_prune_delta = current_prune_delta;
+  rec->current_best_cost = current_best_cost;
+}
+
+void srec_enroll_reset_best_cost_to_zero(srec* rec, costdata current_best_cost)
+{
+  srec_enroll_search* es = rec->enroll;
+  srec_enroll_arc_token* token;
+  arcID arc_index;
+  int i;
+
+  for (arc_index = es->active_arcs; arc_index != MAXarcID; arc_index = token->next_active)
+  {
+    token = &es->arc_tokens[arc_index];
+    for (i = 0; i < es->graph->hmm_arcs[arc_index].num_states; i++)
+    {
+      if (token->cost[i] < MAXcostdata)
+      {
+        ASSERT(token->cost[i] >= current_best_cost);
+        token->cost[i] = (costdata)(token->cost[i] - current_best_cost);
+      }
+    }
+  }
+}
+
+/* see srec_viterbi_part2(), the words go on the lattice at the end */
+
+void srec_enroll_viterbi_part2(srec* rec)
+{
+  costdata current_prune_delta = rec->current_prune_delta;
+  costdata current_best_cost = rec->current_best_cost;
+
+  if (enroll_update_from_hmms_to_nodes(rec, current_prune_delta, current_best_cost) == 0)
+    enroll_update_from_hmms_to_nodes(rec, (costdata)(2 * current_prune_delta), current_best_cost);
+  enroll_epsilon_updates(rec, current_prune_delta, current_best_cost);
+  rec->current_search_frame++;
+}
+
+/* puts the words of a path on the lattice, each at the frame after its
+   end as do_epsilon_updates() would have, returns its last word token.
+   The last frame is left to the final word, as srec_no_more_frames()
+   clobbers it in the general search */
+
+static wtokenID enroll_lattice_add_path(srec* rec, asr_int32_t word_index)
+{
+  srec_enroll_search* es = rec->enroll;
+  srec_word_lattice* wl = rec->word_lattice;
+  srec_enroll_word* wrecord;
+  word_token* wtoken;
+  wtokenID wtoken_index, last_wtoken_index = MAXwtokenID;
+  wtokenID* pbacktrace = &last_wtoken_index;
+  frameID slot;
+
+  for (; word_index >= 0; word_index = wrecord->backtrace)
+  {
+    wrecord = &es->words[word_index];
+    wtoken_index = get_free_word_token(rec, NULL_IF_NO_TOKENS);
+    if (wtoken_index == MAXwtokenID)
+    {
+      PLogError("srec_enroll: out of word tokens\n");
+      break;
+    }
+    wtoken = &rec->word_token_array[wtoken_index];
+    wtoken->word = wrecord->word;
+    wtoken->end_time = wrecord->end_time;
+    wtoken->end_node = wrecord->end_node;
+    wtoken->cost = wrecord->cost;
+    wtoken->backtrace = MAXwtokenID;
+    wtoken->_word_end_time = 0;
+    WORD_TOKEN_SET_WD_ETIME(wtoken, wrecord->word_end_time);
+    wtoken->next_token_index = MAXwtokenID;
+    slot = (frameID)(wrecord->end_time + 1);
+    if (slot < rec->current_search_frame)
+    {
+      wtoken->next_token_index = wl->words_for_frame[slot];
+      lattice_add_word_tokens(wl, slot, wtoken_index);
+    }
+    *pbacktrace = wtoken_index;
+    pbacktrace = &wtoken->backtrace;
+  }
+  return last_wtoken_index;
+}
+
+/* the latest word on the lattice that ended after frame 20 and before the
+   last frame, the best one if several ended then, see srec_force_the_end() */
+
+static asr_int32_t enroll_forced_end_word(srec* rec)
+{
+  srec_enroll_search* es = rec->enroll;
+  srec_enroll_word* wrecord;
+  asr_int32_t i, best = -1;
+  frameID slot;
+
+  for (i = 0; i < es->num_words; i++)
+  {
+    wrecord = &es->words[i];
+    slot = (frameID)(wrecord->end_time + 1);
+    if (!wrecord->kept || slot <= 20 || slot >= rec->current_search_frame)
+      continue;
+    if (best < 0 || wrecord->end_time > es->words[best].end_time
+        || (wrecord->end_time == es->words[best].end_time && wrecord->cost < es->words[best].cost))
+      best = i;
+  }
+  return best;
+}
+
+/* the rest of srec_no_more_frames(), the best path at the end node goes
+   on the lattice, or if none got there, the best path from the latest
+   word end, relabeled as the end as srec_force_the_end() does */
+
+void srec_enroll_no_more_frames(srec* rec)
+{
+  srec_enroll_search* es = rec->enroll;
+  srec_context* context = rec->context;
+  srec_enroll_node_token* ntoken = &es->node_tokens[context->end_node];
+  frameID end_frame = rec->current_search_frame;
+  wtokenID wtoken_index = MAXwtokenID, backtrace;
+  word_token* wtoken = NULL;
+  asr_int32_t word_index;
+
+  if (ntoken->active == ENROLL_NODE_ACTIVE)
+  {
+    backtrace = enroll_lattice_add_path(rec, ntoken->word_backtrace);
+    wtoken_index = get_free_word_token(rec, NULL_IF_NO_TOKENS);
+    if (wtoken_index != MAXwtokenID)
+    {
+      wtoken = &rec->word_token_array[wtoken_index];
+      wtoken->word = ntoken->word;
+      wtoken->end_time = end_frame;
+      wtoken->cost = ntoken->cost;
+      wtoken->backtrace = backtrace;
+      wtoken->_word_end_time = 0;
+      WORD_TOKEN_SET_WD_ETIME(wtoken, end_frame - ntoken->silence_duration);
+    }
+  }
+  else if ((word_index = enroll_forced_end_word(rec)) >= 0)
+  {
+    srec_enroll_word* wrecord = &es->words[word_index];
+    backtrace = enroll_lattice_add_path(rec, wrecord->backtrace);
+    wtoken_index = get_free_word_token(rec, NULL_IF_NO_TOKENS);
+    if (wtoken_index != MAXwtokenID)
+    {
+      wtoken = &rec->word_token_array[wtoken_index];
+      wtoken->word = context->end_silence_word;
+      wtoken->end_time = (frameID)(wrecord->end_time + 1);
+      wtoken->cost = wrecord->cost;
+      wtoken->backtrace = backtrace;
+      wtoken->_word_end_time = 0;
+      WORD_TOKEN_SET_WD_ETIME(wtoken, wrecord->word_end_time);
+    }
+  }
+  if (wtoken)
+  {
+    wtoken->end_node = context->end_node;
+    wtoken->next_token_index = MAXwtokenID;
+  }
+  lattice_add_word_tokens(rec->word_lattice, end_frame, wtoken_index);
+
+  rec->current_best_cost = lattice_best_cost_to_frame(rec->word_lattice,
+                           rec->word_token_array, end_frame);
+}
+
+void srec_enroll_terminate(srec* rec)
+{
+  srec_enroll_search* es = rec->enroll;
+  arcID arc_index;
+
+  for (arc_index = es->active_arcs; arc_index != MAXarcID; arc_index = es->arc_tokens[arc_index].next_active)
+    es->arc_tokens[arc_index].active = 0;
+  es->active_arcs = MAXarcID;
+  es->num_active_arcs = 0;
+  enroll_clear_nodes(es);
+  es->num_words = 0;
+}
+
+void srec_enroll_get_eos_state(srec* rec, srec_eos_search_state* state)
+{
+  srec_enroll_search* es = rec->enroll;
+  srec_enroll_node_token* ntoken;
+
+  ntoken = &es->node_tokens[rec->context->end_node];
+  state->end_valid = (asr_int16_t)(ntoken->active == ENROLL_NODE_ACTIVE);
+  state->end_has_word = 0;
+  if (state->end_valid)
+  {
+    state->end_cost = ntoken->cost;
+    if (ntoken->word_backtrace >= 0)
+    {
+      state->end_has_word = 1;
+      state->end_word_end_time = es->words[ntoken->word_backtrace].end_time;
+    }
+  }
+
+  state->optend_valid = (asr_int16_t)(es->best_node[NODE_INFO_OPTENDN] != MAXnodeID);
+  if (state->optend_valid)
+    state->optend_cost = es->node_tokens[es->best_node[NODE_INFO_OPTENDN]].cost;
+
+  state->regular_valid = (asr_int16_t)(es->best_node[NODE_INFO_REGULAR] != MAXnodeID);
+  if (state->regular_valid)
+  {
+    ntoken = &es->node_tokens[es->best_node[NODE_INFO_REGULAR]];
+    state->regular_cost = ntoken->cost;
+    state->regular_node = es->best_node[NODE_INFO_REGULAR];
+    state->regular_word = ntoken->word;
+  }
+}
+
+void srec_enroll_free(srec* rec)
+{
+  srec_enroll_search* es = rec->enroll;
+
+  if (!es)
+    return;
+  if (es->arc_tokens)
+    FREE(es->arc_tokens);
+  if (es->node_tokens)
+    FREE(es->node_tokens);
+  if (es->words)
+    FREE(es->words);
+  if (es->queue)
+    FREE(es->queue);
+  FREE(es);
+  rec->enroll = NULL;
+}
@@ -73,42 +73,66 @@ EOSrc srec_check_end_of_speech_end(srec* rec)
   return rc;
 }
 
+/* gathers the paths the decision below looks at from the tokens of the
+   general search, srec_enroll_get_eos_state() does the same for the
+   enrollment search */
+
+static void get_eos_search_state(srec* rec, srec_eos_search_state* state)
+{
+  fsmnode_token *eftoken, *oeftoken, *xftoken;
+  ftokenID eftoken_index, oeftoken_index, xftoken_index;
+
+  eftoken_index = BEST_TOKEN_FOR_NODE(rec, rec->context->end_node);
+  state->end_valid = (asr_int16_t)(eftoken_index != MAXftokenID);
+  state->end_has_word = 0;
+  if (state->end_valid)
+  {
+    eftoken = &rec->fsmnode_token_array[ eftoken_index];
+    state->end_cost = eftoken->cost;
+    if (eftoken->word_backtrace != MAXwtokenID)
+    {
+      state->end_has_word = 1;
+      state->end_word_end_time = rec->word_token_array[eftoken->word_backtrace].end_time;
+    }
+  }
+
+  oeftoken_index = rec->current_best_ftoken_index[NODE_INFO_OPTENDN];
+  state->optend_valid = (asr_int16_t)(oeftoken_index != MAXftokenID);
+  if (state->optend_valid)
+  {
+    oeftoken = &rec->fsmnode_token_array[ oeftoken_index];
+    state->optend_cost = oeftoken->cost;
+  }
+
+  xftoken_index  = rec->current_best_ftoken_index[NODE_INFO_REGULAR];
+  state->regular_valid = (asr_int16_t)(xftoken_index != MAXftokenID);
+  if (state->regular_valid)
+  {
+    xftoken = &rec->fsmnode_token_array[ xftoken_index];
+    state->regular_cost = xftoken->cost;
+    state->regular_node = xftoken->FSMnode_index;
+    state->regular_word = xftoken->word;
+  }
+}
+
 EOSrc srec_check_end_of_speech(srec_eos_detector_parms* eosd_parms, srec* rec)
 {
-  nodeID end_node;
   EOSrc rc = VALID_SPEECH_CONTINUING;
   bigcostdata eos_cost_margin;
   bigcostdata opteos_cost_margin;
-  word_token* last_wtoken;
   int nframes_since_eos;
+  srec_eos_search_state state;
   
-  fsmnode_token *ftoken, *eftoken, *oeftoken, *xftoken;
-  ftokenID ftoken_index, eftoken_index, oeftoken_index, xftoken_index;
   costdata wrapup_cost = rec->context->wrapup_cost;
   srec_eos_detector_state* eosd_state = &rec->eosd_state;
   
   if (rec->current_search_frame == 1)
     srec_eosd_state_reset(eosd_state);
     
-  end_node = rec->context->end_node;
-  eftoken_index = rec->best_token_for_node[ end_node];
-  if (eftoken_index != MAXftokenID)
-    eftoken = &rec->fsmnode_token_array[ eftoken_index];
+  if (SREC_ENROLL_ACTIVE(rec))
+    srec_enroll_get_eos_state(rec, &state);
   else
-    eftoken = NULL;
-    
-  xftoken_index  = rec->current_best_ftoken_index[NODE_INFO_REGULAR];
-  if (xftoken_index != MAXftokenID)
-    xftoken = &rec->fsmnode_token_array[ xftoken_index];
-  else
-    xftoken = NULL;
-    
-  oeftoken_index = rec->current_best_ftoken_index[NODE_INFO_OPTENDN];
-  if (oeftoken_index != MAXftokenID)
-    oeftoken = &rec->fsmnode_token_array[ oeftoken_index];
-  else
-    oeftoken = NULL;
-    
+    get_eos_search_state(rec, &state);
     
   if (rec->srec_ended)
     rc = SPEECH_MAYBE_ENDED;
@@ -117,7 +141,7 @@ EOSrc srec_check_end_of_speech(srec_eos_detector_parms* eosd_parms, srec* rec)
   {
     /* here we will need to differentiate max_frames from
        num_frames_allocated */
-    if (eftoken_index != MAXftokenID)
+    if (state.end_valid)
       rc = SPEECH_ENDED;
     else
       rc = SPEECH_TOO_LONG;
@@ -126,18 +150,16 @@ EOSrc srec_check_end_of_speech(srec_eos_detector_parms* eosd_parms, srec* rec)
   {
   
     /* reset the internal counter? */
-    ftoken_index = rec->current_best_ftoken_index[NODE_INFO_REGULAR];
-    if (ftoken_index != MAXftokenID)
+    if (state.regular_valid)
     {
-      ftoken = &rec->fsmnode_token_array[ ftoken_index];
-      if (eosd_state->internalnode_node_index != ftoken->FSMnode_index)
+      if (eosd_state->internalnode_node_index != state.regular_node)
       {
-        eosd_state->internalnode_node_index = ftoken->FSMnode_index;
+        eosd_state->internalnode_node_index = state.regular_node;
         eosd_state->internalnode_frmcnt = 1;
       }
       else
       {
-        if (ftoken->word != rec->context->beg_silence_word)
+        if (state.regular_word != rec->context->beg_silence_word)
           eosd_state->internalnode_frmcnt++;
       }
     }
@@ -148,73 +170,64 @@ EOSrc srec_check_end_of_speech(srec_eos_detector_parms* eosd_parms, srec* rec)
     }
     
     /* nframes since eos */
-    if (eftoken)
-    {
-      last_wtoken = NULL;
-      if (eftoken->word_backtrace != MAXwtokenID)
-      {
-        last_wtoken = &rec->word_token_array[eftoken->word_backtrace];
-        nframes_since_eos = rec->current_search_frame - last_wtoken->end_time;
-      }
-      else
-        nframes_since_eos = 0;
-    }
+    if (state.end_valid && state.end_has_word)
+      nframes_since_eos = rec->current_search_frame - state.end_word_end_time;
     else
       nframes_since_eos = 0;
       
     /* eos cost margin */
-    if (!eftoken)
+    if (!state.end_valid)
     {
       eos_cost_margin = 0;
     }
-    else if (!oeftoken && !xftoken)
+    else if (!state.optend_valid && !state.regular_valid)
     {
       eos_cost_margin = MAXcostdata;
     }
-    else if (!oeftoken)
+    else if (!state.optend_valid)
     {
-      eos_cost_margin = xftoken->cost + wrapup_cost - eftoken->cost;
+      eos_cost_margin = state.regular_cost + wrapup_cost - state.end_cost;
     }
-    else if (!xftoken)
+    else if (!state.regular_valid)
     {
-      eos_cost_margin = oeftoken->cost + wrapup_cost - eftoken->cost;
+      eos_cost_margin = state.optend_cost + wrapup_cost - state.end_cost;
     }
-    else if (oeftoken->cost > eftoken->cost)
+    else if (state.optend_cost > state.end_cost)
     {
-      eos_cost_margin = xftoken->cost + wrapup_cost - eftoken->cost;
+      eos_cost_margin = state.regular_cost + wrapup_cost - state.end_cost;
     }
     else
-    { /* if(oeftoken->cost < eftoken->cost) */
-      eos_cost_margin = oeftoken->cost + wrapup_cost - eftoken->cost;
+    { /* if(optend_cost < end_cost) */
+      eos_cost_margin = state.optend_cost + wrapup_cost - state.end_cost;
     }
     
     /* opteos cost margin */
-    if (!eftoken)
+    if (!state.end_valid)
     {
       opteos_cost_margin = 0;
     }
-    else if (!oeftoken)
+    else if (!state.optend_valid)
     {
       opteos_cost_margin = 0;
     }
-    else if (!xftoken)
+    else if (!state.regular_valid)
     {
       opteos_cost_margin = MAXcostdata;
     }
     else
     {
-      opteos_cost_margin = xftoken->cost + wrapup_cost - eftoken->cost;
+      opteos_cost_margin = state.regular_cost + wrapup_cost - state.end_cost;
     }
     
-    if (eftoken)
+    if (state.end_valid)
     {
-      if (oeftoken && nframes_since_eos > eosd_parms->optendnode_timeout
+      if (state.optend_valid && nframes_since_eos > eosd_parms->optendnode_timeout
           && opteos_cost_margin > eosd_parms->eos_costdelta)
       {
         rc = SPEECH_ENDED;
         
       }
-      else if (!oeftoken && nframes_since_eos > eosd_parms->endnode_timeout
+      else if (!state.optend_valid && nframes_since_eos > eosd_parms->endnode_timeout
                && eos_cost_margin > eosd_parms->eos_costdelta)
       {
         rc = SPEECH_ENDED;
@@ -236,14 +249,6 @@ EOSrc srec_check_end_of_speech(srec_eos_detector_parms* eosd_parms, srec* rec)
     if (eosd_state->internalnode_frmcnt >= eosd_parms->internalnode_timeout)
     {
       /* PLogMessage("eosd_state->internalnode_frmcnt %d eosd_parms->internalnode_timeout %d\n", eosd_state->internalnode_frmcnt, eosd_parms->internalnode_timeout); */
-      ftoken_index = rec->current_best_ftoken_index[NODE_INFO_REGULAR];
-      ftoken = &rec->fsmnode_token_array [ ftoken_index];
-      /* sprintf(buf, "eos rec%d@%d,%d i%d> ", rec->id,
-      rec->current_search_frame, ftoken->FSMnode_index,
-      eosd_state->internalnode_frmcnt);
-      PLogMessage(buf); 
-      sprint_word_token_backtrace(buf,sizeof(buf),rec,ftoken->word_backtrace);
-      PLogMessage(" %s\n", buf); */
       rc = SPEECH_ENDED;
     }
   }
@@ -23,9 +23,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 #include "passert.h"
 
 #include "portable.h"
+#include "srec_score_pool.h"
 
 #include "hmm_desc.h"
 #include "utteranc.h"
@@ -49,6 +51,9 @@ input args come from config and are:
     int         max_hmm_tokens;       controls the maximum number of HMM's alive in any frame.  If number
      exceeded, pruning gets tightened.  So, this threshold can be used
      to tradeoff accuracy for computation an memory
+    int         max_active_hmm_tokens; histogram pruning, at the end of each frame the beam is
+     narrowed so that at most this many HMM's stay alive, 0 disables it.
+     Unlike max_hmm_tokens this does not change memory, it bounds cpu per frame
     int         max_fsmnode_tokens;   controls the maximum number of FSMs alive in any frame.  If number,
      exceeded, pruning gets tightened.  So, this threshold can be used
      to tradeoff accuracy for computation an memory
@@ -60,6 +65,17 @@ input args come from config and are:
 
     int         num_wordends_per_frame; controls the size of the word lattice - the number of word ends to
        keep at each time frame
+    int         frame_budget_usec;    search time target per frame, the beam is narrowed (to no less
+     than a quarter of viterbi_prune_thresh) while the average frame takes longer, 0 disables it
+    int         phone_lookahead_margin; arcs out of active fsm nodes are not entered when
+     a rough per-phoneme score puts them beyond viterbi_prune_thresh plus this margin, 0 disables it
+    int         score_threads;        threads for acoustic scoring, frames with many states to score
+     are split across them (needs a build with USE_THREAD), 1 scores on the recognition thread
+    int         first_pass_pdfs;      two-pass decoding, the first pass scores only this many pdfs per
+     state (with a wider beam), the utterance is then rescored with the full models, 0 is a single pass
+    int         enrollment_search;    voice enrollment grammars run on the phoneme loop search of
+     srec_enroll.c (single pass), 0 runs them on the general search
+
     int         max_fsm_nodes;        allocation size of a few arrays in the search - needs to be big enough
      to handle any grammar that the search needs to run.  Initialization fails
      if num exceeded
@@ -72,12 +88,14 @@ input args come from config and are:
 static void allocate_recognition1(srec *rec,
                                   int viterbi_prune_thresh,  /*score-based pruning threshold - only keep paths within this delta of best cost*/
                                   int max_hmm_tokens,
+                                  int max_active_hmm_tokens,
                                   int max_fsmnode_tokens,
                                   int max_word_tokens,
                                   int max_altword_tokens,
                                   int num_wordends_per_frame,
                                   int max_frames,
-                                  int max_model_states)
+                                  int max_model_states,
+                                  int first_pass_pdfs)
 {
 #ifdef SREC_ENGINE_VERBOSE_LOGGING
   PLogMessage("allocating recognition arrays2 prune %d max_hmm_tokens %d max_fsmnode_tokens %d max_word_tokens %d max_altword_tokens %d max_wordends_per_frame %d\n",
@@ -89,12 +107,15 @@ static void allocate_recognition1(srec *rec,
               num_wordends_per_frame);
 #endif
   rec->current_model_scores = (costdata*) CALLOC_CLR(max_model_states, sizeof(costdata), "search.srec.current_model_scores"); /*FIX - either get NUM_MODELS from acoustic models, or check this someplace to make sure we have enough room*/
+  rec->needed_model_list = (modelID*) CALLOC_CLR(max_model_states, sizeof(modelID), "search.srec.needed_model_list");
   rec->num_model_slots_allocated = (modelID)max_model_states;
 
   rec->fsmarc_token_array_size = (stokenID)max_hmm_tokens;
 
   rec->fsmarc_token_array = (fsmarc_token*) CALLOC_CLR(rec->fsmarc_token_array_size , sizeof(fsmarc_token), "search.srec.fsmarc_token_array");
   rec->max_new_states = (stokenID)max_hmm_tokens;
+  rec->max_active_hmm_tokens = (stokenID)max_active_hmm_tokens;
+  rec->active_fsmarc_token_list = (stokenID*) CALLOC_CLR(rec->fsmarc_token_array_size, sizeof(stokenID), "search.srec.active_fsmarc_token_list");
 
   rec->word_token_array = (word_token*) CALLOC_CLR(max_word_tokens, sizeof(word_token), "search.srec.word_token_array");
   rec->word_token_array_size = (wtokenID)max_word_tokens;
@@ -104,6 +125,13 @@ static void allocate_recognition1(srec *rec,
   rec->fsmnode_token_array = (fsmnode_token*) CALLOC_CLR(max_fsmnode_tokens, sizeof(fsmnode_token), "search.srec.fsmnode_token_array");
   rec->fsmnode_token_array_size = (ftokenID)max_fsmnode_tokens;
 
+  if (first_pass_pdfs > 0)
+  {
+    rec->first_pass_word_start = (asr_int32_t*) CALLOC_CLR(max_frames + 1, sizeof(asr_int32_t), "search.srec.first_pass_word_start");
+    rec->first_pass_words = (wordID*) CALLOC_CLR(max_word_tokens, sizeof(wordID), "search.srec.first_pass_words");
+    rec->first_pass_word_end = (frameID*) CALLOC_CLR(max_word_tokens, sizeof(frameID), "search.srec.first_pass_word_end");
+  }
+
   rec->altword_token_array = (altword_token*) CALLOC_CLR(max_altword_tokens, sizeof(altword_token), "search.srec.altword_token_array");
   rec->altword_token_array_size = (wtokenID)max_altword_tokens;
 
@@ -121,6 +149,9 @@ static void allocate_recognition1(srec *rec,
   rec->context = NULL;
 }
 
+/* the id limits of a SREC_WIDE_IDS build are beyond an int parameter */
+#define ID_PARAMETER_MAX(mAx) ((asr_uint32_t)(mAx) > INT_MAX ? INT_MAX : (int)(mAx))
+
 static int check_parameter_range(int parval, int parmin, int parmax, const char* parname)
 {
   if (parval > parmax)
@@ -138,6 +169,7 @@ static int check_parameter_range(int parval, int parmin, int parmax, const char*
 int allocate_recognition(multi_srec *rec,
                          int viterbi_prune_thresh,  /*score-based pruning threshold - only keep paths within this delta of best cost*/
                          int max_hmm_tokens,
+                         int max_active_hmm_tokens,
                          int max_fsmnode_tokens,
                          int max_word_tokens,
                          int max_altword_tokens,
@@ -146,39 +178,65 @@ int allocate_recognition(multi_srec *rec,
                          int max_fsm_arcs,
                          int max_frames,
                          int max_model_states,
-                         int max_searches)
+                         int max_searches,
+                         int frame_budget_usec,
+                         int phone_lookahead_margin,
+                         int first_pass_pdfs,
+                         int score_threads,
+                         int max_grammars,
+                         int enrollment_search)
 {
   int i;
 
-  if (check_parameter_range(max_fsm_nodes, 1, MAXnodeID, "max_fsm_nodes"))
+  if (check_parameter_range(max_fsm_nodes, 1, ID_PARAMETER_MAX(MAXnodeID), "max_fsm_nodes"))
     return 1;
-  if (check_parameter_range(max_fsm_arcs, 1, MAXarcID, "max_fsm_arcs"))
+  if (check_parameter_range(max_fsm_arcs, 1, ID_PARAMETER_MAX(MAXarcID), "max_fsm_arcs"))
     return 1;
-  if (check_parameter_range(max_frames, 1, MAXframeID, "max_frames"))
+  if (check_parameter_range(max_frames, 1, ID_PARAMETER_MAX(MAXframeID), "max_frames"))
     return 1;
   if (check_parameter_range(max_model_states, 1, MAXmodelID, "max_model_states"))
     return 1;
-  if (check_parameter_range(max_hmm_tokens, 1, MAXstokenID, "max_hmm_tokens"))
+  if (check_parameter_range(max_hmm_tokens, 1, ID_PARAMETER_MAX(MAXstokenID), "max_hmm_tokens"))
+    return 1;
+  if (check_parameter_range(max_active_hmm_tokens, 0, max_hmm_tokens, "max_active_hmm_tokens"))
     return 1;
-  if (check_parameter_range(max_fsmnode_tokens, 1, MAXftokenID, "max_fsmnode_tokens"))
+  if (check_parameter_range(max_fsmnode_tokens, 1, ID_PARAMETER_MAX(MAXftokenID), "max_fsmnode_tokens"))
     return 1;
   if (check_parameter_range(viterbi_prune_thresh, 1, MAXcostdata, "viterbi_prune_thresh"))
     return 1;
-  if (check_parameter_range(max_altword_tokens, 0, MAXftokenID, "max_altword_tokens"))
+  if (check_parameter_range(max_altword_tokens, 0, ID_PARAMETER_MAX(MAXftokenID), "max_altword_tokens"))
+    return 1;
+  if (check_parameter_range(max_searches, 1, MAX_ACOUSTIC_MODELS * MAX_ACTIVE_GRAMMARS, "max_searches"))
+    return 1;
+  if (check_parameter_range(frame_budget_usec, 0, INT_MAX, "frame_budget_usec"))
     return 1;
-  if (check_parameter_range(max_searches, 1, 2, "max_searches"))
+  if (check_parameter_range(phone_lookahead_margin, 0, MAXcostdata, "phone_lookahead_margin"))
+    return 1;
+  if (check_parameter_range(first_pass_pdfs, 0, 255, "first_pass_pdfs"))
+    return 1;
+  if (check_parameter_range(score_threads, 1, 64, "score_threads"))
+    return 1;
+  if (check_parameter_range(max_grammars, 1, MAX_ACTIVE_GRAMMARS, "max_grammars"))
+    return 1;
+  if (check_parameter_range(enrollment_search, 0, 1, "enrollment_search"))
     return 1;
 
   rec->rec = (srec*)CALLOC_CLR(max_searches, sizeof(srec), "search.srec.base");
   rec->num_allocated_recs = max_searches;
   rec->num_swimodels      = 0;
+  rec->max_grammars       = max_grammars;
+  rec->num_grammars       = 0;
 
   /* best_token_for_arc and best_token_for_node are shared across
      multiple searches */
   rec->best_token_for_arc = (stokenID*)CALLOC_CLR(max_fsm_arcs, sizeof(stokenID), "search.srec.best_token_for_arc");
+  rec->best_token_for_arc_stamp = (tokenepoch*)CALLOC_CLR(max_fsm_arcs, sizeof(tokenepoch), "search.srec.best_token_for_arc_stamp");
+  rec->best_token_for_arc_epoch = 1; /* stamps are all 0, so nothing is valid yet */
   rec->max_fsm_arcs = (arcID)max_fsm_arcs;
 
   rec->best_token_for_node = (ftokenID*)CALLOC_CLR(max_fsm_nodes, sizeof(ftokenID), "search.srec.best_token_for_node");
+  rec->best_token_for_node_stamp = (tokenepoch*)CALLOC_CLR(max_fsm_nodes, sizeof(tokenepoch), "search.srec.best_token_for_node_stamp");
+  rec->best_token_for_node_epoch = 1;
   rec->max_fsm_nodes = (nodeID)max_fsm_nodes;
 
   /* cost offsets and accumulated cost offsets are pooled for all
@@ -187,20 +245,45 @@ int allocate_recognition(multi_srec *rec,
   rec->cost_offset_for_frame = (costdata*)CALLOC_CLR(max_frames, sizeof(costdata), "search.srec.current_best_costs");
   rec->accumulated_cost_offset = (bigcostdata*)CALLOC_CLR(max_frames, sizeof(bigcostdata), "search.srec.accumulated_cost_offset");
   rec->max_frames = (frameID)max_frames;
+  rec->base_prune_delta = (costdata)viterbi_prune_thresh;
+  rec->frame_budget_usec = frame_budget_usec;
+  rec->avg_frame_usec = 0;
+  rec->pass_prune_delta = (costdata)viterbi_prune_thresh;
+  rec->first_pass_pdfs = (asr_int16_t)first_pass_pdfs;
+  rec->search_pass = SEARCH_PASS_SINGLE;
+  rec->first_pass_frames = NULL; /* allocated by the first pass, once it knows the dimension */
+  rec->first_pass_frame_dim = 0;
+  rec->num_first_pass_frames = 0;
+  rec->score_pool = score_pool_create(score_threads);
+  memset(&rec->score_cache, 0, sizeof(rec->score_cache));
+  if (max_searches > 1)
+  {
+    rec->score_cache.stamp = (tokenepoch*)CALLOC_CLR(max_model_states, sizeof(tokenepoch), "search.srec.score_cache.stamp");
+    rec->score_cache.score = (costdata*)CALLOC_CLR(max_model_states, sizeof(costdata), "search.srec.score_cache.score");
+    rec->score_cache.miss_list = (modelID*)CALLOC_CLR(max_model_states, sizeof(modelID), "search.srec.score_cache.miss_list");
+    rec->score_cache.epoch = 1; /* stamps are all 0, so nothing is valid yet */
+  }
   for (i = 0; i < max_frames; i++)
     rec->accumulated_cost_offset[i] = 0;
 
   /* now copy the shared data down to individual recogs */
   for (i = 0; i < rec->num_allocated_recs; i++)
   {
-    allocate_recognition1(&rec->rec[i], viterbi_prune_thresh, max_hmm_tokens, max_fsmnode_tokens, max_word_tokens, max_altword_tokens, num_wordends_per_frame, max_frames, max_model_states);
+    allocate_recognition1(&rec->rec[i], viterbi_prune_thresh, max_hmm_tokens, max_active_hmm_tokens, max_fsmnode_tokens, max_word_tokens, max_altword_tokens, num_wordends_per_frame, max_frames, max_model_states, first_pass_pdfs);
     rec->rec[i].best_token_for_node     = rec->best_token_for_node;
+    rec->rec[i].best_token_for_node_stamp = rec->best_token_for_node_stamp;
+    rec->rec[i].best_token_for_node_epoch = &rec->best_token_for_node_epoch;
     rec->rec[i].max_fsm_nodes           = rec->max_fsm_nodes;
     rec->rec[i].best_token_for_arc      = rec->best_token_for_arc;
+    rec->rec[i].best_token_for_arc_stamp = rec->best_token_for_arc_stamp;
+    rec->rec[i].best_token_for_arc_epoch = &rec->best_token_for_arc_epoch;
     rec->rec[i].max_fsm_arcs            = rec->max_fsm_arcs;
     rec->rec[i].max_frames              = rec->max_frames;
     rec->rec[i].cost_offset_for_frame   = rec->cost_offset_for_frame;
     rec->rec[i].accumulated_cost_offset = rec->accumulated_cost_offset;
+    rec->rec[i].phone_lookahead_margin = (costdata)phone_lookahead_margin;
+    rec->rec[i].enrollment_search = (asr_int16_t)enrollment_search;
+    rec->rec[i].score_pool = rec->score_pool;
     rec->rec[i].id = (asr_int16_t)i;
   }
   rec->eos_status = VALID_SPEECH_NOT_YET_DETECTED;
@@ -211,7 +294,9 @@ int allocate_recognition(multi_srec *rec,
 static void free_recognition1(srec *rec)
 {
   FREE(rec->current_model_scores);
+  FREE(rec->needed_model_list);
   FREE(rec->fsmarc_token_array);
+  FREE(rec->active_fsmarc_token_list);
   FREE(rec->word_token_array);
   FREE(rec->word_token_array_flags);
   FREE(rec->fsmnode_token_array);
@@ -220,6 +305,14 @@ static void free_recognition1(srec *rec)
   destroy_word_lattice(rec->word_lattice);
   free_priority_q(rec->word_priority_q);
   astar_stack_destroy(rec);
+  srec_free_phone_lookahead(rec);
+  srec_enroll_free(rec);
+  if (rec->first_pass_word_start)
+    FREE(rec->first_pass_word_start);
+  if (rec->first_pass_words)
+    FREE(rec->first_pass_words);
+  if (rec->first_pass_word_end)
+    FREE(rec->first_pass_word_end);
 }
 
 void free_recognition(multi_srec *rec)
@@ -229,8 +322,19 @@ void free_recognition(multi_srec *rec)
     free_recognition1(&rec->rec[i]);
   FREE(rec->accumulated_cost_offset);
   FREE(rec->cost_offset_for_frame);
+  if (rec->first_pass_frames)
+    FREE(rec->first_pass_frames);
+  score_pool_destroy(rec->score_pool);
+  if (rec->score_cache.stamp)
+  {
+    FREE(rec->score_cache.stamp);
+    FREE(rec->score_cache.score);
+    FREE(rec->score_cache.miss_list);
+  }
   FREE(rec->best_token_for_node);
+  FREE(rec->best_token_for_node_stamp);
   FREE(rec->best_token_for_arc);
+  FREE(rec->best_token_for_arc_stamp);
   FREE(rec->rec);
 }
 
@@ -56,6 +56,13 @@ int srec_get_bestcost_recog_id(multi_srec* recm, int* id)
   return 0;
 }
 
+/* the grammar the results come from, when several are decoded at once */
+srec_context* srec_get_bestcost_context(multi_srec* recm)
+{
+  srec* rec = WHICH_RECOG(recm);
+  return rec ? rec->context : NULL;
+}
+
 void srec_result_strip_slot_markers(char* result)
 {
   if (!result) return;
@@ -454,6 +461,96 @@ int srec_nbest_get_choice_info(void* rec_void, int ibest, asr_int32_t* infoval,
 }
 
 
+/* Same values as srec_nbest_get_choice_info(), for every choice in one
+   pass.  The gsm cost is a sum over the speech frames of the choice, and
+   the choices mostly share their speech boundaries, so it is carried from
+   one choice to the next by adding and removing the frames at the ends
+   rather than summed from scratch.  Returns the number of choices filled. */
+int srec_nbest_get_choice_infos(void* rec_void, srec_nbest_choice_info* infos, int max_choices)
+{
+  srec* rec = (srec*)rec_void;
+  AstarStack* stack = rec ? rec->astar_stack : 0;
+  frameID gsm_start = MAXframeID, gsm_end = MAXframeID;
+  bigcostdata gsm_states_cost = 0;
+  int ibest, num_choices;
+
+  if (!stack)
+    return 0;
+  num_choices = stack->num_complete_paths < max_choices ? stack->num_complete_paths : max_choices;
+
+  for (ibest = 0; ibest < num_choices; ibest++)
+  {
+    srec_nbest_choice_info* info = &infos[ibest];
+    partial_path* parp = stack->complete_paths[ibest];
+    frameID start_frame = MAXframeID;
+    frameID end_frame = MAXframeID;
+    bigcostdata start_cost = 0, end_cost = 0;
+    word_token* wtoken;
+    frameID num_words;
+
+    info->cost = parp->costsofar;
+    info->num_speech_frames = 400;
+    info->speech_frames_cost = 0;
+    info->gsm_cost = 0;
+    info->num_words = 0;
+
+    for (num_words = 0 ; parp; parp = parp->next)
+    {
+      if (parp->token_index == MAXwtokenID) break;
+      wtoken = &rec->word_token_array[ parp->token_index];
+      if (wtoken->word == rec->context->beg_silence_word)
+      {
+        start_frame = wtoken->end_time;
+        start_cost = wtoken->cost + rec->accumulated_cost_offset[ start_frame];
+        num_words--;
+      }
+      else if (parp->next &&
+               parp->next->token_index != MAXwtokenID &&
+               rec->word_token_array[ parp->next->token_index].word == rec->context->end_silence_word)
+      {
+        end_frame = wtoken->end_time;
+        end_cost = wtoken->cost + rec->accumulated_cost_offset[ end_frame];
+        num_words--;
+      }
+      num_words++;
+    }
+
+    if (start_frame != MAXframeID && end_frame != MAXframeID)
+    {
+      bigcostdata speech_frames_cost = end_cost - start_cost;
+      speech_frames_cost = speech_frames_cost - (num_words + 1) * (rec->context->wtw_average - WTW_AT_NNREJ_TRAINING);
+      info->num_speech_frames = (frameID)(end_frame - start_frame);
+      info->speech_frames_cost = speech_frames_cost;
+      info->num_words = num_words;
+
+      /* gsm cost over ]start_frame, end_frame] */
+      if (gsm_start == MAXframeID || gsm_end <= gsm_start || end_frame <= start_frame
+          || start_frame > gsm_end || end_frame < gsm_start)
+      {
+        frameID i;
+        gsm_states_cost = 0;
+        for (i = start_frame + 1; i <= end_frame; i++)
+          gsm_states_cost += rec->best_model_cost_for_frame[i];
+      }
+      else
+      {
+        for (; gsm_start < start_frame; gsm_start++)
+          gsm_states_cost -= rec->best_model_cost_for_frame[gsm_start + 1];
+        for (; gsm_start > start_frame; gsm_start--)
+          gsm_states_cost += rec->best_model_cost_for_frame[gsm_start];
+        for (; gsm_end < end_frame; gsm_end++)
+          gsm_states_cost += rec->best_model_cost_for_frame[gsm_end + 1];
+        for (; gsm_end > end_frame; gsm_end--)
+          gsm_states_cost -= rec->best_model_cost_for_frame[gsm_end];
+      }
+      gsm_start = start_frame;
+      gsm_end = end_frame;
+      info->gsm_cost = gsm_states_cost;
+    }
+  }
+  return num_choices;
+}
+
 int srec_nbest_sort(void* rec_void)
 {
   srec* rec = (srec*)rec_void;
@@ -0,0 +1,202 @@
+/*---------------------------------------------------------------------------*
+ *  srec_score_pool.c  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. * 
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#include "pstdio.h"
+#include "passert.h"
+#include "portable.h"
+
+#include "srec_score_pool.h"
+
+#ifdef USE_THREAD
+#include "ptrd.h"
+
+typedef struct
+{
+  score_pool* pool;
+  PtrdThread* thread;
+  PtrdSemaphore* start;   /* released by the caller when a slice is ready */
+  int begin, end;         /* the slice of states[] for this worker */
+}
+score_worker;
+
+struct score_pool_t
+{
+  int num_workers;        /* threads besides the calling one */
+  score_worker* workers;
+  PtrdSemaphore* done;    /* released by each worker when its slice is scored */
+  int quit;
+
+  /* the current job, only written while the workers are waiting */
+  costdata* scores;
+  const modelID* states;
+  const SWIModel* acoustic_models;
+  const preprocessed* prep;
+  int max_pdfs;
+};
+
+static void score_states(score_pool* pool, int begin, int end)
+{
+  const SWIModel* acoustic_models = pool->acoustic_models;
+  scodata score;
+  modelID state;
+  int i;
+
+  for (i = begin; i < end; i++)
+  {
+    state = pool->states[i];
+    if (pool->max_pdfs)
+      score = mixture_diagonal_gaussian_swimodel_npdfs(pool->prep,
+              &acoustic_models->hmmstates[state], acoustic_models->num_dims, (short)pool->max_pdfs);
+    else
+      score = mixture_diagonal_gaussian_swimodel(pool->prep,
+              &acoustic_models->hmmstates[state], acoustic_models->num_dims);
+    ASSERT(score <= 0 && "model score out of range");
+    pool->scores[state] = (costdata) - score;
+  }
+}
+
+static void score_worker_main(PtrdThreadArg arg)
+{
+  score_worker* worker = (score_worker*)arg;
+  score_pool* pool = worker->pool;
+
+  for (;;)
+  {
+    if (PtrdSemaphoreAcquire(worker->start) != ESR_SUCCESS || pool->quit)
+      break;
+    score_states(pool, worker->begin, worker->end);
+    PtrdSemaphoreRelease(pool->done);
+  }
+}
+
+score_pool* score_pool_create(int num_threads)
+{
+  score_pool* pool;
+  score_worker* worker;
+  int i;
+
+  if (num_threads <= 1)
+    return NULL;
+  pool = (score_pool*)CALLOC_CLR(1, sizeof(score_pool), "search.score_pool");
+  if (!pool)
+    return NULL;
+  pool->workers = (score_worker*)CALLOC_CLR(num_threads - 1, sizeof(score_worker), "search.score_pool.workers");
+  if (!pool->workers || PtrdSemaphoreCreate(0, num_threads - 1, &pool->done) != ESR_SUCCESS)
+    goto FAILED;
+  for (i = 0; i < num_threads - 1; i++)
+  {
+    worker = &pool->workers[i];
+    worker->pool = pool;
+    if (PtrdSemaphoreCreate(0, 1, &worker->start) != ESR_SUCCESS)
+      goto FAILED;
+    if (PtrdThreadCreate(score_worker_main, worker, &worker->thread) != ESR_SUCCESS)
+    {
+      PtrdSemaphoreDestroy(worker->start);
+      worker->start = NULL;
+      goto FAILED;
+    }
+    pool->num_workers++;
+  }
+  return pool;
+
+FAILED:
+  PLogError("warning: could not start %d scoring threads, scoring on one thread\n", num_threads);
+  score_pool_destroy(pool);
+  return NULL;
+}
+
+void score_pool_destroy(score_pool* pool)
+{
+  int i;
+
+  if (!pool)
+    return;
+  pool->quit = 1;
+  for (i = 0; i < pool->num_workers; i++)
+    PtrdSemaphoreRelease(pool->workers[i].start);
+  for (i = 0; i < pool->num_workers; i++)
+  {
+    PtrdThreadJoin(pool->workers[i].thread);
+    PtrdThreadDestroy(pool->workers[i].thread);
+    PtrdSemaphoreDestroy(pool->workers[i].start);
+  }
+  if (pool->done)
+    PtrdSemaphoreDestroy(pool->done);
+  if (pool->workers)
+    FREE(pool->workers);
+  FREE(pool);
+}
+
+int score_pool_compute(score_pool* pool, costdata* scores,
+                       const modelID* states, int num_states,
+                       const SWIModel* acoustic_models, const preprocessed* prep,
+                       int max_pdfs)
+{
+  int i, slice, begin, num_started = 0;
+
+  if (!pool || pool->num_workers == 0)
+    return 1;
+  pool->scores = scores;
+  pool->states = states;
+  pool->acoustic_models = acoustic_models;
+  pool->prep = prep;
+  pool->max_pdfs = max_pdfs;
+
+  /* the calling thread takes the first slice */
+  slice = (num_states + pool->num_workers) / (pool->num_workers + 1);
+  begin = slice;
+  for (i = 0; i < pool->num_workers && begin < num_states; i++)
+  {
+    score_worker* worker = &pool->workers[i];
+    worker->begin = begin;
+    worker->end = begin + slice < num_states ? begin + slice : num_states;
+    begin = worker->end;
+    if (PtrdSemaphoreRelease(worker->start) == ESR_SUCCESS)
+      num_started++;
+    else
+      score_states(pool, worker->begin, worker->end);
+  }
+  score_states(pool, 0, slice < num_states ? slice : num_states);
+  for (i = 0; i < num_started; i++)
+    PtrdSemaphoreAcquire(pool->done);
+  return 0;
+}
+
+#else
+
+score_pool* score_pool_create(int num_threads)
+{
+  if (num_threads > 1)
+    PLogError("warning: built without USE_THREAD, scoring on one thread\n");
+  return NULL;
+}
+
+void score_pool_destroy(score_pool* pool)
+{
+}
+
+int score_pool_compute(score_pool* pool, costdata* scores,
+                       const modelID* states, int num_states,
+                       const SWIModel* acoustic_models, const preprocessed* prep,
+                       int max_pdfs)
+{
+  return 1;
+}
+
+#endif
@@ -0,0 +1,51 @@
+/*---------------------------------------------------------------------------*
+ *  srec_score_pool.h  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. * 
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#ifndef _SREC_SCORE_POOL_H_
+#define _SREC_SCORE_POOL_H_
+
+#include "ptypes.h"
+#include "srec_sizes.h"
+#include "pre_desc.h"
+#include "swimodel.h"
+
+/* frames needing fewer states than this are scored on the calling
+   thread, waking the workers would cost more than it saves */
+#define SCORE_POOL_MIN_STATES 256
+
+/**
+ * A small persistent pool of threads for acoustic scoring.  Each frame,
+ * the list of states to score is cut into one contiguous slice per
+ * thread, the calling thread takes the first slice and waits for the
+ * others.  Threads come from ptrd.h, so without USE_THREAD no pool can
+ * be created and all scoring stays on the calling thread.
+ */
+typedef struct score_pool_t score_pool;
+
+score_pool* score_pool_create(int num_threads);
+void score_pool_destroy(score_pool* pool);
+
+/* scores[states[i]] = cost of states[i] for i < num_states, returns
+   non-zero if there is no pool, the caller then scores them itself */
+int score_pool_compute(score_pool* pool, costdata* scores,
+                       const modelID* states, int num_states,
+                       const SWIModel* acoustic_models, const preprocessed* prep,
+                       int max_pdfs);
+
+#endif
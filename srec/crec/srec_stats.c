@@ -127,8 +127,8 @@ void srec_stats_update(srec* rec, char* msg)
   /* altword tokens */
   for (num = 0, awtoken = rec->altword_token_freelist; awtoken; awtoken = awtoken->next_token)
     num++;
-  num = rec->altword_token_array_size - num;
-  for (numb = 0, i = 0; i < rec->altword_token_array_size; i++)
+  num = rec->altword_token_array_linked - num;
+  for (numb = 0, i = 0; i < rec->altword_token_array_linked; i++)
     if (rec->altword_token_array[i].next_token == AWTNULL)
       numb++;
   numb--; /* foreach tail, there is a head, remove the freelist head pointer */
@@ -50,17 +50,36 @@ int count_fsmarc_token_list(srec* rec, stokenID token_index)
 
 /* static int num_fsmarc_tokens_allocated = 0; */
 
-void initialize_free_fsmarc_tokens(srec *rec)
+/* The token arrays are allocated at their maximum size, but the freelists
+   are built TOKEN_POOL_CHUNK tokens at a time, whenever the freelist runs
+   dry, so an utterance only touches (and the system only commits) the part
+   of the arrays that it actually needs.  Since a freelist is extended as
+   soon as its last token is taken, an empty freelist still means that all
+   the tokens are in use. */
+
+static void extend_free_fsmarc_tokens(srec *rec)
 {
-  stokenID i;
+  stokenID i, end;
   
+  if (rec->fsmarc_token_array_linked >= rec->fsmarc_token_array_size)
+    return;
+  if (rec->fsmarc_token_array_size - rec->fsmarc_token_array_linked > TOKEN_POOL_CHUNK)
+    end = (stokenID)(rec->fsmarc_token_array_linked + TOKEN_POOL_CHUNK);
+  else
+    end = rec->fsmarc_token_array_size;
+  for (i = rec->fsmarc_token_array_linked; i < end - 1; i++)
+    rec->fsmarc_token_array[i].next_token_index = (stokenID)(i + 1);
+  rec->fsmarc_token_array[end-1].next_token_index = MAXstokenID;
+  rec->fsmarc_token_freelist = rec->fsmarc_token_array_linked;
+  rec->fsmarc_token_array_linked = end;
+}
+
+void initialize_free_fsmarc_tokens(srec *rec)
+{
   /* num_fsmarc_tokens_allocated = 0; */
-  for (i = 0;i < rec->fsmarc_token_array_size - 1;i++)
-  {
-    rec->fsmarc_token_array[i].next_token_index = i + 1;
-  }
-  rec->fsmarc_token_array[rec->fsmarc_token_array_size-1].next_token_index = MAXstokenID;
-  rec->fsmarc_token_freelist = 0;
+  rec->fsmarc_token_array_linked = 0;
+  rec->fsmarc_token_freelist = MAXstokenID;
+  extend_free_fsmarc_tokens(rec);
 }
 
 /*allocates the token and sets it up for a given arc*/
@@ -106,6 +125,8 @@ stokenID setup_free_fsmarc_token(srec *rec, FSMarc* arc, arcID fsm_arc_index, mi
   }
   
   rec->fsmarc_token_freelist = token->next_token_index;
+  if (rec->fsmarc_token_freelist == MAXstokenID)
+    extend_free_fsmarc_tokens(rec);
   
   /* num_fsmarc_tokens_allocated++; */
   return token_to_return;
@@ -133,19 +154,39 @@ void sort_fsmarc_token_list(srec* rec, stokenID* ptoken_index)
  * word_token management
  */
 
-void initialize_free_word_tokens(srec *rec)
+static void extend_free_word_tokens(srec *rec)
 {
-  wtokenID i;
-  word_token* wtoken = NULL;
+  wtokenID i, end;
   
-  for (i = 0;i < rec->word_token_array_size;i++)
-  {
-    wtoken = &rec->word_token_array[i];
-    wtoken->next_token_index = i + 1;
-  }
+  if (rec->word_token_array_linked >= rec->word_token_array_size)
+    return;
+  if (rec->word_token_array_size - rec->word_token_array_linked > TOKEN_POOL_CHUNK)
+    end = (wtokenID)(rec->word_token_array_linked + TOKEN_POOL_CHUNK);
+  else
+    end = rec->word_token_array_size;
+  for (i = rec->word_token_array_linked; i < end - 1; i++)
+    rec->word_token_array[i].next_token_index = (wtokenID)(i + 1);
   /* last one must point nowhere */
-  wtoken->next_token_index = MAXwtokenID;
-  rec->word_token_freelist = 0;
+  rec->word_token_array[end-1].next_token_index = MAXwtokenID;
+  rec->word_token_freelist = rec->word_token_array_linked;
+  rec->word_token_array_linked = end;
+}
+
+void initialize_free_word_tokens(srec *rec)
+{
+  rec->word_token_array_linked = 0;
+  rec->word_token_freelist = MAXwtokenID;
+  extend_free_word_tokens(rec);
+}
+
+wtokenID count_free_word_tokens(srec *rec)
+{
+  wtokenID wtoken_index = rec->word_token_freelist;
+  wtokenID num_free_wtokens = (wtokenID)(rec->word_token_array_size - rec->word_token_array_linked);
+  
+  for (; wtoken_index != MAXwtokenID; wtoken_index = rec->word_token_array[wtoken_index].next_token_index)
+    num_free_wtokens++;
+  return num_free_wtokens;
 }
 
 wtokenID get_free_word_token(srec *rec, miscdata what_to_do_if_fails)
@@ -174,6 +215,8 @@ wtokenID get_free_word_token(srec *rec, miscdata what_to_do_if_fails)
   token_to_return = rec->word_token_freelist;
   wtoken =  &rec->word_token_array[token_to_return];
   rec->word_token_freelist = wtoken->next_token_index;
+  if (rec->word_token_freelist == MAXwtokenID)
+    extend_free_word_tokens(rec);
   
   /*note that we are returning without setting any contents of the token (including next_token_index)
    leave it for the calling program to take care of that*/
@@ -201,19 +244,29 @@ int count_fsmnode_token_list(srec* rec, ftokenID token_index)
   return count;
 }
 
-void initialize_free_fsmnode_tokens(srec *rec)
+static void extend_free_fsmnode_tokens(srec *rec)
 {
-  ftokenID i;
-  fsmnode_token* ftoken = NULL;
+  ftokenID i, end;
   
-  for (i = 0;i < rec->fsmnode_token_array_size;i++)
-  {
-    ftoken = &rec->fsmnode_token_array[i];
-    ftoken->next_token_index = i + 1;
-  }
+  if (rec->fsmnode_token_array_linked >= rec->fsmnode_token_array_size)
+    return;
+  if (rec->fsmnode_token_array_size - rec->fsmnode_token_array_linked > TOKEN_POOL_CHUNK)
+    end = (ftokenID)(rec->fsmnode_token_array_linked + TOKEN_POOL_CHUNK);
+  else
+    end = rec->fsmnode_token_array_size;
+  for (i = rec->fsmnode_token_array_linked; i < end - 1; i++)
+    rec->fsmnode_token_array[i].next_token_index = (ftokenID)(i + 1);
   /* last one must point nowhere */
-  ftoken->next_token_index = MAXftokenID;
-  rec->fsmnode_token_freelist = 0;
+  rec->fsmnode_token_array[end-1].next_token_index = MAXftokenID;
+  rec->fsmnode_token_freelist = rec->fsmnode_token_array_linked;
+  rec->fsmnode_token_array_linked = end;
+}
+
+void initialize_free_fsmnode_tokens(srec *rec)
+{
+  rec->fsmnode_token_array_linked = 0;
+  rec->fsmnode_token_freelist = MAXftokenID;
+  extend_free_fsmnode_tokens(rec);
 }
 
 ftokenID get_free_fsmnode_token(srec *rec, miscdata what_to_do_if_fails)
@@ -242,6 +295,8 @@ ftokenID get_free_fsmnode_token(srec *rec, miscdata what_to_do_if_fails)
   token_to_return = rec->fsmnode_token_freelist;
   ftoken =  &rec->fsmnode_token_array[token_to_return];
   rec->fsmnode_token_freelist = ftoken->next_token_index;
+  if (rec->fsmnode_token_freelist == MAXftokenID)
+    extend_free_fsmnode_tokens(rec);
   
   /*note that we are returning without setting any contents of the token
     (including next_token_index)
@@ -266,21 +321,35 @@ void free_fsmnode_token(srec *rec, ftokenID old_token_index)
  *  altword token management
  */
 
-void initialize_free_altword_tokens(srec *rec)
+static void extend_free_altword_tokens(srec *rec)
 {
-  wtokenID i;
-  altword_token* awtoken = NULL;
-  for (i = 0;i < rec->altword_token_array_size;i++)
+  altword_token *awtoken, *end;
+  
+  if (rec->altword_token_array_linked >= rec->altword_token_array_size)
+    return;
+  if (rec->altword_token_array_size - rec->altword_token_array_linked > TOKEN_POOL_CHUNK)
+    end = rec->altword_token_array + rec->altword_token_array_linked + TOKEN_POOL_CHUNK;
+  else
+    end = rec->altword_token_array + rec->altword_token_array_size;
+  for (awtoken = rec->altword_token_array + rec->altword_token_array_linked; awtoken < end; awtoken++)
   {
-    awtoken = rec->altword_token_array + i;
     awtoken->next_token = awtoken + 1;
     awtoken->costdelta  = MAXcostdata;
     awtoken->refcount   = 0;
     awtoken->costbasis  = 0;
   }
   /* last one must point nowhere */
-  awtoken->next_token = NULL;
-  rec->altword_token_freelist = &rec->altword_token_array[0];
+  (end - 1)->next_token = NULL;
+  rec->altword_token_freelist = rec->altword_token_array + rec->altword_token_array_linked;
+  rec->altword_token_array_linked = (wtokenID)(end - rec->altword_token_array);
+}
+
+void initialize_free_altword_tokens(srec *rec)
+{
+  rec->altword_token_array_linked = 0;
+  rec->altword_token_freelist = NULL;
+  extend_free_altword_tokens(rec);
+  /* counts the tokens not linked yet */
   rec->altword_token_freelist_len = rec->altword_token_array_size;
 }
 
@@ -309,6 +378,8 @@ altword_token* get_free_altword_token(srec* rec, miscdata what_to_do_if_fails)
   awtoken->refcount = 1;
   rec->altword_token_freelist = awtoken->next_token;
   rec->altword_token_freelist_len--;
+  if (!rec->altword_token_freelist)
+    extend_free_altword_tokens(rec);
   return awtoken;
 }
 
@@ -27,6 +27,9 @@
 #define EXIT_IF_NO_TOKENS 1  /*for handling allocation failures*/
 #define NULL_IF_NO_TOKENS 2  /*for handling allocation failures*/
 
+/* number of tokens added to a freelist each time it runs dry */
+#define TOKEN_POOL_CHUNK 256
+
 /*
  * fsmarc_token management
  */
@@ -43,6 +46,7 @@ void sort_fsmarc_token_list(srec* rec, stokenID* ptoken_index);
 
 void initialize_free_word_tokens(srec *rec);
 wtokenID get_free_word_token(srec *rec, miscdata what_to_do_if_fails);
+wtokenID count_free_word_tokens(srec *rec);
 
 /*
  * fsmnode_token management
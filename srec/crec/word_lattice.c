@@ -81,6 +81,42 @@ void initialize_word_lattice(srec_word_lattice* wl)
   }
 }
 
+int srec_dump_word_lattice(srec* rec, PFile* fp)
+{
+  asr_int32_t header[4];
+  wtokenID tmp[7];
+  word_token* wtoken;
+  frameID num_frames = (frameID)(rec->current_search_frame + 1);
+  wtokenID i;
+  int nfields;
+
+  header[0] = WORD_LATTICE_IMAGE_FORMAT;
+  header[1] = num_frames;
+  header[2] = rec->word_token_array_size;
+  header[3] = rec->context->beg_silence_word;
+  if (pfwrite(header, sizeof(header[0]), 4, fp) != 4)
+    return 1;
+  if (pfwrite(rec->accumulated_cost_offset, sizeof(bigcostdata), num_frames, fp) != num_frames)
+    return 1;
+  if (pfwrite(rec->word_lattice->words_for_frame, sizeof(wtokenID), num_frames, fp) != num_frames)
+    return 1;
+  for (i = 0; i < rec->word_token_array_size; i++)
+  {
+    wtoken = &rec->word_token_array[i];
+    nfields = 0;
+    tmp[nfields++] = wtoken->word;
+    tmp[nfields++] = wtoken->end_time;
+    tmp[nfields++] = wtoken->end_node;
+    tmp[nfields++] = wtoken->backtrace;
+    tmp[nfields++] = wtoken->cost;
+    tmp[nfields++] = wtoken->next_token_index;
+    tmp[nfields++] = wtoken->_word_end_time;
+    if (pfwrite(tmp, sizeof(tmp[0]), nfields, fp) != (size_t)nfields)
+      return 1;
+  }
+  return 0;
+}
+
 costdata lattice_best_cost_to_frame(srec_word_lattice *wl, word_token* word_token_array, frameID ifr)
 {
   int sanity_counter = 0;
@@ -699,7 +735,7 @@ int reprune_word_tokens(srec* rec, costdata current_best_cost)
   /* we will flag all wtokens to be kept */
 
   /* initialize the flags to keep all */
-  memset(rec->word_token_array_flags, 0, sizeof(rec->word_token_array_flags[0])*rec->word_token_array_size);
+  memset(rec->word_token_array_flags, 0, sizeof(rec->word_token_array_flags[0])*rec->word_token_array_linked);
 
   /* flag all those tokens not active, ie already free */
   wtoken_index = rec->word_token_freelist;
@@ -742,8 +778,9 @@ int reprune_word_tokens(srec* rec, costdata current_best_cost)
   astar_stack_flag_word_tokens_used(rec->astar_stack, rec);
   astar_stack_clear(rec->astar_stack);
 
-  /* kill_word_tokens */
-  for (i = 0; i < rec->word_token_array_size; i++)
+  /* kill_word_tokens, the ones never linked are not on the freelist but
+     are free all the same */
+  for (i = 0; i < rec->word_token_array_linked; i++)
   {
     if (rec->word_token_array_flags[i] == 0) /* < 0 are already free! */
       free_word_token_from_lattice(rec, (frameID)i);
@@ -79,7 +79,7 @@ typedef struct partial_path_t
   struct partial_path_t* linkl_prev_arc;
   arc_token* arc_for_wtoken;
   short refcount;
-  struct partial_path_t* hashlink;
+  unsigned int hashval;   /* cached hashfunc(), set in hash_set() */
 }
 partial_path;
 #define PARP_TERMINAL         ((partial_path*)-1)
@@ -94,7 +94,7 @@ typedef struct
   /* todo: replace these pointers with partial_path_token type things */
   int max_active_paths;
   int num_active_paths;
-  partial_path** active_paths;    /* partial paths, sorted by score */
+  partial_path** active_paths;    /* partial paths, heap on score */
   
   int max_complete_paths;
   int num_complete_paths;
@@ -55,12 +55,14 @@ extern "C"
 
   void multi_srec_get_result(multi_srec *rec);
   int activate_grammar_for_recognition(multi_srec* rec1, srec_context* context, const char* rule);
+  int deactivate_grammar_for_recognition(multi_srec* rec1, srec_context* context);
   int clear_grammars_for_recognition(multi_srec* rec1);
 
   void partial_traceback(multi_srec *rec, pattern_info *pattern,
                          utterance_info *utt);
   void begin_recognition(multi_srec *rec, int begin_syn_node);
   void end_recognition(multi_srec *rec);
+  int rescore_recognition(multi_srec *rec, srec_eos_detector_parms* eosd, pattern_info *pattern);
   int  add_acoustic_model_for_recognition(multi_srec* rec, const SWIModel* swimodel);
   int  clear_acoustic_models_for_recognition(multi_srec* rec);
 
@@ -69,6 +71,7 @@ extern "C"
                            int viterbi_prune_thresh,
                            /* score-based pruning threshold - only keep paths within this delta of best cost*/
                            int max_hmm_tokens,
+                           int max_active_hmm_tokens,
                            int max_fsmnode_tokens,
                            int max_word_tokens,
                            int max_altword_tokens,
@@ -77,7 +80,13 @@ extern "C"
                            int max_fsm_arcs,
                            int max_frames,
                            int max_model_states,
-                           int max_searches);
+                           int max_searches,
+                           int frame_budget_usec,
+                           int phone_lookahead_margin,
+                           int first_pass_pdfs,
+                           int score_threads,
+                           int max_grammars,
+                           int enrollment_search);
 
   int compare_model_indices(multi_srec *rec1, srec *rec2);
 
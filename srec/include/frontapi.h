@@ -246,6 +246,8 @@ extern "C"
   */
 ESR_ReturnCode CA_GetCMSParameters ( CA_Wave *hWave, LCHAR *param_string, size_t* len );
 ESR_ReturnCode CA_SetCMSParameters ( CA_Wave *hWave, const LCHAR *param_string );
+ESR_ReturnCode CA_GetCMSState ( CA_Wave *hWave, swicms_state *state );
+ESR_ReturnCode CA_SetCMSState ( CA_Wave *hWave, const swicms_state *state );
 
 
   void CA_ReLoadCMSParameters(CA_Wave *hWave,
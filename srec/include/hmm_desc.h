@@ -146,6 +146,8 @@ typedef struct
   const char* first_entry; /* first entry in the dictionary */
   const char* last_entry; /* last entry in the dictionary */
   int hasUpper; /* nonzero if upper case present in dictionary (usually not) */
+  asr_uint32_t* label_index; /* offset of the first entry of each distinct label, sorted */
+  int num_labels; /* number of entries in label_index */
 }
 vocab_info;
 
@@ -35,6 +35,11 @@ void clear_partial_distance_approx(preprocessed *prep);
 void    clear_preprocessed(preprocessed *datapak);
 
 void    linear_transform_frame(preprocessed *datapak, imeldata *fram, int do_shift);
+void    linear_transform_frames(preprocessed *datapak, imeldata **frames,
+                                int num_frames, int do_shift);
+void    transform_and_normalize_frame(preprocessed *datapak, imeldata *fram,
+                                      imeldata *unnorm, const imeldata *adjust,
+                                      int adjust_dim);
 void    inverse_transform_frame (preprocessed *prep, imeldata *fram, int do_shift);
 
 #ifdef __cplusplus
@@ -269,6 +269,8 @@ typedef struct
     int         max_hmm_tokens;       /*controls the maximum number of HMM's alive in any frame.  If number
          exceeded, pruning gets tightened.  So, this threshold can be used
          to tradeoff accuracy for computation an memory*/
+    int         max_active_hmm_tokens; /*histogram pruning, the beam is narrowed each frame so that at
+         most this many HMM's stay alive, bounding the cpu per frame.  0 disables it*/
     int         max_fsmnode_tokens;   /*controls the maximum number of FSMs alive in any frame.  If number,
          exceeded, pruning gets tightened.  So, this threshold can be used
          to tradeoff accuracy for computation an memory*/
@@ -292,6 +294,12 @@ typedef struct
     int         stats_enabled;              /* enable frame-by-frame recognizer stats */
     int         max_frames;             /* max number of frames in for searching */
     int         max_model_states;       /* indicates largest acoustic model this search can use */
+    int         frame_budget_usec;      /* search time target per frame, the beam is narrowed to meet it, 0 disables */
+    int         phone_lookahead_margin; /* skip arcs whose phoneme scores beyond the beam plus this margin, 0 disables */
+    int         first_pass_pdfs;        /* two-pass decoding, pdfs per state scored in the fast first pass, 0 for one pass */
+    int         score_threads;          /* threads for acoustic scoring of large frames, 1 for none */
+    int         max_grammars;           /* grammars decoded at once, 1 replaces the grammar on activation */
+    int         enrollment_search;      /* voice enrollment grammars run on the phoneme loop search, 0 for the general one */
   }
   CA_RecInputParams;
 
@@ -1521,6 +1529,56 @@ typedef struct
    ************************************************************************
    */
 
+  void CA_DeactivateSyntaxForRecognizer(CA_Syntax *hSyntax,
+                                        CA_Recog *hRecog);
+  /**
+   *
+   * Params       hSyntax valid syntax handle
+   *              hRecog  valid recog handle
+   *
+   * Returns      void
+   *
+   * See          CA_SetupSyntaxForRecognizer
+   *
+   ************************************************************************
+   * Stops decoding one syntax, the other active ones are kept.
+   ************************************************************************
+   */
+
+  int  CA_IsBestResultSyntax(CA_Syntax *hSyntax,
+                             CA_Recog *hRecog);
+  /**
+   *
+   * Params       hSyntax valid syntax handle
+   *              hRecog  valid recog handle
+   *
+   * Returns      1 if the best result of the recognition comes from
+   *              this syntax, otherwise 0
+   *
+   * See          CA_SetupSyntaxForRecognizer
+   *
+   ************************************************************************
+   * With several syntaxes active at once, tells which one the results
+   * belong to.
+   ************************************************************************
+   */
+
+  int  CA_IsEnrollmentRecognition(CA_Recog *hRecog);
+  /**
+   *
+   * Params       hRecog  valid recog handle
+   *
+   * Returns      1 if the best result of the recognition comes from a
+   *              voice enrollment syntax, otherwise 0
+   *
+   * See          CA_IsBestResultSyntax
+   *
+   ************************************************************************
+   * Tells whether the current results are a voice enrollment, before the
+   * n-best list is prepared.
+   ************************************************************************
+   */
+
 
   int  CA_CompileSyntax(CA_Syntax *hSyntax);
   /**
@@ -1603,12 +1661,17 @@ int CA_ArbdataGetModelIdsForPIC(CA_Arbdata* ca_arbdata, const char lphon, const
 void CA_FreeArbdata(CA_Arbdata* arbdata);
 int CA_AddWordToSyntax(CA_Syntax* syntax, const char* slot,
                          const char *phrase, const char* pronunciation, const int weight);
+int CA_AddWordsToSyntax(CA_Syntax* syntax, const char* slot, int num_words,
+                          const char **phrases, const char** pronunciations,
+                          const int* weights, int* results);
 int CA_ResetSyntax(CA_Syntax* syntax);
 int CA_LoadSyntaxAsExtensible(CA_Syntax *hSyntax, char *synbase,
                                 int num_words_to_add);
 int CA_DumpSyntaxAsImage(CA_Syntax *hSyntax, const char *imagename, int version_number);
 int CA_DumpSyntax(CA_Syntax *hSyntax, const char *basename);
 int CA_LoadSyntaxFromImage(CA_Syntax *hSyntax, const LCHAR* filename);
+int CA_DumpSyntaxDelta(CA_Syntax *hSyntax, const char *deltaname);
+int CA_LoadSyntaxDelta(CA_Syntax *hSyntax, const LCHAR* deltaname);
 
 
   /*
@@ -1778,6 +1841,26 @@ int CA_LoadSyntaxFromImage(CA_Syntax *hSyntax, const LCHAR* filename);
    */
 
 
+  void CA_RescoreRecognition(CA_Recog *hRecog,
+                             CA_Pattern *hPattern);
+  /**
+   *
+   * Params       hRecog      valid recog handle
+   *              hPattern    valid pattern handle
+   *
+   * Returns      void
+   *
+   * See          CA_EndRecognition
+   *
+   ************************************************************************
+   * With two-pass decoding, rescores the utterance just ended with the
+   * full acoustic models over the words of the first pass lattice.  Call
+   * after CA_EndRecognition, only for an utterance whose result is wanted,
+   * it does nothing for a single-pass search.
+   ************************************************************************
+   */
+
+
   int CA_DiscardRecognition(CA_Recog *hRecog,
                             CA_Pattern *hPattern,
                             CA_Utterance *hUtterance);
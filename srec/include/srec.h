@@ -34,6 +34,15 @@
 
 #define MAX_HMM 3            /*maximum HMM states in an allophone*/
 #define DO_ALLOW_MULTIPLE_MODELS 1
+#define SILENCE_MODEL_INDEX 0
+#define PRUNE_TIGHTEN 0.9     /*if we run out of room in the state arrays,
+                                keep multiplying pruning thresh by this amount
+                                until there is room */
+#define HISTOGRAM_PRUNE_BINS 64 /* resolution of the histogram pruning */
+
+/* current_model_scores[] marks, before the states are scored */
+#define DO_COMPUTE_MODEL     0
+#define DO_NOT_COMPUTE_MODEL MAXcostdata
 
 /*in order to keep data sizes as small as possible, most of the the structure
   below use indices into one fsmarc_token array and one word_token array.  This
@@ -64,16 +73,19 @@ altword_token;
  */
 typedef struct fsmarc_token_t
 {
+  /* what the viterbi recursion and beam test read every frame comes
+     first, the backtrace payload below is only touched when a path
+     moves into the next state */
   frameID num_hmm_states;           /* number of hmm states */
   costdata cost[MAX_HMM];           /* cost so far*/
-  wtokenID word_backtrace[MAX_HMM]; /* index into word tokens*/
-  wordID word[MAX_HMM];             /* when the path encounters an output
-             symbol, store it here*/
   frameID duration[MAX_HMM];        /* frames observed for this hmm state, todo: pack into char! */
   arcID FSMarc_index;               /* index into the FSM arc array */
 
   stokenID next_token_index;        /* for maintaining linked lists of these
              tokens, both in search and in freelist */
+  wtokenID word_backtrace[MAX_HMM]; /* index into word tokens*/
+  wordID word[MAX_HMM];             /* when the path encounters an output
+             symbol, store it here*/
   altword_token* aword_backtrace[MAX_HMM];
 }
 fsmarc_token;
@@ -113,10 +125,15 @@ typedef struct word_token_t
      (ie 32767 frames * 20ms/frame = 655 sec), we use the high-bit to store
 	 whether this word_token represents a homonym, this is used in confidence
 	 score fixing! */
-#define WORD_TOKEN_GET_HOMONYM(wT)     (wT->_word_end_time & 0x8000)  // 10000000
-#define WORD_TOKEN_SET_HOMONYM(wT,hM)  (wT->_word_end_time = (wT->_word_end_time&0x7fff)|(hM?0x8000:0))
-#define WORD_TOKEN_GET_WD_ETIME(wT)    (wT->_word_end_time & 0x7fff) // 01111111
-#define WORD_TOKEN_SET_WD_ETIME(wT,eT) (wT->_word_end_time = (wT->_word_end_time&0x8000)|(eT))
+#if SREC_WIDE_IDS
+#define WORD_TOKEN_HOMONYM_BIT 0x80000000u
+#else
+#define WORD_TOKEN_HOMONYM_BIT 0x8000
+#endif
+#define WORD_TOKEN_GET_HOMONYM(wT)     (wT->_word_end_time & WORD_TOKEN_HOMONYM_BIT)  // 10000000
+#define WORD_TOKEN_SET_HOMONYM(wT,hM)  (wT->_word_end_time = (frameID)((wT->_word_end_time&~WORD_TOKEN_HOMONYM_BIT)|(hM?WORD_TOKEN_HOMONYM_BIT:0)))
+#define WORD_TOKEN_GET_WD_ETIME(wT)    ((frameID)(wT->_word_end_time & ~WORD_TOKEN_HOMONYM_BIT)) // 01111111
+#define WORD_TOKEN_SET_WD_ETIME(wT,eT) (wT->_word_end_time = (frameID)((wT->_word_end_time&WORD_TOKEN_HOMONYM_BIT)|(eT)))
 }
 word_token;
 /* 12 bytes */
@@ -155,6 +172,144 @@ priority_q;
  *                                                                  *
  *------------------------------------------------------------------*/
 
+/* best_token_for_arc[] and best_token_for_node[] are reset every frame.
+   Rather than sweep the whole grammar, a reset bumps the epoch, and an
+   entry is only valid if its stamp matches the current epoch.  Setting
+   an entry to MAXstokenID/MAXftokenID needs no stamp, a stale entry
+   reads as that anyway. */
+typedef asr_uint16_t tokenepoch;
+#define MAXtokenepoch 65535
+
+#define BEST_TOKEN_FOR_ARC(rEc, aRc) \
+  ((rEc)->best_token_for_arc_stamp[aRc] == *(rEc)->best_token_for_arc_epoch ? \
+   (rEc)->best_token_for_arc[aRc] : MAXstokenID)
+#define SET_BEST_TOKEN_FOR_ARC(rEc, aRc, tOk) \
+  ((rEc)->best_token_for_arc_stamp[aRc] = *(rEc)->best_token_for_arc_epoch, \
+   (rEc)->best_token_for_arc[aRc] = (tOk))
+#define BEST_TOKEN_FOR_NODE(rEc, nOd) \
+  ((rEc)->best_token_for_node_stamp[nOd] == *(rEc)->best_token_for_node_epoch ? \
+   (rEc)->best_token_for_node[nOd] : MAXftokenID)
+#define SET_BEST_TOKEN_FOR_NODE(rEc, nOd, tOk) \
+  ((rEc)->best_token_for_node_stamp[nOd] = *(rEc)->best_token_for_node_epoch, \
+   (rEc)->best_token_for_node[nOd] = (tOk))
+
+/* state scores of the current frame, shared by the searches of a
+   multi_srec that use the same acoustic models.  The key is the models,
+   the frame and the pdfs scored per state, a score is valid when its
+   stamp matches the epoch, which is bumped when the key changes */
+typedef struct
+{
+  const void *model;       /* key: the SWIModel */
+  frameID frame;           /* key: current_search_frame */
+  asr_int16_t max_pdfs;    /* key: score_max_pdfs */
+  tokenepoch epoch;
+  tokenepoch *stamp;       /* size max_model_states */
+  costdata *score;         /* size max_model_states */
+  modelID *miss_list;      /* size max_model_states, the states not in the cache */
+}
+srec_score_cache;
+
+/* voice enrollment search.  An enrollment grammar is a loop of phoneme
+   hmms, small and fixed once compiled, so it is flattened once into the
+   compact graph below, shared by all searches on the grammar.  Node ids
+   are those of the context, the hmm arcs and the epsilon arcs leaving a
+   node are contiguous, and the hmm arcs carry their state indices.  The
+   nodes with epsilon arcs are kept in topological order, so that one
+   pass over them per frame does all the epsilon updates */
+
+typedef struct srec_enroll_hmm_arc_t
+{
+  nodeID to_node;
+  wordID olabel;
+  costdata cost;
+  asr_int16_t num_states;
+  modelID state_indices[MAX_HMM];
+}
+srec_enroll_hmm_arc;
+
+typedef struct srec_enroll_eps_arc_t
+{
+  nodeID to_node;
+  labelID ilabel;           /* EPSILON_LABEL or WORD_BOUNDARY */
+  wordID olabel;
+  costdata cost;
+}
+srec_enroll_eps_arc;
+
+typedef struct srec_enroll_graph_t
+{
+  const HMMInfo* hmm_info_for_ilabel; /* the states were taken from these */
+  nodeID num_nodes;
+  arcID* first_hmm_arc;       /* size num_nodes+1 */
+  srec_enroll_hmm_arc* hmm_arcs;
+  arcID num_hmm_arcs;
+  arcID* first_eps_arc;       /* size num_nodes+1 */
+  srec_enroll_eps_arc* eps_arcs;
+  nodeID* eps_order;          /* nodes with epsilon arcs, in topological order */
+  nodeID num_eps_order;
+}
+srec_enroll_graph;
+
+/* the words ended along the paths of the enrollment search, only the
+   best path ever makes it to the word lattice, see srec_enroll.c */
+typedef struct srec_enroll_word_t
+{
+  wordID word;
+  frameID end_time;
+  frameID word_end_time;      /* excl trailing silence */
+  nodeID end_node;
+  costdata cost;
+  asr_int32_t backtrace;      /* index into words, -1 for none */
+  asr_int16_t kept;           /* survived the word queue of its frame */
+}
+srec_enroll_word;
+
+typedef struct srec_enroll_arc_token_t
+{
+  costdata cost[MAX_HMM];
+  frameID duration[MAX_HMM];
+  wordID word[MAX_HMM];
+  asr_int32_t word_backtrace[MAX_HMM];
+  arcID next_active;
+  asr_int16_t active;
+}
+srec_enroll_arc_token;
+
+typedef struct srec_enroll_node_token_t
+{
+  costdata cost;
+  wordID word;
+  frameID silence_duration;
+  asr_int32_t word_backtrace;
+  nodeID next_active;
+  asr_int16_t active;
+}
+srec_enroll_node_token;
+
+typedef struct srec_enroll_search_t
+{
+  srec_enroll_graph* graph;   /* non-owning ptr, NULL when the general search runs */
+  srec_enroll_arc_token* arc_tokens;   /* one per hmm arc of the graph */
+  arcID arc_tokens_size;
+  srec_enroll_node_token* node_tokens; /* one per node of the graph */
+  nodeID node_tokens_size;
+  arcID active_arcs;          /* head of the active list, MAXarcID if empty */
+  arcID num_active_arcs;
+  nodeID active_nodes;        /* head of the active list, MAXnodeID if empty */
+  nodeID num_active_nodes;
+  nodeID best_node[NODE_INFO_NUMS];    /* per node class, as current_best_ftoken_index[] */
+  srec_enroll_word* words;
+  asr_int32_t num_words;
+  asr_int32_t max_words;
+  asr_int32_t* queue;         /* the words of this frame, worst first, as the word_priority_q */
+  asr_int16_t num_in_queue;
+  asr_int16_t max_in_queue;
+  costdata queue_threshold;
+}
+srec_enroll_search;
+
+#define SREC_ENROLL_ACTIVE(rEc) ((rEc)->enroll != NULL && (rEc)->enroll->graph != NULL)
+
 /* notes ... what needs to be acoustic model specific
 
    (p)ool it
@@ -193,6 +348,7 @@ priority_q;
 struct srec_t
 {  /*contains everything needed to run the search*/
   asr_int16_t id;                   /*contains an id for this recognizer*/
+  asr_int16_t swimodel_index;       /*which of the multi_srec acoustic models this search uses*/
   srec_context *context;      /*contains the recognition context (fst, info about models, etc)*/
   priority_q *word_priority_q; /*used to keep track of new word in frame*/
   srec_word_lattice *word_lattice;  /*used to keep track of word lattice in utterance*/
@@ -203,17 +359,47 @@ struct srec_t
 
   frameID current_search_frame;
   stokenID *best_token_for_arc;  /* non-owning ptr, see multi_srec below */
+  tokenepoch *best_token_for_arc_stamp;  /* non-owning ptr, see multi_srec below */
+  tokenepoch *best_token_for_arc_epoch;  /* non-owning ptr, see multi_srec below */
 
   stokenID active_fsmarc_tokens; /*head of list of state tokens for the next frame.  Used during
         the search to keep track of new states for new frame.  This
         is to allow us to efficently do things like prune, free state arrays, etc*/
+  stokenID *active_fsmarc_token_list; /* the same list packed into an array (size
+        fsmarc_token_array_size), rebuilt each frame for the hmm update */
 
 
   nodeID num_new_states;
   nodeID max_new_states;  /*the num allocated in the new_states array - if the search is exceeding this,
          we need to tighten the pruning*/
+  stokenID max_active_hmm_tokens; /* histogram pruning keeps at most this many tokens alive
+         at the end of a frame, 0 to disable */
+
+  costdata phone_lookahead_margin; /* arcs whose phoneme scores worse than the beam plus
+         this margin are not entered, 0 to disable */
+  srec_arbdata *lookahead_allotree;      /* the arbdata the tables below were built from */
+  asr_int16_t lookahead_num_phonemes;
+  asr_int16_t *lookahead_phoneme_for_hmm; /* phoneme of each hmm, -1 if none */
+  modelID *lookahead_state_for_phoneme;   /* the state scored for each phoneme */
+  costdata *lookahead_penalty;            /* per phoneme, cost behind the best phoneme */
+
+  asr_int16_t score_max_pdfs;    /* pdfs scored per state in this pass, 0 for all */
+  struct score_pool_t *score_pool; /* non-owning ptr, see multi_srec below */
+  modelID *needed_model_list;    /* size num_model_slots_allocated, the states
+         to score this frame, each once, handed to the score_pool */
+  asr_int32_t num_needed_models;
+  srec_score_cache *score_cache; /* non-owning ptr, see multi_srec below, NULL
+         unless another search uses the same models */
+  frameID first_pass_num_frames; /* while rescoring, the frames of the first pass, else 0 */
+  asr_int32_t *first_pass_word_start; /* size max_frames+1, per start frame index into the below */
+  wordID *first_pass_words;      /* size word_token_array_size, the words the first pass
+         left in its lattice, by start frame, a rescored word must start and
+         end near one of these */
+  frameID *first_pass_word_end;  /* size word_token_array_size, end frame of the above */
 
   ftokenID *best_token_for_node;   /* non-owning ptr, see multi_srec below */
+  tokenepoch *best_token_for_node_stamp;  /* non-owning ptr, see multi_srec below */
+  tokenepoch *best_token_for_node_epoch;  /* non-owning ptr, see multi_srec below */
 
   ftokenID active_fsmnode_tokens;  /* linked list of all fsmnode token (same as ones in
            best_state_for_node, just kept as a list)*/
@@ -226,7 +412,10 @@ struct srec_t
   /*the following arrays handle all the state and word tokens.  All of them
     are allocated to a fixed size at startup time, and the search uses elements
     from the first array in the search.  The pruning of the search is used to
-    make sure that the allocated number is not exceeded*/
+    make sure that the allocated number is not exceeded.  The freelists are
+    built in chunks as the search needs them (see srec_tokens.c); the
+    *_linked counts say how much of each array has been put on them in the
+    current utterance*/
 
 
   fsmarc_token *fsmarc_token_array;  /*used for storage of all state tokens
@@ -236,6 +425,7 @@ struct srec_t
            exceeded*/
   stokenID fsmarc_token_array_size; /*total number of tokens allocated in this array*/
   stokenID fsmarc_token_freelist;   /*index to head of state token freelist*/
+  stokenID fsmarc_token_array_linked; /*tokens put on the freelist so far*/
 
   fsmnode_token *fsmnode_token_array;  /*used for storage of all fsmnode tokens
            - allocated once at startup time and kept
@@ -244,6 +434,7 @@ struct srec_t
            exceeded*/
   ftokenID fsmnode_token_array_size; /*total number of tokens allocated in this array*/
   ftokenID fsmnode_token_freelist;   /*index to head of fsmnode token freelist*/
+  ftokenID fsmnode_token_array_linked; /*tokens put on the freelist so far*/
 
   word_token *word_token_array;    /* used for storage of all word tokens -
             allocated once at startup time and kept
@@ -254,11 +445,13 @@ struct srec_t
   wtokenID word_token_array_size;  /* total number of tokens allocated in
             this array*/
   wtokenID word_token_freelist;    /* index to head of word token freelist*/
+  wtokenID word_token_array_linked; /*tokens put on the freelist so far*/
 
   altword_token* altword_token_array; /* used to store alternative words before a wb */
   wtokenID altword_token_array_size;
   altword_token* altword_token_freelist;
-  wtokenID altword_token_freelist_len;
+  wtokenID altword_token_freelist_len;    /* free tokens, linked or not */
+  wtokenID altword_token_array_linked;
 
   frameID max_frames;
   costdata* best_model_cost_for_frame;
@@ -280,10 +473,19 @@ struct srec_t
   const featdata* avg_state_durations;  /* average state durations (from AMs) */
 
   srec_eos_detector_state eosd_state;
+
+  asr_int16_t enrollment_search;  /* run voice enrollment grammars on the search of srec_enroll.c */
+  srec_enroll_search* enroll;     /* allocated on the first enrollment */
 };
 
 #define MAX_RECOGNIZERS 2          /* generally, 1x for each acoustic model */
+
+/* multi_srec.search_pass */
+#define SEARCH_PASS_SINGLE  0
+#define SEARCH_PASS_FIRST   1      /* fast pass of two-pass decoding */
+#define SEARCH_PASS_RESCORE 2      /* full model, over the frames of the first pass */
 #define MAX_ACOUSTIC_MODELS 2
+#define MAX_ACTIVE_GRAMMARS 4
 
 /**
  * @todo document
@@ -293,7 +495,7 @@ typedef struct
   asr_int32_t num_allocated_recs;
   asr_int32_t num_activated_recs;
   srec* rec;                       /* size num_allocated_recs, one for
-            each gender */
+            each gender and active grammar */
 
   frameID max_frames;
   costdata* cost_offset_for_frame; /* size max_frames, keeps track of
@@ -304,14 +506,46 @@ typedef struct
 
   ftokenID *best_token_for_node;  /* array (size max_fsm_nodes) best path into
            fsmnode - kept as an fsmnode_token */
+  tokenepoch *best_token_for_node_stamp; /* array (size max_fsm_nodes), epoch
+           in which best_token_for_node[] was set */
+  tokenepoch best_token_for_node_epoch;
   nodeID max_fsm_nodes;
   stokenID *best_token_for_arc;   /* array (size max_fsm_arcs) best path into
            fsmarc - kept as a fsmarc_token */
+  tokenepoch *best_token_for_arc_stamp; /* array (size max_fsm_arcs) */
+  tokenepoch best_token_for_arc_epoch;
   arcID max_fsm_arcs;
 
+  costdata base_prune_delta;      /* viterbi_prune_thresh, rec[i].prune_delta is
+           narrowed from this to meet frame_budget_usec */
+  asr_int32_t frame_budget_usec;  /* search time target per frame, 0 disables */
+  asr_int32_t avg_frame_usec;     /* smoothed search time per frame */
+  costdata pass_prune_delta;      /* beam of the current pass, base_prune_delta
+           widened for the first pass of two-pass decoding */
+
+  /* two-pass decoding: the first pass scores only first_pass_pdfs pdfs per
+     state under a wider beam, and keeps the features; the rescoring pass
+     replays them with the full models, constrained to the first lattice */
+  struct score_pool_t *score_pool; /* threads to score large frames on, NULL
+           for single-threaded scoring */
+  srec_score_cache score_cache;   /* allocated if there is more than one search */
+
+  asr_int16_t first_pass_pdfs;    /* 0 for a single pass */
+  asr_int16_t search_pass;        /* SEARCH_PASS_* */
+  int begin_syn_node;
+  imeldata *first_pass_frames;    /* size max_frames * first_pass_frame_dim */
+  asr_int32_t first_pass_frame_dim;
+  frameID num_first_pass_frames;
+
   /* non owning pointer to compact acoustic models */
   asr_int32_t num_swimodels;
   const SWIModel    *swimodel[MAX_ACOUSTIC_MODELS];
+
+  /* non owning pointers to the grammars decoded at once, rec[] runs
+     grammar by grammar, one search per acoustic model */
+  asr_int32_t max_grammars;
+  asr_int32_t num_grammars;
+  srec_context *grammar[MAX_ACTIVE_GRAMMARS];
   EOSrc eos_status;
 }
 multi_srec;
@@ -329,11 +563,26 @@ extern "C"
   costdata get_priority_q_threshold(priority_q *pq, word_token *word_token_array);
 
   void free_word_token(srec *rec, wtokenID old_token_index);
+  void reset_best_token_for_arcs(srec *rec);
+  void reset_best_token_for_nodes(srec *rec);
+  void srec_free_phone_lookahead(srec *rec);
   int srec_begin(srec* rec, int begin_syn_node);
+  void srec_keep_first_pass_words(srec* rec);
   void srec_no_more_frames(srec* rec);
   bigcostdata accumulated_cost_offset(costdata *cost_offsets, frameID frame);
   void multi_srec_get_speech_bounds(multi_srec* rec, frameID* start_frame, frameID* end_frame);
   int multi_srec_get_eos_status(multi_srec* rec);
+
+  /* voice enrollment search, srec_enroll.c */
+  int srec_enroll_begin(srec* rec);
+  void srec_enroll_find_models(srec* rec, const SWIModel* acoustic_models);
+  void srec_enroll_viterbi_part1(srec* rec, costdata* current_model_scores);
+  void srec_enroll_reset_best_cost_to_zero(srec* rec, costdata current_best_cost);
+  void srec_enroll_viterbi_part2(srec* rec);
+  void srec_enroll_no_more_frames(srec* rec);
+  void srec_enroll_terminate(srec* rec);
+  void srec_enroll_get_eos_state(srec* rec, srec_eos_search_state* state);
+  void srec_enroll_free(srec* rec);
 #ifdef __cplusplus
 }
 #endif
@@ -31,7 +31,19 @@
 
 #define CONTEXT_FILE_FORMAT_VERSION1_ID 10001
 #define IMAGE_FORMAT_V1   32432
-#define IMAGE_FORMAT_V2   32439
+/* V2 and delta images store the ids at the width of the build, see
+   SREC_WIDE_IDS in srec_sizes.h, a build only loads its own width */
+#define IMAGE_FORMAT_V2_NARROW    32439
+#define IMAGE_FORMAT_V2_WIDE      32443
+#define IMAGE_FORMAT_DELTA_NARROW 32441 /* words, arcs and nodes added to a V2 image */
+#define IMAGE_FORMAT_DELTA_WIDE   32445
+#if SREC_WIDE_IDS
+#define IMAGE_FORMAT_V2    IMAGE_FORMAT_V2_WIDE
+#define IMAGE_FORMAT_DELTA IMAGE_FORMAT_DELTA_WIDE
+#else
+#define IMAGE_FORMAT_V2    IMAGE_FORMAT_V2_NARROW
+#define IMAGE_FORMAT_DELTA IMAGE_FORMAT_DELTA_NARROW
+#endif
 #define USE_HMM_BASED_ENROLLMENT 0
 
 /*********************************************************************
@@ -157,6 +169,15 @@ typedef struct srec_context
   /* says whether a grammar has been prepared FST_Prepare()
      a Grammar must be prepared before it is used in a recognition */
   asr_int16_t whether_prepared;
+
+  /* FST_IsVoiceEnrollment() answer, valid once voice_enrollment_known
+     is set; the search asks on every frame */
+  asr_int16_t voice_enrollment_known;
+  asr_int16_t is_voice_enrollment;
+
+  /* compact copy of an enrollment grammar for the enrollment search, built
+     on first use and dropped when the graph changes, see srec_enroll.c */
+  struct srec_enroll_graph_t* enroll_graph;
 }
 srec_context;
 
@@ -195,6 +216,13 @@ extern "C"
                            const char* slot,
                            const char* word,
                            const char* pron, const int cost);
+  /* adds many words to one slot, the slot lookup and the growth of the
+     arc and node pools are done once for the batch, per word return codes
+     (as from FST_AddWordToGrammar) are written to results if not NULL */
+  int FST_AddWordsToGrammar(srec_context* fst,
+                            const char* slot, int num_words,
+                            const char** words, const char** prons,
+                            const int* costs, int* results);
   int FST_ResetGrammar(srec_context* fst);
   
   int FST_PrepareContext(srec_context* fst);
@@ -213,6 +241,11 @@ extern "C"
 #endif
   int FST_DumpContextAsImageV2(srec_context* context, PFile* fp);
   int FST_LoadContextFromImage(srec_context** pcontext, PFile* fp);
+  /* saves only what was added since the base image, ie. the words beyond
+     num_base_words and the arcs and nodes beyond num_base_arcs/nodes;
+     loading replays them onto a context holding the same base image */
+  int FST_DumpContextDelta(srec_context* context, PFile* fp);
+  int FST_LoadContextDelta(srec_context* context, PFile* fp);
   
   int FST_CheckPath(srec_context* context, const char* transcription,
                     char* literal, size_t max_literal_len);
@@ -237,6 +270,7 @@ extern "C"
   ESR_ReturnCode deserializeWordMapV2(wordmap **pwordmap, PFile* fp);
   ESR_ReturnCode serializeWordMapV2(wordmap *wordmap, PFile* fp);
   int FST_GetGrammarType(srec_context* context);
+  void srec_enroll_graph_free(srec_context* context);
   
 #ifdef __cplusplus
 }
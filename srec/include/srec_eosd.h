@@ -47,6 +47,23 @@ typedef struct srec_eos_detector_state_t
 }
 srec_eos_detector_state;
 
+/* what the end of speech decision looks at, the best paths at the end
+   node, at an optional end node and at a regular node after this frame */
+typedef struct srec_eos_search_state_t
+{
+  asr_int16_t end_valid;
+  costdata end_cost;
+  asr_int16_t end_has_word;      /* whether the end path has ended a word */
+  frameID end_word_end_time;     /* end_time of that word */
+  asr_int16_t optend_valid;
+  costdata optend_cost;
+  asr_int16_t regular_valid;
+  costdata regular_cost;
+  nodeID regular_node;
+  wordID regular_word;
+}
+srec_eos_search_state;
+
 void srec_eosd_allocate(srec_eos_detector_parms** eosd_parms,
                         int eos_costdelta,
                         int opt_eos_costdelta,
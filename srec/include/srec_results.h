@@ -27,10 +27,24 @@ extern "C"
 {
 #endif
 
+  /* what srec_nbest_get_choice_info() reports for one n-best choice, for
+     all the choices at once; the fields keep their defaults when the path
+     has no leading or trailing silence */
+  typedef struct
+  {
+    asr_int32_t cost;               /* total path cost */
+    asr_int32_t num_speech_frames;  /* default 400 */
+    asr_int32_t speech_frames_cost; /* default 0 */
+    asr_int32_t gsm_cost;           /* default 0 */
+    asr_int32_t num_words;          /* default 0 */
+  }
+  srec_nbest_choice_info;
+
   /* results */
   int srec_has_results(multi_srec* rec);
   int srec_clear_results(multi_srec* rec);
   int srec_get_bestcost_recog_id(multi_srec* rec, int* id);
+  srec_context* srec_get_bestcost_context(multi_srec* rec);
 
   /* nbest */
   void* srec_nbest_prepare_list(multi_srec* rec, int n, asr_int32_t* bestcost);
@@ -44,6 +58,7 @@ extern "C"
   ESR_ReturnCode srec_nbest_get_resultWordIDs(void* nbest, size_t inde, wordID* wordIDs, size_t* len, asr_int32_t* cost);
   void srec_result_strip_slot_markers(char* result);
   int srec_nbest_get_choice_info(void* rec_void, int ibest, asr_int32_t* infoval, char* infoname);
+  int srec_nbest_get_choice_infos(void* rec_void, srec_nbest_choice_info* infos, int max_choices);
   int srec_nbest_remove_result(void* rec_void, int n);
   int srec_nbest_sort(void* rec_void);
 
@@ -23,9 +23,27 @@
 #ifndef _h_srec_sizes_
 #define _h_srec_sizes_
 
+/* SREC_WIDE_IDS builds use 32 bits for the grammar, word, frame and
+   token ids, for graphs, vocabularies and utterances beyond 65535 of
+   each.  Grammar images and lattice dumps are not interchangeable between
+   the two, their formats carry the width (see srec_context.h) */
+#ifndef SREC_WIDE_IDS
+#define SREC_WIDE_IDS 0
+#endif
+
 typedef asr_uint16_t costdata;  /*done as cost, so always >= 0*/
 typedef asr_int32_t bigcostdata;          /*done as cost, so always >= 0*/
 typedef asr_uint16_t miscdata;  /*for random small things*/
+#if SREC_WIDE_IDS
+typedef asr_uint32_t labelID; /*as wide as wordID, since arcs carry word ids in their labels*/
+typedef asr_uint32_t wordID;  /*for word index*/
+typedef asr_uint32_t nodeID;  /*for FSM node index*/
+typedef asr_uint32_t arcID;  /*for FSM arc index*/
+typedef asr_uint32_t frameID;  /*for time frame*/
+typedef asr_uint32_t stokenID;  /*for state token storage*/
+typedef asr_uint32_t ftokenID;  /*for FSMnode token storage*/
+typedef asr_uint32_t wtokenID;  /*for word token storage*/
+#else
 typedef asr_uint16_t labelID; /*16 bits is a bit overkill for this, but 8's not enough*/
 typedef asr_uint16_t wordID;  /*for word index*/
 typedef asr_uint16_t nodeID;  /*for FSM node index*/
@@ -34,7 +52,15 @@ typedef asr_uint16_t frameID;  /*for time frame*/
 typedef asr_uint16_t stokenID;  /*for state token storage*/
 typedef asr_uint16_t ftokenID;  /*for FSMnode token storage*/
 typedef asr_uint16_t wtokenID;  /*for word token storage*/
+#endif
 typedef asr_uint16_t HMMID;  /*for HMMs*/
+
+/*printf and scanf conversion for the id types above, used as "%" ID_FMT*/
+#if SREC_WIDE_IDS
+#define ID_FMT "u"
+#else
+#define ID_FMT "hu"
+#endif
 typedef asr_uint16_t modelID;  /*for models (HMM state distributions)*/
 
 /*limits on each of the above sizes*/
@@ -42,6 +68,16 @@ typedef asr_uint16_t modelID;  /*for models (HMM state distributions)*/
 #define MAXcostdata ((costdata)65535)
 #define MAXbcostdata ((bigcostdata)2147483647)
 #define FREEcostdata 0
+#if SREC_WIDE_IDS
+#define MAXlabelID ((labelID)0xFFFFFFFFu)
+#define MAXwordID ((wordID)0xFFFFFFFFu)
+#define MAXnodeID ((nodeID)0xFFFFFFFFu)
+#define MAXarcID ((arcID)0xFFFFFFFFu)
+#define MAXframeID ((frameID)0xFFFFFFFFu)
+#define MAXstokenID ((stokenID)0xFFFFFFFFu)
+#define MAXftokenID ((ftokenID)0xFFFFFFFFu)
+#define MAXwtokenID ((wtokenID)0xFFFFFFFFu)
+#else
 #define MAXlabelID 65535
 #define MAXwordID 65535
 #define MAXnodeID 65535
@@ -50,6 +86,7 @@ typedef asr_uint16_t modelID;  /*for models (HMM state distributions)*/
 #define MAXstokenID 65535
 #define MAXftokenID 65535
 #define MAXwtokenID 65535
+#endif
 #define MAXmodelID 65535
 #define MAXHMMID 65535
 
@@ -83,6 +83,17 @@ typedef struct
 }
 swicms_norm_info;
 
+/**
+ * The part of the channel normalization that is worth keeping from one
+ * session to the next, see swicms_get_state().
+ */
+typedef struct
+{
+  imeldata cmn[MAX_CHAN_DIM];  /* channel mean, in the space of swicms->cmn */
+  int num_frames_in_cmn;       /* num frames behind cmn */
+}
+swicms_state;
+
 int swicms_init(swicms_norm_info* swicms);
 int swicms_cache_frame(swicms_norm_info* swicms, imeldata* frame, int dimen);
 int apply_channel_normalization_in_swicms(swicms_norm_info *swicms,
@@ -94,6 +105,8 @@ int swicms_update(swicms_norm_info* swicms, int speech_start_frame, int speech_e
 
 ESR_ReturnCode swicms_set_cmn(swicms_norm_info *swicms, const LCHAR *new_cmn_params );
 ESR_ReturnCode swicms_get_cmn(swicms_norm_info *swicms, LCHAR *cmn_params, size_t* len );
+void swicms_get_state(swicms_norm_info *swicms, swicms_state *state);
+void swicms_set_state(swicms_norm_info *swicms, const swicms_state *state);
 
 #if DEBUG_SWICMS
 int swicms_compare(swicms_norm_info* swicms, imeldata* imelda_adjust);
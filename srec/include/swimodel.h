@@ -66,6 +66,7 @@ extern "C"
 const SWIModel *load_swimodel(const char *filename);
 void free_swimodel(const SWIModel* swimodel);
 scodata mixture_diagonal_gaussian_swimodel(const preprocessed *prep, const SWIhmmState *spd, short num_dims);
+scodata mixture_diagonal_gaussian_swimodel_npdfs(const preprocessed *prep, const SWIhmmState *spd, short num_dims, short max_pdfs);
 
 extern const char loop_cost_table [128][6];
 extern const char trans_cost_table [128][6];
@@ -52,6 +52,17 @@ extern "C"
   void lattice_add_word_tokens(srec_word_lattice *wl, frameID frame,
                                wtokenID word_token_list_head);
   costdata lattice_best_cost_to_frame(srec_word_lattice *wl, word_token* word_token_array, frameID ifr);
+
+  /* the lattice dump, ie. what the backward search needs to rerun off-line:
+     header, accumulated cost offsets and word token lists per frame, and
+     all word tokens, see tools/astar_bench.  Token fields are stored at
+     the id width of the build */
+#if SREC_WIDE_IDS
+#define WORD_LATTICE_IMAGE_FORMAT 32451
+#else
+#define WORD_LATTICE_IMAGE_FORMAT 32450
+#endif
+  int srec_dump_word_lattice(srec* rec, PFile* fp);
   
 #if defined(__cplusplus)
 }
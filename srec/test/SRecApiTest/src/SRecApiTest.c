@@ -0,0 +1,236 @@
+/*---------------------------------------------------------------------------*
+ *  SRecApiTest.c  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+/*
+ *	Checks of the batch and persistence APIs that the command scripts of
+ *	SRecTest cannot reach.  Every test prints PASSED or FAILED, and the exit
+ *	status is the number of tests that failed.
+ */
+
+#include "ESR_CommandLine.h"
+#include "ESR_Session.h"
+#include "LCHAR.h"
+#include "plog.h"
+#include "pmemory.h"
+#include "ptypes.h"
+#include "SR_Grammar.h"
+#include "SR_Recognizer.h"
+#include "SR_Session.h"
+#include "SR_Vocabulary.h"
+#include "PStackSize.h"
+
+#include "srec_api_test.h"
+
+typedef int (*SREC_API_TEST_FUNCTION) ( ApiTestData *data );
+
+typedef struct
+    {
+    const LCHAR             *name;
+    SREC_API_TEST_FUNCTION  run;
+    } SREC_API_TEST;
+
+static const SREC_API_TEST srec_api_tests [] =
+    {
+    { L("add_words_to_slot"),    srec_api_test_add_words_to_slot },
+    { L("grammar_delta"),        srec_api_test_grammar_delta },
+    { L("nametags_file"),        srec_api_test_nametags_file },
+    { L("acoustic_state_store"), srec_api_test_acoustic_state_store },
+    { L("nbest_choice_infos"),   srec_api_test_nbest_choice_infos },
+    };
+
+#define NUM_SREC_API_TESTS  ( sizeof ( srec_api_tests ) / sizeof ( srec_api_tests [0] ) )
+
+
+
+int srec_api_test_load_grammar ( ApiTestData *data, const LCHAR *grammar_file, SR_Grammar **grammar )
+    {
+    int             load_status;
+    ESR_ReturnCode  esr_status;
+    LCHAR           path [P_PATH_MAX];
+    size_t          path_length;
+
+    load_status = 0;
+    LSTRCPY ( path, grammar_file );
+    path_length = P_PATH_MAX;
+    esr_status = ESR_SessionPrefixWithBaseDirectory ( path, &path_length );
+
+    if ( esr_status == ESR_SUCCESS )
+        esr_status = SR_GrammarLoad ( path, grammar );
+
+    if ( esr_status == ESR_SUCCESS )
+        {
+        esr_status = SR_GrammarSetupVocabulary ( *grammar, data->vocabulary );
+
+        if ( esr_status == ESR_SUCCESS )
+            esr_status = SR_GrammarSetupRecognizer ( *grammar, data->recognizer );
+
+        if ( esr_status != ESR_SUCCESS )
+            {
+            SR_GrammarDestroy ( *grammar );
+            *grammar = NULL;
+            }
+        }
+
+    if ( esr_status != ESR_SUCCESS )
+        {
+        load_status = -1;
+        LPRINTF ( L("    cannot load %s: %s\n"), grammar_file, ESR_rc2str ( esr_status ) );
+        }
+    return ( load_status );
+    }
+
+
+
+static int srec_api_test_init_session ( ApiTestData *data, int argc, LCHAR *argv [] )
+    {
+    int             init_status;
+    ESR_ReturnCode  esr_status;
+    LCHAR           path [P_PATH_MAX];
+    size_t          len;
+
+    init_status = -1;
+    len = P_PATH_MAX;
+    esr_status = ESR_CommandLineGetValue ( argc, (const char **)argv, L("parfile"), path, &len );
+
+    if ( esr_status == ESR_SUCCESS )
+        {
+        esr_status = SR_SessionCreate ( path );
+
+        if ( esr_status == ESR_SUCCESS )
+            {
+  /* Command-line options always override PAR file options */
+            esr_status = ESR_SessionImportCommandLine ( argc, argv );
+
+            if ( esr_status == ESR_SUCCESS )
+                esr_status = SR_RecognizerCreate ( &data->recognizer );
+
+            if ( esr_status == ESR_SUCCESS )
+                {
+                esr_status = SR_RecognizerSetup ( data->recognizer );
+
+                if ( esr_status == ESR_SUCCESS )
+                    {
+                    len = P_PATH_MAX;
+                    esr_status = ESR_SessionGetLCHAR ( L("cmdline.vocabulary"), path, &len );
+
+                    if ( esr_status == ESR_SUCCESS )
+                        esr_status = SR_VocabularyLoad ( path, &data->vocabulary );
+
+                    if ( esr_status == ESR_SUCCESS )
+                        init_status = 0;
+                    else
+                        SR_RecognizerUnsetup ( data->recognizer );
+                    }
+                if ( init_status != 0 )
+                    {
+                    SR_RecognizerDestroy ( data->recognizer );
+                    data->recognizer = NULL;
+                    }
+                }
+            if ( init_status != 0 )
+                SR_SessionDestroy ( );
+            }
+        if ( init_status != 0 )
+            LPRINTF ( L("Cannot set up the recognizer: %s\n"), ESR_rc2str ( esr_status ) );
+        }
+    else
+        {
+        LPRINTF ( L("Usage: SRecApiTest -parfile <parfile>\n") );
+        }
+    return ( init_status );
+    }
+
+
+
+static void srec_api_test_shutdown_session ( ApiTestData *data )
+    {
+
+    SR_VocabularyDestroy ( data->vocabulary );
+    data->vocabulary = NULL;
+    SR_RecognizerUnsetup ( data->recognizer );
+    SR_RecognizerDestroy ( data->recognizer );
+    data->recognizer = NULL;
+    SR_SessionDestroy ( );
+    }
+
+
+
+static int srec_api_test_run_tests ( ApiTestData *data )
+    {
+    int     num_failed;
+    int     test_status;
+    size_t  test_num;
+
+    num_failed = 0;
+
+    for ( test_num = 0; test_num < NUM_SREC_API_TESTS; test_num++ )
+        {
+        LPRINTF ( L("TEST %s\n"), srec_api_tests [test_num].name );
+        test_status = srec_api_tests [test_num].run ( data );
+
+        if ( test_status == 0 )
+            {
+            LPRINTF ( L("TEST %s: PASSED\n"), srec_api_tests [test_num].name );
+            }
+        else
+            {
+            num_failed++;
+            LPRINTF ( L("TEST %s: FAILED\n"), srec_api_tests [test_num].name );
+            }
+        }
+    LPRINTF ( L("%d of %d tests failed\n"), num_failed, (int)NUM_SREC_API_TESTS );
+
+    return ( num_failed );
+    }
+
+
+
+int main ( int argc, LCHAR *argv [] )
+    {
+    int             num_failed;
+    ESR_ReturnCode  esr_status;
+    PLogger         *logger;
+    ApiTestData     data;
+
+    num_failed = 1;
+    data.recognizer = NULL;
+    data.vocabulary = NULL;
+    esr_status = PMemInit ( );
+
+    if ( esr_status == ESR_SUCCESS )
+        {
+        PSTACK_SIZE_INIT ( );
+        esr_status = PLogCreateFileLogger ( PSTDOUT, &logger );
+
+        if ( esr_status == ESR_SUCCESS )
+            esr_status = PLogInit ( logger, 0 );
+
+        if ( esr_status == ESR_SUCCESS )
+            {
+            if ( srec_api_test_init_session ( &data, argc, argv ) == 0 )
+                {
+                num_failed = srec_api_test_run_tests ( &data );
+                srec_api_test_shutdown_session ( &data );
+                }
+            PLogShutdown ( );
+            }
+        PMemShutdown ( );
+        }
+    return ( num_failed );
+    }
@@ -0,0 +1,71 @@
+/*---------------------------------------------------------------------------*
+ *  srec_api_test.h  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#ifndef __SREC_API_TEST_H
+#define __SREC_API_TEST_H
+
+#include "LCHAR.h"
+#include "plog.h"
+#include "SR_Grammar.h"
+#include "SR_Recognizer.h"
+#include "SR_Vocabulary.h"
+
+/*
+ *	Run from the config directory of a language, e.g. config/en.us, with
+ *	SRecApiTest -parfile baseline11k.par
+ *	The grammars must be compiled first, see tcp/bothtags5.tcp
+ */
+
+#define SREC_API_TEST_GRAMMAR           L("grammars/bothtags5.g2g")
+#define SREC_API_TEST_SLOT              L("@Names")
+
+typedef struct
+    {
+    SR_Recognizer   *recognizer;
+    SR_Vocabulary   *vocabulary;
+    } ApiTestData;
+
+/*
+ *	Marks the test as failed, and says where, when a check does not hold
+ */
+
+#define SREC_API_TEST_CHECK(test_status, condition)                                         \
+    do                                                                                      \
+        {                                                                                   \
+        if ( !( condition ) )                                                               \
+            {                                                                               \
+            LPRINTF ( L("    %s:%d: check failed: %s\n"), __FILE__, __LINE__, #condition ); \
+            test_status = -1;                                                               \
+            }                                                                               \
+        }                                                                                   \
+    while ( 0 )
+
+/*
+ *	All functions return 0 on success, -1 on failure
+ */
+
+int srec_api_test_load_grammar ( ApiTestData *data, const LCHAR *grammar_file, SR_Grammar **grammar );
+
+int srec_api_test_add_words_to_slot ( ApiTestData *data );
+int srec_api_test_grammar_delta ( ApiTestData *data );
+int srec_api_test_nametags_file ( ApiTestData *data );
+int srec_api_test_acoustic_state_store ( ApiTestData *data );
+int srec_api_test_nbest_choice_infos ( ApiTestData *data );
+
+#endif /* __SREC_API_TEST_H */
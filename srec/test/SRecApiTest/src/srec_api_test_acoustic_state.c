@@ -0,0 +1,287 @@
+/*---------------------------------------------------------------------------*
+ *  srec_api_test_acoustic_state.c  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "LCHAR.h"
+#include "plog.h"
+#include "ptypes.h"
+#include "SR_AcousticState.h"
+#include "SR_AcousticStateStore.h"
+
+#include "srec_api_test.h"
+
+#define SREC_API_TEST_STORE_FILE        L("apitest_acoustic_states.bin")
+#define SREC_API_TEST_STORE_TORN_FILE   L("apitest_acoustic_states2.bin")
+#define SREC_API_TEST_STORE_CAPACITY    3
+#define MAX_ACOUSTIC_STATE_LENGTH       512
+#define MAX_STORE_FILE_SIZE             4096
+
+static const LCHAR *srec_api_test_speakers [] =
+    {
+    L("alice"),
+    L("bob"),
+    L("carol"),
+    L("dave"),
+    };
+
+#define NUM_SREC_API_TEST_SPEAKERS  ( sizeof ( srec_api_test_speakers ) / sizeof ( srec_api_test_speakers [0] ) )
+
+enum
+    {
+    ALICE,
+    BOB,
+    CAROL,
+    DAVE
+    };
+
+
+
+/*
+ *	Gives the recognizer a state of its own for every speaker, and keeps it
+ *	as the recognizer reports it, so that it can be compared once restored
+ */
+
+static int srec_api_test_make_states ( ApiTestData *data, LCHAR states [] [MAX_ACOUSTIC_STATE_LENGTH] )
+    {
+    int             make_status;
+    ESR_ReturnCode  esr_status;
+    LCHAR           base_state [MAX_ACOUSTIC_STATE_LENGTH];
+    LCHAR           new_state [MAX_ACOUSTIC_STATE_LENGTH];
+    LCHAR           *value;
+    LCHAR           *end_of_value;
+    size_t          len;
+    size_t          speaker_num;
+    int             new_length;
+
+    make_status = 0;
+    len = MAX_ACOUSTIC_STATE_LENGTH;
+    esr_status = SR_AcousticStateGet ( data->recognizer, base_state, &len );
+
+    for ( speaker_num = 0; ( speaker_num < NUM_SREC_API_TEST_SPEAKERS ) && ( esr_status == ESR_SUCCESS ); speaker_num++ )
+        {
+        new_length = 0;
+        value = base_state;
+
+        while ( *value != L('\0') )
+            {
+            new_length += sprintf ( new_state + new_length, ( value == base_state ) ? "%ld" : ",%ld",
+                                    strtol ( value, &end_of_value, 10 ) + 10 * (long)( speaker_num + 1 ) );
+            value = ( *end_of_value == L(',') ) ? end_of_value + 1 : end_of_value;
+            }
+        esr_status = SR_AcousticStateSet ( data->recognizer, new_state );
+
+        if ( esr_status == ESR_SUCCESS )
+            {
+            len = MAX_ACOUSTIC_STATE_LENGTH;
+            esr_status = SR_AcousticStateGet ( data->recognizer, states [speaker_num], &len );
+            }
+        if ( esr_status == ESR_SUCCESS )
+            esr_status = SR_AcousticStateSet ( data->recognizer, base_state );
+        }
+    if ( esr_status != ESR_SUCCESS )
+        {
+        make_status = -1;
+        LPRINTF ( L("    cannot set acoustic states: %s\n"), ESR_rc2str ( esr_status ) );
+        }
+    return ( make_status );
+    }
+
+
+
+/*
+ *	Returns ESR_TRUE if the store restores the state of the speaker
+ */
+
+static ESR_BOOL srec_api_test_has_state ( ApiTestData *data, SR_AcousticStateStore *store,
+                                          size_t speaker_num, LCHAR states [] [MAX_ACOUSTIC_STATE_LENGTH] )
+    {
+    ESR_ReturnCode  esr_status;
+    LCHAR           state [MAX_ACOUSTIC_STATE_LENGTH];
+    size_t          len;
+
+    esr_status = SR_AcousticStateStoreGet ( store, data->recognizer, srec_api_test_speakers [speaker_num] );
+
+    if ( esr_status == ESR_SUCCESS )
+        {
+        len = MAX_ACOUSTIC_STATE_LENGTH;
+        esr_status = SR_AcousticStateGet ( data->recognizer, state, &len );
+        }
+    return ( ( esr_status == ESR_SUCCESS ) && ( LSTRCMP ( state, states [speaker_num] ) == 0 ) ) ? ESR_TRUE : ESR_FALSE;
+    }
+
+
+
+static ESR_BOOL srec_api_test_is_missing ( ApiTestData *data, SR_AcousticStateStore *store, size_t speaker_num )
+    {
+    ESR_ReturnCode  esr_status;
+
+    esr_status = SR_AcousticStateStoreGet ( store, data->recognizer, srec_api_test_speakers [speaker_num] );
+
+    return ( esr_status == ESR_NO_MATCH_ERROR ) ? ESR_TRUE : ESR_FALSE;
+    }
+
+
+
+static int srec_api_test_put_state ( ApiTestData *data, SR_AcousticStateStore *store,
+                                     size_t speaker_num, LCHAR states [] [MAX_ACOUSTIC_STATE_LENGTH] )
+    {
+    ESR_ReturnCode  esr_status;
+
+    esr_status = SR_AcousticStateSet ( data->recognizer, states [speaker_num] );
+
+    if ( esr_status == ESR_SUCCESS )
+        esr_status = SR_AcousticStateStorePut ( store, data->recognizer, srec_api_test_speakers [speaker_num] );
+
+    return ( esr_status == ESR_SUCCESS ) ? 0 : -1;
+    }
+
+
+
+static size_t srec_api_test_store_size ( SR_AcousticStateStore *store )
+    {
+    size_t  size;
+
+    size = 0;
+    SR_AcousticStateStoreGetSize ( store, &size );
+
+    return ( size );
+    }
+
+
+
+/*
+ *	Copies all but the last bytes of a file, as a crash in the middle of a save
+ *	would leave it
+ */
+
+static int srec_api_test_copy_torn_file ( const LCHAR *file_name, const LCHAR *torn_file_name, size_t num_bytes )
+    {
+    int     copy_status;
+    FILE    *file;
+    char    buffer [MAX_STORE_FILE_SIZE];
+    size_t  size;
+
+    copy_status = -1;
+    file = fopen ( file_name, "rb" );
+
+    if ( file != NULL )
+        {
+        size = fread ( buffer, 1, sizeof ( buffer ), file );
+        fclose ( file );
+
+        if ( ( size > num_bytes ) && ( size < sizeof ( buffer ) ) )
+            {
+            file = fopen ( torn_file_name, "wb" );
+
+            if ( file != NULL )
+                {
+                if ( fwrite ( buffer, 1, size - num_bytes, file ) == size - num_bytes )
+                    copy_status = 0;
+                fclose ( file );
+                }
+            }
+        }
+    return ( copy_status );
+    }
+
+
+
+int srec_api_test_acoustic_state_store ( ApiTestData *data )
+    {
+    int                     test_status;
+    ESR_ReturnCode          esr_status;
+    SR_AcousticStateStore   *store;
+    SR_AcousticStateStore   *small_store;
+    LCHAR                   states [NUM_SREC_API_TEST_SPEAKERS] [MAX_ACOUSTIC_STATE_LENGTH];
+
+    SR_AcousticStateReset ( data->recognizer );
+    test_status = srec_api_test_make_states ( data, states );
+
+    if ( test_status != 0 )
+        return ( test_status );
+
+    esr_status = SR_AcousticStateStoreCreate ( SREC_API_TEST_STORE_CAPACITY, &store );
+
+    if ( esr_status != ESR_SUCCESS )
+        return ( -1 );
+    SREC_API_TEST_CHECK ( test_status, LSTRCMP ( states [ALICE], states [BOB] ) != 0 );
+
+    /* using alice makes bob the least recently used, so dave takes his place */
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_put_state ( data, store, ALICE, states ) == 0 );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_put_state ( data, store, BOB, states ) == 0 );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_put_state ( data, store, CAROL, states ) == 0 );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_has_state ( data, store, ALICE, states ) );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_put_state ( data, store, DAVE, states ) == 0 );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_store_size ( store ) == SREC_API_TEST_STORE_CAPACITY );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_is_missing ( data, store, BOB ) );
+
+    /* from least to most recently used: carol, alice, dave */
+    esr_status = SR_AcousticStateStoreSave ( store, SREC_API_TEST_STORE_FILE );
+    SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+
+    /* a smaller store keeps the most recently used states of the file */
+    esr_status = SR_AcousticStateStoreCreate ( SREC_API_TEST_STORE_CAPACITY - 1, &small_store );
+
+    if ( esr_status == ESR_SUCCESS )
+        {
+        esr_status = SR_AcousticStateStoreLoad ( small_store, SREC_API_TEST_STORE_FILE );
+        SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+        SREC_API_TEST_CHECK ( test_status, srec_api_test_store_size ( small_store ) == SREC_API_TEST_STORE_CAPACITY - 1 );
+        SREC_API_TEST_CHECK ( test_status, srec_api_test_is_missing ( data, small_store, CAROL ) );
+        SREC_API_TEST_CHECK ( test_status, srec_api_test_has_state ( data, small_store, ALICE, states ) );
+        SREC_API_TEST_CHECK ( test_status, srec_api_test_has_state ( data, small_store, DAVE, states ) );
+        SR_AcousticStateStoreDestroy ( small_store );
+        }
+    else
+        {
+        test_status = -1;
+        }
+
+    /* a store loaded in full goes on dropping states in the saved order */
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_put_state ( data, store, BOB, states ) == 0 );
+    esr_status = SR_AcousticStateStoreLoad ( store, SREC_API_TEST_STORE_FILE );
+    SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_store_size ( store ) == SREC_API_TEST_STORE_CAPACITY );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_is_missing ( data, store, BOB ) );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_put_state ( data, store, BOB, states ) == 0 );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_is_missing ( data, store, CAROL ) );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_has_state ( data, store, ALICE, states ) );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_has_state ( data, store, BOB, states ) );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_has_state ( data, store, DAVE, states ) );
+
+    /* a torn file is refused, and the store keeps what it held */
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_copy_torn_file ( SREC_API_TEST_STORE_FILE, SREC_API_TEST_STORE_TORN_FILE, 4 ) == 0 );
+    esr_status = SR_AcousticStateStoreLoad ( store, SREC_API_TEST_STORE_TORN_FILE );
+    SREC_API_TEST_CHECK ( test_status, esr_status == ESR_READ_ERROR );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_store_size ( store ) == SREC_API_TEST_STORE_CAPACITY );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_has_state ( data, store, BOB, states ) );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_is_missing ( data, store, CAROL ) );
+
+    /* so is a file that is not a store */
+    esr_status = SR_AcousticStateStoreLoad ( store, SREC_API_TEST_GRAMMAR );
+    SREC_API_TEST_CHECK ( test_status, esr_status == ESR_INVALID_STATE );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_store_size ( store ) == SREC_API_TEST_STORE_CAPACITY );
+
+    SR_AcousticStateStoreDestroy ( store );
+    SR_AcousticStateReset ( data->recognizer );
+
+    return ( test_status );
+    }
@@ -0,0 +1,176 @@
+/*---------------------------------------------------------------------------*
+ *  srec_api_test_confidence.c  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#include "ESR_Session.h"
+#include "LCHAR.h"
+#include "plog.h"
+#include "pstdio.h"
+#include "ptypes.h"
+#include "SR_Grammar.h"
+#include "SR_Recognizer.h"
+#include "SR_RecognizerResultImpl.h"
+#include "srec_results.h"
+
+#include "srec_api_test.h"
+
+/* "cd player", see tcp/bothtags5.tcp */
+#define SREC_API_TEST_WAVEFORM          L("audio/m252/m252a3fe.nwv")
+#define SREC_API_TEST_RULE              L("trash")
+#define NIST_HEADER_SIZE                1024
+#define AUDIO_BUFFER_SIZE               256
+#define MAX_NBEST_CHOICES               16
+#define MAX_CHOICE_LABEL_LENGTH         256
+
+
+
+/*
+ *	Runs a recognition of a NIST file, and leaves the recognizer started so
+ *	that the result stays valid
+ */
+
+static int srec_api_test_recognize_nist_file ( ApiTestData *data, const LCHAR *waveform, SR_RecognizerResult **result )
+    {
+    int                     recognize_status;
+    ESR_ReturnCode          esr_status;
+    SR_RecognizerStatus     esr_recog_status;
+    SR_RecognizerResultType result_type;
+    LCHAR                   path [P_PATH_MAX];
+    size_t                  path_length;
+    PFile                   *waveform_file;
+    asr_int16_t             audio_buffer [AUDIO_BUFFER_SIZE];
+    size_t                  num_samples_read;
+    ESR_BOOL                hit_eof;
+
+    recognize_status = -1;
+    LSTRCPY ( path, waveform );
+    path_length = P_PATH_MAX;
+    esr_status = ESR_SessionPrefixWithBaseDirectory ( path, &path_length );
+    waveform_file = ( esr_status == ESR_SUCCESS ) ? pfopen ( path, L("rb") ) : NULL;
+
+    if ( waveform_file != NULL )
+        {
+        esr_status = pfseek ( waveform_file, NIST_HEADER_SIZE, SEEK_SET );
+
+        if ( esr_status == ESR_SUCCESS )
+            esr_status = SR_RecognizerStart ( data->recognizer );
+
+        if ( esr_status == ESR_SUCCESS )
+            {
+            esr_recog_status = SR_RECOGNIZER_EVENT_INCOMPLETE;
+            result_type = SR_RECOGNIZER_RESULT_TYPE_INVALID;
+            hit_eof = ESR_FALSE;
+
+            do
+                {
+                num_samples_read = pfread ( audio_buffer, sizeof ( asr_int16_t ), AUDIO_BUFFER_SIZE, waveform_file );
+
+                if ( num_samples_read == 0 )
+                    hit_eof = ESR_TRUE;
+                esr_status = SR_RecognizerPutAudio ( data->recognizer, audio_buffer, &num_samples_read, hit_eof );
+
+                if ( esr_status == ESR_SUCCESS )
+                    {
+                    do
+                        esr_status = SR_RecognizerAdvance ( data->recognizer, &esr_recog_status, &result_type, result );
+                    while ( ( esr_status == ESR_SUCCESS ) && ( esr_recog_status == SR_RECOGNIZER_EVENT_INCOMPLETE ) );
+                    }
+                }
+            while ( ( esr_status == ESR_SUCCESS ) && ( hit_eof == ESR_FALSE ) && ( result_type != SR_RECOGNIZER_RESULT_TYPE_COMPLETE ) );
+
+            while ( ( esr_status == ESR_SUCCESS ) && ( result_type != SR_RECOGNIZER_RESULT_TYPE_COMPLETE ) )
+                esr_status = SR_RecognizerAdvance ( data->recognizer, &esr_recog_status, &result_type, result );
+
+            if ( ( esr_status == ESR_SUCCESS ) && ( esr_recog_status == SR_RECOGNIZER_EVENT_RECOGNITION_RESULT ) )
+                recognize_status = 0;
+            else
+                SR_RecognizerStop ( data->recognizer );
+            }
+        pfclose ( waveform_file );
+        }
+    if ( recognize_status != 0 )
+        LPRINTF ( L("    cannot recognize %s: %s\n"), waveform, ESR_rc2str ( esr_status ) );
+
+    return ( recognize_status );
+    }
+
+
+
+/*
+ *	The features of all the choices at once must be the ones read one
+ *	choice and one feature at a time, the way confidence scoring used to
+ */
+
+int srec_api_test_nbest_choice_infos ( ApiTestData *data )
+    {
+    int                     test_status;
+    ESR_ReturnCode          esr_status;
+    SR_Grammar              *grammar;
+    SR_RecognizerResult     *result;
+    void                    *nbest;
+    srec_nbest_choice_info  infos [MAX_NBEST_CHOICES];
+    char                    label [MAX_CHOICE_LABEL_LENGTH];
+    asr_int32_t             value;
+    int                     num_choices;
+    int                     choice_num;
+
+    test_status = srec_api_test_load_grammar ( data, SREC_API_TEST_GRAMMAR, &grammar );
+
+    if ( test_status == 0 )
+        {
+        esr_status = SR_RecognizerActivateRule ( data->recognizer, grammar, SREC_API_TEST_RULE, 1 );
+        SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+
+        if ( ( esr_status == ESR_SUCCESS ) && ( srec_api_test_recognize_nist_file ( data, SREC_API_TEST_WAVEFORM, &result ) == 0 ) )
+            {
+            nbest = ( (SR_RecognizerResultImpl *)result )->nbestList;
+            num_choices = srec_nbest_get_choice_infos ( nbest, infos, MAX_NBEST_CHOICES );
+            SREC_API_TEST_CHECK ( test_status, num_choices == srec_nbest_get_num_choices ( nbest ) );
+            /* more than one, so that the gsm cost is carried from one choice to the next */
+            SREC_API_TEST_CHECK ( test_status, num_choices > 1 );
+
+            for ( choice_num = 0; choice_num < num_choices; choice_num++ )
+                {
+                value = 0;
+                SREC_API_TEST_CHECK ( test_status, srec_nbest_get_result ( nbest, choice_num, label, MAX_CHOICE_LABEL_LENGTH, &value, 0 ) == 0 );
+                SREC_API_TEST_CHECK ( test_status, infos [choice_num].cost == value );
+                value = 400;
+                srec_nbest_get_choice_info ( nbest, choice_num, &value, "num_speech_frames" );
+                SREC_API_TEST_CHECK ( test_status, infos [choice_num].num_speech_frames == value );
+                value = 0;
+                srec_nbest_get_choice_info ( nbest, choice_num, &value, "speech_frames_cost" );
+                SREC_API_TEST_CHECK ( test_status, infos [choice_num].speech_frames_cost == value );
+                value = 0;
+                srec_nbest_get_choice_info ( nbest, choice_num, &value, "gsm_cost" );
+                SREC_API_TEST_CHECK ( test_status, infos [choice_num].gsm_cost == value );
+                value = 0;
+                srec_nbest_get_choice_info ( nbest, choice_num, &value, "num_words" );
+                SREC_API_TEST_CHECK ( test_status, infos [choice_num].num_words == value );
+                }
+            SR_RecognizerStop ( data->recognizer );
+            }
+        else
+            {
+            test_status = -1;
+            }
+        if ( esr_status == ESR_SUCCESS )
+            SR_RecognizerDeactivateRule ( data->recognizer, grammar, SREC_API_TEST_RULE );
+        SR_GrammarDestroy ( grammar );
+        }
+    return ( test_status );
+    }
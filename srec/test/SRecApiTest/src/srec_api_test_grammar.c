@@ -0,0 +1,241 @@
+/*---------------------------------------------------------------------------*
+ *  srec_api_test_grammar.c  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+
+#include "LCHAR.h"
+#include "plog.h"
+#include "ptypes.h"
+#include "SR_Grammar.h"
+
+#include "srec_api_test.h"
+
+#define MAX_TRANSCRIPTION_LENGTH    128
+#define SREC_API_TEST_DELTA_FILE    L("apitest_delta.bin")
+#define SREC_API_TEST_DELTA_COPY    L("apitest_delta2.bin")
+
+static const LCHAR *srec_api_test_names [] =
+    {
+    L("Jen_Parker"),
+    L("Jennifer_Hernandez"),
+    L("Barb_Baker"),
+    L("Elaine"),
+    L("David"),
+    };
+
+/* from dictionary/cmu6plus.ok, so that the test does not depend on the g2p */
+static const LCHAR *srec_api_test_name_prons [] =
+    {
+    L("jenp)rkP"),
+    L("jen@fPhPnandcz"),
+    L("b)rbbAkP"),
+    L("ElAn"),
+    L("dAv@d"),
+    };
+
+static const LCHAR *srec_api_test_name_tags [] =
+    {
+    L("V='Jen_Parker'"),
+    L("V='Jennifer_Hernandez'"),
+    L("V='Barb_Baker'"),
+    L("V='Elaine'"),
+    L("V='David'"),
+    };
+
+#define NUM_SREC_API_TEST_NAMES ( sizeof ( srec_api_test_names ) / sizeof ( srec_api_test_names [0] ) )
+
+
+
+/*
+ *	Returns ESR_TRUE if "phone delete <name>" is a path of the grammar
+ */
+
+static ESR_BOOL srec_api_test_has_name ( SR_Grammar *grammar, const LCHAR *name )
+    {
+    ESR_ReturnCode  esr_status;
+    LCHAR           transcription [MAX_TRANSCRIPTION_LENGTH];
+    size_t          result_count;
+
+    LSTRCPY ( transcription, L("phone delete ") );
+    LSTRCAT ( transcription, name );
+    result_count = 0;
+    esr_status = SR_GrammarCheckParse ( grammar, transcription, NULL, &result_count );
+
+    return ( ( esr_status == ESR_SUCCESS ) && ( result_count > 0 ) ) ? ESR_TRUE : ESR_FALSE;
+    }
+
+
+
+/*
+ *	Returns ESR_TRUE if both files hold the same bytes
+ */
+
+static ESR_BOOL srec_api_test_same_files ( const LCHAR *file_name1, const LCHAR *file_name2 )
+    {
+    FILE        *file1;
+    FILE        *file2;
+    int         c1;
+    int         c2;
+
+    c1 = c2 = 0;
+    file1 = fopen ( file_name1, "rb" );
+    file2 = fopen ( file_name2, "rb" );
+
+    if ( ( file1 != NULL ) && ( file2 != NULL ) )
+        {
+        do
+            {
+            c1 = fgetc ( file1 );
+            c2 = fgetc ( file2 );
+            }
+        while ( ( c1 == c2 ) && ( c1 != EOF ) );
+        }
+    else
+        {
+        c1 = 1;
+        }
+    if ( file1 != NULL )
+        fclose ( file1 );
+    if ( file2 != NULL )
+        fclose ( file2 );
+
+    return ( c1 == c2 ) ? ESR_TRUE : ESR_FALSE;
+    }
+
+
+
+int srec_api_test_add_words_to_slot ( ApiTestData *data )
+    {
+    int             test_status;
+    ESR_ReturnCode  esr_status;
+    ESR_ReturnCode  results [NUM_SREC_API_TEST_NAMES];
+    SR_Grammar      *grammar;
+    size_t          name_num;
+
+    test_status = srec_api_test_load_grammar ( data, SREC_API_TEST_GRAMMAR, &grammar );
+
+    if ( test_status == 0 )
+        {
+        for ( name_num = 0; name_num < NUM_SREC_API_TEST_NAMES; name_num++ )
+            SREC_API_TEST_CHECK ( test_status, !srec_api_test_has_name ( grammar, srec_api_test_names [name_num] ) );
+
+        /* every word of a batch for a missing slot fails, and none is added */
+        for ( name_num = 0; name_num < NUM_SREC_API_TEST_NAMES; name_num++ )
+            results [name_num] = ESR_SUCCESS;
+        esr_status = SR_GrammarAddWordsToSlot ( grammar, L("@NoSuchSlot"), NUM_SREC_API_TEST_NAMES,
+                                                srec_api_test_names, srec_api_test_name_prons, NULL, srec_api_test_name_tags, results );
+        SREC_API_TEST_CHECK ( test_status, esr_status != ESR_SUCCESS );
+
+        for ( name_num = 0; name_num < NUM_SREC_API_TEST_NAMES; name_num++ )
+            {
+            SREC_API_TEST_CHECK ( test_status, results [name_num] != ESR_SUCCESS );
+            SREC_API_TEST_CHECK ( test_status, !srec_api_test_has_name ( grammar, srec_api_test_names [name_num] ) );
+            }
+
+        /* the same batch for the real slot */
+        esr_status = SR_GrammarAddWordsToSlot ( grammar, SREC_API_TEST_SLOT, NUM_SREC_API_TEST_NAMES,
+                                                srec_api_test_names, srec_api_test_name_prons, NULL, srec_api_test_name_tags, results );
+        SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+
+        if ( esr_status == ESR_SUCCESS )
+            {
+            esr_status = SR_GrammarCompile ( grammar );
+            SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+
+            for ( name_num = 0; name_num < NUM_SREC_API_TEST_NAMES; name_num++ )
+                {
+                SREC_API_TEST_CHECK ( test_status, results [name_num] == ESR_SUCCESS );
+                SREC_API_TEST_CHECK ( test_status, srec_api_test_has_name ( grammar, srec_api_test_names [name_num] ) );
+                }
+            }
+        SR_GrammarDestroy ( grammar );
+        }
+    return ( test_status );
+    }
+
+
+
+int srec_api_test_grammar_delta ( ApiTestData *data )
+    {
+    int             test_status;
+    ESR_ReturnCode  esr_status;
+    SR_Grammar      *grammar;
+    size_t          name_num;
+
+    test_status = srec_api_test_load_grammar ( data, SREC_API_TEST_GRAMMAR, &grammar );
+
+    if ( test_status == 0 )
+        {
+        esr_status = SR_GrammarAddWordsToSlot ( grammar, SREC_API_TEST_SLOT, NUM_SREC_API_TEST_NAMES,
+                                                srec_api_test_names, srec_api_test_name_prons, NULL, srec_api_test_name_tags, NULL );
+        SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+
+        esr_status = SR_GrammarSaveDelta ( grammar, SREC_API_TEST_DELTA_FILE );
+        SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+
+        /* into the same grammar once its slots are reset */
+        esr_status = SR_GrammarResetAllSlots ( grammar );
+        SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+
+        for ( name_num = 0; name_num < NUM_SREC_API_TEST_NAMES; name_num++ )
+            SREC_API_TEST_CHECK ( test_status, !srec_api_test_has_name ( grammar, srec_api_test_names [name_num] ) );
+
+        esr_status = SR_GrammarLoadDelta ( grammar, SREC_API_TEST_DELTA_FILE );
+        SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+
+        for ( name_num = 0; name_num < NUM_SREC_API_TEST_NAMES; name_num++ )
+            SREC_API_TEST_CHECK ( test_status, srec_api_test_has_name ( grammar, srec_api_test_names [name_num] ) );
+
+        /* the words and their semantic tags come back as they were saved */
+        esr_status = SR_GrammarSaveDelta ( grammar, SREC_API_TEST_DELTA_COPY );
+        SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+        SREC_API_TEST_CHECK ( test_status, srec_api_test_same_files ( SREC_API_TEST_DELTA_FILE, SREC_API_TEST_DELTA_COPY ) );
+
+        /* not on top of the words it holds already */
+        esr_status = SR_GrammarLoadDelta ( grammar, SREC_API_TEST_DELTA_FILE );
+        SREC_API_TEST_CHECK ( test_status, esr_status == ESR_READ_ERROR );
+        SR_GrammarDestroy ( grammar );
+        }
+
+    /* into a freshly loaded grammar */
+    if ( srec_api_test_load_grammar ( data, SREC_API_TEST_GRAMMAR, &grammar ) == 0 )
+        {
+        esr_status = SR_GrammarLoadDelta ( grammar, SREC_API_TEST_DELTA_FILE );
+        SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+
+        if ( esr_status == ESR_SUCCESS )
+            {
+            esr_status = SR_GrammarCompile ( grammar );
+            SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+            }
+
+        for ( name_num = 0; name_num < NUM_SREC_API_TEST_NAMES; name_num++ )
+            SREC_API_TEST_CHECK ( test_status, srec_api_test_has_name ( grammar, srec_api_test_names [name_num] ) );
+
+        esr_status = SR_GrammarSaveDelta ( grammar, SREC_API_TEST_DELTA_COPY );
+        SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+        SREC_API_TEST_CHECK ( test_status, srec_api_test_same_files ( SREC_API_TEST_DELTA_FILE, SREC_API_TEST_DELTA_COPY ) );
+        SR_GrammarDestroy ( grammar );
+        }
+    else
+        {
+        test_status = -1;
+        }
+    return ( test_status );
+    }
@@ -0,0 +1,310 @@
+/*---------------------------------------------------------------------------*
+ *  srec_api_test_nametags.c  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "LCHAR.h"
+#include "plog.h"
+#include "ptypes.h"
+#include "SR_Nametag.h"
+#include "SR_Nametags.h"
+
+#include "srec_api_test.h"
+
+#define SREC_API_TEST_NAMETAGS_FILE     L("apitest_nametags.bin")
+#define NUM_SREC_API_TEST_NAMETAGS      20
+#define MAX_NAMETAG_ID_LENGTH           32
+#define MAX_NAMETAG_VALUE_LENGTH        32
+#define MAX_NAMETAGS_FILE_SIZE          4096
+
+/* first word of a nametag file, and what a host of the other byte order reads there */
+#define NAMETAGS_FORMAT_SWAPPED         0x3147544e
+
+
+
+/*
+ *	Adds a nametag whose value is the null-terminated pronunciation given,
+ *	values hold a list of pronunciations ending with a double null
+ */
+
+static int srec_api_test_add_nametag ( SR_Nametags *nametags, const LCHAR *id, const char *pronunciation )
+    {
+    int             add_status;
+    ESR_ReturnCode  esr_status;
+    SR_Nametag      *nametag;
+    char            value [MAX_NAMETAG_VALUE_LENGTH];
+    size_t          len;
+
+    len = strlen ( pronunciation );
+    memcpy ( value, pronunciation, len );
+    value [len] = '\0';
+    value [len + 1] = '\0';
+    esr_status = SR_NametagCreateFromValue ( id, value, len + 2, &nametag );
+
+    if ( esr_status == ESR_SUCCESS )
+        {
+        esr_status = SR_NametagsAdd ( nametags, nametag );
+
+        if ( esr_status != ESR_SUCCESS )
+            SR_NametagDestroy ( nametag );
+        }
+    add_status = ( esr_status == ESR_SUCCESS ) ? 0 : -1;
+
+    return ( add_status );
+    }
+
+
+
+static int srec_api_test_remove_nametag ( SR_Nametags *nametags, const LCHAR *id )
+    {
+    int             remove_status;
+    ESR_ReturnCode  esr_status;
+    SR_Nametag      *nametag;
+
+    esr_status = SR_NametagsGet ( nametags, id, &nametag );
+
+    if ( esr_status == ESR_SUCCESS )
+        {
+        esr_status = SR_NametagsRemove ( nametags, id );
+
+        if ( esr_status == ESR_SUCCESS )
+            SR_NametagDestroy ( nametag );
+        }
+    remove_status = ( esr_status == ESR_SUCCESS ) ? 0 : -1;
+
+    return ( remove_status );
+    }
+
+
+
+/*
+ *	Returns ESR_TRUE if the collection holds the nametag with this pronunciation
+ */
+
+static ESR_BOOL srec_api_test_has_nametag ( SR_Nametags *nametags, const LCHAR *id, const char *pronunciation )
+    {
+    ESR_ReturnCode  esr_status;
+    SR_Nametag      *nametag;
+    const char      *value;
+    size_t          len;
+
+    esr_status = SR_NametagsGet ( nametags, id, &nametag );
+
+    if ( esr_status == ESR_SUCCESS )
+        esr_status = SR_NametagGetValue ( nametag, &value, &len );
+
+    if ( esr_status == ESR_SUCCESS )
+        return ( ( len == strlen ( pronunciation ) + 2 ) && ( strcmp ( value, pronunciation ) == 0 ) ) ? ESR_TRUE : ESR_FALSE;
+    return ( ESR_FALSE );
+    }
+
+
+
+/*
+ *	Loads the file into a new collection, and checks its size
+ */
+
+static int srec_api_test_reload_nametags ( SR_Nametags **nametags, size_t expected_size )
+    {
+    int             test_status;
+    ESR_ReturnCode  esr_status;
+    size_t          size;
+
+    test_status = 0;
+
+    if ( *nametags != NULL )
+        SR_NametagsDestroy ( *nametags );
+    esr_status = SR_NametagsCreate ( nametags );
+
+    if ( esr_status == ESR_SUCCESS )
+        {
+        esr_status = SR_NametagsLoad ( *nametags, SREC_API_TEST_NAMETAGS_FILE );
+        SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+        size = 0;
+        SR_NametagsGetSize ( *nametags, &size );
+        SREC_API_TEST_CHECK ( test_status, size == expected_size );
+        }
+    else
+        {
+        *nametags = NULL;
+        test_status = -1;
+        }
+    return ( test_status );
+    }
+
+
+
+static long srec_api_test_file_size ( const LCHAR *file_name )
+    {
+    FILE    *file;
+    long    size;
+
+    size = -1;
+    file = fopen ( file_name, "rb" );
+
+    if ( file != NULL )
+        {
+        if ( fseek ( file, 0, SEEK_END ) == 0 )
+            size = ftell ( file );
+        fclose ( file );
+        }
+    return ( size );
+    }
+
+
+
+/*
+ *	Cuts the end off the file, as a crash in the middle of an append would
+ */
+
+static int srec_api_test_tear_file ( const LCHAR *file_name, size_t num_bytes )
+    {
+    int     tear_status;
+    FILE    *file;
+    char    buffer [MAX_NAMETAGS_FILE_SIZE];
+    size_t  size;
+
+    tear_status = -1;
+    file = fopen ( file_name, "rb" );
+
+    if ( file != NULL )
+        {
+        size = fread ( buffer, 1, sizeof ( buffer ), file );
+        fclose ( file );
+
+        if ( ( size > num_bytes ) && ( size < sizeof ( buffer ) ) )
+            {
+            file = fopen ( file_name, "wb" );
+
+            if ( file != NULL )
+                {
+                if ( fwrite ( buffer, 1, size - num_bytes, file ) == size - num_bytes )
+                    tear_status = 0;
+                fclose ( file );
+                }
+            }
+        }
+    return ( tear_status );
+    }
+
+
+
+static int srec_api_test_overwrite_word ( const LCHAR *file_name, long offset, asr_uint32_t word )
+    {
+    int     overwrite_status;
+    FILE    *file;
+
+    overwrite_status = -1;
+    file = fopen ( file_name, "r+b" );
+
+    if ( file != NULL )
+        {
+        if ( ( fseek ( file, offset, SEEK_SET ) == 0 ) && ( fwrite ( &word, sizeof ( word ), 1, file ) == 1 ) )
+            overwrite_status = 0;
+        fclose ( file );
+        }
+    return ( overwrite_status );
+    }
+
+
+
+int srec_api_test_nametags_file ( ApiTestData *data )
+    {
+    int             test_status;
+    ESR_ReturnCode  esr_status;
+    SR_Nametags     *nametags;
+    LCHAR           id [MAX_NAMETAG_ID_LENGTH];
+    ESR_BOOL        contains;
+    long            append_offset;
+    int             nametag_num;
+
+    test_status = 0;
+    nametags = NULL;
+    esr_status = SR_NametagsCreate ( &nametags );
+
+    if ( esr_status != ESR_SUCCESS )
+        return ( -1 );
+
+    for ( nametag_num = 0; nametag_num < NUM_SREC_API_TEST_NAMETAGS; nametag_num++ )
+        {
+        LSPRINTF ( id, L("tag%d"), nametag_num );
+        SREC_API_TEST_CHECK ( test_status, srec_api_test_add_nametag ( nametags, id, ( nametag_num % 2 ) ? "abcde" : "xyz" ) == 0 );
+        }
+    esr_status = SR_NametagsSave ( nametags, SREC_API_TEST_NAMETAGS_FILE );
+    SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+
+    /* the changes since the save go at the end of the file */
+    append_offset = srec_api_test_file_size ( SREC_API_TEST_NAMETAGS_FILE );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_add_nametag ( nametags, L("new1"), "qq" ) == 0 );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_remove_nametag ( nametags, L("tag3") ) == 0 );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_add_nametag ( nametags, L("new2"), "zz" ) == 0 );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_remove_nametag ( nametags, L("new2") ) == 0 );
+    esr_status = SR_NametagsAppend ( nametags, SREC_API_TEST_NAMETAGS_FILE );
+    SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_file_size ( SREC_API_TEST_NAMETAGS_FILE ) > append_offset );
+
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_reload_nametags ( &nametags, NUM_SREC_API_TEST_NAMETAGS ) == 0 );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_has_nametag ( nametags, L("tag0"), "xyz" ) );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_has_nametag ( nametags, L("tag1"), "abcde" ) );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_has_nametag ( nametags, L("new1"), "qq" ) );
+    contains = ESR_TRUE;
+    SR_NametagsContains ( nametags, L("tag3"), &contains );
+    SREC_API_TEST_CHECK ( test_status, !contains );
+    contains = ESR_TRUE;
+    SR_NametagsContains ( nametags, L("new2"), &contains );
+    SREC_API_TEST_CHECK ( test_status, !contains );
+
+    /* a torn append is dropped, and the next append goes in its place */
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_add_nametag ( nametags, L("torn"), "ww" ) == 0 );
+    esr_status = SR_NametagsAppend ( nametags, SREC_API_TEST_NAMETAGS_FILE );
+    SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_tear_file ( SREC_API_TEST_NAMETAGS_FILE, 3 ) == 0 );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_reload_nametags ( &nametags, NUM_SREC_API_TEST_NAMETAGS ) == 0 );
+    contains = ESR_TRUE;
+    SR_NametagsContains ( nametags, L("torn"), &contains );
+    SREC_API_TEST_CHECK ( test_status, !contains );
+
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_add_nametag ( nametags, L("after"), "de" ) == 0 );
+    esr_status = SR_NametagsAppend ( nametags, SREC_API_TEST_NAMETAGS_FILE );
+    SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_reload_nametags ( &nametags, NUM_SREC_API_TEST_NAMETAGS + 1 ) == 0 );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_has_nametag ( nametags, L("after"), "de" ) );
+
+    /* so is a change that is neither an addition nor a removal */
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_add_nametag ( nametags, L("garbled"), "ab" ) == 0 );
+    append_offset = srec_api_test_file_size ( SREC_API_TEST_NAMETAGS_FILE );
+    esr_status = SR_NametagsAppend ( nametags, SREC_API_TEST_NAMETAGS_FILE );
+    SREC_API_TEST_CHECK ( test_status, esr_status == ESR_SUCCESS );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_overwrite_word ( SREC_API_TEST_NAMETAGS_FILE, append_offset, 7 ) == 0 );
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_reload_nametags ( &nametags, NUM_SREC_API_TEST_NAMETAGS + 1 ) == 0 );
+    contains = ESR_TRUE;
+    SR_NametagsContains ( nametags, L("garbled"), &contains );
+    SREC_API_TEST_CHECK ( test_status, !contains );
+
+    /* a file of the other byte order is refused */
+    SREC_API_TEST_CHECK ( test_status, srec_api_test_overwrite_word ( SREC_API_TEST_NAMETAGS_FILE, 0, NAMETAGS_FORMAT_SWAPPED ) == 0 );
+    esr_status = SR_NametagsLoad ( nametags, SREC_API_TEST_NAMETAGS_FILE );
+    SREC_API_TEST_CHECK ( test_status, esr_status == ESR_INVALID_STATE );
+
+    if ( nametags != NULL )
+        SR_NametagsDestroy ( nametags );
+
+    return ( test_status );
+    }
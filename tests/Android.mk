@@ -81,6 +81,7 @@ copy_from :=                                       \
     ../config/en.us/run-change-sample-rate2.sh     \
     ../config/en.us/run-liveaudio.sh               \
     ../config/en.us/run-set-get-param.sh           \
+    ../config/en.us/run-apitest.sh                 \
     ../config/en.us/run-chmod.sh                   \
 
 copy_to := $(addprefix $(TARGET_OUT)/usr/srec/config/,$(copy_from))
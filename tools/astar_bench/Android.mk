@@ -0,0 +1,31 @@
+# Copyright 2006 The Android Open Source Project
+
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+# common settings for all ASR builds, exports some variables for sub-makes
+include $(ASR_MAKE_DIR)/Makefile.defs
+
+LOCAL_SRC_FILES:= \
+	astar_bench.c \
+
+LOCAL_C_INCLUDES := \
+	$(ASR_ROOT_DIR)/shared/include \
+	$(ASR_ROOT_DIR)/portable/include \
+	$(ASR_ROOT_DIR)/srec/include \
+	$(ASR_ROOT_DIR)/srec/clib \
+
+LOCAL_CFLAGS += \
+	$(ASR_GLOBAL_DEFINES) \
+	$(ASR_GLOBAL_CPPFLAGS) \
+
+LOCAL_SHARED_LIBRARIES := \
+	libESR_Shared \
+	libESR_Portable \
+	libSR_Core \
+
+LOCAL_MODULE:= astar_bench
+
+LOCAL_32_BIT_ONLY := true
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,228 @@
+/*---------------------------------------------------------------------------*
+ *  astar_bench.c  *
+ *                                                                           *
+ *  Copyright 2007, 2008 Nuance Communciations, Inc.                               *
+ *                                                                           *
+ *  Licensed under the Apache License, Version 2.0 (the 'License');          *
+ *  you may not use this file except in compliance with the License.         *
+ *                                                                           *
+ *  You may obtain a copy of the License at                                  *
+ *      http://www.apache.org/licenses/LICENSE-2.0                           *
+ *                                                                           *
+ *  Unless required by applicable law or agreed to in writing, software      *
+ *  distributed under the License is distributed on an 'AS IS' BASIS,        *
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. *
+ *  See the License for the specific language governing permissions and      *
+ *  limitations under the License.                                           *
+ *                                                                           *
+ *---------------------------------------------------------------------------*/
+
+/* Reruns the A* N-best backward search on word lattices dumped by
+   srec_dump_word_lattice() (see DUMP_ASTAR_LATTICES in astar.c), and
+   reports the N-best costs and the time taken.  There is no grammar
+   attached, so every extension present in the lattice is allowed. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pstdio.h"
+#include "pmemory.h"
+
+#include "srec_sizes.h"
+#include "search_network.h"
+#include "srec.h"
+#include "srec_context.h"
+#include "word_lattice.h"
+#include "astar.h"
+
+#define DEFAULT_NBEST       10
+#define DEFAULT_ITERATIONS 100
+#define MAX_WORDS_AT_FRAME  60 /* size of the word priority_q, as in the recognizer */
+
+typedef struct
+{
+  frameID num_frames;
+  wtokenID num_wtokens;
+  wordID beg_silence_word;
+  bigcostdata* accumulated_cost_offset;
+  wtokenID* words_for_frame;
+  word_token* word_token_array;
+}
+lattice_image;
+
+int usage(char* exename)
+{
+  pfprintf(PSTDOUT, "usage: %s [-nbest n] [-iterations k] [-verbose] file.lat ...\n", exename);
+  pfprintf(PSTDOUT, "file.lat are word lattices dumped with DUMP_ASTAR_LATTICES\n");
+  return 1;
+}
+
+static void free_lattice_image(lattice_image* lat)
+{
+  if (lat->accumulated_cost_offset) FREE(lat->accumulated_cost_offset);
+  if (lat->words_for_frame) FREE(lat->words_for_frame);
+  if (lat->word_token_array) FREE(lat->word_token_array);
+  memset(lat, 0, sizeof(*lat));
+}
+
+static int load_lattice_image(const char* filename, lattice_image* lat)
+{
+  PFile* fp;
+  asr_int32_t header[4];
+  wtokenID tmp[7];
+  word_token* wtoken;
+  wtokenID i;
+
+  memset(lat, 0, sizeof(*lat));
+  fp = pfopen(filename, L("rb"));
+  if (!fp)
+  {
+    pfprintf(PSTDOUT, "error: could not open %s\n", filename);
+    return 1;
+  }
+  if (pfread(header, sizeof(header[0]), 4, fp) != 4 || header[0] != WORD_LATTICE_IMAGE_FORMAT)
+  {
+    pfprintf(PSTDOUT, "error: %s is not a word lattice image\n", filename);
+    goto CLEANUP;
+  }
+  lat->num_frames = (frameID)header[1];
+  lat->num_wtokens = (wtokenID)header[2];
+  lat->beg_silence_word = (wordID)header[3];
+
+  lat->accumulated_cost_offset = NEW_ARRAY(bigcostdata, lat->num_frames, L("astar_bench.costoffsets"));
+  lat->words_for_frame = NEW_ARRAY(wtokenID, lat->num_frames, L("astar_bench.words"));
+  lat->word_token_array = NEW_ARRAY(word_token, lat->num_wtokens, L("astar_bench.wtokens"));
+  if (!lat->accumulated_cost_offset || !lat->words_for_frame || !lat->word_token_array)
+  {
+    pfprintf(PSTDOUT, "error: out of memory loading %s\n", filename);
+    goto CLEANUP;
+  }
+  if (pfread(lat->accumulated_cost_offset, sizeof(bigcostdata), lat->num_frames, fp) != lat->num_frames ||
+      pfread(lat->words_for_frame, sizeof(wtokenID), lat->num_frames, fp) != lat->num_frames)
+    goto READ_ERROR;
+  for (i = 0; i < lat->num_wtokens; i++)
+  {
+    if (pfread(tmp, sizeof(tmp[0]), 7, fp) != 7)
+      goto READ_ERROR;
+    wtoken = &lat->word_token_array[i];
+    wtoken->word = tmp[0];
+    wtoken->end_time = tmp[1];
+    wtoken->end_node = tmp[2];
+    wtoken->backtrace = tmp[3];
+    wtoken->cost = tmp[4];
+    wtoken->next_token_index = tmp[5];
+    wtoken->_word_end_time = tmp[6];
+  }
+  pfclose(fp);
+  return 0;
+
+READ_ERROR:
+  pfprintf(PSTDOUT, "error: %s is truncated\n", filename);
+CLEANUP:
+  pfclose(fp);
+  free_lattice_image(lat);
+  return 1;
+}
+
+/* the search re-sorts the lattice in place, so every run starts over
+   from the image */
+static void reset_rec_from_image(srec* rec, lattice_image* lat)
+{
+  memcpy(rec->word_token_array, lat->word_token_array, lat->num_wtokens * sizeof(word_token));
+  memcpy(rec->word_lattice->words_for_frame, lat->words_for_frame, lat->num_frames * sizeof(wtokenID));
+  memset(rec->word_lattice->whether_sorted, 0, rec->word_lattice->max_frames * sizeof(asr_int16_t));
+}
+
+static int bench_lattice(const char* filename, int nbest, int iterations, int verbose)
+{
+  lattice_image lat;
+  srec rec;
+  srec_context context;
+  AstarStack* stack;
+  clock_t elapsed = 0, start;
+  int i, rc = 0;
+
+  if (load_lattice_image(filename, &lat))
+    return 1;
+
+  memset(&rec, 0, sizeof(rec));
+  memset(&context, 0, sizeof(context));
+  context.beg_silence_word = lat.beg_silence_word;
+  context.arc_token_list = NULL; /* no grammar constraints */
+  rec.context = &context;
+  rec.current_search_frame = (frameID)(lat.num_frames - 1);
+  rec.accumulated_cost_offset = lat.accumulated_cost_offset;
+  rec.word_token_array_size = lat.num_wtokens;
+  rec.word_token_array = NEW_ARRAY(word_token, lat.num_wtokens, L("astar_bench.rec.wtokens"));
+  rec.word_lattice = allocate_word_lattice((frameID)(lat.num_frames + 1));
+  rec.word_priority_q = allocate_priority_q(MAX_WORDS_AT_FRAME);
+  rec.astar_stack = stack = astar_stack_make(&rec, nbest);
+  if (!rec.word_token_array || !rec.word_lattice || !rec.word_priority_q || !stack)
+  {
+    pfprintf(PSTDOUT, "error: out of memory\n");
+    rc = 1;
+    goto CLEANUP;
+  }
+
+  for (i = 0; i < iterations; i++)
+  {
+    reset_rec_from_image(&rec, &lat);
+    start = clock();
+    if (astar_stack_prepare(stack, nbest, &rec) == 0)
+      astar_stack_do_backwards_search(&rec, nbest);
+    elapsed += clock() - start;
+    if (i < iterations - 1)
+      astar_stack_clear(stack);
+  }
+
+  pfprintf(PSTDOUT, "%s frames %d wtokens %d nbest %d choices %d usec/search %d\n",
+           filename, lat.num_frames, lat.num_wtokens, nbest, stack->num_complete_paths,
+           (int)((double)elapsed * 1000000 / CLOCKS_PER_SEC / iterations));
+  if (verbose)
+  {
+    for (i = 0; i < stack->num_complete_paths; i++)
+    {
+      partial_path* parp = stack->complete_paths[i];
+      pfprintf(PSTDOUT, "%.3d cost %d words", i, parp->costsofar);
+      for (; parp && parp->token_index != MAXwtokenID; parp = parp->next)
+        pfprintf(PSTDOUT, " %d", rec.word_token_array[parp->token_index].word);
+      pfprintf(PSTDOUT, "\n");
+    }
+  }
+  astar_stack_clear(stack);
+
+CLEANUP:
+  if (rec.astar_stack) astar_stack_destroy(&rec);
+  if (rec.word_priority_q) free_priority_q(rec.word_priority_q);
+  if (rec.word_lattice) destroy_word_lattice(rec.word_lattice);
+  if (rec.word_token_array) FREE(rec.word_token_array);
+  free_lattice_image(&lat);
+  return rc;
+}
+
+int main(int argc, char* argv[])
+{
+  int i, nbest = DEFAULT_NBEST, iterations = DEFAULT_ITERATIONS, verbose = 0;
+  int num_files = 0, rc = 0;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "-nbest") && i + 1 < argc)
+      nbest = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-iterations") && i + 1 < argc)
+      iterations = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-verbose"))
+      verbose = 1;
+    else if (argv[i][0] == '-')
+      return usage(argv[0]);
+    else
+    {
+      rc |= bench_lattice(argv[i], nbest, iterations > 0 ? iterations : 1, verbose);
+      num_files++;
+    }
+  }
+  if (num_files == 0)
+    return usage(argv[0]);
+  return rc;
+}
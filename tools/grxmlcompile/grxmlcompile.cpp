@@ -19,7 +19,9 @@
 
 #include "ptypes.h"
 
+#include <thread>
 #include <unordered_map>
+#include <unistd.h>
 
 #include "fst/lib/fst.h"
 #include "fst/lib/fstlib.h"
@@ -114,6 +116,7 @@
 
 static int debug = 0;
 static int verbose = 0;
+static const char* cachedir = NULL;
 
 using namespace std;
 
@@ -150,7 +153,7 @@ std::string ExtractFileName(const std::string& full)
 
 int usage_error(const char* prgname)
 {
-  printf("USAGE: -par <par file> -grxml <grxml grammar file> -vocab <dictionary file (.ok)> [-outdir <output directory>]\n");
+  printf("USAGE: -par <par file> -grxml <grxml grammar file> -vocab <dictionary file (.ok)> [-outdir <output directory>] [-cachedir <graph cache directory>]\n");
   return (int)ESR_INVALID_ARGUMENT;
 }
 
@@ -194,6 +197,8 @@ int main(int argc, char* argv[])
         cmdline_vocfile = argv[++i];
       else if(!strcmp(argv[i],"-outdir")) 
         outdir = std::string(argv[++i]);
+      else if(!strcmp(argv[i],"-cachedir")) 
+        cachedir = argv[++i];
       else {
         printf("error_usage: argument [%s]\n", argv[i]);
 	return usage_error(argv[0]);
@@ -568,6 +573,256 @@ ESR_ReturnCode FstAddSlotMarkersToCFst( fst::StdVectorFst& cfst_, int myMin, int
     return ESR_SUCCESS;
 }
 
+/*-----------------------------------------------------------------*
+ * graph cache                                                     *
+ *-----------------------------------------------------------------*/
+
+/* entries are named by a hash of what the graph is made of, so they
+   never go stale and are never evicted either; nothing here bounds the
+   size of the cache directory, it is up to whoever owns it to clear it */
+
+/* change whenever the graphs built from the same inputs change */
+#define GRAPH_CACHE_VERSION "grxmlcompile-graphs-1"
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+/* FNV-1a, good enough to tell grammars apart */
+static uint64 hash_bytes( uint64 h, const void* data, size_t len)
+{
+  const unsigned char* p = (const unsigned char*)data;
+  for( ; len>0; len--, p++) {
+    h ^= *p;
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+static uint64 hash_string( uint64 h, const std::string& s)
+{
+  return hash_bytes( h, s.c_str(), s.size()+1);
+}
+
+static uint64 hash_file( uint64 h, const std::string& filename)
+{
+  char buf[4096];
+  std::ifstream strm( filename.c_str(), ios_base::in | ios_base::binary);
+  while( strm.read( buf, sizeof(buf)), strm.gcount() > 0)
+    h = hash_bytes( h, buf, strm.gcount());
+  return h;
+}
+
+static uint64 hash_fst( uint64 h, const fst::StdVectorFst& fst_)
+{
+  fst::StdArc::StateId start = fst_.Start();
+  h = hash_bytes( h, &start, sizeof(start));
+  for (fst::StateIterator<fst::StdFst> siter(fst_); !siter.Done(); siter.Next()) {
+    fst::StdArc::StateId s = siter.Value();
+    float final = fst_.Final(s).Value();
+    h = hash_bytes( h, &s, sizeof(s));
+    h = hash_bytes( h, &final, sizeof(final));
+    for(fst::ArcIterator<fst::StdFst> aiter(fst_,s); !aiter.Done(); aiter.Next()) {
+      const fst::StdArc& arc = aiter.Value();
+      float weight = arc.weight.Value();
+      h = hash_bytes( h, &arc.ilabel, sizeof(arc.ilabel));
+      h = hash_bytes( h, &arc.olabel, sizeof(arc.olabel));
+      h = hash_bytes( h, &weight, sizeof(weight));
+      h = hash_bytes( h, &arc.nextstate, sizeof(arc.nextstate));
+    }
+  }
+  return h;
+}
+
+static std::string cached_graph_name( uint64 key, const char* suffix)
+{
+  char name[32];
+  sprintf( name, "%016llx", key);
+  return std::string(cachedir) + "/" + name + suffix;
+}
+
+static bool copy_graph_file( const std::string& from, const std::string& to)
+{
+  std::ifstream istrm( from.c_str(), ios_base::in | ios_base::binary);
+  if(!istrm) 
+    return false;
+  std::ofstream ostrm( to.c_str(), ios_base::out | ios_base::binary);
+  if(!ostrm) 
+    return false;
+  ostrm << istrm.rdbuf();
+  ostrm.close();
+  return !ostrm.fail();
+}
+
+static bool fetch_cached_graph( uint64 key, const char* suffix, const std::string& filename)
+{
+  if(!copy_graph_file( cached_graph_name( key, suffix), filename)) 
+    return false;
+  cout << "info: using cached " << filename << endl;
+  return true;
+}
+
+static void store_cached_graph( uint64 key, const char* suffix, const std::string& filename)
+{
+  std::string name = cached_graph_name( key, suffix);
+  char pid[32];
+  /* several builds may share the cache, so the entry appears all at once */
+  sprintf( pid, ".%d", (int)getpid());
+  std::string tmpName = name + pid;
+  if(!copy_graph_file( filename, tmpName) || rename( tmpName.c_str(), name.c_str()) != 0) {
+    cerr << "warning: could not cache " << filename << " in " << cachedir << endl;
+    remove( tmpName.c_str());
+  }
+}
+
+/*-----------------------------------------------------------------*
+ * graphs                                                          *
+ *-----------------------------------------------------------------*/
+
+/*
+ * the reverse G is made on a thread of its own, see make_openfst_graphs()
+ */
+
+struct GrevJob {
+  fst::StdVectorFst grev_fst;     // reversed G, not shared with anything else
+  const fst::SymbolTable* word_syms;
+  std::string grxmlBasename;
+  std::string grevFilename;
+  ESR_ReturnCode rc;
+};
+
+static void make_grev_graph( GrevJob* job)
+{
+  const std::string& grxmlBasename = job->grxmlBasename;
+  fst::StdVectorFst& grev_fst = job->grev_fst;
+  fst::StdVectorFst grev_det_fst;
+  fst::StdVectorFst eps_fst;
+  int stateSt, stateEn;
+
+  stateSt = eps_fst.AddState();   
+  stateEn = stateSt; // stateEn = eps_fst.AddState();
+  eps_fst.SetStart(stateSt);  // arg is state ID
+  eps_fst.SetFinal(stateEn, 0.0);  // 1st arg is state ID, 2nd arg weight
+
+  if(debug) grev_fst.Write( grxmlBasename + ".Grev");
+  fst::RmEpsilon( &grev_fst, /*connect?*/ true );
+  if(debug) grev_fst.Write( grxmlBasename + ".Grevrme");
+  fst::Determinize(grev_fst, &grev_det_fst);
+  if(debug) grev_det_fst.Write( grxmlBasename + ".Grevrmedet");
+  if(1) fst::Minimize(&grev_det_fst);
+  if(debug) grev_det_fst.Write( grxmlBasename + ".Grevrmedetmin");
+  fst::Concat( &eps_fst, grev_det_fst);
+  grev_det_fst = eps_fst;
+  if(debug) grev_det_fst.Write( grxmlBasename + ".Grevrmedetmin2");
+  
+  ofstream ostrm1( job->grevFilename.c_str(), ios_base::out);
+  if(!ostrm1) {
+    job->rc = ESR_OPEN_ERROR;
+    return;
+  }
+  fst::FstPrinter<fst::StdArc> printer1( grev_det_fst,
+					job->word_syms, job->word_syms, 
+					 NULL, /*acceptor?*/ true);
+  printer1.Print( &ostrm1, job->grevFilename);
+  ostrm1.close();
+  job->rc = ostrm1.fail() ? ESR_WRITE_ERROR : ESR_SUCCESS;
+}
+
+static ESR_ReturnCode make_pclg_graph( fst::StdVectorFst& l_fst,
+				       fst::StdVectorFst& g_fst,
+				       fst::StdVectorFst& prefix_fst,
+				       const fst::StdVectorFst& suffix_fst,
+				       const fst::SymbolTable* word_syms,
+				       const fst::SymbolTable* model_syms,
+				       const char* cfstFilename,
+				       const std::string& grxmlBasename,
+				       const std::string& pclgFilename)
+{
+  ESR_ReturnCode rc;
+  fst::StdVectorFst* c_fst;
+  fst::StdVectorFst lg_fst;
+  fst::StdVectorFst clg_fst;
+  fst::StdVectorFst clg_det_fst;
+  int max_model_sym = 0;
+  
+  cout << "info: reading model fst " << cfstFilename << endl;
+  c_fst = fst::StdVectorFst::Read( cfstFilename);
+  if(!c_fst) {
+    cerr << "error: reading model fst" << endl;
+    return ESR_OPEN_ERROR;
+  }
+  
+  int slot_olabel_min=0, slot_olabel_max=0; // [min,max) .. ie excludes max
+  get_slot_olabel_range( word_syms, &slot_olabel_min, &slot_olabel_max);
+  if(slot_olabel_max > MAX_NUM_SLOTS) 
+    std::cout << "Error: SREC may have trouble with this many slots! (" << slot_olabel_max << ")" << std::endl;
+
+  /* add slot markers as if they were silence phonemes, this makes the context
+     for them as if the slot were silence, which is reasonable, although another
+     reasonable thing would be to allow all contexts.  Adding the true context
+     only would add complexity and slow down word addition too much. */
+
+  rc = FstAddSlotMarkersToCFst( *c_fst, slot_olabel_min, slot_olabel_max);
+  if(rc) {
+    delete c_fst;
+    return rc;
+  }
+
+  fst::Concat( &g_fst, suffix_fst);
+  fst::Concat( &prefix_fst, g_fst);
+  if(debug) prefix_fst.Write( grxmlBasename + ".G2");    
+  fst::ComposeOptions copts( /*connect?*/ true);
+  
+  fst::ArcSort(&l_fst, fst::StdOLabelCompare());
+  fst::ArcSort(&prefix_fst, fst::StdILabelCompare());
+
+  fst::Compose(l_fst, prefix_fst, &lg_fst, copts);
+  if(debug) lg_fst.Write( grxmlBasename + ".LG");    
+  fst::ArcSort(&lg_fst, fst::StdILabelCompare());
+  if(debug) lg_fst.Write( grxmlBasename + ".LG2");    
+
+  fst::RmEpsilon( &lg_fst, /*connect?*/ true );
+  if(debug) lg_fst.Write( grxmlBasename + ".LGrme");    
+  fst::Determinize( lg_fst, &clg_fst); // clg_fst is really lg_det_fst!
+  if(debug) clg_fst.Write( grxmlBasename + ".LGrmedet");    
+  rc = FstReplaceILabel( clg_fst, EXTRA_EPSILON_LABEL, EPSILON_LABEL);
+  fst::Compose( *c_fst, clg_fst, &clg_det_fst, copts);
+  if(debug) clg_det_fst.Write( grxmlBasename + ".CLGrmedet");    
+
+  rc = FstMergeOLabelsToILabels_GetMax( clg_det_fst, /*int&*/max_model_sym);
+  if(verbose)
+    cout << "info: merging into ilabels I=i+" << max_model_sym << "*o" << endl;
+  rc = FstMergeOLabelsToILabels( clg_det_fst, max_model_sym);
+  if(debug) clg_det_fst.Write( grxmlBasename + ".CLGrmedet2");    
+  fst::Minimize( &clg_det_fst);
+  if(debug) clg_det_fst.Write( grxmlBasename + ".CLGrmedet3");    
+  if(verbose) 
+    cout << "info: splitting from ilabels" << endl;
+  rc = FstSplitOLabelsFromILabels( clg_det_fst, max_model_sym);
+  if(debug) clg_det_fst.Write( grxmlBasename + ".CLGrmedet4");    
+
+  rc = FstPushSlotLikeOLabels( clg_det_fst, slot_olabel_min, slot_olabel_max);
+  if(rc != ESR_SUCCESS) 
+        std::cout << "Error: FstPushSlotLikeOLabels() failed" << std::endl;
+  if(debug) clg_det_fst.Write( grxmlBasename + ".CLG");    
+
+  delete c_fst;
+  ofstream ostrm( pclgFilename.c_str(), ios_base::out);
+  if(!ostrm) {
+    cerr << "error: opening " << pclgFilename << endl;
+    return ESR_OPEN_ERROR;
+  }
+  fst::FstPrinter<fst::StdArc> printer( clg_det_fst, 
+					model_syms, word_syms, 
+					NULL, /*acceptor?*/ false);
+  printer.Print( &ostrm, pclgFilename);
+  ostrm.close();
+  if(ostrm.fail()) {
+    cerr << "error: writing " << pclgFilename << endl;
+    return ESR_WRITE_ERROR;
+  }
+  return rc;
+}
+
+
 /*
  * make the graphs used by the recognition engine during the search.
  */
@@ -636,8 +891,8 @@ ESR_ReturnCode make_openfst_graphs(  GRXMLDoc* pDoc,
     cerr << "error: reading prsr_syms" << endl;
     return ESR_INVALID_ARGUMENT;
   }
-  int max_model_sym = 0;
-  /* if(1) {
+  /* int max_model_sym = 0;
+     if(1) {
      fst::SymbolTableIterator iter( *model_syms);
      for(iter.Reset(); !iter.Done(); iter.Next() ) max_model_sym++; */
   
@@ -791,7 +1046,6 @@ ESR_ReturnCode make_openfst_graphs(  GRXMLDoc* pDoc,
   cout << "info: creating helper fsts" << endl;
   fst::StdVectorFst prefix_fst;
   fst::StdVectorFst suffix_fst;
-  fst::StdVectorFst eps_fst;
   // int eps_word = StrToId("eps", word_syms, "arc ilabel");
   int pau_word = StrToId(SILENCE_PREFIX_WORD, word_syms, "arc ilabel");
   int pau2_word = StrToId(SILENCE_SUFFIX_WORD, word_syms, "arc ilabel");
@@ -810,116 +1064,69 @@ ESR_ReturnCode make_openfst_graphs(  GRXMLDoc* pDoc,
   suffix_fst.SetFinal(stateEn, 0.0);  // 1st arg is state ID, 2nd arg weight
   suffix_fst.AddArc(stateSt, fst::StdArc(pau2_word, pau2_word, 0.0, stateEn));
   
-  stateSt = eps_fst.AddState();   
-  stateEn = stateSt; // stateEn = eps_fst.AddState();
-  eps_fst.SetStart(stateSt);  // arg is state ID
-  eps_fst.SetFinal(stateEn, 0.0);  // 1st arg is state ID, 2nd arg weight
-  // eps_fst.AddArc(stateSt, fst::StdArc(eps_word, eps_word, 0.0, stateEn));
-  
-  /*-----------------------------------------------------------------*
-   *    make Grev2.det.txt                                           *
-   *-----------------------------------------------------------------*/
-  cout << "info: creating reverse g fst" << endl;
   fst::StdVectorFst g_fst = p_fst;   // this is a copy!!
-  fst::StdVectorFst grev_fst;        // reversed
-  fst::StdVectorFst grev_min_fst;    // eps removed and minimized
-  fst::StdVectorFst grev_det_fst;
-
   fst::Project(&g_fst, fst::PROJECT_INPUT);
   if(debug) g_fst.Write( grxmlBasename + ".G");
-  fst::Reverse( g_fst, &grev_fst);
-  if(debug) grev_fst.Write( grxmlBasename + ".Grev");
-  fst::RmEpsilon( &grev_fst, /*connect?*/ true );
-  if(debug) grev_fst.Write( grxmlBasename + ".Grevrme");
-  fst::Determinize(grev_fst, &grev_det_fst);
-  if(debug) grev_det_fst.Write( grxmlBasename + ".Grevrmedet");
-  if(1) fst::Minimize(&grev_det_fst);
-  if(debug) grev_det_fst.Write( grxmlBasename + ".Grevrmedetmin");
-  fst::Concat( &eps_fst, grev_det_fst);
-  grev_det_fst = eps_fst;
-  if(debug) grev_det_fst.Write( grxmlBasename + ".Grevrmedetmin2");
-  std::string grevFilename = grxmlBasename + std::string(".Grev2.det.txt");
+
+  /*-----------------------------------------------------------------*
+   *    look the graphs up in the cache                              *
+   *-----------------------------------------------------------------*/
   
-  cout << "info: writing reverse G fst as text " << grevFilename << endl;
-  ostream* ostrm1 = new ofstream( grevFilename.c_str(), ios_base::out);
-  fst::FstPrinter<fst::StdArc> printer1( grev_det_fst,
-					word_syms, word_syms, 
-					 NULL, /*acceptor?*/ true);
-  printer1.Print( ostrm1, grevFilename);
-  delete ostrm1;
+  std::string grevFilename = grxmlBasename + std::string(".Grev2.det.txt");
+  std::string pclgFilename = grxmlBasename + ".PCLG.txt";
+  uint64 grev_key = 0, pclg_key = 0;
+  bool grev_cached = false, pclg_cached = false;
+  if(cachedir) {
+    /* the graphs are keyed by what they are made of; the word symbols
+       are hashed by name too, since they end up in the text files */
+    grev_key = hash_string( FNV_OFFSET_BASIS, GRAPH_CACHE_VERSION);
+    grev_key = hash_fst( grev_key, g_fst);
+    grev_key = hash_file( grev_key, imapFilename);
+    pclg_key = hash_fst( grev_key, l_fst);
+    pclg_key = hash_file( pclg_key, cfstFilename);
+    pclg_key = hash_file( pclg_key, modelmapFilename);
+    grev_cached = fetch_cached_graph( grev_key, ".Grev2.det.txt", grevFilename);
+    pclg_cached = fetch_cached_graph( pclg_key, ".PCLG.txt", pclgFilename);
+  }
   
   /*-----------------------------------------------------------------*
-   *    make PCLG.txt                                                *
+   *    make Grev2.det.txt and PCLG.txt                              *
    *-----------------------------------------------------------------*/
   
-  fst::StdVectorFst* c_fst;
-  fst::StdVectorFst lg_fst;
-  fst::StdVectorFst clg_fst;
-  fst::StdVectorFst clg_det_fst;
-  
-  cout << "info: reading model fst " << cfstFilename << endl;
-  c_fst = fst::StdVectorFst::Read( cfstFilename);
+  /* the two graphs share nothing but the symbol tables, which are only
+     read, so the reverse G is made on a thread of its own meanwhile */
+  GrevJob grev_job;
+  std::thread grev_thread;
+  rc = ESR_SUCCESS;
+  if(!grev_cached) {
+    cout << "info: creating reverse g fst" << endl;
+    fst::Reverse( g_fst, &grev_job.grev_fst);
+    grev_job.word_syms = word_syms;
+    grev_job.grxmlBasename = grxmlBasename;
+    grev_job.grevFilename = grevFilename;
+    grev_job.rc = ESR_SUCCESS;
+    grev_thread = std::thread( make_grev_graph, &grev_job);
+  }
   
-  int slot_olabel_min=0, slot_olabel_max=0; // [min,max) .. ie excludes max
-  get_slot_olabel_range( word_syms, &slot_olabel_min, &slot_olabel_max);
-  if(slot_olabel_max > MAX_NUM_SLOTS) 
-    std::cout << "Error: SREC may have trouble with this many slots! (" << slot_olabel_max << ")" << std::endl;
-
-  /* add slot markers as if they were silence phonemes, this makes the context
-     for them as if the slot were silence, which is reasonable, although another
-     reasonable thing would be to allow all contexts.  Adding the true context
-     only would add complexity and slow down word addition too much. */
-
-  rc = FstAddSlotMarkersToCFst( *c_fst, slot_olabel_min, slot_olabel_max);
-  if(rc) return rc;
-
-  fst::Concat( &g_fst, suffix_fst);
-  fst::Concat( &prefix_fst, g_fst);
-  if(debug) prefix_fst.Write( grxmlBasename + ".G2");    
-  fst::ComposeOptions copts( /*connect?*/ true);
+  if(!pclg_cached) {
+    rc = make_pclg_graph( l_fst, g_fst, prefix_fst, suffix_fst, word_syms, model_syms,
+			  cfstFilename, grxmlBasename, pclgFilename);
+    if(rc == ESR_SUCCESS && cachedir) 
+      store_cached_graph( pclg_key, ".PCLG.txt", pclgFilename);
+  }
   
-  fst::ArcSort(&l_fst, fst::StdOLabelCompare());
-  fst::ArcSort(&prefix_fst, fst::StdILabelCompare());
-
-  fst::Compose(l_fst, prefix_fst, &lg_fst, copts);
-  if(debug) lg_fst.Write( grxmlBasename + ".LG");    
-  fst::ArcSort(&lg_fst, fst::StdILabelCompare());
-  if(debug) lg_fst.Write( grxmlBasename + ".LG2");    
-
-  fst::RmEpsilon( &lg_fst, /*connect?*/ true );
-  if(debug) lg_fst.Write( grxmlBasename + ".LGrme");    
-  fst::Determinize( lg_fst, &clg_fst); // clg_fst is really lg_det_fst!
-  if(debug) clg_fst.Write( grxmlBasename + ".LGrmedet");    
-  rc = FstReplaceILabel( clg_fst, EXTRA_EPSILON_LABEL, EPSILON_LABEL);
-  fst::Compose( *c_fst, clg_fst, &clg_det_fst, copts);
-  if(debug) clg_det_fst.Write( grxmlBasename + ".CLGrmedet");    
-
-  rc = FstMergeOLabelsToILabels_GetMax( clg_det_fst, /*int&*/max_model_sym);
-  if(verbose)
-    cout << "info: merging into ilabels I=i+" << max_model_sym << "*o" << endl;
-  rc = FstMergeOLabelsToILabels( clg_det_fst, max_model_sym);
-  if(debug) clg_det_fst.Write( grxmlBasename + ".CLGrmedet2");    
-  fst::Minimize( &clg_det_fst);
-  if(debug) clg_det_fst.Write( grxmlBasename + ".CLGrmedet3");    
-  if(verbose) 
-    cout << "info: splitting from ilabels" << endl;
-  rc = FstSplitOLabelsFromILabels( clg_det_fst, max_model_sym);
-  if(debug) clg_det_fst.Write( grxmlBasename + ".CLGrmedet4");    
-
-  rc = FstPushSlotLikeOLabels( clg_det_fst, slot_olabel_min, slot_olabel_max);
-  if(rc != ESR_SUCCESS) 
-        std::cout << "Error: FstPushSlotLikeOLabels() failed" << std::endl;
-  if(debug) clg_det_fst.Write( grxmlBasename + ".CLG");    
-
-  std::string pclgFilename = grxmlBasename + ".PCLG.txt";
-  ostream* ostrm = new ofstream( pclgFilename.c_str(), ios_base::out);
-  fst::FstPrinter<fst::StdArc> printer( clg_det_fst, 
-					model_syms, word_syms, 
-					NULL, /*acceptor?*/ false);
-  printer.Print( ostrm, pclgFilename);
-  delete ostrm;
+  if(grev_thread.joinable()) {
+    grev_thread.join();
+    if(grev_job.rc != ESR_SUCCESS) {
+      cerr << "error: writing " << grevFilename << endl;
+      rc = grev_job.rc;
+    } else {
+      cout << "info: wrote reverse G fst as text " << grevFilename << endl;
+      if(cachedir) 
+	store_cached_graph( grev_key, ".Grev2.det.txt", grevFilename);
+    }
+  }
   
-  delete c_fst;
   delete word_syms;  word_syms = NULL;
   delete prsr_syms;  prsr_syms = NULL;
   delete model_syms; model_syms = NULL;